@@ -34,6 +34,7 @@ set(UBIT_CORE_FILES
 	src/ubit/uelem.hpp
 	src/ubit/uevent.hpp
 	src/ubit/ueventflow.hpp
+	src/ubit/ueventlog.hpp
 	src/ubit/ufile.hpp
 	src/ubit/ufilebox.hpp
 	src/ubit/ufont.hpp
@@ -77,9 +78,12 @@ set(UBIT_CORE_FILES
 	src/ubit/ustyleparser.hpp
 	src/ubit/usymbol.hpp
 	src/ubit/usubwin.hpp
+	src/ubit/usharedring.hpp
 	src/ubit/usocket.hpp
 	src/ubit/usource.hpp
 	src/ubit/utable.hpp
+	src/ubit/utaskpool.hpp
+	src/ubit/uthumbnailcache.hpp
 	src/ubit/utimer.hpp
 	src/ubit/utreebox.hpp
 	src/ubit/uview.hpp
@@ -95,13 +99,16 @@ set(UBIT_CORE_FILES
 	src/ubit/u3dicon.hpp
 	src/ubit/nat/udispX11.hpp
 	src/ubit/nat/udispGLUT.hpp
+	src/ubit/nat/udispHeadless.hpp
 	src/ubit/nat/urendercontext.hpp
 	src/ubit/nat/uglcontext.hpp
 	src/ubit/nat/ux11context.hpp
+	src/ubit/nat/uheadlesscontext.hpp
 	src/ubit/nat/uhardfont.hpp
 	src/ubit/nat/uhardima.hpp
 	src/ubit/nat/uhardwinX11.hpp
 	src/ubit/nat/uhardwinGLUT.hpp
+	src/ubit/nat/uhardwinHeadless.hpp
 
 	src/ubit/uattr.cpp
 	src/ubit/uappli.cpp
@@ -127,6 +134,7 @@ set(UBIT_CORE_FILES
 	src/ubit/uelem.cpp
 	src/ubit/uevent.cpp
 	src/ubit/ueventflow.cpp
+	src/ubit/ueventlog.cpp
 	src/ubit/ufile.cpp
 	src/ubit/ufilebox.cpp
 	src/ubit/ufont.cpp
@@ -160,6 +168,7 @@ set(UBIT_CORE_FILES
 	src/ubit/uslider.cpp
 	src/ubit/uscrollbar.cpp
 	src/ubit/uscrollpane.cpp
+	src/ubit/usharedring.cpp
 	src/ubit/usocket.cpp
 	src/ubit/usource.cpp
 	src/ubit/ustyle.cpp
@@ -167,6 +176,8 @@ set(UBIT_CORE_FILES
 	src/ubit/usymbol.cpp
 	src/ubit/usubwin.cpp
 	src/ubit/utable.cpp
+	src/ubit/utaskpool.cpp
+	src/ubit/uthumbnailcache.cpp
 	src/ubit/utimer.cpp
 	src/ubit/utreebox.cpp
 	src/ubit/uview.cpp
@@ -184,12 +195,15 @@ set(UBIT_CORE_FILES
 	src/ubit/u3dicon.cpp
 	src/ubit/nat/udispX11.cpp
 	src/ubit/nat/udispGLUT.cpp
+	src/ubit/nat/udispHeadless.cpp
 	src/ubit/nat/uglcontext.cpp
 	src/ubit/nat/ux11context.cpp
+	src/ubit/nat/uheadlesscontext.cpp
 	src/ubit/nat/uhardfont.cpp
 	src/ubit/nat/uhardima.cpp
 	src/ubit/nat/uhardwinX11.cpp
 	src/ubit/nat/uhardwinGLUT.cpp
+	src/ubit/nat/uhardwinHeadless.cpp
 	src/ubit/nat/uimaJPEG.cpp
 	src/ubit/nat/uimaGIF.cpp
 	src/ubit/nat/uimaXPM.cpp
@@ -16,16 +16,58 @@ ubit_add_libraries(uappli_tests)
 
 add_test(NAME appli_test COMMAND uappli_tests)
 
+add_executable(uheadless_tests
+	tests/test_uheadless.cpp
+)
+
+target_link_libraries(uheadless_tests
+	PUBLIC gtest_main
+	PUBLIC gmock_main
+	PUBLIC gmock
+)
+
+ubit_add_include_dir(uheadless_tests)
+
+ubit_add_libraries(uheadless_tests)
+
+# the GL tests are only built if EGL is available
+find_package(PkgConfig)
+if(PKG_CONFIG_FOUND)
+	pkg_check_modules(EGL egl)
+endif()
+
+if(EGL_FOUND)
+	target_compile_definitions(uheadless_tests
+		PRIVATE UBIT_WITH_EGL=1
+	)
+	target_include_directories(uheadless_tests
+		PRIVATE ${EGL_INCLUDE_DIRS}
+	)
+	target_link_libraries(uheadless_tests
+		PUBLIC ${EGL_LIBRARIES}
+	)
+endif()
+
+add_test(NAME headless_test COMMAND uheadless_tests)
+
 
 add_executable(ubittests
 	tests/test_uon.cpp
 	tests/test_uzoom.cpp
+	tests/test_usocket.cpp
+	tests/test_usharedring.cpp
+	tests/test_ueventlog.cpp
+	tests/test_umstimers.cpp
+	tests/test_umssource.cpp
+	tests/test_umsmotion.cpp
 )
 
+# the UMS components that do not depend on the X server are tested too
 target_link_libraries(ubittests
 	PUBLIC gtest_main
 	PUBLIC gmock_main
 	PUBLIC gmock
+	PRIVATE ums
 )
 
 ubit_add_include_dir(ubittests)
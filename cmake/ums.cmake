@@ -3,6 +3,9 @@ add_library(ums STATIC
 	src/ums/umserver.cpp
 	src/ums/flow.cpp
 	src/ums/source.cpp
+	src/ums/sourcequeue.cpp
+	src/ums/timers.cpp
+	src/ums/motion.cpp
 	src/ums/events.hpp
 	src/ums/macevents.hpp
 	src/ums/request.cpp
@@ -18,6 +21,8 @@ add_library(ums STATIC
 	src/ums/umserver.hpp
 	src/ums/flow.hpp
 	src/ums/source.hpp
+	src/ums/timers.hpp
+	src/ums/motion.hpp
 	src/ums/calib.hpp
 	src/ums/remoteserver.hpp
 	src/ums/zeroconf.hpp
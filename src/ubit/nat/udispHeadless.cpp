@@ -0,0 +1,233 @@
+/* ***********************************************************************
+ *
+ *  udispHeadless.cpp: display without window system
+ *  Ubit GUI Toolkit - Version 6.0
+ *  (C) 2009 Eric Lecolinet | ENST Paris | www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#include <ubit/ubit_features.h>
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <errno.h>
+#include <sys/select.h>
+#include <ubit/uappli.hpp>
+#include <ubit/uappliImpl.hpp>
+#include <ubit/ueventflow.hpp>
+#include <ubit/ugraph.hpp>
+#include <ubit/uupdatecontext.hpp>
+#include <ubit/uviewImpl.hpp>
+#include <ubit/uevent.hpp>
+#include <ubit/ukey.hpp>
+#include <ubit/utimer.hpp>
+#include <ubit/uwin.hpp>
+#include <ubit/nat/udispHeadless.hpp>
+#include <ubit/nat/uheadlesscontext.hpp>
+using namespace std;
+#define NAMESPACE_UBIT namespace ubit {
+NAMESPACE_UBIT
+
+UDispHeadless::UDispHeadless(const UStr& _dname) : UDisp(_dname),
+pointer_state(0), modifiers(0)
+{
+  // a typical screen, which is only used for placing the windows
+  screen_width = 1920;
+  screen_height = 1080;
+  setPixelPerInch(96);
+  if (bpp == 0) bpp = 24;
+
+  // pixels are RGBA values in a single unsigned long (see createColorPixel())
+  red_mask   = 0xff000000;
+  green_mask = 0x00ff0000;
+  blue_mask  = 0x0000ff00;
+  countBits(red_mask, red_bits, red_shift);
+  countBits(green_mask, green_bits, green_shift);
+  countBits(blue_mask, blue_bits, blue_shift);
+  black_pixel = 0x000000ff;
+  white_pixel = 0xffffffff;
+
+  default_context = new UHeadlessContext(this);
+  UKey::mapKeys(this);
+  is_opened = true;
+}
+
+UDispHeadless::~UDispHeadless() {}
+
+// ==================================================== [Ubit Toolkit] =========
+
+unsigned long UDispHeadless::createColorPixel(const URgba& c) {
+  return (c.comps[0] << 24) | (c.comps[1] << 16) | (c.comps[2] << 8) | c.comps[3];
+}
+
+UHardwinHeadless* UDispHeadless::createWinImpl(UWin* win) {
+  return new UHardwinHeadless(this, win);
+}
+
+UHardwinHeadless* UDispHeadless::getHardwin(UWin& win) const {
+  return static_cast<UHardwinHeadless*>(win.getHardwin(const_cast<UDispHeadless*>(this)));
+}
+
+bool UDispHeadless::pickWindow(int& x_in_win, int& y_in_win, UHardwinImpl* window,
+                               UCursor* cursor, UCall* callback) {
+  UAppli::error("UDisp::pickWindow","This function is not available with the headless display");
+  return false;
+}
+
+// ==================================================== [Ubit Toolkit] =========
+// synthetic events.
+
+UView* UDispHeadless::prepareEvent(UWin& win, const UPoint& win_pos, UPoint& screen_pos) {
+  UHardwinHeadless* hw = getHardwin(win);
+  if (!hw) {
+    UAppli::error("UDispHeadless","the window (%p) is not realized on this display", &win);
+    return null;
+  }
+  UPoint wpos = hw->getScreenPos();
+  screen_pos.set(wpos.x + win_pos.x, wpos.y + win_pos.y);
+  pointer_pos = screen_pos;
+  return win.getWinView(this);
+}
+
+void UDispHeadless::endEvent() {
+  if (UAppli::impl.request_mask) UAppli::impl.processPendingRequests();
+}
+
+void UDispHeadless::mousePress(UWin& win, const UPoint& win_pos, int button) {
+  UPoint scr_pos;
+  UView* winview = prepareEvent(win, win_pos, scr_pos);
+  if (!winview) return;
+  pointer_state |= button;     // the pressed button must be included
+  obtainChannelFlow(0)->mousePress(winview, UAppli::getTime(), pointer_state | modifiers,
+                                   win_pos, scr_pos, button);
+  endEvent();
+}
+
+void UDispHeadless::mouseRelease(UWin& win, const UPoint& win_pos, int button) {
+  UPoint scr_pos;
+  UView* winview = prepareEvent(win, win_pos, scr_pos);
+  if (!winview) return;
+  pointer_state &= ~button;    // the released button must be excluded
+  obtainChannelFlow(0)->mouseRelease(winview, UAppli::getTime(), pointer_state | modifiers,
+                                     win_pos, scr_pos, button);
+  endEvent();
+}
+
+void UDispHeadless::mouseMotion(UWin& win, const UPoint& win_pos) {
+  UPoint scr_pos;
+  UView* winview = prepareEvent(win, win_pos, scr_pos);
+  if (!winview) return;
+  obtainChannelFlow(0)->mouseMotion(winview, UAppli::getTime(), pointer_state | modifiers,
+                                    win_pos, scr_pos);
+  endEvent();
+}
+
+void UDispHeadless::wheelMotion(UWin& win, const UPoint& win_pos, int delta) {
+  UPoint scr_pos;
+  UView* winview = prepareEvent(win, win_pos, scr_pos);
+  if (!winview) return;
+  obtainChannelFlow(0)->wheelMotion(winview, UAppli::getTime(), pointer_state | modifiers,
+                                    win_pos, scr_pos, 0/*type*/, delta);
+  endEvent();
+}
+
+void UDispHeadless::keyPress(UWin& win, int keycode, short keychar) {
+  UView* winview = win.getWinView(this);
+  if (!winview) return;
+  obtainChannelFlow(0)->keyPress(winview, UAppli::getTime(), pointer_state | modifiers,
+                                 keycode, keychar);
+  endEvent();
+}
+
+void UDispHeadless::keyRelease(UWin& win, int keycode, short keychar) {
+  UView* winview = win.getWinView(this);
+  if (!winview) return;
+  obtainChannelFlow(0)->keyRelease(winview, UAppli::getTime(), pointer_state | modifiers,
+                                   keycode, keychar);
+  endEvent();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+void UDispHeadless::expose(UWin& win, const URect& win_rect) {
+  UHardwinHeadless* hw = getHardwin(win);
+  if (!hw || !hw->isShown()) return;
+  int x1 = std::max(0, int(win_rect.x)), y1 = std::max(0, int(win_rect.y));
+  int x2 = std::min(hw->width, int(ceil(win_rect.x + win_rect.width)));
+  int y2 = std::min(hw->height, int(ceil(win_rect.y + win_rect.height)));
+  if (x1 >= x2 || y1 >= y2) return;
+  // the damaged pixels are white, as those of a newly mapped window
+  for (int j = y1; j < y2; ++j)
+    memset(&hw->pixels[(size_t(j) * hw->width + x1) * 4], 255, (x2 - x1) * 4);
+  hw->exposes.push_back(URect(x1, y1, x2 - x1, y2 - y1));
+}
+
+void UDispHeadless::flushExposes(UWin& win) {
+  UHardwinHeadless* hw = getHardwin(win);
+  UView* winview = win.getWinView(this);
+  if (!hw || !winview) return;
+  std::vector<URect> exposes;
+  exposes.swap(hw->exposes);
+  // contrary to onPaint(), which repaints the whole window, drawing is clipped
+  // to the exposed areas, so that the pixels that are not repainted remain visible
+  for (unsigned int k = 0; k < exposes.size(); ++k) {
+    UGraph g(winview);
+    UViewUpdate vup(UViewUpdate::PAINT_ALL);
+    UWinUpdateContext winctx(winview, &g);
+    winview->doUpdate(winctx, *winview, exposes[k], vup);
+  }
+}
+
+// ==================================================== [Ubit Toolkit] =========
+// the main loop only waits for the sources and the timers.
+
+void UDispHeadless::quitLoop(bool main) {
+  UAppliImpl& a = UAppli::impl;
+  if (main) a.mainloop_running = a.subloop_running = false;
+  else a.subloop_running = false;
+}
+
+void UDispHeadless::startLoop(bool main) {
+  UAppliImpl& a = UAppli::impl;
+  bool& running = main ? a.mainloop_running : a.subloop_running;
+  running = true;
+
+  while (running) {
+    if (a.request_mask) a.processPendingRequests();
+    if (!running) break;
+
+    fd_set read_set, write_set;
+    FD_ZERO(&read_set);
+    FD_ZERO(&write_set);
+    int maxfd = 0;
+    if (a.sources) a.resetSources(a.sources, read_set, write_set, maxfd);
+
+    struct timeval delay;
+    bool has_timeout = false;
+    UTimerImpl::Timers& timers = a.timer_impl.timers;
+    if (timers.size() > 0) has_timeout = a.timer_impl.resetTimers(delay);
+
+    int has_input = ::select(maxfd+1, &read_set, &write_set, null,
+                             (has_timeout ? &delay : null));
+    if (has_input < 0) {
+      if (errno == EINTR || errno == EAGAIN) errno = 0;
+      UAppli::warning("UDispHeadless::startLoop","error in select()");
+      a.cleanSources(a.sources); // remove invalid sources
+    }
+    else {
+      if (has_input > 0 && a.sources) a.fireSources(a.sources, read_set, write_set);
+      if (has_timeout && timers.size() > 0) a.timer_impl.fireTimers();
+    }
+  }
+}
+
+}
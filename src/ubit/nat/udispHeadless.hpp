@@ -0,0 +1,105 @@
+/* ***********************************************************************
+ *
+ *  udispHeadless.hpp: display without window system
+ *  Ubit GUI Toolkit - Version 6.0
+ *  (C) 2009 Eric Lecolinet | ENST Paris | www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#ifndef UDispHeadless_hpp
+#define	UDispHeadless_hpp 1
+#include <ubit/udisp.hpp>
+#include <ubit/nat/uhardwinHeadless.hpp>
+namespace ubit {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/** headless display: windows are rendered in memory, no window system is used.
+ * this display is created instead of the native display when UConf::headless
+ * is true (or when the application is launched with the --headless option).
+ * It makes it possible to run layout and paint benchmarks, or to render
+ * snapshots of the GUI, on machines that have no X server.
+ *
+ * Windows are UHardwinHeadless objects that contain an RGBA framebuffer.
+ * Input events are generated by calling the mouseXxx() and keyXxx() functions,
+ * which dispatch the events to the native event flow and then process the
+ * pending update requests (as the main loop does). Example:
+ * <pre>
+ *    UAppli::conf.headless = true;   // or: myappli --headless
+ *    UAppli appli(argc, argv);
+ *    UFrame& frame = ...;
+ *    appli.add(frame);
+ *    frame.show();
+ *    UDispHeadless* d = (UDispHeadless*)UAppli::getDisp();
+ *    d->mousePress(frame, UPoint(10, 10), UMouseEvent::LeftButton);
+ *    d->mouseRelease(frame, UPoint(10, 10), UMouseEvent::LeftButton);
+ *    d->getHardwin(frame)->writePPM("frame.ppm");
+ * </pre>
+ */
+class UDispHeadless : public UDisp {
+public:
+  UDispHeadless(const UStr&);
+  virtual ~UDispHeadless();
+
+  virtual void   setPointerPos(const UPoint& screen_pos) {pointer_pos = screen_pos;}
+  virtual UPoint getPointerPos() const {return pointer_pos;}
+  virtual int    getPointerState() const {return pointer_state;}
+  virtual bool   grabPointer(const UCursor*) {return true;}
+  virtual void   ungrabPointer() {}
+  virtual bool   pickWindow(int& x_in_win, int& y_in_win, UHardwinImpl* window,
+                            UCursor* cursor = null, UCall* callback = null);
+
+  virtual unsigned long createColorPixel(const URgba&);
+  virtual UHardwinHeadless* createWinImpl(UWin*);
+  virtual UCursorImpl*  createCursorImpl(int curtype) {return null;}
+  virtual void          deleteCursorImpl(UCursorImpl*) {}
+
+  UHardwinHeadless* getHardwin(UWin&) const;
+  ///< returns the hard window (and thus the framebuffer) of this window (null if none).
+
+  void mousePress(UWin&, const UPoint& win_pos, int button);
+  void mouseRelease(UWin&, const UPoint& win_pos, int button);
+  void mouseMotion(UWin&, const UPoint& win_pos);
+  void wheelMotion(UWin&, const UPoint& win_pos, int delta);
+  void keyPress(UWin&, int keycode, short keychar);
+  void keyRelease(UWin&, int keycode, short keychar);
+  /**< dispatches a synthetic event to the native event flow of this display.
+   * 'win_pos' is relative to the window; 'button' is one of UMouseEvent::LeftButton,
+   * MidButton, RightButton; 'delta' is a multiple of UWheelEvent::WHEEL_DELTA.
+   * The pending update requests are then processed.
+   */
+
+  void setModifiers(int modifier_mask) {modifiers = modifier_mask;}
+
+  ///< changes the modifiers that are added to the state of the next events.
+
+  void expose(UWin&, const URect& win_rect);
+  void flushExposes(UWin&);
+  /**< simulate the exposures of the window, as when it is uncovered with X11.
+   * expose() clears an area of the window (in window coordinates) and queues
+   * an exposure, as the X server does. flushExposes() paints the queued
+   * exposures, as the main loop does when it receives the Expose events, but
+   * drawing is clipped to the exposed areas.
+   */
+
+protected:
+  virtual void startAppli() {}
+  virtual void quitAppli() {}
+  virtual void startLoop(bool main_loop);
+  virtual void quitLoop(bool main_loop);
+  UView* prepareEvent(UWin&, const UPoint& win_pos, UPoint& screen_pos);
+  void endEvent();
+
+  UPoint pointer_pos;
+  int pointer_state, modifiers;
+};
+
+}
+#endif
@@ -36,6 +36,7 @@
 #include <ubit/ucursor.hpp>
 #include <ubit/ucolor.hpp>
 #include <ubit/umsproto.hpp>
+#include <ubit/umessage.hpp>
 #include <ubit/nat/urendercontext.hpp>
 #include <ubit/nat/ux11context.hpp>
 #include <ubit/nat/uglcontext.hpp>
@@ -150,6 +151,7 @@ UDispX11::UDispX11(const UStr& _dname) : UDisp(_dname),
   atoms.WM_TAKE_FOCUS   = GetAtom(sys_disp, "WM_TAKE_FOCUS");
   atoms.UMS_WINDOW      = GetAtom(sys_disp, UMS_WINDOW_PROPERTY);
   atoms.UMS_MESSAGE     = GetAtom(sys_disp, UMS_MESSAGE_PROPERTY);
+  atoms.UMS_MESSAGE_SOCKET = GetAtom(sys_disp, UMS_MESSAGE_SOCKET_PROPERTY);
   //atoms.USELECTION    = GetAtom(sys_disp, _USELECTION);
   
   // NB: requires: sys_visual, default_pixmap, atoms, and possibly, white/black pixels
@@ -708,8 +710,9 @@ void UDispX11::startLoop(bool main) {
 #endif
 
     // ** sources and timers
-    fd_set read_set;
+    fd_set read_set, write_set;
     FD_ZERO(&read_set);
+    FD_ZERO(&write_set);
     
     int maxfd = 0;
     for (unsigned int k = 0; k < displist.size(); ++k) {
@@ -718,7 +721,8 @@ void UDispX11::startLoop(bool main) {
       maxfd = std::max(maxfd, xconnection);
     }
     
-    if (UAppli::impl.sources) a.resetSources(UAppli::impl.sources, read_set, maxfd);
+    if (UAppli::impl.sources) 
+      a.resetSources(UAppli::impl.sources, read_set, write_set, maxfd);
     
     struct timeval delay;
     bool has_timeout = false;
@@ -731,7 +735,7 @@ void UDispX11::startLoop(bool main) {
     // rien sur xconnection, rien sur sources, timeouts pas atteints
     int has_input = ::select(maxfd+1,
                              &read_set, //read
-                             null,      //write
+                             &write_set,//write
                              null,      //except
                              (has_timeout ? &delay : null));
     if (has_input < 0) {
@@ -742,7 +746,7 @@ void UDispX11::startLoop(bool main) {
     
     else {
       if (has_input > 0) {	// source event
-        if (a.sources) a.fireSources(a.sources, read_set);
+        if (a.sources) a.fireSources(a.sources, read_set, write_set);
         if (a.request_mask) a.processPendingRequests();
       }
       
@@ -864,6 +868,13 @@ static void onMessage(UDispX11* nd, XEvent* xev) {
 
 void UDispX11::dispatchEvent(XEvent* sev) {
   Window event_win = sev->xany.window;
+
+  // the windows (of any application) that UMessage::send() is connected to
+  if (sev->type == DestroyNotify)
+    UMessage::closeChannel(sev->xdestroywindow.window);
+  else if (sev->type == PropertyNotify && sev->xproperty.atom == atoms.UMS_MESSAGE_SOCKET)
+    UMessage::closeChannel(event_win);
+
   UWin* win = null;
   {   // retrieve the window
     HardwinList::iterator c = hardwin_list.begin();     // NB: on pourrait utiliser une MAP
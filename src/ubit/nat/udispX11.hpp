@@ -43,7 +43,7 @@ struct UCursorImpl {
 struct UAtomsX11 {
   Atom PRIMARY_SELECTION, SECONDARY_SELECTION,
   WM_PROTOCOLS, WM_DELETE_WINDOW, WM_TAKE_FOCUS,
-  UMS_WINDOW, UMS_MESSAGE;
+  UMS_WINDOW, UMS_MESSAGE, UMS_MESSAGE_SOCKET;
 };
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -78,6 +78,7 @@ public:
   /**< returns useful atoms.
   * - UMS_WINDOW: a X window that has this property will receive UMS events.
   * - UMS_MESSAGE: the property for exchanging messages between applications.
+  * - UMS_MESSAGE_SOCKET: the socket of an application for receiving messages.
   * see also: umsproto.hpp and the UMS server (available in directory ubit/ums).
   */
 
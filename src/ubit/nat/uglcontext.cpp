@@ -19,6 +19,9 @@
 
 #include <iostream>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
 #include <ubit/udefs.hpp>
 #include <ubit/ufont.hpp>
 #include <ubit/ufontmetrics.hpp>
@@ -48,12 +51,14 @@ NAMESPACE_UBIT
 #if UBIT_WITH_X11
 
 UGlcontext::UGlcontext(UDisp* d, UGlcontext* sharelists) :
-URenderContext(d), win_height(0), cx(0), cy(0) 
+URenderContext(d), win_height(0), cx(0), cy(0),
+sharegroup(sharelists ? sharelists->sharegroup : this)
 {
   glxcontext = ((UDispX11*)d)->createGlcontext(sharelists);
 }
 
 UGlcontext::~UGlcontext() {
+  if (!UAppli::isExiting()) disp->getGlresources()->releaseContext(this);
   ((UDispX11*)disp)->destroyGlcontext(glxcontext);
 }
 
@@ -80,10 +85,11 @@ void UGlcontext::swapBuffers() {
   glXSwapBuffers(((UHardwinX11*)dest)->getSysDisp(), ((UHardwinX11*)dest)->getSysWin());
 }
 
-// used by UDisp::getFont() to create fonts in the default context
+// used by UDisp::getFont() to create fonts in the default context: contexts
+// of the same share group can use the same fonts and textures.
 bool UGlcontext::isSharedWith(const URenderContext* c) const {
-  const UGlcontext* glc = c->toGlcontext();
-  return glc && glc->glxcontext == glxcontext; // !!! A COMPLETER : FAUT VERIFIER SHAREDLISTS !!!
+  const UGlcontext* glc = c ? c->toGlcontext() : null;
+  return glc && glc->sharegroup == sharegroup;
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -91,12 +97,14 @@ bool UGlcontext::isSharedWith(const URenderContext* c) const {
 #elif UBIT_WITH_GLUT
 
 UGlcontext::UGlcontext(UDisp* d, UHardwinGLUT* hw) :
-URenderContext(d), win_height(0), cx(0), cy(0) 
+URenderContext(d), win_height(0), cx(0), cy(0), sharegroup(this)
 {
   hardwin = hw;
 }
 
-UGlcontext::~UGlcontext() {}
+UGlcontext::~UGlcontext() {
+  if (!UAppli::isExiting()) disp->getGlresources()->releaseContext(this);
+}
 
 void UGlcontext::makeCurrent() const {
   if (!dest) {
@@ -119,9 +127,9 @@ void UGlcontext::swapBuffers() {
   glutSwapBuffers();
 }
 
-// used by UDisp::getFont() to create fonts in the default context
+// GLUT contexts don't share their resources
 bool UGlcontext::isSharedWith(const URenderContext* c) const {
-  return false;                // !!! A COMPLETER : FAUT VERIFIER SHAREDLISTS !!!
+  return c == this;
 }
 
 #endif
@@ -220,6 +228,28 @@ void UGlcontext::copyArea(double x, double y, double w, double h, double delta_x
   UAppli::error("UGraph::copyArea","This function is not available when OpenGL is used");
 }
 
+bool UGlcontext::readPixels(double x, double y, int w, int h,
+                            std::vector<unsigned char>& rgba) const
+{
+  MAKE_CURRENT;
+  // win_height is 0 in 3D mode
+  if (w <= 0 || h <= 0 || win_height <= 0) return false;
+  GLint x1 = GLint(floor(cx + x + 0.5));
+  GLint y1 = GLint(floor(cy - y + 0.5)) - h;    // GL origin is the bottom left point
+  if (x1 < 0 || y1 < 0 || x1 + w > dest->getSize().width) return false;
+
+  std::vector<unsigned char> buf(size_t(w) * h * 4);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(x1, y1, w, h, GL_RGBA, GL_UNSIGNED_BYTE, &buf[0]);
+  if (glGetError() != GL_NO_ERROR) return false;
+
+  // GL rows are bottom up
+  rgba.resize(buf.size());
+  for (int j = 0; j < h; ++j)
+    memcpy(&rgba[size_t(j) * w * 4], &buf[size_t(h-1 - j) * w * 4], w * 4);
+  return true;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 void UGlcontext::setClip(double x, double y, double width, double height) {
@@ -460,8 +490,10 @@ void UGlcontext::drawTex(const UGraph& g, const UHardImaGL* ni,
 {
   MAKE_CURRENT;
   
-  if (ni->texid == 0) {
-    if (ni->pixels) ni->createTexFromPixels(); //??? pouquoi pas fait dans setRaster?
+  // the texture is normally created by UGlresources::flush() before painting.
+  // it is created again if it belongs to another share group
+  if (ni->texid == 0 || ni->upload_pending || !isSharedWith(ni->texcontext)) {
+    if (ni->pixels) disp->getGlresources()->upload(ni);
     if (ni->getTexID() == 0) return;
   }
   
@@ -477,18 +509,135 @@ void UGlcontext::drawTex(const UGraph& g, const UHardImaGL* ni,
   //glColor4f(1.0, 1.0, 1.0, g.alpha);
   glColor4f(1.0, 1.0, 1.0, 1.); // g.color_rgba.getAlphaI());   // !!!!!??????
   
+  // the image may only occupy the top left corner of the texture
   glBindTexture(GL_TEXTURE_2D, ni->texid);
   glBegin(GL_POLYGON);
   glTexCoord2f(0.0, 0.0); glVertex2f(x1, y1);
-  glTexCoord2f(1.0, 0.0); glVertex2f(x2, y1);
-  glTexCoord2f(1.0, 1.0); glVertex2f(x2, y2);
-  glTexCoord2f(0.0, 1.0); glVertex2f(x1, y2);
+  glTexCoord2f(ni->tex_s, 0.0); glVertex2f(x2, y1);
+  glTexCoord2f(ni->tex_s, ni->tex_t); glVertex2f(x2, y2);
+  glTexCoord2f(0.0, ni->tex_t); glVertex2f(x1, y2);
   glEnd();
   //if (alpha >= 1.) glDisable(GL_BLEND);
   glDisable(GL_TEXTURE_2D);
   glPopAttrib();
 }
 
+// ==================================================== [Ubit Toolkit] =========
+
+// the headless display has no GL context: flush() is never called
+UGlresources::UGlresources(UDisp* d) : disp(d), tex_count(0), tex_memory(0),
+mipmap_generation(-1), deferred_uploads(!d || !d->getConf().headless) {}
+
+// the textures are not deleted here: they are destroyed with the glcontexts
+UGlresources::~UGlresources() {
+  for (set<const UHardImaGL*>::iterator i = uploads.begin(); i != uploads.end(); ++i)
+    (*i)->upload_pending = false;
+}
+
+void UGlresources::requestUpload(const UHardImaGL* ni) {
+  if (!ni || ni->upload_pending || !deferred_uploads) return;
+  ni->upload_pending = true;
+  uploads.insert(ni);
+}
+
+void UGlresources::cancelUpload(const UHardImaGL* ni) {
+  if (!ni || !ni->upload_pending) return;
+  ni->upload_pending = false;
+  uploads.erase(ni);
+}
+
+// the textures that are created when nothing is current (headless display)
+// belong to the default share group.
+bool UGlresources::isDefaultGroup(const UGlcontext* c) const {
+  return !c || (disp->default_context && c->isSharedWith(disp->default_context));
+}
+
+void UGlresources::releaseTexture(const UHardImaGL* ni) {
+  if (ni->texid == 0) return;
+  
+  if (isDefaultGroup(ni->texcontext)) {
+    deletions.push_back(ni->texid);
+    tex_count--;
+    tex_memory = (ni->texsize < tex_memory) ? tex_memory - ni->texsize : 0;
+  }
+  else {
+    // flush() deletes textures in the default share group: this texture is
+    // deleted now, in the context that created it
+    const UGlcontext* current = disp->current_glcontext;
+    if (current != ni->texcontext) ni->texcontext->makeCurrent();
+    glDeleteTextures(1, &ni->texid);
+    if (current && current != ni->texcontext) current->makeCurrent();
+    others.erase(ni);
+  }
+  ni->texid = 0;
+  ni->texsize = 0;
+  ni->texcontext = null;
+}
+
+// the textures of a context that does not share its resources are destroyed with it.
+void UGlresources::releaseContext(const UGlcontext* c) {
+  for (set<const UHardImaGL*>::iterator i = others.begin(); i != others.end(); ) {
+    const UHardImaGL* ni = *i;
+    if (ni->texcontext != c) ++i;
+    else {
+      ni->texid = 0;
+      ni->texsize = 0;
+      ni->texcontext = null;
+      others.erase(i++);
+    }
+  }
+}
+
+// textures can only be updated partially if GL generates their mipmaps (GL 1.4)
+static bool hasMipmapGeneration() {
+  const char* version = (const char*)glGetString(GL_VERSION);
+  int major = 0, minor = 0;
+  if (!version || sscanf(version, "%d.%d", &major, &minor) < 2) return false;
+  return major > 1 || (major == 1 && minor >= 4);
+}
+
+void UGlresources::upload(const UHardImaGL* ni) {
+  cancelUpload(ni);
+  const UGlcontext* current = disp->current_glcontext;
+  bool same_group = ni->texcontext == current 
+  || (current && current->isSharedWith(ni->texcontext));
+  
+  // only the modified area is uploaded if possible (the texture is reused)
+  if (ni->texid != 0 && same_group && !ni->tex_scaled && ni->dirty_x2 > ni->dirty_x1) {
+    ni->updateTexFromPixels();
+    return;
+  }
+  // the pixels have been modified or the texture belongs to another share group
+  if (ni->texid != 0) releaseTexture(ni);
+
+  if (mipmap_generation < 0) mipmap_generation = hasMipmapGeneration();
+  ni->createTexFromPixels(!mipmap_generation);
+  if (ni->texid != 0) {
+    ni->texcontext = current;
+    if (!isDefaultGroup(current)) others.insert(ni);
+    else {
+      tex_count++;
+      tex_memory += ni->texsize;
+    }
+  }
+}
+
+void UGlresources::flush() {
+  if (!uploads.empty()) {
+    set<const UHardImaGL*> l;
+    l.swap(uploads);
+    for (set<const UHardImaGL*>::iterator i = l.begin(); i != l.end(); ++i) {
+      (*i)->upload_pending = false;
+      upload(*i);
+    }
+  }
+  // done last because upload() releases the previous textures
+  if (!deletions.empty()) {
+    glDeleteTextures(GLsizei(deletions.size()), &deletions[0]);
+    deletions.clear();
+  }
+}
+
 /* without textures
  void UGlcontext::drawTex(URenderContext* ge, const UHardIma& ima,
  float x, float y, float width, float height) {
@@ -18,6 +18,8 @@
 
 #ifndef _UGlcontext_hpp_
 #define	_UGlcontext_hpp_ 1
+#include <vector>
+#include <set>
 #include <ubit/ugl.hpp>
 #include <ubit/nat/urendercontext.hpp>
 namespace ubit {
@@ -37,6 +39,7 @@ public:
   virtual UGlcontext* toGlcontext() {return this;}
   virtual const UGlcontext* toGlcontext() const {return this;}
   virtual bool isSharedWith(const URenderContext*) const;
+  ///< true if this context shares its resources (textures, display lists) with this argument.
 
   virtual void setDest(UHardwinImpl* destination, double xoffset, double yoffset);
   virtual void setOffset(double x, double y);
@@ -68,9 +71,16 @@ public:
                         double delta_x, double delta_y,
                         bool generate_refresh_events_when_obscured) const;
   ///< not available with OpenGL.
+
+  virtual bool readPixels(double x, double y, int w, int h,
+                          std::vector<unsigned char>& rgba) const;
+  ///< reads the current read buffer (the back buffer in double buffering mode).
   
 private:
   double win_height, cx, cy;  // offset from 'dest' origin with cy converted to lower bound
+  // the context that created the share group of this context (this context if
+  // it was not created with a sharelists). only compared, never dereferenced.
+  const UGlcontext* sharegroup;
 #if UBIT_WITH_X11
   friend class UDispX11;
   GLXContext glxcontext;
@@ -80,6 +90,83 @@ private:
   void drawTex(const UGraph&, const UHardImaGL*, double x, double y, double width, double height) const;
 };
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/** [Impl] GL resources that are shared by the GL contexts of a display.
+ * the textures of the images (see UHardImaGL) belong to the share group of the
+ * default context of the display: they are created once and can be drawn by all
+ * the contexts that share their resources with this context (this is the case of
+ * the windows of the display and, by default, of UGlcanvas widgets). Fonts are
+ * also created in this share group (see UDisp::getFont()).
+ *
+ * Textures are not uploaded or deleted when images are modified, but at the
+ * beginning of the next paint (see flush()), so that these GL calls are grouped
+ * and performed in a context of the share group. An image is uploaded immediately
+ * if it is drawn before that. Uploads are not requested with the headless display,
+ * which never flushes: the textures are then created when the images are drawn. When the pixels of an image are modified, its
+ * texture is reused and only the modified area is uploaded.
+ *
+ * An image that is drawn by a context that does not share its resources with the
+ * default context (see UGlcanvas::shareResources()) has its texture created in
+ * this context. This texture is not counted in the resources of the display and
+ * it is deleted immediately, in this context, when it is released.
+ */
+class UGlresources {
+public:
+  UGlresources(UDisp*);
+  ~UGlresources();
+  
+  void flush();
+  /**< uploads the pending textures and deletes the released textures.
+   * a context of the share group of the default context must be current.
+   */
+  
+  void upload(const UHardImaGL*);
+  /**< creates or updates the texture of this image in the current context.
+   * only the modified area of the image is uploaded if the texture already exists
+   * (see UHardImaGL::invalidate()). This requires GL 1.4 (the mipmaps are generated
+   * by GL). Otherwise, the texture is created again.
+   */
+  
+  void requestUpload(const UHardImaGL*);
+  /**< the texture of this image will be created or updated by the next flush().
+   * does nothing with the headless display (see above).
+   */
+  
+  void cancelUpload(const UHardImaGL*);
+  ///< cancels requestUpload() (the image is being deleted).
+  
+  void releaseTexture(const UHardImaGL*);
+  /**< releases the texture of this image.
+   * the texture is deleted by the next flush() if it belongs to the share group of
+   * the default context, and immediately in the context that created it otherwise.
+   */
+  
+  void releaseContext(const UGlcontext*);
+  ///< forgets the textures that were created by this context (it is being deleted).
+  
+  int getTextureCount() const {return tex_count;}
+  ///< returns the number of textures that are resident in the share group of the default context.
+  
+  unsigned long getTextureMemory() const {return tex_memory;}
+  ///< returns the approximate size of these textures, in bytes (including mipmaps).
+  
+  int getPendingUploadCount() const {return (int)uploads.size();}
+  int getPendingDeleteCount() const {return (int)deletions.size();}
+  
+private:
+  UGlresources(const UGlresources&);
+  UGlresources& operator=(const UGlresources&);
+  UDisp* disp;
+  std::set<const UHardImaGL*> uploads;      // images whose texture must be created
+  std::vector<GLuint> deletions;            // textures that must be deleted
+  std::set<const UHardImaGL*> others;       // images whose texture is in another share group
+  int tex_count;
+  unsigned long tex_memory;
+  signed char mipmap_generation;  // GL generates mipmaps (-1 if not yet known)
+  bool deferred_uploads;          // false if nothing calls flush()
+  bool isDefaultGroup(const UGlcontext*) const;
+};
+
 }
 #endif
 #endif
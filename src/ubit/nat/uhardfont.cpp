@@ -15,6 +15,7 @@
  * ***********************************************************************/
 
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <ubit/ubit_features.h>
 #include <ubit/ustr.hpp>
@@ -24,6 +25,7 @@
 #include <ubit/nat/udispX11.hpp>
 //#include <ubit/nat/udispGDK.hpp>
 #include <ubit/nat/uhardfont.hpp>
+#include <ubit/nat/uheadlesscontext.hpp>
 
 #if UBIT_WITH_GL && UBIT_WITH_FREETYPE
 #    include <FTGL/ftgl.h>  // FTGL
@@ -38,7 +40,7 @@ NAMESPACE_UBIT
 
 
 UHardFont::UHardFont(UDisp* nd, const UFontDesc& fd)  // glcontext dependent!!!
-: status(NO_FONT), count(1)
+: status(NO_FONT), count(1), bitmap_scale(1.), bitmap_bold(false)
 #if WITH_2D_GRAPHICS
   ,sysf(0)
 #endif
@@ -46,6 +48,14 @@ UHardFont::UHardFont(UDisp* nd, const UFontDesc& fd)  // glcontext dependent!!!
   ,ftf(null)
 #endif
 {
+  if (nd->getConf().headless) {
+    // the headless display draws the built-in bitmap font (no window system is available)
+    if (fd.actual_size > 0) bitmap_scale = float(fd.actual_size) / UHeadlessContext::GLYPH_SIZE;
+    bitmap_bold = (fd.styles & UFont::BOLD) != 0;
+    status = BITMAP_FONT;
+    return;
+  }
+
   if (UAppli::conf.is_using_freetype) {
 #ifdef UBIT_WITH_GL
     ftf = loadFTGLFont(nd, fd);     // glcontext dependent!!!
@@ -98,6 +108,7 @@ UHardFont::~UHardFont() {     // glcontext dependent!!!
 /* ==================================================== ===== ======= */
 
 float UHardFont::getAscent() const {
+  if (status == BITMAP_FONT) return UHeadlessContext::GLYPH_ASCENT * bitmap_scale;
 #if UBIT_WITH_GL
   if (UAppli::conf.is_using_freetype) return ftf->Ascender();
 #endif
@@ -108,6 +119,7 @@ float UHardFont::getAscent() const {
 }
 
 float UHardFont::getDescent() const {
+  if (status == BITMAP_FONT) return UHeadlessContext::GLYPH_DESCENT * bitmap_scale;
 #if UBIT_WITH_GL
   if (UAppli::conf.is_using_freetype) return -ftf->Descender();  //att: Descender() is < 0 !
 #endif
@@ -118,6 +130,7 @@ float UHardFont::getDescent() const {
 }
 
 float UHardFont::getHeight() const {
+  if (status == BITMAP_FONT) return UHeadlessContext::GLYPH_SIZE * bitmap_scale;
 #if UBIT_WITH_GL
   if (UAppli::conf.is_using_freetype) return ftf->Ascender() - ftf->Descender(); //att: Descender() is < 0 !
 #endif
@@ -165,6 +178,7 @@ static int CharWidth(XFontStruct* f, char _c) {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 float UHardFont::getWidth(char c) const {
+  if (status == BITMAP_FONT) return UHeadlessContext::GLYPH_ADVANCE * bitmap_scale;
 #if UBIT_WITH_GL
   if (UAppli::conf.is_using_freetype) {
     char s[2];
@@ -188,6 +202,10 @@ float UHardFont::getWidth(char c) const {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 float UHardFont::getWidth(const char* s, int len) const {
+  if (status == BITMAP_FONT) {
+    if (len < 0) len = s ? strlen(s) : 0;
+    return len * UHeadlessContext::GLYPH_ADVANCE * bitmap_scale;
+  }
 #if UBIT_WITH_GL
   if (UAppli::conf.is_using_freetype) {
     return ftf->Advance(s, len);  // ELC: 'len' rajoute a Advance()
@@ -34,7 +34,7 @@ namespace ubit {
 */
 class UHardFont {
 public:
-  enum {NO_FONT=0, SYS_FONT, GLX_FONT, FTGL_FONT};
+  enum {NO_FONT=0, SYS_FONT, GLX_FONT, FTGL_FONT, BITMAP_FONT};
 
   UHardFont(UDisp*, const UFontDesc&);
   ~UHardFont();
@@ -52,7 +52,10 @@ public:
 private:
   friend class UDisp;
   friend class UGraph;
+  friend class UHeadlessContext;
   short status, count;
+  float bitmap_scale;   // BITMAP_FONT: scale of the built-in font (@see UHeadlessContext)
+  bool bitmap_bold;
 
 #if UBIT_WITH_GL
   union {
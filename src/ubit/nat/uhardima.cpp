@@ -20,6 +20,7 @@
 #include <ubit/ubit_features.h>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
 #include <ubit/ufile.hpp>
 #include <ubit/ucall.hpp>
 #include <ubit/ucolor.hpp>
@@ -28,6 +29,10 @@
 #include <ubit/ustr.hpp>
 #include <ubit/uappli.hpp>
 #include <ubit/nat/uhardima.hpp>
+#include <ubit/nat/uglcontext.hpp>
+#if UBIT_WITH_GL && !defined(GL_GENERATE_MIPMAP)
+#  define GL_GENERATE_MIPMAP 0x8191
+#endif
 
 #if UBIT_WITH_X11 
 #  include <ubit/nat/udispX11.hpp>
@@ -100,6 +105,15 @@ UHardImaGL::UHardImaGL(UDisp* d, int w, int h, int transparency_hint) {
   disp = d;
   pixels = null;
   texid = 0;
+  texcontext = null;
+  texsize = 0;
+  upload_pending = false;
+  tex_scaled = false;
+  tex_s = tex_t = 1.;
+  tex_width = tex_height = 0;
+  dirty_x1 = dirty_y1 = dirty_x2 = dirty_y2 = 0;
+  padding = null;
+  padding_size = 0;
   setRaster(w, h, transparency_hint);
 }
 
@@ -115,9 +129,55 @@ UHardImaGL::UHardImaGL(UDisp* nd, unsigned char* _glpix, int w, int h) {
 }
 */
 
-UHardImaGL::~UHardImaGL() {      // glcontext dependent!!!
+UHardImaGL::~UHardImaGL() {
   delete[] pixels;
-  if (texid != 0) glDeleteTextures(1, &texid);
+  delete[] padding;
+  if (upload_pending && disp && !UAppli::isExiting()) 
+    disp->getGlresources()->cancelUpload(this);
+  releaseTex();
+}
+
+// the texture is deleted by UGlresources in the share group where it was created
+// (the current context may not belong to this share group).
+// nothing is done when the appli is exiting as the glcontexts may be destroyed.
+void UHardImaGL::releaseTex() {
+  if (texid != 0 && disp && !UAppli::isExiting())
+    disp->getGlresources()->releaseTexture(this);
+  texid = 0;
+  texcontext = null;
+  texsize = 0;
+  dirty_x1 = dirty_y1 = dirty_x2 = dirty_y2 = 0;
+}
+
+// the texture is entirely created by the next upload if there is no texture yet
+void UHardImaGL::invalidate(int x, int y, int w, int h) {
+  if (x < 0) {w += x; x = 0;}
+  if (y < 0) {h += y; y = 0;}
+  if (x + w > width) w = width - x;
+  if (y + h > height) h = height - y;
+  if (!pixels || w <= 0 || h <= 0) return;
+  
+  if (texid != 0) {
+    if (dirty_x2 <= dirty_x1) {
+      dirty_x1 = x; dirty_y1 = y; dirty_x2 = x + w; dirty_y2 = y + h;
+    }
+    else {
+      dirty_x1 = min(dirty_x1, x); dirty_y1 = min(dirty_y1, y);
+      dirty_x2 = max(dirty_x2, x + w); dirty_y2 = max(dirty_y2, y + h);
+    }
+  }
+  if (disp && !UAppli::isExiting()) disp->getGlresources()->requestUpload(this);
+}
+
+bool UHardImaGL::swapPixels(UHardImaGL& ima) {
+  if (&ima == this || !pixels || !ima.pixels 
+      || ima.width != width || ima.height != height) return false;
+  unsigned char* p = pixels;
+  pixels = ima.pixels;
+  ima.pixels = p;
+  invalidate();
+  ima.invalidate();
+  return true;
 }
 
 bool UHardImaGL::isRealized() const {
@@ -127,9 +187,9 @@ bool UHardImaGL::isRealized() const {
 
 /* ==================================================== ===== ======= */
 
-void UHardImaGL::setRaster(int w, int h, int transparency_hint) {   // glcontext dependent!!!
+void UHardImaGL::setRaster(int w, int h, int transparency_hint) {
   delete[] pixels;
-  if (texid != 0) glDeleteTextures(1, &texid);
+  releaseTex();
 
   if (w > 0 && h > 0) {
     width = w; height = h;
@@ -138,38 +198,37 @@ void UHardImaGL::setRaster(int w, int h, int transparency_hint) {   // glcontext
     // but seems to be OK if another line is added
     // pixels = new unsigned char[w * h * bpp/8];
     pixels = new unsigned char[w * (h+1) * bpp/8];
-    texid = 0;                                // ... ??? !!!!@@@@@ createText?
+    // the texture is created at the next paint, when the pixels have been set
+    if (disp && !UAppli::isExiting()) disp->getGlresources()->requestUpload(this);
   }
   else {
     width = height = 0;
     bpp = 0; transparency = 0;
     pixels = null;
-    texid = 0;
   }
 }
 
-void UHardImaGL::setRasterAndAdopt(unsigned char* pixbuf, int w, int h) {   // glcontext dependent!!!
+void UHardImaGL::setRasterAndAdopt(unsigned char* pixbuf, int w, int h) {
   delete[] pixels;
-  if (texid != 0) glDeleteTextures(1, &texid);
+  releaseTex();
 
   if (pixbuf && w > 0 && h > 0) {
     width = w; height = h;
     bpp = 32; transparency = 8;
     pixels = pixbuf;
-    texid = 0;                                // ... ??? !!!!@@@@@ createText?
+    if (disp && !UAppli::isExiting()) disp->getGlresources()->requestUpload(this);
   }
   else {
     width = height = 0;
     bpp = 0; transparency = 0;
     pixels = null;
-    texid = 0;
   }  
 }
 
 /* ==================================================== ===== ======= */
 #if WITH_2D_GRAPHICS
 
-void UHardImaGL::setRasterAndAdopt(USysIma ima, USysIma imashape) {   // glcontext dependent!!!
+void UHardImaGL::setRasterAndAdopt(USysIma ima, USysIma imashape) {
 #if UBIT_WITH_X11
   UDispX11* d = (UDispX11*)disp;
 #else
@@ -177,13 +236,12 @@ void UHardImaGL::setRasterAndAdopt(USysIma ima, USysIma imashape) {   // glconte
 #endif
   
   delete[] pixels;
-  if (texid != 0) glDeleteTextures(1, &texid);
+  releaseTex();
 
   if (!ima) {
     width = height = 0; 
     bpp = 0; transparency = 0;
     pixels = null;
-    texid = 0;
   }
   
   else {
@@ -212,7 +270,7 @@ void UHardImaGL::setRasterAndAdopt(USysIma ima, USysIma imashape) {   // glconte
       }
     }
   
-    texid = 0;                                // ... ??? !!!!@@@@@ createText?
+    if (!UAppli::isExiting()) disp->getGlresources()->requestUpload(this);
   }
   
   if (ima) DestroyImage(ima);
@@ -236,9 +294,27 @@ UHardIma* UHardImaGL::createScaledClone(float xscale, float yscale, UDisp* to_nd
 
 /* ==================================================== ===== ======= */
 
-void UHardImaGL::createTexFromPixels() const {   // glcontext dependent!!!
+// creates the texture in the current glcontext: must only be called by UGlresources
+// (which deletes the previous texture and accounts for 'texsize').
+// - if 'scaled' is true, the image is scaled to the size of the texture by
+//   gluBuild2DMipmaps(), which does not allow partial updates.
+// - otherwise, the image is copied in the top left corner of the texture and the
+//   mipmaps are generated by GL (GL 1.4), so that glTexSubImage2D() can be used
+//   (see uploadTexArea()).
+void UHardImaGL::createTexFromPixels(bool scaled) const {   // glcontext dependent!!!
   if (!pixels) return;
-  if (texid != 0) glDeleteTextures(1, &texid);
+  
+  // the size of the texture is a power of 2, mipmaps add 1/3
+  GLint maxsize = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxsize);
+  int tw = 1, th = 1;
+  while (tw < width) tw <<= 1;
+  while (th < height) th <<= 1;
+  if (tw > maxsize || th > maxsize) scaled = true;
+  texsize = (unsigned long)tw * th * 4 * 4 / 3;
+  tex_width = tw;
+  tex_height = th;
+  dirty_x1 = dirty_y1 = dirty_x2 = dirty_y2 = 0;
 
   glGenTextures(1, &texid);
   glBindTexture(GL_TEXTURE_2D, texid);
@@ -247,8 +323,93 @@ void UHardImaGL::createTexFromPixels() const {   // glcontext dependent!!!
   //glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
   //glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
   //GLenum format = (alpha==0 ? GL_RGB : GL_RGBA);
-  gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGBA, width, height,
-                    GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+  if (scaled) {
+    tex_scaled = true;
+    tex_s = tex_t = 1.;
+    tex_width = width;
+    tex_height = height;
+    gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGBA, width, height,
+                      GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    return;
+  }
+  
+  tex_scaled = false;
+  tex_s = float(width) / tw;
+  tex_t = float(height) / th;
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tw, th, 0, GL_RGBA, GL_UNSIGNED_BYTE, null);
+  glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+  uploadTexArea(0, 0, width, height);
+}
+
+// uploads this area of the image in the texture. The texture is larger than the
+// image if its size is not a power of 2: the last column and the last row of the
+// image are then replicated in the rest of the texture so that neither linear
+// filtering nor the generated mipmaps blend the borders of the image with
+// undefined texels. The area is uploaded from 'pixels' and the padding is only
+// uploaded if the area touches the last column or the last row.
+void UHardImaGL::uploadTexArea(int x, int y, int w, int h) const {
+  bool right = (x + w == width && tex_width > width);
+  bool bottom = (y + h == height && tex_height > height);
+  glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  
+  // the mipmaps are generated again by each upload: only by the last one here
+  if (right || bottom) glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+  glPixelStorei(GL_UNPACK_SKIP_PIXELS, x);
+  glPixelStorei(GL_UNPACK_SKIP_ROWS, y);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+  glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+  
+  const unsigned int* pix = (const unsigned int*)pixels;
+  
+  if (right) {          // the last column, on the rows of the area
+    int pw = tex_width - width;
+    unsigned int* p = getPadding(pw * h);
+    for (int j = y; j < y + h; ++j) {
+      unsigned int val = pix[j * width + width - 1];
+      for (int i = 0; i < pw; ++i) *p++ = val;
+    }
+    if (!bottom) glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, width, y, pw, h, GL_RGBA, GL_UNSIGNED_BYTE, padding);
+  }
+  
+  if (bottom) {         // the last row, on the columns of the area and their padding
+    int x2 = right ? tex_width : x + w, ph = tex_height - height;
+    const unsigned int* row = pix + (height - 1) * width;
+    unsigned int* p = getPadding((x2 - x) * ph);
+    for (int j = 0; j < ph; ++j) {
+      for (int i = x; i < x2; ++i) *p++ = row[std::min(i, width - 1)];
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, height, x2 - x, ph, GL_RGBA, GL_UNSIGNED_BYTE, padding);
+  }
+  glPopClientAttrib();
+}
+
+// returns the staging buffer of the padding, which is reused by the next uploads.
+unsigned int* UHardImaGL::getPadding(int size) const {
+  if (size > padding_size) {
+    delete[] padding;
+    padding = new unsigned int[size];
+    padding_size = size;
+  }
+  return padding;
+}
+
+// uploads the modified area of the image in its texture (see invalidate()).
+void UHardImaGL::updateTexFromPixels() const {   // glcontext dependent!!!
+  if (!pixels || texid == 0 || tex_scaled || dirty_x2 <= dirty_x1) return;
+  int x = dirty_x1, y = dirty_y1, w = dirty_x2 - dirty_x1, h = dirty_y2 - dirty_y1;
+  dirty_x1 = dirty_y1 = dirty_x2 = dirty_y2 = 0;
+  
+  glBindTexture(GL_TEXTURE_2D, texid);
+  uploadTexArea(x, y, w, h);
 }
 
 /* sans MipMaps
@@ -165,17 +165,45 @@ namespace ubit {
     // USysPixel getPixel(int x, int y);
     // void setPixel(USysPixel p, int x, int y);
     
+    void invalidate(int x, int y, int width, int height);
+    /**< specifies that the pixels of this area have been modified.
+     * the texture is updated before the next paint. Only this area is uploaded
+     * (with glTexSubImage2D) if the texture was not scaled (see UGlresources).
+     */
+    
+    void invalidate() {invalidate(0, 0, width, height);}
+    ///< specifies that all the pixels have been modified: the texture is reused.
+    
+    bool swapPixels(UHardImaGL& ima);
+    /**< exchanges the pixels of these images, which must have the same size.
+     * the textures are reused and updated. returns false if the sizes differ.
+     */
+    
     virtual float getScale() const {return 1.;}
     
     GLuint getTexID() const {return texid;}
     
   protected:
     friend class UGlcontext;
+    friend class UGlresources;
     // inherited int width, height; ATTENTION: taille LOGIQUE de l'image, pas de 
     // la texture, qui est toujours une puissance de 2!
     unsigned char* pixels;   // image data for OpenGL
-    mutable GLuint texid;    // texture ID
-    void createTexFromPixels() const;
+    mutable GLuint texid;    // texture ID (in the share group of 'texcontext')
+    mutable const UGlcontext* texcontext; // context that created the texture (see UGlresources)
+    mutable unsigned long texsize;  // approximate size of the texture, in bytes
+    mutable bool upload_pending;    // true if UGlresources will create or update the texture
+    mutable bool tex_scaled;        // true if the image was scaled to the size of the texture
+    mutable float tex_s, tex_t;     // texture coordinates of the bottom right corner of the image
+    mutable int tex_width, tex_height;  // size of the texture (a power of 2)
+    mutable int dirty_x1, dirty_y1, dirty_x2, dirty_y2; // modified area (empty if dirty_x2 <= dirty_x1)
+    mutable unsigned int* padding;  // staging buffer of the padding of the texture
+    mutable int padding_size;       // size of this buffer, in pixels
+    void createTexFromPixels(bool scaled) const;
+    void updateTexFromPixels() const;
+    void uploadTexArea(int x, int y, int w, int h) const;
+    unsigned int* getPadding(int size) const;
+    void releaseTex();
   };
   
 #endif // UBIT_WITH_GL
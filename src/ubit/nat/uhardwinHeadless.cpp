@@ -0,0 +1,140 @@
+/* ***********************************************************************
+ *
+ *  uhardwinHeadless.cpp: windows of the headless display
+ *  Ubit GUI Toolkit - Version 6.0
+ *  (C) 2009 Eric Lecolinet | ENST Paris | www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#include <ubit/ubit_features.h>
+#include <cstdio>
+#include <ubit/uappli.hpp>
+#include <ubit/uwin.hpp>
+#include <ubit/uview.hpp>
+#include <ubit/nat/udispHeadless.hpp>
+using namespace std;
+#define NAMESPACE_UBIT namespace ubit {
+NAMESPACE_UBIT
+
+UHardwinHeadless::UHardwinHeadless(UDispHeadless* d, UWin* w)
+: UHardwinImpl(d, w), realized(false), shown(false), x(0), y(0), width(0), height(0) {
+}
+
+UHardwinHeadless::~UHardwinHeadless() {}
+
+void UHardwinHeadless::realize(WinType wtype, float w, float h) {
+  if (isRealized()) return;
+  wintype = wtype;  // must be done first!
+
+  if (wtype == PIXMAP) {
+    UAppli::error("UHardwinHeadless","type PIXMAP not implemented for the headless display");
+    return;
+  }
+  if (!isHardwin()) {
+    UAppli::error("UHardwinHeadless","wrong type for this function: %d", wtype);
+    return;
+  }
+  realized = true;
+  setSize(UDimension(w, h));
+}
+
+// the framebuffer is white, as a newly mapped window
+void UHardwinHeadless::clear() {
+  pixels.assign(size_t(width) * height * 4, 255);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+void UHardwinHeadless::show(bool state) {
+  if (!realized || state == shown) return;
+  shown = state;
+  // same as the Expose event that X11 sends when a window is mapped
+  if (shown && win) {
+    UView* winview = win->getWinView(disp);
+    if (winview) disp->onPaint(winview, 0, 0, width, height);
+  }
+}
+
+// the exposures are kept at their old location (see UHardwinImpl::shiftExposes())
+void UHardwinHeadless::shiftExposes(const URect& area, float dx, float dy) {
+  if (dx == 0 && dy == 0) return;
+  for (unsigned int k = 0, count = exposes.size(); k < count; ++k) {
+    URect r(exposes[k].x + dx, exposes[k].y + dy, exposes[k].width, exposes[k].height);
+    if (r.doIntersection(area)) exposes.push_back(r);
+  }
+}
+
+// windows do not overlap
+void UHardwinHeadless::toBack() {}
+void UHardwinHeadless::toFront() {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+UPoint UHardwinHeadless::getPos() const {
+  return UPoint(x, y);
+}
+
+void UHardwinHeadless::setPos(const UPoint& p) {
+  x = int(p.x);
+  y = int(p.y);
+}
+
+// subwindows are positioned relatively to their parent
+UPoint UHardwinHeadless::getScreenPos() const {
+  UPoint pos(x, y);
+  if (wintype == SUBWIN && win) {
+    UWin* parw = dynamic_cast<UWin*>(win->getParent(0));
+    UHardwinImpl* parhw = parw ? parw->getHardwin(disp) : null;
+    if (parhw && parhw != this) {
+      UPoint ppos = parhw->getScreenPos();
+      pos.set(pos.x + ppos.x, pos.y + ppos.y);
+    }
+  }
+  return pos;
+}
+
+UDimension UHardwinHeadless::getSize() const {
+  return UDimension(width, height);
+}
+
+void UHardwinHeadless::setSize(const UDimension& size) {
+  int w = size.width > 0 ? int(size.width) : 1;
+  int h = size.height > 0 ? int(size.height) : 1;
+  if (w == width && h == height && !pixels.empty()) return;
+  width = w;
+  height = h;
+  clear();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+bool UHardwinHeadless::writePPM(const UStr& filename) const {
+  if (pixels.empty()) return false;
+  FILE* f = fopen(filename.c_str(), "wb");
+  if (!f) return false;
+  fprintf(f, "P6\n%d %d\n255\n", width, height);
+
+  vector<unsigned char> line(width * 3);
+  bool ok = true;
+  for (int j = 0; j < height && ok; ++j) {
+    const unsigned char* p = &pixels[size_t(j) * width * 4];
+    for (int i = 0; i < width; ++i, p += 4) {
+      line[i*3] = p[0];
+      line[i*3+1] = p[1];
+      line[i*3+2] = p[2];
+    }
+    ok = fwrite(&line[0], 1, line.size(), f) == line.size();
+  }
+  if (fclose(f) != 0) ok = false;
+  return ok;
+}
+
+}
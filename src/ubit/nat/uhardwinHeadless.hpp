@@ -0,0 +1,94 @@
+/* ***********************************************************************
+ *
+ *  uhardwinHeadless.hpp: windows of the headless display
+ *  Ubit GUI Toolkit - Version 6.0
+ *  (C) 2009 Eric Lecolinet | ENST Paris | www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#ifndef UHardwinHeadless_hpp
+#define	UHardwinHeadless_hpp 1
+#include <vector>
+#include <ubit/udisp.hpp>
+#include <ubit/uwinImpl.hpp>
+namespace ubit {
+
+class UDispHeadless;
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+/** headless window: the window is rendered in an RGBA framebuffer.
+ * the framebuffer is created when the window is realized and resized with it;
+ * its pixels are stored line by line from the top left corner, with 4 bytes
+ * (red, green, blue, alpha) per pixel.
+ */
+class UHardwinHeadless : public UHardwinImpl {
+public:
+  UHardwinHeadless(UDispHeadless*, UWin*);
+  virtual ~UHardwinHeadless();
+
+  UDispHeadless* getDispHeadless() const {return (UDispHeadless*)disp;}
+
+  const unsigned char* getPixels() const {return pixels.empty() ? null : &pixels[0];}
+  ///< returns the framebuffer (null if the window is not realized).
+
+  int getWidth()  const {return width;}
+  int getHeight() const {return height;}
+  ///< returns the size of the framebuffer.
+
+  bool isShown() const {return shown;}
+
+  bool writePPM(const UStr& filename) const;
+  /**< saves the framebuffer in a (binary) PPM file.
+   * the alpha channel is not saved. Returns false if the file can't be written.
+   */
+
+  virtual void realize(WinType, float w, float h);
+  virtual bool isRealized() const {return realized;}
+
+  virtual void show(bool);
+  ///< note that the window is painted when it is shown for the first time.
+
+  virtual void toBack();
+  virtual void toFront();
+
+  virtual UPoint getScreenPos() const;
+  virtual UPoint getPos() const;
+  virtual void setPos(const UPoint&);
+
+  virtual UDimension getSize() const;
+  virtual void setSize(const UDimension&);
+  ///< changes window size (the content of the framebuffer is lost).
+
+  virtual UStr getTitle() const {return title;}
+  virtual void setTitle(const UStr& s) {title = s;}
+  virtual UStr getIconTitle() const {return icon_title;}
+  virtual void setIconTitle(const UStr& s) {icon_title = s;}
+
+  virtual void setCursor(const UCursor*) {}
+  virtual void setClassProperty(const UStr& instance_name, const UStr& class_name) {}
+  ///< no action with the headless display.
+
+  virtual void shiftExposes(const URect& area, float dx, float dy);
+  ///< shifts the exposures that have not been painted (see UDispHeadless::expose()).
+
+protected:
+  friend class UDispHeadless;
+  friend class UHeadlessContext;
+  void clear();
+  bool realized, shown;
+  int x, y, width, height;
+  UStr title, icon_title;
+  std::vector<unsigned char> pixels;
+  std::vector<URect> exposes;    // pending exposures (see UDispHeadless::expose())
+};
+
+}
+#endif
@@ -19,12 +19,15 @@
 
 #include <iostream>
 #include <cstdio>
+#include <cmath>
+#include <vector>
 #include <ubit/uappli.hpp>
 #include <ubit/ucall.hpp>
 #include <ubit/uon.hpp>
 #include <ubit/ustr.hpp>
 #include <ubit/ucursor.hpp>
 #include <ubit/uwin.hpp>
+#include <ubit/umessage.hpp>
 //#include <ubit/umsproto.hpp>
 #include <ubit/nat/udispX11.hpp>
 using namespace std;
@@ -207,6 +210,39 @@ void UHardwinX11::setClassProperty(const UStr& res_name, const UStr& res_class)
   }
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+// the exposures that are still in the event queue refer to the pixels that were
+// damaged before the copy: they are repainted at both locations.
+void UHardwinX11::shiftExposes(const URect& area, float dx, float dy) {
+  if (sys_win == None || (dx == 0 && dy == 0)) return;
+  XSync(SYS_DISP, False);   // the exposures that are sent by the server
+
+  std::vector<XEvent> exposes;
+  XEvent e;
+  while (XCheckTypedWindowEvent(SYS_DISP, sys_win, Expose, &e)
+         || XCheckTypedWindowEvent(SYS_DISP, sys_win, GraphicsExpose, &e)) {
+    exposes.push_back(e);
+    URect r = (e.type == Expose) ?
+    URect(e.xexpose.x, e.xexpose.y, e.xexpose.width, e.xexpose.height)
+    : URect(e.xgraphicsexpose.x, e.xgraphicsexpose.y,
+            e.xgraphicsexpose.width, e.xgraphicsexpose.height);
+    r.x += dx;
+    r.y += dy;
+    if (!r.doIntersection(area)) continue;
+    // a GraphicsExpose event, which has the same fields as an Expose event
+    e.type = GraphicsExpose;
+    e.xgraphicsexpose.drawable = sys_win;
+    e.xgraphicsexpose.x = int(r.x);
+    e.xgraphicsexpose.y = int(r.y);
+    e.xgraphicsexpose.width = int(ceil(r.width));
+    e.xgraphicsexpose.height = int(ceil(r.height));
+    e.xgraphicsexpose.count = 0;
+    exposes.push_back(e);
+  }
+  // XPutBackEvent() inserts the events at the head of the queue
+  for (int k = int(exposes.size()) - 1; k >= 0; --k) XPutBackEvent(SYS_DISP, &exposes[k]);
+}
 
 /*
 void UHardwinX11::setNames(const UStr& res_class, const UStr& res_name, 
@@ -370,6 +406,10 @@ void UHardwinX11::realize(WinType wtype, float w, float h) {
     unsigned char winid[2] = {wtype, 0};
     XChangeProperty(d->sys_disp, sys_win, atoms.UMS_WINDOW,
                     XA_STRING, 8/*format*/, PropModeReplace, winid, 2);  
+
+    // the other applications of this host send messages to this socket
+    if (UAppli::getMessagePortMap()) 
+      UAppli::getMessagePortMap()->publishLocalSocket(*this);
   }
   
   // l'iconification du MainFrame entraine l'iconification de ce Dialog
@@ -82,6 +82,9 @@ public:
   virtual void setClassProperty(const UStr& instance_name, const UStr& class_name);
   ///< changes the WM_CLASS property.
   
+  virtual void shiftExposes(const URect& area, float dx, float dy);
+  ///< shifts the Expose and GraphicsExpose events that are in the event queue.
+  
 protected:
   friend class UDispX11;
   friend class UGLcanvas;
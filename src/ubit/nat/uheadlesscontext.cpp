@@ -0,0 +1,482 @@
+/* ***********************************************************************
+ *
+ *  uheadlesscontext.cpp: rendering context of the headless display
+ *  Ubit GUI Toolkit - Version 6.0
+ *  (C) 2009 Eric Lecolinet | ENST Paris | www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#include <ubit/ubit_features.h>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <ubit/udefs.hpp>
+#include <ubit/uappli.hpp>
+#include <ubit/ugraph.hpp>
+#include <ubit/uima.hpp>
+#include <ubit/nat/uhardima.hpp>
+#include <ubit/nat/uhardfont.hpp>
+#include <ubit/nat/uhardwinHeadless.hpp>
+#include <ubit/nat/uheadlesscontext.hpp>
+using namespace std;
+#define NAMESPACE_UBIT namespace ubit {
+NAMESPACE_UBIT
+
+// built-in font: characters 32 to 126, one byte per row (the 5 low bits, the
+// leftmost pixel being the highest bit). Rows 0 to 6 are above the baseline.
+static const unsigned char glyphs[95][UHeadlessContext::GLYPH_ROWS] = {
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // ' '
+  {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00},  // '!'
+  {0x0a, 0x0a, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // '"'
+  {0x0a, 0x0a, 0x1f, 0x0a, 0x1f, 0x0a, 0x0a, 0x00, 0x00},  // '#'
+  {0x04, 0x0f, 0x14, 0x0e, 0x05, 0x1e, 0x04, 0x00, 0x00},  // '$'
+  {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03, 0x00, 0x00},  // '%'
+  {0x0c, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0d, 0x00, 0x00},  // '&'
+  {0x04, 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // '''
+  {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02, 0x00, 0x00},  // '('
+  {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08, 0x00, 0x00},  // ')'
+  {0x00, 0x04, 0x15, 0x0e, 0x15, 0x04, 0x00, 0x00, 0x00},  // '*'
+  {0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00, 0x00, 0x00},  // '+'
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x04, 0x08, 0x00},  // ','
+  {0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00, 0x00, 0x00},  // '-'
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c, 0x00, 0x00},  // '.'
+  {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00, 0x00, 0x00},  // '/'
+  {0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e, 0x00, 0x00},  // '0'
+  {0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e, 0x00, 0x00},  // '1'
+  {0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f, 0x00, 0x00},  // '2'
+  {0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e, 0x00, 0x00},  // '3'
+  {0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02, 0x00, 0x00},  // '4'
+  {0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e, 0x00, 0x00},  // '5'
+  {0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e, 0x00, 0x00},  // '6'
+  {0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08, 0x00, 0x00},  // '7'
+  {0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e, 0x00, 0x00},  // '8'
+  {0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c, 0x00, 0x00},  // '9'
+  {0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00, 0x00, 0x00},  // ':'
+  {0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x04, 0x08, 0x00, 0x00},  // ';'
+  {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02, 0x00, 0x00},  // '<'
+  {0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00, 0x00, 0x00},  // '='
+  {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08, 0x00, 0x00},  // '>'
+  {0x0e, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04, 0x00, 0x00},  // '?'
+  {0x0e, 0x11, 0x01, 0x0d, 0x15, 0x15, 0x0e, 0x00, 0x00},  // '@'
+  {0x0e, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11, 0x00, 0x00},  // 'A'
+  {0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e, 0x00, 0x00},  // 'B'
+  {0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e, 0x00, 0x00},  // 'C'
+  {0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c, 0x00, 0x00},  // 'D'
+  {0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f, 0x00, 0x00},  // 'E'
+  {0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10, 0x00, 0x00},  // 'F'
+  {0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f, 0x00, 0x00},  // 'G'
+  {0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11, 0x00, 0x00},  // 'H'
+  {0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e, 0x00, 0x00},  // 'I'
+  {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c, 0x00, 0x00},  // 'J'
+  {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11, 0x00, 0x00},  // 'K'
+  {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f, 0x00, 0x00},  // 'L'
+  {0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11, 0x00, 0x00},  // 'M'
+  {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11, 0x00, 0x00},  // 'N'
+  {0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e, 0x00, 0x00},  // 'O'
+  {0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10, 0x00, 0x00},  // 'P'
+  {0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d, 0x00, 0x00},  // 'Q'
+  {0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11, 0x00, 0x00},  // 'R'
+  {0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e, 0x00, 0x00},  // 'S'
+  {0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00},  // 'T'
+  {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e, 0x00, 0x00},  // 'U'
+  {0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04, 0x00, 0x00},  // 'V'
+  {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a, 0x00, 0x00},  // 'W'
+  {0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11, 0x00, 0x00},  // 'X'
+  {0x11, 0x11, 0x0a, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00},  // 'Y'
+  {0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f, 0x00, 0x00},  // 'Z'
+  {0x0e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0e, 0x00, 0x00},  // '['
+  {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00, 0x00, 0x00},  // backslash
+  {0x0e, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0e, 0x00, 0x00},  // ']'
+  {0x04, 0x0a, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // '^'
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x00},  // '_'
+  {0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},  // '`'
+  {0x00, 0x00, 0x0e, 0x01, 0x0f, 0x11, 0x0f, 0x00, 0x00},  // 'a'
+  {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1e, 0x00, 0x00},  // 'b'
+  {0x00, 0x00, 0x0e, 0x10, 0x10, 0x11, 0x0e, 0x00, 0x00},  // 'c'
+  {0x01, 0x01, 0x0d, 0x13, 0x11, 0x11, 0x0f, 0x00, 0x00},  // 'd'
+  {0x00, 0x00, 0x0e, 0x11, 0x1f, 0x10, 0x0e, 0x00, 0x00},  // 'e'
+  {0x06, 0x09, 0x08, 0x1c, 0x08, 0x08, 0x08, 0x00, 0x00},  // 'f'
+  {0x00, 0x00, 0x0f, 0x11, 0x11, 0x13, 0x0d, 0x01, 0x0e},  // 'g'
+  {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11, 0x00, 0x00},  // 'h'
+  {0x04, 0x00, 0x0c, 0x04, 0x04, 0x04, 0x0e, 0x00, 0x00},  // 'i'
+  {0x02, 0x00, 0x06, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c},  // 'j'
+  {0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12, 0x00, 0x00},  // 'k'
+  {0x0c, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e, 0x00, 0x00},  // 'l'
+  {0x00, 0x00, 0x1a, 0x15, 0x15, 0x11, 0x11, 0x00, 0x00},  // 'm'
+  {0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11, 0x00, 0x00},  // 'n'
+  {0x00, 0x00, 0x0e, 0x11, 0x11, 0x11, 0x0e, 0x00, 0x00},  // 'o'
+  {0x00, 0x00, 0x1e, 0x11, 0x11, 0x19, 0x16, 0x10, 0x10},  // 'p'
+  {0x00, 0x00, 0x0f, 0x11, 0x11, 0x13, 0x0d, 0x01, 0x01},  // 'q'
+  {0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10, 0x00, 0x00},  // 'r'
+  {0x00, 0x00, 0x0e, 0x10, 0x0e, 0x01, 0x1e, 0x00, 0x00},  // 's'
+  {0x08, 0x08, 0x1c, 0x08, 0x08, 0x09, 0x06, 0x00, 0x00},  // 't'
+  {0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0d, 0x00, 0x00},  // 'u'
+  {0x00, 0x00, 0x11, 0x11, 0x11, 0x0a, 0x04, 0x00, 0x00},  // 'v'
+  {0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0a, 0x00, 0x00},  // 'w'
+  {0x00, 0x00, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x00, 0x00},  // 'x'
+  {0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0d, 0x01, 0x0e},  // 'y'
+  {0x00, 0x00, 0x1f, 0x02, 0x04, 0x08, 0x1f, 0x00, 0x00},  // 'z'
+  {0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02, 0x00, 0x00},  // '{'
+  {0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00},  // '|'
+  {0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08, 0x00, 0x00},  // '}'
+  {0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00, 0x00, 0x00},  // '~'
+};
+
+static inline int ipos(double v) {return int(floor(v + 0.5));}
+
+// src-over blending of a color in a pixel of the framebuffer
+static inline void blend(unsigned char* p, const unsigned char* c) {
+  unsigned int a = c[3];
+  if (a == 255) {
+    p[0] = c[0]; p[1] = c[1]; p[2] = c[2]; p[3] = 255;
+  }
+  else if (a > 0) {
+    unsigned int na = 255 - a;
+    p[0] = (c[0] * a + p[0] * na + 127) / 255;
+    p[1] = (c[1] * a + p[1] * na + 127) / 255;
+    p[2] = (c[2] * a + p[2] * na + 127) / 255;
+    p[3] = a + (p[3] * na + 127) / 255;
+  }
+}
+
+UHeadlessContext::UHeadlessContext(UDisp* d) : URenderContext(d),
+color(0u, 0u, 0u, 255u), bgcolor(255u, 255u, 255u, 255u),
+xor_mode(false), line_width(1) {
+}
+
+UHeadlessContext::~UHeadlessContext() {}
+
+UHardwinHeadless* UHeadlessContext::getFramebuffer() const {
+  UHardwinHeadless* fb = static_cast<UHardwinHeadless*>(dest);
+  return (fb && !fb->pixels.empty()) ? fb : null;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+void UHeadlessContext::setClip(double x, double y, double width, double height) {
+  clip.setRect(x, y, width, height);
+}
+
+void UHeadlessContext::setPaintMode(UGraph& g) {
+  xor_mode = false;
+  color = g.color_rgba;
+}
+
+void UHeadlessContext::setXORMode(UGraph& g, const UColor& bg) {
+  xor_mode = true;
+  g.bgcolor_rgba = bgcolor = bg.getRgba();
+}
+
+void UHeadlessContext::setColor(UGraph& g, const UColor& c) {
+  g.color_rgba = color = c.getRgba();
+}
+
+void UHeadlessContext::setBackground(UGraph& g, const UColor& c) {
+  g.bgcolor_rgba = bgcolor = c.getRgba();
+}
+
+void UHeadlessContext::setWidth(UGraph&, double w) {
+  line_width = w > 1. ? ipos(w) : 1;
+}
+
+// ==================================================== [Ubit Toolkit] =========
+// rasterization (absolute coordinates, bounds included).
+
+void UHeadlessContext::fillSpan(int x1, int x2, int y) const {
+  UHardwinHeadless* fb = getFramebuffer();
+  if (!fb) return;
+  int cx1 = max(0, ipos(clip.x));
+  int cx2 = min(fb->width, ipos(clip.x + clip.width)) - 1;
+  int cy1 = max(0, ipos(clip.y));
+  int cy2 = min(fb->height, ipos(clip.y + clip.height)) - 1;
+  if (y < cy1 || y > cy2) return;
+  if (x1 > x2) std::swap(x1, x2);
+  x1 = max(x1, cx1);
+  x2 = min(x2, cx2);
+  if (x1 > x2) return;
+
+  unsigned char* p = &fb->pixels[(size_t(y) * fb->width + x1) * 4];
+  if (xor_mode) {
+    unsigned char r = color.comps[0] ^ bgcolor.comps[0];
+    unsigned char g = color.comps[1] ^ bgcolor.comps[1];
+    unsigned char b = color.comps[2] ^ bgcolor.comps[2];
+    for (int x = x1; x <= x2; ++x, p += 4) {p[0] ^= r; p[1] ^= g; p[2] ^= b;}
+  }
+  else {
+    for (int x = x1; x <= x2; ++x, p += 4) blend(p, color.comps);
+  }
+}
+
+void UHeadlessContext::fillBox(int x1, int y1, int x2, int y2) const {
+  if (y1 > y2) std::swap(y1, y2);
+  for (int y = y1; y <= y2; ++y) fillSpan(x1, x2, y);
+}
+
+void UHeadlessContext::plot(int x, int y) const {
+  if (line_width <= 1) fillSpan(x, x, y);
+  else {
+    int x1 = x - line_width/2, y1 = y - line_width/2;
+    fillBox(x1, y1, x1 + line_width-1, y1 + line_width-1);
+  }
+}
+
+void UHeadlessContext::line(int x1, int y1, int x2, int y2) const {
+  if (y1 == y2 && line_width <= 1) {
+    fillSpan(x1, x2, y1);
+    return;
+  }
+  // Bresenham
+  int dx = abs(x2 - x1), dy = -abs(y2 - y1);
+  int sx = x1 < x2 ? 1 : -1, sy = y1 < y2 ? 1 : -1;
+  int err = dx + dy;
+  while (true) {
+    plot(x1, y1);
+    if (x1 == x2 && y1 == y2) break;
+    int e2 = 2 * err;
+    if (e2 >= dy) {err += dy; x1 += sx;}
+    if (e2 <= dx) {err += dx; y1 += sy;}
+  }
+}
+
+// even-odd rule (as the Complex shape of X11), pixels are filled if their
+// center is inside the polygon
+void UHeadlessContext::fillPolygon(const std::vector<UPoint>& pts) const {
+  int card = pts.size();
+  if (card < 3) return;
+  double ymin = pts[0].y, ymax = pts[0].y;
+  for (int k = 1; k < card; ++k) {
+    ymin = min(ymin, double(pts[k].y));
+    ymax = max(ymax, double(pts[k].y));
+  }
+  std::vector<double> xs;
+  for (int y = int(ceil(ymin - 0.5)); y + 0.5 < ymax; ++y) {
+    double yc = y + 0.5;
+    xs.clear();
+    for (int k = 0, j = card-1; k < card; j = k++) {
+      double ya = pts[j].y, yb = pts[k].y;
+      if ((ya <= yc && yb > yc) || (yb <= yc && ya > yc))
+        xs.push_back(pts[j].x + (yc - ya) * (pts[k].x - pts[j].x) / (yb - ya));
+    }
+    std::sort(xs.begin(), xs.end());
+    for (unsigned int k = 0; k + 1 < xs.size(); k += 2) {
+      int x1 = int(ceil(xs[k] - 0.5)), x2 = int(ceil(xs[k+1] - 0.5)) - 1;
+      if (x1 <= x2) fillSpan(x1, x2, y);
+    }
+  }
+}
+
+void UHeadlessContext::strokePolygon(const std::vector<UPoint>& pts, bool closed) const {
+  int card = pts.size();
+  if (card == 0) return;
+  if (card == 1) {plot(ipos(pts[0].x), ipos(pts[0].y)); return;}
+  for (int k = 1; k < card; ++k)
+    line(ipos(pts[k-1].x), ipos(pts[k-1].y), ipos(pts[k].x), ipos(pts[k].y));
+  if (closed)
+    line(ipos(pts[card-1].x), ipos(pts[card-1].y), ipos(pts[0].x), ipos(pts[0].y));
+}
+
+// appends the points of an elliptic arc; (x,y,w,h) is the bounding box of the
+// ellipse, angles are in degrees, counterclockwise from 3 o'clock (as with X11)
+void UHeadlessContext::arcPoints(std::vector<UPoint>& pts, double x, double y,
+                                 double w, double h, double start, double ext) const {
+  double rx = w / 2., ry = h / 2.;
+  double cx = x + rx, cy = y + ry;
+  int n = int(M_PI * (rx + ry) * fabs(ext) / 360. / 2.);   // about 2 pixels per segment
+  if (n < 4) n = 4;
+  for (int k = 0; k <= n; ++k) {
+    double a = (start + ext * k / n) * M_PI / 180.;
+    pts.push_back(UPoint(cx + rx * cos(a), cy - ry * sin(a)));
+  }
+}
+
+// ==================================================== [Ubit Toolkit] =========
+
+void UHeadlessContext::drawLine(double x1, double y1, double x2, double y2) const {
+  line(ipos(xwin + x1), ipos(ywin + y1), ipos(xwin + x2), ipos(ywin + y2));
+}
+
+// same conventions as X11: filled rectangles are w x h pixels large, while
+// the outline of a rectangle is (w+1) x (h+1) pixels large
+void UHeadlessContext::drawRect(double x, double y, double w, double h, bool filled) const {
+  int x1 = ipos(xwin + x), y1 = ipos(ywin + y);
+  int iw = ipos(w), ih = ipos(h);
+  if (filled) {
+    if (iw > 0 && ih > 0) fillBox(x1, y1, x1 + iw-1, y1 + ih-1);
+  }
+  else {
+    int x2 = x1 + iw, y2 = y1 + ih;
+    line(x1, y1, x2, y1);
+    line(x2, y1, x2, y2);
+    line(x2, y2, x1, y2);
+    line(x1, y2, x1, y1);
+  }
+}
+
+void UHeadlessContext::drawRoundRect(double x, double y, double w, double h,
+                                     double arc_w, double arc_h, bool filled) const {
+  double x1 = xwin + x, y1 = ywin + y, x2 = x1 + w, y2 = y1 + h;
+  double aw = min(arc_w, w), ah = min(arc_h, h);  // diameters of the corners
+  std::vector<UPoint> pts;
+  arcPoints(pts, x2 - aw, y1, aw, ah, 0, 90);      // top right
+  arcPoints(pts, x1, y1, aw, ah, 90, 90);          // top left
+  arcPoints(pts, x1, y2 - ah, aw, ah, 180, 90);    // bottom left
+  arcPoints(pts, x2 - aw, y2 - ah, aw, ah, 270, 90);  // bottom right
+  if (filled) fillPolygon(pts);
+  else strokePolygon(pts, true);
+}
+
+void UHeadlessContext::drawArc(double x, double y, double w, double h,
+                               double start, double ext, bool filled) const {
+  std::vector<UPoint> pts;
+  arcPoints(pts, xwin + x, ywin + y, w, h, start, ext);
+  if (filled) {
+    // pie slice (the default arc mode of X11)
+    if (fabs(ext) < 360.) pts.push_back(UPoint(xwin + x + w/2., ywin + y + h/2.));
+    fillPolygon(pts);
+  }
+  else strokePolygon(pts, false);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// type is one of LINE_STRIP (polyline), LINE_LOOP (polygon), FILLED (filled polygon).
+
+void UHeadlessContext::drawPolygon(const float* coords2d, int card, int polytype) const {
+  if (card <= 0 || coords2d == null) return;
+  std::vector<UPoint> pts(card);
+  for (int k = 0; k < card; ++k)
+    pts[k].set(coords2d[2*k] + xwin, coords2d[2*k+1] + ywin);
+  if (polytype == UGraph::FILLED) fillPolygon(pts);
+  else strokePolygon(pts, polytype == UGraph::LINE_LOOP);
+}
+
+void UHeadlessContext::drawPolygon(const std::vector<UPoint>& points, int polytype) const {
+  int card = points.size();
+  if (card <= 0) return;
+  std::vector<UPoint> pts(card);
+  for (int k = 0; k < card; ++k) pts[k].set(points[k].x + xwin, points[k].y + ywin);
+  if (polytype == UGraph::FILLED) fillPolygon(pts);
+  else strokePolygon(pts, polytype == UGraph::LINE_LOOP);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// 'y' is the baseline. The glyphs are scaled with the nearest neighbor method:
+// each pixel of a glyph is a box, and consecutive pixels of a row are filled
+// at once. Bold fonts are drawn by widening the boxes.
+
+void UHeadlessContext::drawString(const UHardFont* font, const char* str, int str_len,
+                                  double x, double y) const {
+  if (!font || font->status != UHardFont::BITMAP_FONT || !str) return;
+  UHardwinHeadless* fb = getFramebuffer();
+  if (!fb) return;
+  double s = font->bitmap_scale;
+  double top = ywin + y - (GLYPH_ASCENT - 1) * s;   // first row of the glyphs
+  double left = xwin + x;
+  int bold = font->bitmap_bold ? max(1, ipos(s)) : 0;
+  double clip_x2 = clip.x + clip.width;
+
+  for (int c = 0; c < str_len; ++c, left += GLYPH_ADVANCE * s) {
+    if (left > clip_x2) break;
+    if (left + GLYPH_ADVANCE * s < clip.x) continue;
+    unsigned char ch = str[c];
+    if (ch == ' ') continue;
+    const unsigned char* g = glyphs[(ch >= 32 && ch <= 126) ? ch - 32 : '?' - 32];
+
+    for (int row = 0; row < GLYPH_ROWS; ++row) {
+      unsigned char bits = g[row];
+      if (!bits) continue;
+      int y1 = ipos(top + row * s), y2 = max(y1, ipos(top + (row+1) * s) - 1);
+      int col = 0;
+      while (col < GLYPH_WIDTH) {
+        if (!(bits & (1 << (GLYPH_WIDTH-1 - col)))) {col++; continue;}
+        int end = col;
+        while (end+1 < GLYPH_WIDTH && (bits & (1 << (GLYPH_WIDTH-2 - end)))) end++;
+        int x1 = ipos(left + col * s), x2 = max(x1, ipos(left + (end+1) * s) - 1);
+        fillBox(x1, y1, x2 + bold, y2);
+        col = end + 1;
+      }
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// images are only available in GL mode, where they are RGBA buffers (UHardImaGL).
+
+void UHeadlessContext::drawIma(const UGraph& g, const UIma& ima, double x, double y,
+                               double scale) const {
+#if UBIT_WITH_GL
+  UHardwinHeadless* fb = getFramebuffer();
+  if (!fb || !UAppli::isUsingGL() || ima.getNatImas().empty()) return;
+  UHardImaGL* ni = (UHardImaGL*)*(ima.getNatImas().begin());
+  const unsigned char* src = ni ? ni->getPixels() : null;
+  if (!src) return;
+
+  int sw = ni->getWidth(), sh = ni->getHeight();
+  int x1 = ipos(xwin + x), y1 = ipos(ywin + y);
+  int w = ipos(ima.getWidth() * scale), h = ipos(ima.getHeight() * scale);
+  if (sw <= 0 || sh <= 0 || w <= 0 || h <= 0) return;
+
+  int cx1 = max(max(0, ipos(clip.x)), x1);
+  int cx2 = min(min(fb->width, ipos(clip.x + clip.width)), x1 + w) - 1;
+  int cy1 = max(max(0, ipos(clip.y)), y1);
+  int cy2 = min(min(fb->height, ipos(clip.y + clip.height)), y1 + h) - 1;
+
+  for (int j = cy1; j <= cy2; ++j) {
+    const unsigned char* srow = src + size_t((j - y1) * sh / h) * sw * 4;
+    unsigned char* p = &fb->pixels[(size_t(j) * fb->width + cx1) * 4];
+    for (int i = cx1; i <= cx2; ++i, p += 4) blend(p, srow + ((i - x1) * sw / w) * 4);
+  }
+#endif
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+void UHeadlessContext::copyArea(double x, double y, double w, double h,
+                                double delta_x, double delta_y,
+                                bool generate_refresh_events_when_obscured) const {
+  UHardwinHeadless* fb = getFramebuffer();
+  if (!fb) return;
+  int sx = ipos(xwin + x), sy = ipos(ywin + y), dx = ipos(delta_x), dy = ipos(delta_y);
+  int iw = ipos(w), ih = ipos(h);
+
+  // clip the source and the destination to the framebuffer
+  if (sx < 0) {iw += sx; sx = 0;}
+  if (sy < 0) {ih += sy; sy = 0;}
+  if (sx + dx < 0) {iw += sx + dx; sx = -dx;}
+  if (sy + dy < 0) {ih += sy + dy; sy = -dy;}
+  iw = min(iw, min(fb->width - sx, fb->width - sx - dx));
+  ih = min(ih, min(fb->height - sy, fb->height - sy - dy));
+  if (iw <= 0 || ih <= 0) return;
+
+  size_t stride = size_t(fb->width) * 4;
+  unsigned char* base = &fb->pixels[0];
+  // rows are copied in the opposite direction of the move when areas overlap
+  for (int k = 0; k < ih; ++k) {
+    int row = dy > 0 ? ih-1 - k : k;
+    memmove(base + (sy + dy + row) * stride + (sx + dx) * 4,
+            base + (sy + row) * stride + sx * 4, iw * 4);
+  }
+}
+
+bool UHeadlessContext::readPixels(double x, double y, int w, int h,
+                                  std::vector<unsigned char>& rgba) const {
+  UHardwinHeadless* fb = getFramebuffer();
+  int x1 = ipos(xwin + x), y1 = ipos(ywin + y);
+  if (!fb || w <= 0 || h <= 0 || x1 < 0 || y1 < 0 
+      || x1 + w > fb->width || y1 + h > fb->height)
+    return false;
+
+  rgba.resize(size_t(w) * h * 4);
+  for (int j = 0; j < h; ++j)
+    memcpy(&rgba[size_t(j) * w * 4], &fb->pixels[(size_t(y1 + j) * fb->width + x1) * 4], w * 4);
+  return true;
+}
+
+}
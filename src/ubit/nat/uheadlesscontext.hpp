@@ -0,0 +1,95 @@
+/* ***********************************************************************
+ *
+ *  uheadlesscontext.hpp: rendering context of the headless display
+ *  Ubit GUI Toolkit - Version 6.0
+ *  (C) 2009 Eric Lecolinet | ENST Paris | www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#ifndef _uheadlesscontext_hpp_
+#define	_uheadlesscontext_hpp_ 1
+#include <ubit/ucolor.hpp>
+#include <ubit/nat/urendercontext.hpp>
+namespace ubit {
+
+class UHardwinHeadless;
+
+/** [Impl] software rendering context of the headless display.
+ * draws in the RGBA framebuffer of a UHardwinHeadless. Colors are blended
+ * according to their alpha value (or xored in XOR mode). Text is drawn with
+ * a built-in bitmap font that is scaled to the font size (@see UHardFont).
+ */
+class UHeadlessContext : public URenderContext {
+public:
+  enum {
+    GLYPH_WIDTH = 5, GLYPH_ROWS = 9,  ///< size of the glyphs of the bitmap font
+    GLYPH_ADVANCE = 6,                ///< width of a character (including spacing)
+    GLYPH_ASCENT = 8, GLYPH_DESCENT = 2,
+    GLYPH_SIZE = GLYPH_ASCENT + GLYPH_DESCENT  ///< font size that is drawn without scaling
+  };
+
+  UHeadlessContext(UDisp*);
+  virtual ~UHeadlessContext();
+
+  virtual bool isGlcontext() const {return false;}
+  virtual UGlcontext* toGlcontext() {return null;}
+  virtual const UGlcontext* toGlcontext() const {return null;}
+  virtual bool isSharedWith(const URenderContext*) const {return false;}
+
+  virtual void setDest(UHardwinImpl* d, double x, double y) {dest=d; xwin=x; ywin=y;}
+  virtual void setOffset(double x, double y) {xwin = x; ywin = y;}
+  virtual void setPaintMode(UGraph&);
+  virtual void setXORMode(UGraph&, const UColor& backcolor);
+  virtual void set3Dmode(bool state) {}
+  virtual void setClip(double x, double y, double width, double height);
+
+  virtual void setColor(UGraph&, const UColor&);
+  virtual void setBackground(UGraph&, const UColor&);
+  virtual void setWidth(UGraph&, double);
+  virtual void setFont(UGraph&, const UFontDesc&) {}
+
+  virtual void makeCurrent() const {}
+  virtual void swapBuffers() {}
+  virtual void flush() {}
+
+  virtual void drawArc(double x, double y, double w, double h, double start, double ext, bool filled) const;
+  virtual void drawIma(const UGraph&, const UIma&, double x, double y, double scale) const;
+  virtual void drawLine(double x1, double y1, double x2, double y2) const;
+  virtual void drawPolygon(const float* points, int card, int polytype) const;
+  virtual void drawPolygon(const std::vector<UPoint>& points, int polytype) const;
+  virtual void drawRect(double x, double y, double w, double h, bool filled) const;
+  virtual void drawRoundRect(double x, double y, double w, double h,
+                             double arc_w, double arc_h, bool filled) const;
+  virtual void drawString(const UHardFont*, const char* str, int str_len, double x, double y) const;
+  virtual void copyArea(double x, double y, double w, double h, double delta_x, double delta_y,
+                        bool generate_refresh_events_when_obscured) const;
+  virtual bool readPixels(double x, double y, int w, int h,
+                          std::vector<unsigned char>& rgba) const;
+
+protected:
+  // these functions use absolute coordinates (ie. xwin and ywin are already added)
+  void fillSpan(int x1, int x2, int y) const;
+  void fillBox(int x1, int y1, int x2, int y2) const;
+  void plot(int x, int y) const;
+  void line(int x1, int y1, int x2, int y2) const;
+  void fillPolygon(const std::vector<UPoint>& points) const;
+  void strokePolygon(const std::vector<UPoint>& points, bool closed) const;
+  void arcPoints(std::vector<UPoint>& points, double x, double y, double w, double h,
+                 double start, double ext) const;
+  UHardwinHeadless* getFramebuffer() const;
+
+  URgba color, bgcolor;
+  bool xor_mode;
+  int line_width;
+};
+
+}
+#endif
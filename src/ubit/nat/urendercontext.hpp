@@ -114,6 +114,12 @@ public:
   virtual void copyArea(double x, double y, double w, double h, double delta_x, double delta_y,
                         bool generate_refresh_events_when_obscured) const = 0;
 
+  virtual bool readPixels(double x, double y, int w, int h,
+                          std::vector<unsigned char>& rgba) const {return false;}
+  /* reads the pixels of this area of the destination (@see UGraph::readPixels()).
+   * returns false if this is not possible (the default).
+   */
+
 protected:
   URenderContext(UDisp* d) : disp(d), dest(null), xwin(0), ywin(0), own_dest(false) {}  
   virtual ~URenderContext() {if (own_dest) delete dest;}
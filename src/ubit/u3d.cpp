@@ -372,6 +372,138 @@ public:
   }
 };
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// screen bounds of the children of a U3Dcanvas: they are computed in software 
+// (with the same transforms as beginUpdate3d() and findInChildren()) and are kept
+// until the camera, the U3Dpos or the size of the child change.
+
+struct U3DboundsProp : public UViewProp {
+  enum {KEY_SIZE = 16};
+  
+  U3DboundsProp() : rx(0), ry(0), valid(false), culled(false), has_rect(false),
+  xmin(0), ymin(0), xmax(0), ymax(0) {}
+  
+  float rx, ry;          // where the child was last painted
+  float key[KEY_SIZE];   // the geometry the bounds were computed for
+  bool valid;
+  bool culled;           // outside of the view frustum
+  bool has_rect;         // false if the child crosses the plane of the eye
+  float xmin, ymin, xmax, ymax;   // in the viewport of the canvas (y is up)
+};
+
+// m = m * b (column-major matrices, as in OpenGL)
+static void multMatrix(double m[16], const double b[16]) {
+  double r[16];
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j) {
+      double v = 0;
+      for (int k = 0; k < 4; ++k) v += m[k*4 + i] * b[j*4 + k];
+      r[j*4 + i] = v;
+    }
+  for (int i = 0; i < 16; ++i) m[i] = r[i];
+}
+
+// same as glRotatef(angle, ...) around the x (0), y (1) or z (2) axis
+static void rotateMatrix(double m[16], double angle, int axis) {
+  double a = angle * M_PI / 180.;
+  double r[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+  int i = (axis + 1) % 3, j = (axis + 2) % 3;
+  r[i*4 + i] = r[j*4 + j] = cos(a);
+  r[i*4 + j] = sin(a);
+  r[j*4 + i] = -sin(a);
+  multMatrix(m, r);
+}
+
+// r is where the child is painted (null when picking: the last value is used)
+static U3DboundsProp* getScreenBounds(U3DcanvasView* canvas_view, UView* chview,
+                                      const U3Dpos* pos3d, const URect* r) {
+  U3DboundsProp* b = null;
+  chview->obtainProp(b);
+  if (r) {b->rx = r->x; b->ry = r->y;}
+  
+  U3Dcanvas* canvas = (U3Dcanvas*)canvas_view->getBox();
+  float cw = canvas_view->getWidth(), ch = canvas_view->getHeight();
+  float w = chview->getWidth(), h = chview->getHeight();
+  float aspect = ch > 0 ? canvas->getAspect() * cw / ch : 1.;
+  float key[U3DboundsProp::KEY_SIZE] = {
+    pos3d->getX().val, pos3d->getY().val, pos3d->getZ(),
+    pos3d->getXRot(), pos3d->getYRot(), pos3d->getZRot(), w, h, b->rx, b->ry,
+    canvas->getFovy(), aspect, canvas->getNear(), canvas->getFar(), cw, ch
+  };
+  if (b->valid && equal(key, key + U3DboundsProp::KEY_SIZE, b->key)) return b;
+  copy(key, key + U3DboundsProp::KEY_SIZE, b->key);
+  b->valid = true;
+  
+  // the child is painted at (rx, ry) but picked at (0, 0), y is up in OpenGL,
+  // and the planes are superposed when painted (see beginUpdate3d())
+  float x1 = min(0.f, b->rx), x2 = max(w, b->rx + w);
+  float y1 = -max(h, b->ry + h), y2 = -min(0.f, b->ry);
+  URect bounds;
+  b->culled = !canvas->getScreenBounds(*pos3d, URect(x1, y1, x2 - x1, y2 - y1),
+                                       2 * SUPERPOSE, cw, ch, bounds);
+  b->has_rect = !bounds.isEmpty();
+  b->xmin = bounds.x;
+  b->ymin = bounds.y;
+  b->xmax = bounds.x + bounds.width;
+  b->ymax = bounds.y + bounds.height;
+  return b;
+}
+
+void U3Dcanvas::getMatrices(const U3Dpos& pos3d, float width, float height,
+                            double model[16], double proj[16]) const {
+  // same as gluPerspective()
+  double a = height > 0 ? aspect * width / height : 1.;
+  double f = 1. / tan(fovy * M_PI / 360.);
+  double p[16] = {f/a,0,0,0, 0,f,0,0, 0,0,(far+near)/(near-far),-1, 0,0,2*far*near/(near-far),0};
+  copy(p, p + 16, proj);
+  
+  // same as glTranslatef() and glRotatef() in beginUpdate3d()
+  double m[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0,
+    pos3d.getX().val, pos3d.getY().val, pos3d.getZ(), 1};
+  rotateMatrix(m, -pos3d.getXRot(), 0);
+  rotateMatrix(m, pos3d.getYRot(), 1);
+  rotateMatrix(m, pos3d.getZRot(), 2);
+  copy(m, m + 16, model);
+}
+
+bool U3Dcanvas::getScreenBounds(const U3Dpos& pos3d, const URect& r, float depth,
+                                float width, float height, URect& bounds) const {
+  double model[16], proj[16];
+  getMatrices(pos3d, width, height, model, proj);
+  
+  double xs[2] = {r.x, r.x + r.width};
+  double ys[2] = {r.y, r.y + r.height};
+  double zs[2] = {0, depth};
+  
+  int outside = 0x3f;   // the planes of the frustum that all the corners are outside of
+  bool has_rect = true;
+  float xmin = 1e30, ymin = 1e30, xmax = -1e30, ymax = -1e30;
+  
+  for (int k = 0; k < 8; ++k) {
+    double p[4] = {xs[k & 1], ys[(k >> 1) & 1], 0, 1}, e[4], c[4];
+    for (int i = 0; i < 4; ++i)
+      e[i] = model[i] * p[0] + model[4+i] * p[1] + model[8+i] * p[2] + model[12+i];
+    e[2] += zs[k >> 2];
+    for (int i = 0; i < 4; ++i)
+      c[i] = proj[i] * e[0] + proj[4+i] * e[1] + proj[8+i] * e[2] + proj[12+i] * e[3];
+    
+    outside &= (c[0] < -c[3]) | (c[0] > c[3]) << 1 | (c[1] < -c[3]) << 2
+    | (c[1] > c[3]) << 3 | (c[2] < -c[3]) << 4 | (c[2] > c[3]) << 5;
+    
+    // same as gluProject() with the viewport (0, 0, width, height)
+    if (c[3] <= 1e-6) has_rect = false;
+    else {
+      float vx = (c[0] / c[3] + 1) * width / 2, vy = (c[1] / c[3] + 1) * height / 2;
+      xmin = min(xmin, vx); xmax = max(xmax, vx);
+      ymin = min(ymin, vy); ymax = max(ymax, vy);
+    }
+  }
+  
+  if (has_rect) bounds.setRect(xmin, ymin, xmax - xmin, ymax - ymin);
+  else bounds.setRect(0, 0, 0, 0);
+  return outside == 0;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 UView* U3DcanvasView::findInChildren(UElem* grp, const UPoint& winpos,
@@ -449,6 +581,12 @@ UView* U3DcanvasView::findInChildren(UElem* grp, const UPoint& winpos,
         }
         
         else {
+          // only the children whose screen bounds contain the pointer are unprojected
+          U3DboundsProp* b = getScreenBounds(this, chview, pos3d, null);
+          if (b->culled || (b->has_rect && (ex < b->xmin || ex > b->xmax
+                                            || ey < b->ymin || ey > b->ymax)))
+            continue;
+          
           glPopMatrix();
           glPushMatrix(); //get global modelview matrix
           glTranslatef(pos3d->x.val, pos3d->y.val, pos3d->z);
@@ -620,13 +758,22 @@ bool U3DcanvasView::unproject(const U3Dpos* pos3d,
 
 // =============================================================================
 
-void UView::beginUpdate3d(UViewUpdateImpl& vd, UElem& grp, UUpdateContext& curp) {
+bool UView::beginUpdate3d(UViewUpdateImpl& vd, UElem& grp, UUpdateContext& curp,
+                          const URect& r) {
 #ifdef UBIT_WITH_GL
-  if (!vd.can_paint) return;
+  if (!vd.can_paint) return true;
+  
+  U3Dpos* pos3d = dynamic_cast<U3Dpos*>(curp.pos);
+  
+  // the children of the canvas that are outside of the view frustum are not painted
+  U3DcanvasView* canvas_view = 
+  curp.parent_ctx ? dynamic_cast<U3DcanvasView*>(curp.parent_ctx->view) : null;
+  if (pos3d && canvas_view && grp.toBox() 
+      && getScreenBounds(canvas_view, vd.view, pos3d, &r)->culled)
+    return false;
   
   glTranslatef(0,0,SUPERPOSE);    // superposer les plans
   
-  U3Dpos* pos3d = dynamic_cast<U3Dpos*>(curp.pos);
   if (pos3d) {  
     glPushMatrix();
     //change to object s local coordinate system.
@@ -637,6 +784,7 @@ void UView::beginUpdate3d(UViewUpdateImpl& vd, UElem& grp, UUpdateContext& curp)
     glRotatef(pos3d->z_rot, 0,0,1);
   }
 #endif
+  return true;
 }
 
 void UView::endUpdate3d(UViewUpdateImpl& vd, UElem& grp, UUpdateContext& curp) {
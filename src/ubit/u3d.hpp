@@ -49,6 +49,24 @@ namespace ubit {
     void setNear(float n)   {near = n;}
     void setFar(float f)    {far = f;}
     
+    void getMatrices(const U3Dpos&, float width, float height,
+                     double modelview[16], double projection[16]) const;
+    /**< computes the matrices that display a child that has this 3D position.
+     * 'width' and 'height' are the size of the canvas. The matrices are the same
+     * as those of OpenGL (gluPerspective(), glTranslatef() and glRotatef()) but
+     * they are computed in software.
+     */
+    
+    bool getScreenBounds(const U3Dpos&, const URect& rect, float depth,
+                         float width, float height, URect& bounds) const;
+    /**< computes the bounds of a rectangle of a child in the viewport of the canvas.
+     * 'rect' is in the plane of the child (y is up, as in OpenGL), which is moved
+     * towards the eye by 0 to 'depth'. 'width' and 'height' are the size of the
+     * canvas. 'bounds' are in the viewport (y is up); they are empty if the
+     * rectangle crosses the plane of the eye. Returns false if the rectangle
+     * is outside of the view frustum.
+     */
+    
   private:
     friend class U3DcanvasView;
     float fovy, aspect, near, far;
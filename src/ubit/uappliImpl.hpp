@@ -64,9 +64,9 @@ namespace ubit {
     void removeModalWin(UWin&);
     void setModalStatus(int);
     
-    void resetSources(UElem* sources, fd_set& read_set, int& maxfd);
+    void resetSources(UElem* sources, fd_set& read_set, fd_set& write_set, int& maxfd);
     void cleanSources(UElem* sources);
-    void fireSources(UElem* sources, fd_set& read_set);
+    void fireSources(UElem* sources, fd_set& read_set, fd_set& write_set);
     
     // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
   //private:
@@ -46,6 +46,26 @@ void UAlpha::putProp(UUpdateContext *props, UElem&) {
 
 /* ==================================================== [Elc] ======= */
 
+ULayer::ULayer(bool s) : UAttr() {state = s;}
+
+ULayer& ULayer::setCached(bool s) {
+  if (checkConst() || s == state) return *this;
+  state = s;
+  changed();
+  return *this;
+}
+
+// the bitmap is discarded as the box is repainted (see UView::setCacheDamaged())
+void ULayer::update() {
+  updateAutoParents(UUpdate::paint);
+}
+
+void ULayer::putProp(UUpdateContext *props, UElem&) {
+  props->local.layer = this;
+}
+
+/* ==================================================== [Elc] ======= */
+
 //inline UBackground& ubgcolor(int r, int g, int b);
 //obsolete.
 
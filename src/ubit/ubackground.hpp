@@ -156,6 +156,44 @@ namespace ubit {
   inline UAlpha& ualpha(float value = 1.0) {return *new UAlpha(value);}
   ///< shortcut function that returns *new UAlpha(value).
   
+  
+  /* ==================================================== ===== ======= */
+  /** Widget Layer: caches the rendering of a box in a bitmap.
+   * a box that has an active ULayer is painted normally once, then its bitmap is
+   * drawn instead of its content and its children, until the box or one of its
+   * descendants is updated, or the box is moved or resized. This speeds up
+   * static boxes (toolbars, palettes, table headers...) that are often repainted
+   * because of other objects (typically, a toolglass that is moved over them).
+   *
+   * Notes:
+   * - the bitmap also contains what is under the box if the box is transparent
+   * - the paint callbacks of the children are not called when the bitmap is drawn
+   * - the bitmap is read back from the display, which requires OpenGL or
+   *   the headless display: boxes are painted normally otherwise.
+   */
+  class ULayer : public UAttr {
+  public:
+    UCLASS(ULayer)
+    
+    ULayer(bool state = true);
+    ///< creates a layer property; see also shortcut function ulayer().
+    
+    bool isCached() const {return state;}
+    ///< returns true if the box is cached.
+    
+    ULayer& setCached(bool state);
+    ///< the bitmap is discarded and not used anymore if state is false.
+    
+    virtual void update();
+    virtual void putProp(UUpdateContext*, UElem&);
+    
+  private:
+    bool state;
+  };
+  
+  inline ULayer& ulayer(bool state = true) {return *new ULayer(state);}
+  ///< shortcut function that returns *new ULayer(state).
+  
 }
 #endif
 
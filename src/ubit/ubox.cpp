@@ -430,6 +430,16 @@ void UBox::doUpdate(const UUpdate& upd, UDisp*) {
     UWin*  hardwin = null;
     UView* hardwin_view = null;
     
+    // the sizes that are cached by the parents of this view must be recomputed
+    // and the bitmaps that they cache must be painted again. This is also done
+    // if the window is hidden as they are used when the window is shown.
+    if (view && view->isRealized()) {
+      if (upd.modes & (UUpdate::LAYOUT | UUpdate::SHOW | UUpdate::HIDE))
+        view->setLayoutDamaged();
+      if (upd.modes & (UUpdate::PAINT | UUpdate::LAYOUT | UUpdate::SHOW | UUpdate::HIDE))
+        view->setCacheDamaged();
+    }
+
     if (view && view->isRealized()   // check views!=null (some may have been deleted)
         && (hardwin = view->getWin())
         && (hardwin_view = hardwin->getWinView(view->getDisp()))
@@ -187,11 +187,11 @@ void USize::putProp(UUpdateContext* props, UElem& obj) {
   //props->local.size = *this;
   if (width != UIGNORE) {
     props->local.size.width = width;
-    obj.emodes.IS_WIDTH_UNRESIZABLE = (width.modes.val & USize::UNRESIZABLE.val);
+    obj.setWidthUnresizable(width.modes.val & USize::UNRESIZABLE.val);
   }
   if (height != UIGNORE) {
     props->local.size.height = height;
-    obj.emodes.IS_HEIGHT_UNRESIZABLE = (height.modes.val & USize::UNRESIZABLE.val);
+    obj.setHeightUnresizable(height.modes.val & USize::UNRESIZABLE.val);
   }
 }
 
@@ -16,11 +16,14 @@
 
 #include <ubit/ubit_features.h>
 #include <iostream>
+#include <algorithm>
+#include <cctype>
 #include <ubit/ustr.hpp>
 #include <ubit/uclass.hpp>
 #include <ubit/uclassImpl.hpp>
 #include <ubit/uappli.hpp>
 #include <ubit/uappliImpl.hpp>
+#include <ubit/utaskpool.hpp>
 using namespace std;
 #define NAMESPACE_UBIT namespace ubit {
 NAMESPACE_UBIT
@@ -41,6 +44,16 @@ UClass::~UClass() {
   delete style;
 }
 
+// the style prototype is created by the main thread (the layout may be
+// performed by worker threads if UConf::parallel_layout is true)
+UStyle* UClass::createStyle() const {
+  if (UTask::inWorkerThread()) {
+    UTask::requireMainThread();
+    return null;
+  }
+  return (style = newStyle());
+}
+
 /*
 //#define UBIT_CLASS(CC) \
 //static  const UClass& Class() {static UClass& c = *new USubclass<CC>(#CC); return c;} \
@@ -58,12 +71,306 @@ inline const UClass& MetaClass(const char*cc_name) {static UClass& c = *new USub
 */
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
+UStyleSheet::UStyleSheet() : rule_count(0) {}
+
 UStyleSheet::~UStyleSheet() {
+  removeRules();
   for (Map::iterator k = map.begin(); k != map.end(); k++) {
     delete k->second; // deletes the nodes
   }
 }
 
+static void deleteRules(std::vector<UStyleSheet::Rule*>& rules) {
+  for (unsigned int k = 0; k < rules.size(); k++) delete rules[k];
+  rules.clear();
+}
+
+void UStyleSheet::removeRules() {
+  // the rules are stored in a single bucket
+  for (Bucket::iterator k = id_rules.begin(); k != id_rules.end(); k++)
+    deleteRules(k->second);
+  for (Bucket::iterator k = class_rules.begin(); k != class_rules.end(); k++)
+    deleteRules(k->second);
+  for (Bucket::iterator k = tag_rules.begin(); k != tag_rules.end(); k++)
+    deleteRules(k->second);
+  deleteRules(universal_rules);
+  id_rules.clear();
+  class_rules.clear();
+  tag_rules.clear();
+  retired_props.insert(rule_props.begin(), rule_props.end());
+  rule_props.clear();
+}
+
+void UStyleSheet::clearRetiredRules() {
+  retired_props.clear();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+static const char* readSelectorName(const char* p, std::string& name) {
+  const char* begin = p;
+  while (*p && (isalnum(*p) || *p == '-' || *p == '_')) p++;
+  name.assign(begin, p - begin);
+  for (unsigned int k = 0; k < name.size(); k++) name[k] = tolower(name[k]);
+  return p;
+}
+
+// parses a simple selector sequence such as: td.navigbar#id[title="xx"]
+bool UStyleSheet::parseSelector(const char* p, Selector& sel) {
+  if (*p == '*') p++;
+  else p = readSelectorName(p, sel.tag);
+  
+  while (*p) {
+    std::string name;
+    if (*p == '.') {
+      p = readSelectorName(p+1, name);
+      if (name.empty()) return false;
+      sel.classes.push_back(name);
+    }
+    else if (*p == '#') {
+      p = readSelectorName(p+1, name);
+      if (name.empty()) return false;
+      sel.id = name;
+    }
+    else if (*p == '[') {
+      p = readSelectorName(p+1, name);
+      if (name.empty()) return false;
+      std::string val;
+      if (*p == '=') {
+        p++;
+        const char* begin = p;
+        while (*p && *p != ']') p++;
+        val.assign(begin, p - begin);
+        // remove quotes
+        if (val.size() >= 2 && (val[0] == '"' || val[0] == '\'')) 
+          val = val.substr(1, val.size() - 2);
+      }
+      if (*p != ']') return false;  // [att~=val], [att|=val]... not supported
+      p++;
+      sel.attrs.push_back(std::make_pair(name, val));
+    }
+    else return false;   // pseudo-classes... not supported
+  }
+  return true;
+}
+
+static bool sameSelectors(const std::vector<UStyleSheet::Selector>& a,
+                          const std::vector<UStyleSheet::Selector>& b) {
+  if (a.size() != b.size()) return false;
+  for (unsigned int k = 0; k < a.size(); k++) {
+    if (a[k].tag != b[k].tag || a[k].id != b[k].id || a[k].classes != b[k].classes
+        || a[k].attrs != b[k].attrs || a[k].combinator != b[k].combinator)
+      return false;
+  }
+  return true;
+}
+
+bool UStyleSheet::addRule(const UStr& selector_str, const UClass& style) {
+  UAttrList* props = style.getAttributes();
+  if (!props || selector_str.empty()) return false;
+  
+  Rule* rule = new Rule();
+  rule->props = props;
+  rule->specificity = 0;
+  
+  // splits the selector in simple selector sequences separated by combinators
+  const char* p = selector_str.c_str();
+  char combinator = 0;
+  while (*p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+      if (combinator == 0 && !rule->selectors.empty()) combinator = ' ';
+      p++;
+    }
+    if (!*p) break;
+    
+    if (*p == '>') {
+      if (rule->selectors.empty()) {delete rule; return false;}
+      combinator = '>';
+      p++;
+      continue;
+    }
+    if (*p == '+' || *p == '~') {delete rule; return false;}  // not supported
+    
+    const char* begin = p;
+    while (*p && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r' && *p != '>'
+           && *p != '+' && *p != '~') {
+      if (*p == '[') {while (*p && *p != ']') p++;}  // spaces are allowed in []
+      if (*p) p++;
+    }
+    
+    Selector sel;
+    sel.combinator = combinator;
+    if (!parseSelector(std::string(begin, p - begin).c_str(), sel)) {
+      delete rule; 
+      return false;
+    }
+    rule->selectors.push_back(sel);
+    rule->specificity += (sel.id.empty() ? 0 : 10000)
+    + 100 * (sel.classes.size() + sel.attrs.size()) + (sel.tag.empty() ? 0 : 1);
+    combinator = 0;
+  }
+  
+  const Selector* subject = rule->selectors.empty() ? null : &rule->selectors.back();
+  
+  // simple element names are stored in the class map
+  if (!subject || (rule->selectors.size() == 1 && subject->id.empty()
+                   && subject->classes.empty() && subject->attrs.empty())) {
+    delete rule;
+    return false;
+  }
+  
+  std::vector<Rule*>& rules =
+    !subject->id.empty() ? id_rules[subject->id]
+    : !subject->classes.empty() ? class_rules[subject->classes[0]]
+    : !subject->tag.empty() ? tag_rules[subject->tag]
+    : universal_rules;
+  
+  // a rule with the same selector is replaced (its props are retired)
+  for (unsigned int k = 0; k < rules.size(); k++) {
+    if (sameSelectors(rules[k]->selectors, rule->selectors)) {
+      if (rules[k]->props != props) {
+        rule_props.erase(rules[k]->props);
+        retired_props.insert(rules[k]->props);
+      }
+      delete rules[k];
+      rules.erase(rules.begin() + k);
+      break;
+    }
+  }
+  
+  rule->order = ++rule_count;
+  rule_props.insert(props);
+  rules.push_back(rule);
+  return true;
+}
+
+bool UStyleSheet::isRuleProps(const UNode* n) const {
+  return rule_props.find(n) != rule_props.end()
+  || retired_props.find(n) != retired_props.end();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+static bool getElemAttr(const UElem& e, const char* name, std::string& val) {
+  UStr v;
+  if (!e.getAttrValue(v, name)) return false;
+  val = v.empty() ? "" : v.c_str();
+  return true;
+}
+
+static bool hasClass(const std::string& classes, const std::string& c) {
+  std::string::size_type pos = 0;
+  while ((pos = classes.find(c, pos)) != std::string::npos) {
+    std::string::size_type end = pos + c.size();
+    if ((pos == 0 || isspace(classes[pos-1])) 
+        && (end == classes.size() || isspace(classes[end]))) 
+      return true;
+    pos = end;
+  }
+  return false;
+}
+
+bool UStyleSheet::matchSelector(const Selector& sel, const UElem& e) {
+  if (!sel.tag.empty() && e.getNodeName().compare(sel.tag.c_str(), true) != 0)
+    return false;
+  std::string val;
+  
+  if (!sel.id.empty()) {
+    if (!getElemAttr(e, "id", val)) return false;
+    std::transform(val.begin(), val.end(), val.begin(), ::tolower);
+    if (val != sel.id) return false;
+  }
+  
+  if (!sel.classes.empty()) {
+    if (!getElemAttr(e, "class", val)) return false;
+    std::transform(val.begin(), val.end(), val.begin(), ::tolower);
+    for (unsigned int k = 0; k < sel.classes.size(); k++) {
+      if (!hasClass(val, sel.classes[k])) return false;
+    }
+  }
+  
+  for (unsigned int k = 0; k < sel.attrs.size(); k++) {
+    if (!getElemAttr(e, sel.attrs[k].first.c_str(), val)) return false;
+    if (!sel.attrs[k].second.empty() && val != sel.attrs[k].second) return false;
+  }
+  return true;
+}
+
+// true if selectors[0..index] match e (selectors[index] being matched against e).
+bool UStyleSheet::matchRule(const Rule& rule, int index, const UElem& e) {
+  const Selector& sel = rule.selectors[index];
+  if (!matchSelector(sel, e)) return false;
+  if (index == 0) return true;
+  
+  const UElem* parent = e.getParent();
+  if (sel.combinator == '>') 
+    return parent && matchRule(rule, index-1, *parent);
+  
+  for ( ; parent != null; parent = parent->getParent()) {  // descendant
+    if (matchRule(rule, index-1, *parent)) return true;
+  }
+  return false;
+}
+
+void UStyleSheet::addCandidates(const Bucket& bucket, const std::string& key,
+                                std::vector<const Rule*>& candidates) const {
+  Bucket::const_iterator k = bucket.find(key);
+  if (k != bucket.end()) 
+    candidates.insert(candidates.end(), k->second.begin(), k->second.end());
+}
+
+static bool compareRules(const UStyleSheet::Rule* r1, const UStyleSheet::Rule* r2) {
+  if (r1->specificity != r2->specificity) return r1->specificity < r2->specificity;
+  else return r1->order < r2->order;
+}
+
+int UStyleSheet::getMatchingRules(const UElem& e, std::vector<UAttrList*>& props) const {
+  if (rule_count == 0) return 0;
+  std::vector<const Rule*> candidates;
+  std::string val;
+  
+  if (!id_rules.empty() && getElemAttr(e, "id", val)) {
+    std::transform(val.begin(), val.end(), val.begin(), ::tolower);
+    addCandidates(id_rules, val, candidates);
+  }
+  
+  if (!class_rules.empty() && getElemAttr(e, "class", val)) {
+    std::transform(val.begin(), val.end(), val.begin(), ::tolower);
+    std::string::size_type pos = 0;
+    while (pos < val.size()) {
+      while (pos < val.size() && isspace(val[pos])) pos++;
+      std::string::size_type end = pos;
+      while (end < val.size() && !isspace(val[end])) end++;
+      if (end > pos) addCandidates(class_rules, val.substr(pos, end - pos), candidates);
+      pos = end;
+    }
+  }
+  
+  if (!tag_rules.empty()) {
+    std::string tag = e.getNodeName().empty() ? "" : e.getNodeName().c_str();
+    std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
+    addCandidates(tag_rules, tag, candidates);
+  }
+  
+  candidates.insert(candidates.end(), universal_rules.begin(), universal_rules.end());
+  
+  // a rule is in a single bucket but an element may have the same class twice 
+  std::sort(candidates.begin(), candidates.end(), compareRules);
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+  
+  int count = 0;
+  for (unsigned int k = 0; k < candidates.size(); k++) {
+    const Rule& r = *candidates[k];
+    // several rules may share the same properties (eg. h1.a, h2.b {...})
+    if (matchRule(r, r.selectors.size()-1, e)
+        && std::find(props.end() - count, props.end(), r.props) == props.end()) {
+      props.push_back(r.props);
+      count++;
+    }
+  }
+  return count;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 UElemClassMap::~UElemClassMap() {}
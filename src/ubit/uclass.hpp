@@ -119,11 +119,11 @@ virtual const UClass& getClass() const {return Class();}
      * redefines this method.
      */
         
-    UStyle* obtainStyle() const {return style ? style : (style = newStyle());}
+    UStyle* obtainStyle() const {return style ? style : createStyle();}
     /**< returns the style prototype that is associated to this class.
      * Ubit classes that derive from UElem can have a style prototype.
      * This function calls newStyle() the 1st type it is called to create the
-     * style prototype
+     * style prototype (except in worker threads, see UTask::requireMainThread()).
      * WARNING: the returned style must NOT be deleted.
      */
     
@@ -145,6 +145,7 @@ virtual const UClass& getClass() const {return Class();}
     mutable UStyle* style;
     mutable UAttrList* attributes;
     
+    UStyle* createStyle() const;
     UClass(const UClass&);   // assignment is forbidden.
     UClass& operator=(const UClass&);
   };
@@ -17,6 +17,9 @@
 #ifndef _uclassImpl_hpp_
 #define	_uclassImpl_hpp_ 1
 #include <map>
+#include <set>
+#include <string>
+#include <vector>
 #include <ubit/uattr.hpp>
 #include <ubit/uelem.hpp>
 #include <ubit/ubox.hpp>
@@ -152,9 +155,77 @@ namespace ubit {
   
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
   
+  /** [impl] Style sheet of a XML/HTML document.
+   * The class map (inherited from UElemClassMap) contains the styles of the
+   * rules that only specify an element name. The other rules (those that have
+   * a class, an id, attribute conditions or descendant/child combinators)
+   * are stored in a selector index: rules are put in a bucket according to the
+   * id, the class or the element name of their rightmost selector, so that 
+   * getMatchingRules() only examines the rules that may match a given element.
+   */
   class UStyleSheet : public UElemClassMap {
   public:
+    UStyleSheet();
     ~UStyleSheet();
+    
+    bool addRule(const UStr& selector, const UClass& style);
+    /**< adds a CSS rule to the selector index.
+     * the properties of the rule are those of style.getAttributes().
+     * A rule that has the same selector is replaced: its properties are then
+     * removed from the elements by UXmlDocument::restyle().
+     * returns false and does nothing if the selector is a simple element name
+     * (such rules are stored in the class map) or if it contains unsupported
+     * features (pseudo-classes, sibling combinators).
+     */
+    
+    void removeRules();
+    /**< removes all the rules of the selector index (the class map is unchanged).
+     * the properties of the removed rules are still recognized by isRuleProps()
+     * until clearRetiredRules() is called, so that UXmlDocument::restyle() can
+     * remove them from the elements (eg. when switching themes).
+     */
+    
+    void clearRetiredRules();
+    ///< forgets the properties of the rules that were removed by removeRules().
+    
+    int getMatchingRules(const UElem&, std::vector<UAttrList*>& props) const;
+    /**< retrieves the properties of the indexed rules that match this element.
+     * the properties are added to 'props' by increasing specificity, then by order
+     * of declaration. Returns the number of matched rules.
+     */
+    
+    bool isRuleProps(const UNode*) const;
+    ///< true if this node is the property list of an indexed (or retired) rule.
+    
+    // - - - impl. - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+#ifndef NO_DOC
+    struct Selector {           // simple selector sequence, eg. td.navigbar[title]
+      std::string tag, id;
+      std::vector<std::string> classes;
+      std::vector<std::pair<std::string,std::string> > attrs;
+      char combinator;          // ' ' or '>' with the previous selector, 0 if first
+    };
+    
+    struct Rule {
+      std::vector<Selector> selectors;   // from left to right
+      unsigned int specificity, order;
+      UAttrList* props;
+    };
+    
+    typedef std::map<std::string, std::vector<Rule*> > Bucket;
+    
+  private:
+    Bucket id_rules, class_rules, tag_rules;
+    std::vector<Rule*> universal_rules;
+    std::set<const UNode*> rule_props, retired_props;
+    unsigned int rule_count;
+    
+    static bool parseSelector(const char*, Selector&);
+    static bool matchSelector(const Selector&, const UElem&);
+    static bool matchRule(const Rule&, int index, const UElem&);
+    void addCandidates(const Bucket&, const std::string& key, 
+                       std::vector<const Rule*>&) const;
+#endif
   };
   
 }
@@ -197,6 +197,8 @@ default_background(*new UBackground(UColor::lightgrey))
 #endif
   transp_scrollbars = false;
   tele_pointers = false;      // group mode sets this mode to true
+  parallel_layout = false;
+  headless = false;
   //linear_gamma = false;     // linear gamma visual for Solaris
   generic_textsel = false;
   click_radius        = 15;	  // MUST be defined
@@ -320,6 +322,8 @@ void UConf::parseUbitOptions(int& argc, char** argv) {
   {"sfm","",      UOption::Arg(soft_menus)},
   {"tsb","",      UOption::Arg(transp_scrollbars)},
   {"telep","",    UOption::Arg(tele_pointers)},
+  {"para","llel", UOption::Arg(parallel_layout)},
+  {"headless","", UOption::Arg(headless)},
   {"group","ware",UOption::Arg(group)},
 
   {null, null, null}
@@ -379,6 +383,8 @@ void UConf::printHelp() {
   << "\n  --[no-]sfd            : soft dialogs [default = disabled]"
   << "\n  --[no-]group          : groupware mode [default = disabled]"
   << "\n  --[no-]telep          : tele pointer mode [default = disabled]"
+  << "\n  --[no-]parallel       : parallel layout on worker threads [default = disabled]"
+  << "\n  --[no-]headless       : renders windows in memory, without X11 [default = disabled]"
   << endl << endl;
 }
 
@@ -165,6 +165,12 @@ public:
     tele_pointers,
     ///< telepointers are shown when the appli is displayed on several X servers.
 
+    parallel_layout,
+    ///< independent subtrees (tabs, panes, table cells...) are laid out by worker threads [default: false].
+
+    headless,
+    ///< windows are rendered in memory and no window system is used (@see UDispHeadless) [default: false].
+
     generic_textsel;
     ///< any object can select text [default: false].
         
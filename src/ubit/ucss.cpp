@@ -45,11 +45,12 @@ struct UCssMaker: public UStyleParser::StyleMaker {
     for (unsigned int k = 0; k < count; k++) {
       const UClass* c = doc->getStyleSheet().obtainClass(*selectors[k]);
       //cerr << " *** " << *selectors[k] << endl;
-      if (k == 0) {
-        attributes = c->getAttributes();      //attributes partagee !!!
-        if (!attributes) attributes = new UAttrList;
-      }
+      // the props of a selector that is declared again are replaced (they are
+      // not appended to the previous list, which may be shared by other selectors)
+      if (k == 0) attributes = new UAttrList;
       c->setAttributes(attributes);
+      // rules with classes, ids or combinators go to the selector index
+      if (k < sources.size()) doc->getStyleSheet().addRule(sources[k], *c);
     }
   }
    
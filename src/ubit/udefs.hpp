@@ -110,6 +110,8 @@ namespace ubit {
   class UPos;
   class U3Dpos;
   class UScale;
+  class ULod;
+  class ULayer;
   class USize;
   class UPadding;
   class UOrient;
@@ -183,6 +185,7 @@ namespace ubit {
   class UUpdate;
   class URenderContext;
   class UGlcontext;
+  class UGlresources;
   
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
   // errors
@@ -235,6 +238,7 @@ namespace ubit {
   
   class UUpdateContext;
   class UWinUpdateContext;
+  struct UComputedStyle;
   class UBehavior;
   class UWinImpl;
   class USoftwinImpl;
@@ -31,8 +31,10 @@
 #include <ubit/uon.hpp>
 #include <ubit/utimer.hpp>
 #include <ubit/umsproto.hpp>
+#include <ubit/utaskpool.hpp>
 #include <ubit/nat/udispX11.hpp>
 #include <ubit/nat/udispGLUT.hpp>
+#include <ubit/nat/udispHeadless.hpp>
 //#include <ubit/nat/udispGDK.hpp>
 #include <ubit/nat/uhardfont.hpp>
 #include <ubit/nat/urendercontext.hpp>
@@ -45,6 +47,8 @@ NAMESPACE_UBIT
 
 UDisp* UDisp::create(const UStr& dname) {
   UDisp* d = null;
+  if (UAppli::conf.headless) d = new UDispHeadless(dname);
+  else
 #if UBIT_WITH_GLUT
   d = new UDispGLUT(dname);
 #elif UBIT_WITH_X11
@@ -71,7 +75,7 @@ stencil_size(UAppli::conf.stencil_size),
 screen_width(0), screen_height(0),
 screen_width_mm(0), screen_height_mm(0),
 is_opened(false), 
-default_context(null), current_glcontext(null), 
+default_context(null), current_glcontext(null), glresources(null),
 app_motion_time(0), nat_motion_time(0),
 red_mask(0), green_mask(0), blue_mask(0),
 red_shift(0), green_shift(0), blue_shift(0), 
@@ -91,6 +95,9 @@ paste_pos(0) {
 
 UDisp::~UDisp() {
   UAppli::deleteNotify(this);
+#if UBIT_WITH_GL
+  delete glresources;
+#endif
 } 
 
 /*
@@ -129,6 +136,15 @@ URenderContext* UDisp::getDefaultContext() {
   return default_context;
 }
 
+UGlresources* UDisp::getGlresources() {
+#if UBIT_WITH_GL
+  if (!glresources) glresources = new UGlresources(this);
+  return glresources;
+#else
+  return null;
+#endif
+}
+
 void UDisp::makeDefaultContextCurrentIfNeeded() {
   if (!UAppli::isUsingGL()) return;
   
@@ -280,9 +296,23 @@ void UDisp::countBits(unsigned long mask, int& bits, int& shift) {
 
 UHardFont* UDisp::getFont(const UFontDesc* f) { // !NOTE: may change the glcontext!
   if (!f) return null;
-  makeDefaultContextCurrentIfNeeded();
-   
   const UFontFamily& ff = *(f->family);
+
+  // worker threads (parallel layout) can neither realize fonts nor change
+  // the glcontext: the task is then performed again in the main thread.
+  // FTGL fonts are excluded because their glyphs are lazily created in the glcontext.
+  if (UTask::inWorkerThread()) {
+    if (UAppli::conf.isUsingFreeType()
+        || !ff.ready || ff.ffindex >= (signed)font_map.size() || !font_map[ff.ffindex]
+        || f->findex < 0 || !font_map[ff.ffindex][f->findex]) {
+      UTask::requireMainThread();
+      return null;
+    }
+    return font_map[ff.ffindex][f->findex];
+  }
+
+  makeDefaultContextCurrentIfNeeded();
+
   if (!ff.ready || ff.ffindex >= (signed)font_map.size() || !font_map[ff.ffindex] 
       || f->findex < 0 || !font_map[ff.ffindex][f->findex])
     return realizeFont(*f);
@@ -200,6 +200,9 @@ public:
 public:
   URenderContext* getDefaultContext();  
   void makeDefaultContextCurrentIfNeeded();
+
+  UGlresources* getGlresources();
+  ///< returns the GL resources (textures) that are shared by the glcontexts of this display (OpenGL mode only).
   
   void addHardwin(UWin*);
   void removeHardwin(UWin*);
@@ -285,8 +288,11 @@ private:
   friend class UFontMetrics;
   friend class UGlcontext;
   friend class UGlcanvas;
+  friend class UGlresources;
   friend class ULength;
   friend class UFont;
+  friend class UEventRecorder;
+  friend class UEventReplayer;
   UDisp(const UDisp&);
   UDisp& operator=(const UDisp&); 
   
@@ -311,6 +317,7 @@ protected:
   bool is_opened;
   URenderContext *default_context;
   const UGlcontext *current_glcontext;
+  UGlresources *glresources;
   std::vector<UHardFont**> font_map;
   unsigned long app_motion_time, nat_motion_time;  // for lag control
   unsigned long black_pixel, white_pixel, red_mask, green_mask, blue_mask;
@@ -15,6 +15,7 @@
  * ***********************************************************************/
 
 #include <typeinfo>
+#include <algorithm>
 #include <iostream>
 #include <cstdio>
 #include <ubit/ubit_features.h>
@@ -228,6 +229,10 @@ void UXmlDocument::initElement(UElem* e) {
     // cette fonctionnalite n'est pas standard !!!
     if (c) e->addImpl1(c->getAttributes(), e->abegin(), e->attributes());  // reafficher ????
   //}
+  
+  // the rules that depend on classes, ids or ancestors are applied at this stage
+  // because the element has been added to its parent and its attributes are set
+  restyleElement(e);
   e->initNode(this);
 }
 
@@ -265,33 +270,50 @@ void UXmlDocument::setIdStyle(UElem* e, const UStr& name, const UStr& value) {
 
 void UXmlDocument::setClassIdStyle(UElem* e, const UStr& att_name, const UStr& att_value) 
 {
-  if (att_name.empty() /*|| !att_value*/) return;
-  char fullname[1000];  // ATT MAX LEN !!
-  const UClass* id = null;
-  
-  // NB: generalisable a tous les attributs
+  if (!e || att_name.empty()) return;
+  // when the document is parsed, the attributes are initialized before the element
+  // is added to its parent: the rules will then be applied by initElement()
+  if (e->pbegin() != e->pend()) restyleElement(e);
+}
+
+bool UXmlDocument::restyleElement(UElem* e) {
+  if (!e) return false;
+  const UStyleSheet& sheet = getStyleSheet();
   
-  if (att_value.empty())
-    sprintf(fullname, "[%s]", att_name.c_str());
-  else
-    sprintf(fullname, "[%s=%s]", att_name.c_str(), att_value.c_str());
+  std::vector<UAttrList*> matched;
+  sheet.getMatchingRules(*e, matched);
   
-  if ((id = getStyleSheet().findClass(fullname)))
-    _addProp(e, id->getAttributes());
-  //cerr <<"setClassIdStyle1 "<<fullname << " " << id
-  //  <<" : "<< *att_name <<"="<< *att_value <<endl;
+  std::vector<UNode*> current;
+  for (UChildIter i = e->abegin(); i != e->aend(); ++i) {
+    if (sheet.isRuleProps(*i)) current.push_back(*i);
+  }
   
-  if (att_value.empty())
-    sprintf(fullname, "%s[%s]", e->getNodeName().c_str(), att_name.c_str());
-  else
-    sprintf(fullname, "%s[%s=%s]", e->getNodeName().c_str(), 
-            att_name.c_str(), att_value.c_str());
+  if (current.size() == matched.size()
+      && std::equal(current.begin(), current.end(), matched.begin())) 
+    return false;   // unchanged
   
-  if ((id = getStyleSheet().findClass(fullname)))
-    _addProp(e, id->getAttributes());
+  for (unsigned int k = 0; k < current.size(); k++) 
+    e->removeAttr(*current[k], false);   // the rules own their props
   
-  //cerr <<"setClassIdStyle2 "<<fullname << " " << id
-  //  <<" : "<< *att_name <<"="<< *att_value <<endl;
+  // by increasing specificity, after the class props and before the style attr
+  for (unsigned int k = 0; k < matched.size(); k++) _addProp(e, matched[k]);
+  return true;
+}
+
+int UXmlDocument::restyle() {
+  int count = doc_elem ? restyleImpl(doc_elem) : 0;
+  // the props of the removed rules have been removed from all the elements
+  doc_stylesheet.clearRetiredRules();
+  return count;
+}
+
+int UXmlDocument::restyleImpl(UElem* e) {
+  int count = restyleElement(e) ? 1 : 0;
+  for (UChildIter i = e->cbegin(); i != e->cend(); ++i) {
+    UElem* child = (*i)->toElem();
+    if (child) count += restyleImpl(child);
+  }
+  return count;
 }
 
 /* ==================================================== ======== ======= */
@@ -133,6 +133,23 @@ namespace ubit {
     virtual void setClassStyle(UElem*, const UStr& name, const UStr& value);
     virtual void setIdStyle(UElem*, const UStr& name, const UStr& value);
     
+    virtual bool restyleElement(UElem*);
+    /**< updates the stylesheet rules that apply to this element.
+     * this function must be called when the class, the id or the attributes of
+     * an element that belongs to the document have changed. The ATTRIBUTE list
+     * of the element is only modified if the matching rules have changed.
+     * Returns true in this case.
+     */
+    
+    virtual int restyle();
+    /**< updates the stylesheet rules that apply to all the elements of the document.
+     * this function should be called after changing the stylesheet (eg. when
+     * switching themes). Only the elements whose matching rules have changed
+     * are modified. The properties of the rules that were removed by
+     * UStyleSheet::removeRules() are removed from the elements, then forgotten.
+     * Returns the number of modified elements.
+     */
+    
     virtual void addGrammar(const UXmlGrammar&);
     ///< adds a grammar to the document.
     
@@ -166,6 +183,7 @@ namespace ubit {
     UDocAttachments attachments;
     void constructs();
     virtual void setClassIdStyle(UElem*, const UStr& name, const UStr& value);
+    int restyleImpl(UElem*);
   };
   
   /* ==================================================== ======== ======= */
@@ -25,6 +25,7 @@
 #include <ubit/ucursor.hpp>
 #include <ubit/uboxgeom.hpp>
 #include <ubit/uappliImpl.hpp>
+#include <ubit/utaskpool.hpp>
 using namespace std;
 #define NAMESPACE_UBIT namespace ubit {
 NAMESPACE_UBIT
@@ -72,6 +73,7 @@ UElem::UElem(UArgs a) {
   memset(&emodes, 0, sizeof(emodes));
   emodes.IS_SHOWABLE = true;
   ostate = UOn::IDLE;
+  computed_style = null;
   
   // call add-initialization procedure of child (VOIR aussi: add())
   // NB: duplication des liens  
@@ -96,6 +98,12 @@ UElem::~UElem() {
   destructs();
   //moved in destructs
   //UAppli::deleteNotify(this);  // tells the appli the object is being deleted
+  delete computed_style;
+}
+
+void UElem::invalidateComputedStyle() const {
+  delete computed_style;
+  computed_style = null;
 }
 
 // ATTENTION:
@@ -380,16 +388,19 @@ UElem& UElem::setAttr(UNode& attr) {   // DEVRAIT UTILISER UNE MAP!!!!
  }
 
 UElem& UElem::addAttr(const UArgs& nodes) {  // A REMPLACER PAR setAttr !!!
+  invalidateComputedStyle();
   return addImpl(nodes, aend(), attributes());
 }
 
 UElem& UElem::removeAttr(UNode& c, bool autodel) {
   UChildIter it = attributes().find(c);
   if (it == aend()) return *this;   // no error if not found
+  invalidateComputedStyle();
   return removeImpl(it, 1, autodel, attributes());
 }
 
 UElem& UElem::removeAllAttrs(bool autodel) {
+  invalidateComputedStyle();
   return removeImpl(abegin(), -1, autodel, attributes());
 }
 
@@ -714,6 +725,21 @@ UElem& UElem::setCrossable(bool state) {
   return *this;
 }
 
+// the modes are only written by the main thread as the elements may be shared
+// by the subtrees that are laid out by worker threads
+
+void UElem::setWidthUnresizable(bool state) {
+  if (emodes.IS_WIDTH_UNRESIZABLE == state) return;
+  if (UTask::inWorkerThread()) UTask::requireMainThread();
+  else emodes.IS_WIDTH_UNRESIZABLE = state;
+}
+
+void UElem::setHeightUnresizable(bool state) {
+  if (emodes.IS_HEIGHT_UNRESIZABLE == state) return;
+  if (UTask::inWorkerThread()) UTask::requireMainThread();
+  else emodes.IS_HEIGHT_UNRESIZABLE = state;
+}
+
 UElem& UElem::ignoreEvents(bool state)  {
   emodes.IGNORE_EVENTS = state;
   return *this;
@@ -487,6 +487,13 @@ namespace ubit {
     bool isVertical() const {return emodes.IS_VERTICAL;}    // && HAS_ORIENT ?  !!!!
     bool isWidthResizable()  const {return !emodes.IS_WIDTH_UNRESIZABLE;}
     bool isHeightResizable() const {return !emodes.IS_HEIGHT_UNRESIZABLE;}
+    
+    void setWidthUnresizable(bool);
+    void setHeightUnresizable(bool);
+    /**< [impl] changes the resizable modes (called by the layout).
+     * worker threads do not change the modes of the elements: they call
+     * UTask::requireMainThread() if the modes must be changed (@see UTaskPool).
+     */
     virtual bool isSubWin() const {return false;}  // redefined by USunWin => MUST be virtual!
     
     void disableMenuClosing(bool s = true) {emodes.DONT_CLOSE_MENUS = s;}
@@ -563,6 +570,11 @@ namespace ubit {
     virtual const UStr* getTextSeparator() const;
     ///< returns the text separator used by retrieveText() for separating enclosed children
     
+    void invalidateComputedStyle() const;
+    /* [impl] discards the cached result of the style cascade (@see UComputedStyle).
+     * called automatically when the ATTRIBUTE list changes.
+     */
+    
     virtual void deleteViewsInside(const std::vector<UView*>& parent_views);
     
     virtual void initView(UView* parent_view);
@@ -622,6 +634,7 @@ namespace ubit {
     mutable Modes emodes;
     long callback_mask;
     mutable UChildren _children;
+    mutable UComputedStyle* computed_style;  // cached style cascade, null if none
     virtual int   _getTextLength(bool recursive) const;
     virtual char* _getTextData(char *ptr, bool recursive) const;
 #endif
@@ -25,6 +25,7 @@
 #include <ubit/uappliImpl.hpp>
 #include <ubit/uevent.hpp>
 #include <ubit/ueventflow.hpp>
+#include <ubit/ueventlog.hpp>
 #include <ubit/uselection.hpp>
 #include <ubit/upix.hpp>
 #include <ubit/uon.hpp>
@@ -193,6 +194,9 @@ void UEventFlow::redirectMousePress(UMouseEvent& e, UView* winview) {
 void UEventFlow::mousePress(UView* winview, unsigned long time, int state, 
                             const UPoint& win_pos, const UPoint& screen_pos, int btn) 
 {
+  if (UEventRecorder::current)
+    UEventRecorder::current->record(UEventLog::MOUSE_PRESS, *this, winview, time, state,
+                                    win_pos, screen_pos, btn);
   UWin* modalwin = static_cast<UWin*>(UAppli::impl.modalwins->getChild(0)); //@@@??? why 0 ??
   if (modalwin && modalwin != winview->getBox()) {  // box outside modalwin
     modalwin->highlight(true);
@@ -269,6 +273,9 @@ AGAIN:
 void UEventFlow::mouseRelease(UView* winview, unsigned long time, int state, 
                               const UPoint& win_pos, const UPoint& screen_pos, int btn) 
 {  
+  if (UEventRecorder::current)
+    UEventRecorder::current->record(UEventLog::MOUSE_RELEASE, *this, winview, time, state,
+                                    win_pos, screen_pos, btn);
   //if (UAppli::hasTelePointers()) showTelePointers(e, -1);
   // security if the crossing was not detected by boxMotion()
   //boxCross(e.source_view, e.when, e.state, UElem::NORMAL);
@@ -328,6 +335,9 @@ void UEventFlow::mouseRelease(UView* winview, unsigned long time, int state,
 
 void UEventFlow::mouseMotion(UView* winview, unsigned long time, int state,
                              const UPoint& win_pos, const UPoint& screen_pos) {
+  if (UEventRecorder::current)
+    UEventRecorder::current->record(UEventLog::MOUSE_MOTION, *this, winview, time, state,
+                                    win_pos, screen_pos);
   // MOUSE_DRAG CASE
   if (lastPressed.view) {
     // NB: if lastPressed is set there is no reason to check the modal dialog condition
@@ -412,6 +422,9 @@ AGAIN:
 void UEventFlow::wheelMotion(UView* winview, unsigned long time, int state, 
                              const UPoint& win_pos, const UPoint& screen_pos,
                              int type, int delta) {
+  if (UEventRecorder::current)
+    UEventRecorder::current->record(UEventLog::WHEEL_MOTION, *this, winview, time, state,
+                                    win_pos, screen_pos, delta, type);
   UWin* modalwin = static_cast<UWin*>(UAppli::impl.modalwins->getChild(0));
   if (modalwin && modalwin != winview->getBox()) {  // box outside modalwin
     modalwin->highlight(true);
@@ -456,6 +469,9 @@ AGAIN:
 
 void UEventFlow::keyPress(UView* winview, unsigned long time, int state,
                           int keycode, short keychar) {
+  if (UEventRecorder::current)
+    UEventRecorder::current->record(UEventLog::KEY_PRESS, *this, winview, time, state,
+                                    UPoint(), UPoint(), keycode, keychar);
   if (currentFocus == null) {
     //cerr <<  "winKeyPress: NO CURRENT FOCUS"<<endl;
     return;
@@ -483,6 +499,9 @@ void UEventFlow::keyPress(UView* winview, unsigned long time, int state,
 
 void UEventFlow::keyRelease(UView* winview, unsigned long time, int state,
                             int keycode, short keychar) {
+  if (UEventRecorder::current)
+    UEventRecorder::current->record(UEventLog::KEY_RELEASE, *this, winview, time, state,
+                                    UPoint(), UPoint(), keycode, keychar);
   if (currentFocus == null) {
     //cerr <<  "winKeyRelease: NO CURRENT FOCUS"<<endl;
     return;
@@ -512,6 +531,9 @@ void UEventFlow::keyRelease(UView* winview, unsigned long time, int state,
 */
   
 void UEventFlow::winEnter(UView* winview, unsigned long time) {                         
+  if (UEventRecorder::current)
+    UEventRecorder::current->record(UEventLog::WIN_ENTER, *this, winview, time, 0,
+                                    UPoint(), UPoint());
                             // !!! A COMPLETER....
   //UBehavior bp(UBehavior::MOUSE);
   //boxCross(winview, time, 0, bp); 
@@ -520,6 +542,9 @@ void UEventFlow::winEnter(UView* winview, unsigned long time) {
 }
   
 void UEventFlow::winLeave(UView* winview, unsigned long time) {
+  if (UEventRecorder::current)
+    UEventRecorder::current->record(UEventLog::WIN_LEAVE, *this, winview, time, 0,
+                                    UPoint(), UPoint());
   // ATTENTION: le XGrab genere des LeaveWindow qd on ouvre le menu associe a un 
   // bouton et qd on bouge la souris sur ce bouton une fois que le menu est ouvert.
   // Ne pas en tenir compte sinon le bouton ouvrant oscille entre Enter et Leave 
@@ -0,0 +1,384 @@
+/************************************************************************
+ *
+ *  ueventlog.cpp: recording and replay of input events
+ *  Ubit GUI Toolkit - Version 6
+ *  (C) 2009 | Eric Lecolinet | TELECOM ParisTech | http://www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#include <ubit/ubit_features.h>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include <algorithm>
+#include <ubit/ueventlog.hpp>
+#include <ubit/ueventflow.hpp>
+#include <ubit/uappli.hpp>
+#include <ubit/uappliImpl.hpp>
+#include <ubit/udisp.hpp>
+#include <ubit/uwin.hpp>
+#include <ubit/uwinImpl.hpp>
+#include <ubit/ugeom.hpp>
+using namespace std;
+#define NAMESPACE_UBIT namespace ubit {
+NAMESPACE_UBIT
+
+static const char LOG_MAGIC[] = "UBEVLOG1";   // the last char is the version
+
+UEventLog::Record::Record() :
+type(0), time(0), channel(0), win(0), state(0), x(0), y(0),
+screen_x(0), screen_y(0), detail(0), detail2(0) {}
+
+UEventLog::UEventLog() : file(null), last_time(0) {}
+
+UEventLog::~UEventLog() {close();}
+
+void UEventLog::close() {
+  if (file) fclose(file);
+  file = null;
+}
+
+bool UEventLog::openWrite(const char* filename) {
+  close();
+  if (!filename || !(file = fopen(filename, "wb"))) return false;
+  last_time = 0;
+  return fwrite(LOG_MAGIC, 1, sizeof(LOG_MAGIC)-1, file) == sizeof(LOG_MAGIC)-1;
+}
+
+bool UEventLog::openRead(const char* filename) {
+  close();
+  if (!filename || !(file = fopen(filename, "rb"))) return false;
+  last_time = 0;
+  char magic[sizeof(LOG_MAGIC)-1];
+  if (fread(magic, 1, sizeof(magic), file) != sizeof(magic)
+      || memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// same encoding as UOutbuf::writeVarint() and writeSVarint()
+
+static void putVarint(FILE* f, unsigned long v) {
+  while (v >= 0x80) {
+    putc(int((v & 0x7f) | 0x80), f);
+    v >>= 7;
+  }
+  putc(int(v), f);
+}
+
+static void putSVarint(FILE* f, long v) {
+  putVarint(f, (v << 1) ^ (v >> (sizeof(long)*8 - 1)));
+}
+
+static bool getVarint(FILE* f, unsigned long& v) {
+  v = 0;
+  for (unsigned int shift = 0; shift < sizeof(long)*8; shift += 7) {
+    int c = getc(f);
+    if (c == EOF) return false;
+    v |= (unsigned long)(c & 0x7f) << shift;
+    if ((c & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+static bool getSVarint(FILE* f, long& v) {
+  unsigned long u;
+  if (!getVarint(f, u)) return false;
+  v = long(u >> 1) ^ -long(u & 1);
+  return true;
+}
+
+static bool getInt(FILE* f, int& v) {
+  unsigned long u;
+  if (!getVarint(f, u)) return false;
+  v = int(u);
+  return true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+bool UEventLog::write(const Record& r) {
+  if (!file) return false;
+  putc(r.type, file);
+  putSVarint(file, long(r.time - last_time));
+  last_time = r.time;
+  putVarint(file, r.channel);
+  putVarint(file, r.win);
+
+  switch (r.type) {
+    case WIN_ENTER:
+    case WIN_LEAVE:
+      break;
+    case KEY_PRESS:
+    case KEY_RELEASE:
+      putVarint(file, r.state);
+      putVarint(file, r.detail);
+      putSVarint(file, r.detail2);
+      break;
+    default:
+      putVarint(file, r.state);
+      putSVarint(file, r.x);
+      putSVarint(file, r.y);
+      // the pos of the window in the screen rarely changes
+      putSVarint(file, r.screen_x - r.x);
+      putSVarint(file, r.screen_y - r.y);
+      if (r.type != MOUSE_MOTION) {
+        putSVarint(file, r.detail);
+        putSVarint(file, r.detail2);
+      }
+      break;
+  }
+  return !ferror(file);
+}
+
+bool UEventLog::read(Record& r) {
+  if (!file) return false;
+  int type = getc(file);
+  if (type < MOUSE_PRESS || type > WIN_LEAVE) return false;   // EOF or corrupted
+
+  r = Record();
+  r.type = type;
+  long dt, v;
+  if (!getSVarint(file, dt) || !getInt(file, r.channel) || !getInt(file, r.win))
+    return false;
+  r.time = last_time = last_time + dt;
+
+  switch (type) {
+    case WIN_ENTER:
+    case WIN_LEAVE:
+      return true;
+    case KEY_PRESS:
+    case KEY_RELEASE:
+      if (!getInt(file, r.state) || !getInt(file, r.detail) || !getSVarint(file, v))
+        return false;
+      r.detail2 = int(v);
+      return true;
+    default:
+      if (!getInt(file, r.state) || !getSVarint(file, r.x) || !getSVarint(file, r.y)
+          || !getSVarint(file, r.screen_x) || !getSVarint(file, r.screen_y))
+        return false;
+      r.screen_x += r.x;
+      r.screen_y += r.y;
+      if (type != MOUSE_MOTION) {
+        if (!getSVarint(file, v)) return false;
+        r.detail = int(v);
+        if (!getSVarint(file, v)) return false;
+        r.detail2 = int(v);
+      }
+      return true;
+  }
+}
+
+/* ==================================================== ===== ======= */
+
+UEventRecorder* UEventRecorder::current = null;
+
+UEventRecorder::UEventRecorder() {}
+
+UEventRecorder::~UEventRecorder() {stop();}
+
+bool UEventRecorder::start(const char* filename) {
+  if (current) current->stop();
+  if (!log.openWrite(filename)) {
+    UAppli::error("UEventRecorder::start","can't open file '%s'", filename ? filename : "");
+    return false;
+  }
+  current = this;
+  return true;
+}
+
+void UEventRecorder::stop() {
+  if (current == this) current = null;
+  log.close();
+}
+
+void UEventRecorder::record(int type, UEventFlow& flow, UView* winview,
+                            unsigned long time, int state,
+                            const UPoint& win_pos, const UPoint& screen_pos,
+                            int detail, int detail2) {
+  if (!winview || !winview->getHardwin()) return;
+
+  // index of the window in the display
+  UDisp::HardwinList& hwl = flow.getDisp().hardwin_list;
+  int win = 0;
+  UDisp::HardwinList::iterator k = hwl.begin();
+  for ( ; k != hwl.end(); ++k, ++win) {
+    if (*k == winview->getHardwin()) break;
+  }
+  if (k == hwl.end()) return;
+
+  UEventLog::Record r;
+  r.type = type;
+  r.time = time;
+  r.channel = flow.getChannel();
+  r.win = win;
+  r.state = state;
+  r.x = long(win_pos.x);
+  r.y = long(win_pos.y);
+  r.screen_x = long(screen_pos.x);
+  r.screen_y = long(screen_pos.y);
+  r.detail = detail;
+  r.detail2 = detail2;
+  if (!log.write(r)) {
+    UAppli::error("UEventRecorder::record","can't write the log: recording stopped");
+    stop();
+  }
+}
+
+/* ==================================================== ===== ======= */
+
+bool UEventProfile::enabled = false;
+unsigned long UEventProfile::time[2] = {0, 0};
+int UEventProfile::depth[2] = {0, 0};
+
+unsigned long UEventProfile::now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+/* ==================================================== ===== ======= */
+
+UEventReplayer::UEventReplayer(UDisp* d) : disp(d), skipped(0) {}
+
+UView* UEventReplayer::findWinView(int win) const {
+  UDisp::HardwinList& hwl = disp->hardwin_list;
+  UDisp::HardwinList::iterator k = hwl.begin();
+  for (int n = 0; k != hwl.end() && n < win; ++k, ++n) ;
+  if (k == hwl.end() || !*k || !(*k)->getWin()) return null;
+  return (*k)->getWin()->getWinView(disp);
+}
+
+void UEventReplayer::dispatch(UEventFlow& f, UView* winview, const UEventLog::Record& r) {
+  UPoint win_pos(r.x, r.y), screen_pos(r.screen_x, r.screen_y);
+
+  switch (r.type) {
+    case UEventLog::MOUSE_PRESS:
+      f.mousePress(winview, r.time, r.state, win_pos, screen_pos, r.detail);
+      break;
+    case UEventLog::MOUSE_RELEASE:
+      f.mouseRelease(winview, r.time, r.state, win_pos, screen_pos, r.detail);
+      break;
+    case UEventLog::MOUSE_MOTION:
+      f.mouseMotion(winview, r.time, r.state, win_pos, screen_pos);
+      break;
+    case UEventLog::WHEEL_MOTION:
+      f.wheelMotion(winview, r.time, r.state, win_pos, screen_pos, r.detail2, r.detail);
+      break;
+    case UEventLog::KEY_PRESS:
+      f.keyPress(winview, r.time, r.state, r.detail, short(r.detail2));
+      break;
+    case UEventLog::KEY_RELEASE:
+      f.keyRelease(winview, r.time, r.state, r.detail, short(r.detail2));
+      break;
+    case UEventLog::WIN_ENTER:
+      f.winEnter(winview, r.time);
+      break;
+    case UEventLog::WIN_LEAVE:
+      f.winLeave(winview, r.time);
+      break;
+  }
+}
+
+bool UEventReplayer::replay(const char* filename, bool realtime) {
+  UEventLog log;
+  if (!log.openRead(filename)) {
+    UAppli::error("UEventReplayer::replay","can't read file '%s'", filename ? filename : "");
+    return false;
+  }
+  if (!disp) disp = UAppli::getDisp();
+  UAppliImpl& a = UAppli::impl;
+  timings.clear();
+  skipped = 0;
+
+  // the windows must be up to date before measuring anything
+  if (a.request_mask) a.processPendingRequests();
+
+  UEventLog::Record r;
+  unsigned long due = UEventProfile::now(), prev_time = 0;
+  bool first = true;
+
+  while (log.read(r)) {
+    // the times may wrap around or not be ordered: the delay since the previous
+    // event is signed and an event is never due before the previous one
+    long delay = first ? 0 : long(r.time - prev_time);
+    if (delay > 0) due += delay * 1000;
+    prev_time = r.time;
+    first = false;
+
+    if (realtime) {   // waits until the event is due (the timers are fired meanwhile)
+      while (UEventProfile::now() < due) {
+        a.timer_impl.fireTimers();
+        if (a.request_mask) a.processPendingRequests();
+        unsigned long now = UEventProfile::now();
+        if (now < due) usleep(std::min(due - now, 1000UL));
+      }
+    }
+
+    UView* winview = findWinView(r.win);
+    if (!winview) {skipped++; continue;}
+    UEventFlow* f = disp->obtainChannelFlow(r.channel);
+    if (!f) {skipped++; continue;}
+
+    UEventProfile::enabled = true;
+    UEventProfile::time[UEventProfile::LAYOUT] = 0;
+    UEventProfile::time[UEventProfile::PAINT] = 0;
+    unsigned long t0 = UEventProfile::now();
+
+    dispatch(*f, winview, r);
+    if (a.request_mask) a.processPendingRequests();
+
+    unsigned long total = UEventProfile::now() - t0;
+    UEventProfile::enabled = false;
+    Timing t;
+    t.type = r.type;
+    t.layout = UEventProfile::time[UEventProfile::LAYOUT];
+    t.paint = UEventProfile::time[UEventProfile::PAINT];
+    t.dispatch = total > t.layout + t.paint ? total - t.layout - t.paint : 0;
+    timings.push_back(t);
+  }
+  return true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+static void printStats(ostream& out, const char* name, vector<unsigned long>& v) {
+  if (v.empty()) return;
+  sort(v.begin(), v.end());
+  double sum = 0;
+  for (unsigned int k = 0; k < v.size(); ++k) sum += v[k];
+  out << "  " << name
+      << "\tmean " << sum / v.size()
+      << "\tmedian " << v[v.size() / 2]
+      << "\t95% " << v[(v.size() * 95) / 100]
+      << "\tmax " << v.back() << endl;
+}
+
+void UEventReplayer::printReport(ostream& out) const {
+  out << "UEventReplayer: " << timings.size() << " events replayed, "
+      << skipped << " skipped (times in microsec)" << endl;
+  vector<unsigned long> dispatch, layout, paint, total;
+  for (unsigned int k = 0; k < timings.size(); ++k) {
+    dispatch.push_back(timings[k].dispatch);
+    layout.push_back(timings[k].layout);
+    paint.push_back(timings[k].paint);
+    total.push_back(timings[k].dispatch + timings[k].layout + timings[k].paint);
+  }
+  printStats(out, "dispatch", dispatch);
+  printStats(out, "layout", layout);
+  printStats(out, "paint", paint);
+  printStats(out, "total", total);
+}
+
+}
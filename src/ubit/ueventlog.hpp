@@ -0,0 +1,186 @@
+/************************************************************************
+ *
+ *  ueventlog.hpp: recording and replay of input events
+ *  Ubit GUI Toolkit - Version 6
+ *  (C) 2009 | Eric Lecolinet | TELECOM ParisTech | http://www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#ifndef _ueventlog_hpp_
+#define	_ueventlog_hpp_ 1
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <ubit/udefs.hpp>
+namespace ubit {
+
+  class UPoint;
+
+  /** file of input events (@see UEventRecorder and UEventReplayer).
+   * the events are those received by the UEventFlow(s) of the application.
+   * They are stored in a compact binary format: each event is a type byte
+   * followed by variable length integers (the time is the delay since the
+   * previous event).
+   */
+  class UEventLog {
+  public:
+    enum Type {
+      MOUSE_PRESS = 1, MOUSE_RELEASE, MOUSE_MOTION, WHEEL_MOTION,
+      KEY_PRESS, KEY_RELEASE, WIN_ENTER, WIN_LEAVE
+    };
+
+    struct Record {
+      Record();
+      int type;              ///< one of the Type values.
+      unsigned long time;    ///< time of the event (millisec).
+      int channel;           ///< channel of the event flow (0 for the native flow).
+      int win;               ///< index of the window in the display (@see UEventRecorder).
+      int state;             ///< button and modifier mask.
+      long x, y;             ///< position in the window.
+      long screen_x, screen_y;  ///< position in the screen.
+      int detail;            ///< button, keycode or wheel delta.
+      int detail2;           ///< keychar or wheel type.
+    };
+
+    UEventLog();
+    ~UEventLog();
+
+    bool openWrite(const char* filename);
+    bool openRead(const char* filename);
+    ///< opens the file for writing or reading; returns false if this is not possible.
+
+    void close();
+    bool isOpened() const {return file != null;}
+
+    bool write(const Record&);
+    bool read(Record&);
+    ///< reads the next event; returns false at the end of the file (or if it is corrupted).
+
+  private:
+    UEventLog(const UEventLog&);
+    UEventLog& operator=(const UEventLog&);
+    FILE* file;
+    unsigned long last_time;
+  };
+
+  /* ==================================================== ===== ======= */
+  /** records the input events of the application.
+   * the events received by all the UEventFlow(s) are written in a UEventLog
+   * until stop() is called or the recorder is destroyed. Windows are identified
+   * by their index in the display: the application must create its windows in
+   * the same order when the log is replayed.
+   */
+  class UEventRecorder {
+  public:
+    UEventRecorder();
+    ~UEventRecorder();
+
+    bool start(const char* filename);
+    ///< starts recording in this file (stops the recorder that was running, if any).
+
+    void stop();
+    bool isRecording() const {return current == this;}
+
+    void record(int type, UEventFlow&, UView* winview, unsigned long time, int state,
+                const UPoint& win_pos, const UPoint& screen_pos,
+                int detail = 0, int detail2 = 0);
+    ///< [impl] called by UEventFlow.
+
+    static UEventRecorder* current;
+    ///< [impl] the recorder that is running (null if none).
+
+  private:
+    UEventLog log;
+  };
+
+  /* ==================================================== ===== ======= */
+  /** replays the input events of a UEventLog and measures their processing time.
+   * each event is given to the corresponding UEventFlow, then the pending update
+   * requests are processed, as in the main loop. The time spent in dispatching
+   * the event, in computing the layout and in painting is measured for each event.
+   * replay() does not need the main loop to be running, but the windows that
+   * were shown when the log was recorded must be realized.
+   *
+   * Example:
+   * <pre>
+   *    UEventReplayer r;
+   *    r.replay("session.log");     // as fast as possible
+   *    r.printReport(cout);
+   * </pre>
+   */
+  class UEventReplayer {
+  public:
+    struct Timing {
+      int type;                 ///< type of the event (@see UEventLog::Type).
+      unsigned long dispatch;   ///< time spent in dispatching the event (microsec).
+      unsigned long layout;     ///< time spent in computing the layout (microsec).
+      unsigned long paint;      ///< time spent in painting (microsec).
+    };
+
+    UEventReplayer(UDisp* = null);
+    ///< replays the events on this display (the default display if null).
+
+    bool replay(const char* filename, bool realtime = false);
+    /**< replays the events of this file.
+     * the events are replayed as fast as possible, or at the speed they were
+     * recorded if 'realtime' is true (the timers are then also fired).
+     * returns false if the file can't be read.
+     */
+
+    const std::vector<Timing>& getTimings() const {return timings;}
+    ///< returns the timings of the events that were replayed.
+
+    int getSkippedCount() const {return skipped;}
+    ///< returns the number of events that were ignored because their window did not exist.
+
+    void printReport(std::ostream&) const;
+    ///< prints the mean, median, 95th percentile and max of the timings.
+
+  private:
+    UView* findWinView(int win) const;
+    void dispatch(UEventFlow&, UView* winview, const UEventLog::Record&);
+    UDisp* disp;
+    std::vector<Timing> timings;
+    int skipped;
+  };
+
+  /* ==================================================== ===== ======= */
+  /** [impl] measures the time spent in layout and paint during a replay.
+   * UView creates a Scope when it computes a layout or paints a window.
+   * Nothing is measured unless 'enabled' is true.
+   */
+  class UEventProfile {
+  public:
+    enum Phase {LAYOUT, PAINT};
+    static bool enabled;
+    static unsigned long time[2];   ///< time spent in each phase (microsec)
+    static unsigned long now();     ///< monotonic time in microsec.
+
+    class Scope {
+    public:
+      Scope(Phase p) : phase(p), counted(enabled), start(0) {
+        if (counted && depth[phase]++ == 0) start = now();
+      }
+      ~Scope() {
+        if (counted && --depth[phase] == 0) time[phase] += now() - start;
+      }
+    private:
+      Phase phase;
+      bool counted;
+      unsigned long start;
+    };
+
+  private:
+    static int depth[2];
+  };
+
+}
+#endif
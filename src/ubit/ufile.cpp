@@ -23,6 +23,7 @@
 #include <ctime>
 #include <algorithm>
 #include <unistd.h>
+#include <fcntl.h>
 #include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -98,6 +99,14 @@ namespace ubit {
     stat(fullpath);
   }
   
+  UFileInfo::UFileInfo(const char* _name, int _mode, unsigned long _size,
+                       unsigned long _modtime) {
+    pname = new UStr(_name);
+    mode = _mode;
+    size = _size;
+    modtime = _modtime;
+  }
+  
   void UFileInfo::setPath(const UStr& path) {
     pname = new UStr(path);
     stat(path.c_str());
@@ -286,6 +295,33 @@ namespace ubit {
     else return strcmp(e1->pname->c_str(), e2->pname->c_str()) < 0;
   }
   
+  // skips . and .. and, depending on the mode, hidden files and files without this prefix
+  static bool skipEntry(const char* dname, const char* prefix, int prefix_len,
+                        bool hidden_files) {
+    if (dname[0] == 0) return true;
+    else if (dname[0]=='.') {
+      // skip .
+      if (dname[1]==0) return true;
+      // skip ..
+      else if (dname[1]=='.' && dname[2]==0) return true;
+      // skip files starting by . depending on mode
+      else if (!hidden_files) return true;
+    }
+    // SKIP si ne correspond pas au filtre (sauf ..)
+    if (prefix && strncmp(dname, prefix, prefix_len) != 0) return true;
+    return false;
+  }
+  
+  // lstat relatively to the directory (the path of the file is not parsed again)
+  static int statEntry(::DIR* dirp, const char* dname, struct stat& st) {
+    // lstat pour eviter de suivre les liens (ce qui peut provoquer
+    // des blocages quand les fichiers sont indisponibles par nfs)
+    if (::fstatat(dirfd(dirp), dname, &st, AT_SYMLINK_NOFOLLOW) == 0) return st.st_mode;
+    st.st_size = 0;
+    st.st_mtime = 0;
+    return 0;
+  }
+  
   static bool matchFilters(const char* dname, const std::vector<UStr*>& filters) {
     const char* ext = UCstr::suffix(dname);
     if (!ext || !*ext) return false;      // no suffix
@@ -314,66 +350,26 @@ namespace ubit {
     if (!dirp) return;    // ce directory n'existe pas
     
     parseFilter(filters, filter);
-    int pathlen = dir_info.pname->length();
-    
-    // fullpath = chemin d'acces complet des fichiers
-    char* fullpath = new char[pathlen + 1000];
-    strcpy(fullpath, dir_info.pname->c_str());
-    
-    // pointe sur le debut du nom de fichier dans le fullpath
-    char *namepos = null;;
-    if (fullpath[pathlen-1] != '/') {
-      fullpath[pathlen]   = '/';
-      fullpath[pathlen+1] = 0;
-      namepos = fullpath + pathlen+1;
-    }
-    else namepos = fullpath + pathlen;
-    
     if (prefix.c_str() && prefix.c_str()[0]=='.') hidden_files = true;
     
-    //struct stat statstr;
+    struct stat st;
     struct dirent* de = null;
     
-    while (dirp) {
-      if (!(de = readdir(dirp)))	// erreur ou fin de liste
-        break;
-      else {
-        char *dname = de->d_name;
-        
-        if (dname[0] == 0) continue;
-        else if (dname[0]=='.') {
-          // skip .
-          if (dname[1]==0) continue;
-          // skip ..
-          else if (dname[1]=='.' && dname[2]==0) continue;
-          // skip files starting by . depending on mode
-          else if (!hidden_files) continue;
-        }
-        
-        // SKIP si ne correspond pas au filtre (sauf ..)
-        if (prefix.c_str()) {
-          if (strncmp(dname, prefix.c_str(), prefix.length()) != 0) continue;
-        }
-        
-        // copier nom du fichier dans fullpath pour faire stat()
-        strcpy(namepos, dname);
-        
-        //EX: lstat(fullpath, &statstr);
-        UFileInfo* finfo = new UFileInfo(fullpath, dname);
-        
-        // SKIP si pas directory et ne correspond pas au filtre
-        // NOTE: on ne filtre PAS les directories (sinon resultat illisible)
-        //
-        //if (filters.size() > 0 && !S_ISDIR(statstr.st_mode)) 
-        if (filters.size() > 0 && !finfo->isDir() && !matchFilters(dname, filters))
-          delete finfo;
-        else file_infos.push_back(finfo);
-      }
+    while ((de = readdir(dirp))) {	// null: erreur ou fin de liste
+      const char *dname = de->d_name;
+      if (skipEntry(dname, prefix.c_str(), prefix.length(), hidden_files)) continue;
+      
+      int mode = statEntry(dirp, dname, st);
+      
+      // SKIP si pas directory et ne correspond pas au filtre
+      // NOTE: on ne filtre PAS les directories (sinon resultat illisible)
+      if (filters.size() > 0 && !S_ISDIR(mode) && !matchFilters(dname, filters))
+        continue;
+      file_infos.push_back(new UFileInfo(dname, mode, st.st_size, st.st_mtime));
     }
     
     sort(file_infos.begin(), file_infos.end(), UFileDir::compareEntries);
     ::closedir(dirp);
-    delete fullpath;
   }
   
   /* ==================================================== ===== ======= */
@@ -450,6 +446,208 @@ namespace ubit {
     delete fullpath;
   }
   
+  /* ==================================================== ===== ======= */
+  
+  int UFileDirReader::first_chunk_size = 200;
+  int UFileDirReader::chunk_size = 10000;
+  
+  UFileDirReader::UFileDirReader() : dir_info(""),
+  hidden_files(false), reading(false), count(0), dirp(null), done(false), cancelled(false) {
+    fds[0] = fds[1] = -1;
+    pthread_mutex_init(&lock, null);
+  }
+  
+  UFileDirReader::~UFileDirReader() {
+    stopThread();
+    clearFileInfos();
+    for (unsigned int k = 0; k < filters.size(); ++k) delete filters[k];
+    pthread_mutex_destroy(&lock);
+    destructs();   // onClose callbacks are not fired
+  }
+  
+  void UFileDirReader::clearFileInfos() {
+    for (unsigned int k = 0; k < file_infos.size(); ++k) delete file_infos[k];
+    file_infos.clear();
+  }
+  
+  bool UFileDirReader::read(const UStr& _path, const UStr& _prefix,
+                            const UStr& filter, bool with_dot_files) {
+    stop();
+    clearFileInfos();
+    count = 0;
+    
+    UStr path = _path;
+    UFileDir::expandDirPath(path);
+    dir_info.setPath(path);
+    
+    ::DIR* d = ::opendir(path.c_str());
+    if (!d) return false;    // ce directory n'existe pas
+    
+    if (::pipe(fds) < 0) {
+      ::closedir(d);
+      fds[0] = fds[1] = -1;
+      return false;
+    }
+    // neither the worker nor the main loop must block on the pipe
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    ::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    
+    for (unsigned int k = 0; k < filters.size(); ++k) delete filters[k];
+    filters.clear();
+    UFileDir::parseFilter(filters, filter);
+    prefix = _prefix.c_str() ? _prefix.c_str() : "";
+    hidden_files = with_dot_files || prefix[0] == '.';
+    
+    dirp = d;
+    done = cancelled = false;
+    reading = true;
+    if (pthread_create(&thread, null, readerMain, this) != 0) {
+      UAppli::error("UFileDirReader","could not create the thread that reads %s", path.c_str());
+      ::closedir(d);
+      ::close(fds[0]);
+      ::close(fds[1]);
+      fds[0] = fds[1] = -1;
+      dirp = null;
+      reading = false;
+      return false;
+    }
+    open(fds[0]);
+    return true;
+  }
+  
+  bool UFileDirReader::accepts(const UStr& filename, bool is_dir) const {
+    const char* dname = filename.c_str();
+    if (!dname || skipEntry(dname, prefix.c_str(), prefix.length(), hidden_files))
+      return false;
+    // directories are not filtered (see readEntries())
+    return is_dir || filters.size() == 0 || matchFilters(dname, filters);
+  }
+  
+  void UFileDirReader::stop() {
+    if (!reading) return;
+    stopThread();
+    close();    // fires onClose callbacks
+  }
+  
+  void UFileDirReader::stopThread() {
+    if (!reading) return;
+    pthread_mutex_lock(&lock);
+    cancelled = true;
+    pthread_mutex_unlock(&lock);
+    pthread_join(thread, null);
+    
+    ::closedir((::DIR*)dirp);
+    dirp = null;
+    ::close(fds[0]);
+    ::close(fds[1]);
+    fds[0] = fds[1] = -1;
+    for (unsigned int k = 0; k < chunks.size(); ++k) delete chunks[k];
+    chunks.clear();
+    reading = false;
+  }
+  
+  void UFileDirReader::wakeup() {
+    char c = 0;
+    // EAGAIN: the pipe is full, so that the main loop will be woken up anyway
+    if (::write(fds[1], &c, 1) < 0) {}
+  }
+  
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  // worker thread: only uses plain data (no UObject is created here)
+  
+  void* UFileDirReader::readerMain(void* reader) {
+    static_cast<UFileDirReader*>(reader)->readEntries();
+    return null;
+  }
+  
+  void UFileDirReader::readEntries() {
+    ::DIR* d = (::DIR*)dirp;
+    unsigned int max_size = first_chunk_size > 0 ? first_chunk_size : 1;
+    Chunk chunk;
+    Entry e;
+    struct stat st;
+    struct dirent* de = null;
+    
+    while ((de = readdir(d))) {
+      const char *dname = de->d_name;
+      if (skipEntry(dname, prefix.c_str(), prefix.length(), hidden_files)) continue;
+      
+      e.mode = statEntry(d, dname, st);
+      // NOTE: on ne filtre PAS les directories (sinon resultat illisible)
+      if (filters.size() > 0 && !S_ISDIR(e.mode) && !matchFilters(dname, filters))
+        continue;
+      e.name = dname;
+      e.size = st.st_size;
+      e.modtime = st.st_mtime;
+      chunk.push_back(e);
+      
+      if (chunk.size() >= max_size) {
+        if (!postChunk(chunk, false)) return;   // cancelled
+        // the GUI is updated after each chunk: doubling the size of the chunks
+        // limits the number of updates (which grows with the number of entries)
+        max_size = std::min(max_size * 2, (unsigned int)std::max(chunk_size, 1));
+      }
+    }
+    postChunk(chunk, true);
+  }
+  
+  bool UFileDirReader::postChunk(Chunk& chunk, bool last) {
+    pthread_mutex_lock(&lock);
+    bool ok = !cancelled;
+    if (ok) {
+      if (!chunk.empty()) {
+        chunks.push_back(new Chunk);
+        chunks.back()->swap(chunk);
+      }
+      done = last;
+    }
+    pthread_mutex_unlock(&lock);
+    if (ok) wakeup();
+    chunk.clear();
+    return ok;
+  }
+  
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  // main thread: fires one chunk each time the main loop is woken up, so that
+  // the GUI is updated (and can be used) between chunks.
+  
+  void UFileDirReader::fireInput() {
+    if (isDestructed() || !reading) return;
+    char buf[64];
+    while (::read(fds[0], buf, sizeof(buf)) > 0) {}
+    
+    pthread_mutex_lock(&lock);
+    Chunk* chunk = null;
+    if (!chunks.empty()) {
+      chunk = chunks.front();
+      chunks.pop_front();
+    }
+    bool more = !chunks.empty();
+    pthread_mutex_unlock(&lock);
+    
+    if (more) wakeup();   // next chunk at the next iteration of the main loop
+    
+    if (chunk) {
+      clearFileInfos();
+      file_infos.reserve(chunk->size());
+      for (unsigned int k = 0; k < chunk->size(); ++k) {
+        const Entry& e = (*chunk)[k];
+        file_infos.push_back(new UFileInfo(e.name.c_str(), e.mode, e.size, e.modtime));
+      }
+      count += chunk->size();
+      delete chunk;
+      USource::fireInput();          // onAction() callbacks
+      clearFileInfos();
+    }
+    
+    // the callbacks may have stopped or restarted reading
+    if (isDestructed() || !reading) return;
+    pthread_mutex_lock(&lock);
+    bool complete = done && chunks.empty();
+    pthread_mutex_unlock(&lock);
+    if (complete) stop();
+  }
+  
   /* ==================================================== ===== ======= */
   // format: blabla (*.html; *.xhtml; *.*)
   
@@ -562,7 +760,7 @@ namespace ubit {
   
   void UFileCache::createCache() {
     const char* user = ::getenv("USER");
-    if (!user | !*user) return;
+    if (!user || !*user) return;
     
     cache = "/tmp/" & UAppli::getName() & "-" & user;
     cleanCache();
@@ -16,8 +16,12 @@
 
 #ifndef _ufile_hpp_
 #define	_ufile_hpp_ 1
+#include <pthread.h>
+#include <deque>
+#include <string>
 #include <vector>
 #include <ubit/unode.hpp>
+#include <ubit/usource.hpp>
 namespace ubit {
   
   /* ==================================================== ======== ======= */
@@ -102,7 +106,9 @@ namespace ubit {
     
   protected:
     friend class UFileDir;
+    friend class UFileDirReader;
     friend class UFilebox;
+    UFileInfo(const char* fname, int mode, unsigned long size, unsigned long modtime);
     unsigned long size;
     unsigned long modtime;
     uptr<UStr> pname;
@@ -156,6 +162,7 @@ namespace ubit {
     // - - - Impl - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
   private:
     friend class UIconbox;
+    friend class UFileDirReader;
     UFileInfo dir_info;
     UFileInfos file_infos;
     std::vector<UStr*> filters;
@@ -163,6 +170,97 @@ namespace ubit {
     static void parseFilter(std::vector<UStr*>& filters, const UStr& filter);
   };
   
+  /* ==================================================== ======== ======= */
+  /** Asynchronous directory reader.
+   * the directory is read by a worker thread (the entries are not sorted) and
+   * sent to the main loop by chunks: onAction() callbacks are fired in the main
+   * thread each time a chunk is available, then onClose() callbacks when reading
+   * is complete or stopped. The first chunk is small, so that a large directory
+   * can be displayed before it is entirely read. Example:
+   * <pre>
+   *    uptr<UFileDirReader> r = new UFileDirReader();
+   *    r->onAction(ucall(obj, &Obj::addEntries));   // calls r->getFileInfos()
+   *    r->onClose(ucall(obj, &Obj::sortEntries));
+   *    r->read(path, "", "", false);
+   * </pre>
+   */
+  class UFileDirReader : public USource {
+  public:
+    UCLASS(UFileDirReader)
+
+    UFileDirReader();
+    virtual ~UFileDirReader();
+    ///< stops reading (without firing onClose() callbacks).
+    
+    bool read(const UStr& path, const UStr& prefix, const UStr& filter, bool with_dot_files);
+    /**< starts reading this directory.
+     * the arguments are the same as for UFileDir::read(). Returns false (and does
+     * not fire any callback) if the directory can't be opened.
+     */
+    
+    void stop();
+    ///< stops reading: the worker thread is stopped and onClose() callbacks are fired.
+
+    bool accepts(const UStr& filename, bool is_dir) const;
+    /**< returns true if a file that has this name is an entry of the directory.
+     * the prefix, filter and with_dot_files arguments of read() are used 
+     * (eg. for adding a file that was created after the directory was read).
+     */
+
+    bool isReading() const {return reading;}
+    ///< returns true if the directory has not been entirely read.
+
+    const UStr& getPath() const {return *dir_info.getFileName();}
+    ///< returns the full pathname of the directory.
+    
+    unsigned long getModTime() const {return dir_info.getModTime();}
+    ///< returns the modification time of the directory when reading started.
+    
+    const UFileInfos& getFileInfos() const {return file_infos;}
+    /**< returns the entries of the current chunk.
+     * these entries are only valid in onAction() callbacks.
+     */
+
+    int getCount() const {return count;}
+    ///< returns the number of entries that have been received.
+    
+    static int first_chunk_size, chunk_size;
+    /**< number of entries in the first chunk and maximum number of entries in a chunk.
+     * the size of the chunks is doubled after each chunk until it reaches chunk_size.
+     */
+
+    // - - - Impl - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    virtual void fireInput();
+
+  private:
+    struct Entry {
+      std::string name;
+      int mode;
+      unsigned long size, modtime;
+    };
+    typedef std::vector<Entry> Chunk;
+    
+    static void* readerMain(void*);
+    void readEntries();
+    bool postChunk(Chunk&, bool last);
+    void wakeup();
+    void stopThread();
+    void clearFileInfos();
+    
+    UFileInfo dir_info;
+    UFileInfos file_infos;
+    std::vector<UStr*> filters;
+    std::string prefix;
+    bool hidden_files, reading;
+    int count;
+    void* dirp;                      // the DIR of the directory
+    int fds[2];                      // the worker writes a byte in fds[1] for each chunk
+    pthread_t thread;
+    pthread_mutex_t lock;            // protects the fields below
+    std::deque<Chunk*> chunks;       // chunks that have not been fired
+    bool done, cancelled;
+  };
+  
   /* ==================================================== ======== ======= */
   /** file cache for SSH.
    */
@@ -107,6 +107,8 @@ UFinderListener* UFinder::getListener() {
 
 UFinder::~UFinder() {
 delete local_ums;
+watcher->close();   // the main loop would otherwise keep the watcher
+com->close();       // same for the pending remote documents
 }
 
 UFinder::UFinder(const UStr& _pathname) :
@@ -126,7 +128,9 @@ piconbox(null),
 last_direntry(null),
 last_preview_request(null),
 last_preview(null),
-preview_timer(new UTimer(false)) 
+preview_timer(new UTimer(false)),
+watcher(new UFinderWatcher(*this)),
+com(new UFinderCom(*this))
 {
   preview_timer->onAction(ucall(this, &UFinder::showIconPreviews));
   UAppli::onMessage("next",    ucall(this, &UFinder::nextEntry));
@@ -335,10 +339,15 @@ void UFinder::open(const UStr& path) {
 
   int path_type = UFileInfo::parsePrefix(path);
 
-  if (path_type == UFileInfo::LOCAL)
+  if (path_type == UFileInfo::LOCAL) {
+    com->cancel();    // the remote documents are no longer wanted
     openImpl(path, 0/*mode unknow at this stage*/, UFileInfo::LOCAL);
-  else
-    new UFinderCom(this, path, path_type);
+  }
+  else com->load(path, path_type);
+}
+
+void UFinder::setRemoteTransfer(UFinderTransfer* t) {
+  com->setTransfer(t);
 }
 
 
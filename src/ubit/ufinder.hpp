@@ -28,6 +28,8 @@ namespace ubit {
  class UFinderFullwin;
  class UFinderControls;
  class UFinderCom;
+ class UFinderTransfer;
+ class UFinderWatcher;
 
 /* ==================================================== ===== ======= */
 /** UFinder Listener.
@@ -86,6 +88,12 @@ public:
   // virtual void compactEvents(bool = true);
   // compact events to avoid delays.
 
+  void setRemoteTransfer(UFinderTransfer*);
+  /**< changes the backend that copies remote documents (ssh:, http:, ftp:) in the file cache.
+   * the backend is adopted. The default backend runs ssh, scp and wget and shares
+   * the ssh connections (@see UFinderTransfer in ufinderImpl.hpp).
+   */
+
   virtual void setTracking(bool);
   virtual void setTracking(bool doc, bool icons);
   ///< tracking mode updates the value while the scrollbar is being dragged (default is true).
@@ -179,6 +187,7 @@ private:
   friend class UFinderDir;
   friend class UFinderHost;
   friend class UFinderCom;  
+  friend class UFinderWatcher;
   static UPix& doc_pix;
   enum {NoMode, DirMode, DocMode} mode;
   bool is_tracking, open_in_fullwin;
@@ -204,6 +213,8 @@ private:
   UIcon* last_preview;
   UChildIter previews_current, previews_end;
   uptr<UTimer> preview_timer;
+  uptr<UFinderWatcher> watcher;
+  uptr<UFinderCom> com;
  };
 
 }
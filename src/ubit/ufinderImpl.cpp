@@ -21,6 +21,14 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <dirent.h>
+#include <cerrno>
+#include <fstream>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
 #include <ubit/udefs.hpp>
 #include <ubit/ufile.hpp>
 #include <ubit/uon.hpp>
@@ -58,6 +66,7 @@ UFinderDir::UFinderDir(UFinder* fd, const UStr& _fpath, int _path_type) {
   iconbox = null;
   keep_open = false;
   path_type = _path_type;
+  watch_id = -1;
   
   popmenu.add
     (ualpha(0.5) + UBackground::black
@@ -123,6 +132,7 @@ UFinderDir* UFinder::findDir(const UStr& name) {
 void UFinder::removeIconbox(UFinderDir* de, bool upd) {
   if (!de) return;
   if (de->iconbox) {
+    watcher->unwatch(de);
     if (de->iconbox == piconbox) piconbox = null;
     //iconbox_panel->setAutoUpdate(upd);
     mainbox.remove(*de->iconbox);
@@ -284,11 +294,16 @@ int UFinder::openDir(UFinderDir* de) {
   }
 
   // on ne recharge le directory que s'il n'a jamais ete charge ou s'il a ete
-  // modifie
+  // modifie. The icons of watched directories are kept up to date, except
+  // if filetime was reset by the watcher (see UFinderWatcher).
   if (de->iconbox) {
-    struct stat statbuf;
-    ::lstat(de->fpath.c_str(), &statbuf);  // faudrait tester return val = 0
-    if ((unsigned long)statbuf.st_mtime <= de->iconbox->filetime) {
+    bool uptodate = (de->watch_id >= 0 && de->iconbox->filetime != 0);
+    if (!uptodate) {
+      struct stat statbuf;
+      uptodate = ::lstat(de->fpath.c_str(), &statbuf) == 0
+      && (unsigned long)statbuf.st_mtime <= de->iconbox->filetime;
+    }
+    if (uptodate) {
       stat = true;
       if (listener) listener->dirLoaded(de->fpath);
       goto end;
@@ -328,6 +343,7 @@ int UFinder::openDir(UFinderDir* de) {
     piconbox = de->iconbox;
     mainbox.add(*piconbox);
     de->emph(true);
+    if (de->path_type == UFileInfo::LOCAL) watcher->watch(de);
     last_direntry = de;
     if (opts.show_icon_images) {      // charger les imagettes
       previews_current = piconbox->icons().cbegin();
@@ -482,163 +498,476 @@ void UFinder::showPreview(UIcon* icon) {
 /* ==================================================== ===== ======= */
 
 void UFinder::showIconPreviews() {
+  // wait until the directory has been read: the icons are then sorted
+  if (piconbox && piconbox->isLoading()) {
+    previews_current = piconbox->icons().cbegin();
+    return;
+  }
+
   if (previews_current == previews_end) {
     preview_timer->stop();
     return;
   }
 
+  // cached thumbnails are cheap to load: they are all shown during the same
+  // call (as long as it does not take too long), so that they appear at once
+  unsigned long start = UAppli::getTime();
+
   while (previews_current != previews_end) {
     UIcon* icon = dynamic_cast<UIcon*>(*previews_current);
     previews_current++;
     if (icon) {
       UStr pathname = piconbox->pathname() & "/" & icon->getName();
-      //icon->readIconImage(icon->getName(), pathname);
-      icon->loadImage(pathname);
-      return;  // sortir du callback qui sera rappele par le timer
+      int stat = icon->loadCachedImage(pathname);
+      if (stat == UFilestat::NotOpened) {
+        icon->readImage(pathname);   // not in the cache
+        return;  // sortir du callback qui sera rappele par le timer
+      }
+      if (UAppli::getTime() - start > 20) return;
     }
     // sinon ce n'est pas un icon: passer au suivant
   }
 }
 
 /* ==================================================== (c)[Elc] ======= */
-// FinderCOM
+// FinderWatcher
+
+UFinderWatcher::UFinderWatcher(UFinder& _fd) : fd(_fd) {
+#ifdef __linux__
+  int ifd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (ifd >= 0) open(ifd);
+  else UAppli::warning("UFinderWatcher","inotify is not available: folders won't be watched");
+#endif
+}
 
-extern "C" {
-  typedef void* (*START_ROUTINE)(void*);
+UFinderWatcher::~UFinderWatcher() {
+  int ifd = getSource();
+  if (isOpened()) close();
+  if (ifd >= 0) ::close(ifd);
+}
+
+bool UFinderWatcher::watch(UFinderDir* de) {
+  if (!de || !isOpened()) return false;
+  if (de->watch_id >= 0) return true;
+#ifdef __linux__
+  int wd = ::inotify_add_watch(getSource(), de->fpath.c_str(),
+                               IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                               | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+  if (wd < 0) return false;
+  de->watch_id = wd;
+  dirs[wd] = de;
+  return true;
+#else
+  return false;
+#endif
 }
 
+void UFinderWatcher::unwatch(UFinderDir* de) {
+  if (!de || de->watch_id < 0) return;
+#ifdef __linux__
+  if (isOpened()) ::inotify_rm_watch(getSource(), de->watch_id);
+#endif
+  dirs.erase(de->watch_id);
+  de->watch_id = -1;
+}
+
+// the iconbox will be read again by openDir()
+void UFinderWatcher::invalidate(UFinderDir* de) {
+  if (de->iconbox) de->iconbox->filetime = 0;
+}
+
+void UFinderWatcher::fireInput() {
+#ifdef __linux__
+  // the buffer must be aligned for reading the inotify_event structs
+  union {
+    struct inotify_event ev;
+    char buf[4096];
+  } events;
+  ssize_t len = 0;
+
+  while ((len = ::read(getSource(), events.buf, sizeof(events.buf))) > 0) {
+    for (char* p = events.buf; p < events.buf + len; ) {
+      struct inotify_event* ev = (struct inotify_event*)p;
+      p += sizeof(struct inotify_event) + ev->len;
+
+      if (ev->mask & IN_Q_OVERFLOW) {     // events were lost
+        for (std::map<int,UFinderDir*>::iterator k = dirs.begin(); k != dirs.end(); ++k)
+          invalidate(k->second);
+        continue;
+      }
+
+      std::map<int,UFinderDir*>::iterator k = dirs.find(ev->wd);
+      if (k == dirs.end()) continue;
+      UFinderDir* de = k->second;
+
+      if (ev->mask & IN_IGNORED) {        // the watch was removed by the system
+        dirs.erase(k);
+        de->watch_id = -1;
+        continue;
+      }
+      if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+        invalidate(de);
+        continue;
+      }
+      // the files that are not shown are ignored by insertFileIcon()
+      if (ev->len == 0 || ev->name[0] == 0) continue;
+
+      if (ev->mask & (IN_CREATE | IN_MOVED_TO)) fileCreated(de, ev->name);
+      else if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) fileRemoved(de, ev->name);
+    }
+  }
+#endif
+}
+
+void UFinderWatcher::fileCreated(UFinderDir* de, const char* name) {
+  UIconbox* ibox = de->iconbox;
+  if (!ibox) return;
+  // the reader may or may not have found this file
+  if (ibox->isLoading()) {invalidate(de); return;}
+  ibox->insertFileIcon(name);
+}
+
+void UFinderWatcher::fileRemoved(UFinderDir* de, const char* name) {
+  UIconbox* ibox = de->iconbox;
+  if (!ibox) return;
+  if (ibox->isLoading()) {invalidate(de); return;}
+  UIcon* icon = ibox->findIcon(name);
+  if (!icon) return;
+
+  // the UFinder must not refer to this icon anymore
+  if (ibox == fd.piconbox) {
+    if (fd.previews_current != fd.previews_end && *fd.previews_current == icon)
+      ++fd.previews_current;
+  }
+  if (fd.last_preview_request == icon) fd.last_preview_request = null;
+  if (fd.last_preview == icon) fd.last_preview = null;
+  ibox->removeIcon(*icon, true);
+}
+
+/* ==================================================== (c)[Elc] ======= */
+// FinderCOM
+
 #ifndef NO_REMOTE_DOC
 
-UFinderCom::UFinderCom(UFinder* _fd, const UStr& _path, int _type)
-: fd(_fd), path(_path), type(_type), mode(0), stat(0) {
-  pthread_create(&thread_id, NULL, (START_ROUTINE)loadDoc, this);
+static string toString(const UStr& s) {
+  return s.c_str() ? s.c_str() : "";
+}
+
+UFinderCom::UFinderCom(UFinder& _fd, int _max_workers) : fd(_fd),
+transfer(new UFinderShellTransfer()),
+max_workers(_max_workers > 0 ? _max_workers : 1), idle_workers(0), stopping(false) {
+  pthread_mutex_init(&lock, null);
+  pthread_cond_init(&cond, null);
+  if (::pipe(fds) < 0) {
+    UAppli::warning("UFinderCom","can't create a pipe: remote documents won't be loaded");
+    fds[0] = fds[1] = -1;
+    return;
+  }
+  // the pipe must not be inherited by the commands that the workers launch
+  for (int k = 0; k < 2; ++k) {
+    ::fcntl(fds[k], F_SETFL, O_NONBLOCK);
+    ::fcntl(fds[k], F_SETFD, FD_CLOEXEC);
+  }
+  open(fds[0]);
+}
+
+UFinderCom::~UFinderCom() {
+  cancel();
+  stopWorkers();
+  if (isOpened()) close();
+  for (list<Job*>::iterator i = jobs.begin(); i != jobs.end(); ++i) delete *i;
+  delete transfer;
+  if (fds[0] >= 0) ::close(fds[0]);
+  if (fds[1] >= 0) ::close(fds[1]);
+  pthread_cond_destroy(&cond);
+  pthread_mutex_destroy(&lock);
+}
+
+void UFinderCom::setTransfer(UFinderTransfer* t) {
+  if (!t || t == transfer) return;
+  // the workers may still use the current transfer: the running jobs are
+  // cancelled so that the workers stop soon
+  cancel();
+  stopWorkers();
+  delete transfer;
+  transfer = t;
+  stopping = false;
+  // the jobs that were not started are discarded (the completed ones are
+  // discarded by fireInput()). load() creates new workers
+  pthread_mutex_lock(&lock);
+  for (unsigned int k = 0; k < queued.size(); ++k) {
+    jobs.remove(queued[k]);
+    delete queued[k];
+  }
+  queued.clear();
+  pthread_mutex_unlock(&lock);
+}
+
+void UFinderCom::stopWorkers() {
+  pthread_mutex_lock(&lock);
+  stopping = true;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&lock);
+  for (unsigned int k = 0; k < workers.size(); ++k) pthread_join(workers[k], null);
+  workers.clear();
+  idle_workers = 0;
+}
+
+void UFinderCom::cancel() {
+  for (list<Job*>::iterator i = jobs.begin(); i != jobs.end(); ++i)
+    (*i)->cancelled = true;
 }
 
 /* ==================================================== ===== ======= */
 
-void UFinderCom::loadDoc(UFinderCom* d) {        // A REVOIR!!!!!!!!! 
-#if 0 
-  //cerr << "BEGIN thread " << pthread_self() << endl;
-  //cerr << "\n*** LoadDoc " << d->path << endl;  
-  UStr com;
+void UFinderCom::load(const UStr& url, int url_type) {
+  if (fds[0] < 0) {
+    fd.showAlert("Can't load: " & url);
+    return;
+  }
 
-  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - 
-  
-  if (d->type == UFileInfo::SSH) {
-    UStr server, spath;
-    d->mode = UFileMode::FILE;
-    if (d->path[-1]=='/') d->mode = UFileMode::DIR;
-
-    // makeCachePath enleve le / final
-    if (!UFileCache::getCachePath(d->path, UFileInfo::SSH,
-                                  server, spath, d->cachepath)) {
-      d->stat = INVALID_URL;
-      goto END_THREAD;
-    }
-    
-    if (d->mode == UFileInfo::DIR)
-      com = "ssh '" & server & "' ls -F " & spath 
-        & " > \"" & d->cachepath & "\"; echo $?";
-    else
-      com = "scp -p -q -B '" & server & ":" & spath 
-        & "' '" & d->cachepath & "'; echo $?";
+  // the same document is not requested twice, the other requests are cancelled
+  bool requested = false;
+  for (list<Job*>::iterator i = jobs.begin(); i != jobs.end(); ++i) {
+    if (!(*i)->cancelled && (*i)->url == toString(url)) requested = true;
+    else (*i)->cancelled = true;
   }
+  if (requested) return;
 
-  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - 
+  UStr server, spath, cachepath;
+  // getCachePath() removes the final /
+  if (!UFileCache::getCachePath(url, url_type, server, spath, cachepath)) {
+    fd.showAlert("Invalid URL: " & url);
+    return;
+  }
 
-  else if (d->type == UFileInfo::HTTP) {
-    UStr server, spath;
-    if (!UFileCache::getCachePath(d->path, UFileInfo::HTTP,
-                                  server, spath, d->cachepath)) {
-      d->stat = INVALID_URL;
-      goto END_THREAD;
-    }
-    
-    // cf -r et -N et -P prefix
-    com = "cd " & UFileCache::getCachePath() 
-      & "http:/; wget -q -N -S -x " & spath & "; echo $?";
+  Job* job = new Job();
+  job->type = url_type;
+  job->mode = (url[-1] == '/') ? UFileMode::DIR : UFileMode::FILE;
+  job->url = toString(url);
+  job->server = toString(server);
+  job->spath = toString(spath);
+  job->cachepath = toString(cachepath);
+  job->cache = toString(UFileCache::getCachePath());
+  jobs.push_back(job);
+
+  pthread_mutex_lock(&lock);
+  queued.push_back(job);
+  bool more_workers = queued.size() > idle_workers && workers.size() < max_workers;
+  pthread_cond_signal(&cond);
+  pthread_mutex_unlock(&lock);
+
+  if (more_workers) {
+    pthread_t t;
+    if (pthread_create(&t, null, workerMain, this) == 0) workers.push_back(t);
+    else if (workers.empty())
+      UAppli::error("UFinderCom","could not create the thread that loads %s", url.c_str());
   }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// worker threads: only use plain data (no UObject is created here)
 
-  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - 
+void* UFinderCom::workerMain(void* com) {
+  static_cast<UFinderCom*>(com)->runJobs();
+  return null;
+}
 
-  else if (d->type == UFileInfo::FTP) {
-    UStr server, spath;
-    if (!UFileCache::getCachePath(d->path, UFileInfo::FTP,
-                                  server, spath, d->cachepath)) {
-      d->stat = INVALID_URL;
-      goto END_THREAD;
+void UFinderCom::runJobs() {
+  pthread_mutex_lock(&lock);
+  while (true) {
+    while (queued.empty() && !stopping) {
+      idle_workers++;
+      pthread_cond_wait(&cond, &lock);
+      idle_workers--;
     }
-    com = "cd " & UFileCache::getCachePath() 
-      & "; ftp " & spath & "; echo $?";
+    if (stopping) break;
+    Job* job = queued.front();
+    queued.pop_front();
+    pthread_mutex_unlock(&lock);
+
+    // cancelled jobs that were not started are just discarded
+    job->ok = !job->cancelled && transfer->fetch(*job);
+
+    pthread_mutex_lock(&lock);
+    done.push_back(job);
+    char c = 0;
+    // EAGAIN: the pipe is full, so that the main loop will be woken up anyway
+    if (::write(fds[1], &c, 1) < 0) {}
   }
+  pthread_mutex_unlock(&lock);
+}
 
-  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - 
-  // exec command
-  {
-    //cerr << "cachepath: " << d->cachepath << " - pathtype " << d->type<< endl;
-    //cerr << "....loading: " << com << endl;
-    
-    /*int stat =*/ system(com.c_str());
-    /*
-    FILE* p = popen(com.c_str(), "r");
-    if (p) {
-      UStr res;
-      char buf[1000];
-      while (fgets(buf, sizeof(buf), p)) res.append(buf);
-      cout << "Result: " << res << endl;
-      pclose(p);
-      }
-    */
-  }
-  
-END_THREAD:
-  // sert a mettre a jour le graphique, mais dans le thread principal
-  UAppli::postpone(ucall(d, &UFinderCom::showDoc));
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// main thread: shows the documents that have been loaded
 
-  //cerr << "END thread " << pthread_self() << endl;
-  pthread_exit(NULL);
-  
-#endif
+void UFinderCom::fireInput() {
+  if (isDestructed()) return;
+  char buf[64];
+  while (::read(fds[0], buf, sizeof(buf)) > 0) {}
+
+  pthread_mutex_lock(&lock);
+  deque<Job*> completed;
+  completed.swap(done);
+  pthread_mutex_unlock(&lock);
+
+  for (unsigned int k = 0; k < completed.size(); ++k) {
+    Job* job = completed[k];
+    jobs.remove(job);
+    if (!job->cancelled) showDoc(*job);
+    delete job;
+  }
 }
 
 /* ==================================================== ======== ======= */
 
-void UFinderCom::showDoc() {
-  if (stat == INVALID_URL) {
-    fd->showAlert("Invalid URL: " & path);
+void UFinderCom::showDoc(Job& job) {
+  UStr path = job.url.c_str();
+  UStr cachepath = job.cachepath.c_str();
+  int type = job.type;
+
+  if (!job.ok) {
+    fd.showAlert("Can't load: " & path);
     return;
   }
-  
+
   UFileMode fm(cachepath);
 
-  if (!fm.isValid()) fd->showAlert("Can't find: " & path);
-  else if (type == UFileInfo::SSH) fd->openImpl(path, mode, UFileInfo::SSH);
+  if (!fm.isValid()) fd.showAlert("Can't find: " & path);
+  else if (type == UFileInfo::SSH) fd.openImpl(path, job.mode, UFileInfo::SSH);
 
   else if (type == UFileInfo::HTTP) {
     if (fm.isFile()) {
-      fd->openImpl(cachepath, UFileInfo::FILE, UFileInfo::HTTP);
+      fd.openImpl(cachepath, UFileInfo::FILE, UFileInfo::HTTP);
     }
     else if (fm.isDir()) {
       cachepath &= "index.htm";   // faudrait gerer les majuscules !
       UFileMode fm2(cachepath);
 
       if (fm2.isValid())
-        fd->openImpl(cachepath, UFileInfo::FILE, UFileInfo::HTTP);
+        fd.openImpl(cachepath, UFileInfo::FILE, UFileInfo::HTTP);
       else {
         cachepath &= "l";  // index.html
         UFileMode fm3(cachepath);
         if (fm3.isValid())
-          fd->openImpl(cachepath, UFileInfo::FILE, UFileInfo::HTTP);
+          fd.openImpl(cachepath, UFileInfo::FILE, UFileInfo::HTTP);
       }
     }
   }
 
   else if (type == UFileInfo::FTP)
-    fd->openImpl(cachepath, UFileInfo::FILE, UFileInfo::FTP);
+    fd.openImpl(cachepath, UFileInfo::FILE, UFileInfo::FTP);
   else
-    fd->showAlert("Unknown protocol: " & path);
+    fd.showAlert("Unknown protocol: " & path);
+}
+
+/* ==================================================== ======== ======= */
+// ssh connections are shared by all the ssh and scp commands: the first
+// command opens the connection, which stays open 5 minutes after the last one.
+
+static string quote(const string& s) {
+  string q = "'";
+  for (unsigned int k = 0; k < s.size(); ++k) {
+    if (s[k] == '\'') q += "'\\''";
+    else q += s[k];
+  }
+  return q + "'";
+}
+
+bool UFinderShellTransfer::fetch(Job& job) {
+  string com, cachedir = job.cachepath.substr(0, job.cachepath.rfind('/'));
+  string ssh_opts = "-o BatchMode=yes -o ControlMaster=auto -o ControlPersist=300 "
+  "-o ControlPath=" + quote(job.cache + "ssh-%C");
+
+  if (job.type == UFileInfo::SSH) {
+    if (job.mode == UFileMode::DIR)
+      com = "ssh " + ssh_opts + " " + quote(job.server) + " ls -F " + quote(job.spath)
+      + " > " + quote(job.cachepath);
+    else
+      com = "scp -p -q " + ssh_opts + " " + quote(job.server + ":" + job.spath)
+      + " " + quote(job.cachepath);
+  }
+  else if (job.type == UFileInfo::HTTP)
+    com = "cd " + quote(job.cache + "http:/")
+    + " && wget -q -N -x " + quote(job.spath);
+  else if (job.type == UFileInfo::FTP)
+    com = "cd " + quote(job.cache + "http:/")
+    + " && wget -q -N -x " + quote("ftp://" + job.spath);
+  else return false;
+
+  return run("mkdir -p " + quote(cachedir) + " && " + com, job);
+}
+
+// the command is killed if the job is cancelled
+bool UFinderShellTransfer::run(const string& command, Job& job) {
+  pid_t pid = ::fork();
+  if (pid < 0) return false;
+  if (pid == 0) {
+    ::setpgid(0, 0);   // the command and its children are killed together
+    ::execl("/bin/sh", "sh", "-c", command.c_str(), (char*)null);
+    ::_exit(127);
+  }
+  ::setpgid(pid, pid);   // also done here, in case the job is cancelled at once
+
+  int status = 0;
+  while (::waitpid(pid, &status, WNOHANG) == 0) {
+    if (job.isCancelled()) {
+      ::kill(-pid, SIGTERM);
+      ::waitpid(pid, &status, 0);
+      return false;
+    }
+    ::usleep(20000);
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
 
-  delete this;
+/* ==================================================== ======== ======= */
+
+static bool makeDirs(const string& path) {
+  for (unsigned int k = 1; k <= path.size(); ++k) {
+    if (k < path.size() && path[k] != '/') continue;
+    if (::mkdir(path.substr(0, k).c_str(), 0700) < 0 && errno != EEXIST) return false;
+  }
+  return true;
+}
+
+bool UFinderLocalTransfer::fetch(Job& job) {
+  if (job.type != UFileInfo::SSH 
+      || !makeDirs(job.cachepath.substr(0, job.cachepath.rfind('/'))))
+    return false;
+  // relative paths are relative to the home directory, as with ssh
+  string path = job.spath;
+  const char* home = ::getenv("HOME");
+  if (path.empty() || path[0] != '/') path = string(home ? home : "") + "/" + path;
+
+  ofstream out(job.cachepath.c_str(), ios::binary);
+  if (!out) return false;
+
+  if (job.mode == UFileMode::DIR) {
+    // same format as "ls -F" (see UFileDir::readRemote())
+    ::DIR* d = ::opendir(path.c_str());
+    if (!d) return false;
+    struct dirent* de;
+    struct stat st;
+    while ((de = ::readdir(d)) && !job.isCancelled()) {
+      const char* name = de->d_name;
+      if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+      bool is_dir = ::fstatat(dirfd(d), name, &st, 0) == 0 && S_ISDIR(st.st_mode);
+      out << name << (is_dir ? "/" : "") << "\n";
+    }
+    ::closedir(d);
+  }
+  else {
+    ifstream in(path.c_str(), ios::binary);
+    if (!in) return false;
+    char buf[8192];
+    while (in && !job.isCancelled()) {
+      in.read(buf, sizeof(buf));
+      out.write(buf, in.gcount());
+    }
+  }
+  out.close();
+  return !job.isCancelled() && !out.fail();
 }
 
 #endif
@@ -664,6 +993,8 @@ void UFinderHost::putFileImpl() {
 
   //if (remote_ums) delete remote_ums;         // !!!  A REVOIR
   UMService* remote_ums = new UMService(address);
+  // the file is sent synchronously and the connection is closed just after
+  remote_ums->setNonBlocking(false);
 
   UStr path = fd.piconbox->pathname() & "/" & icon->getName();
 
@@ -17,21 +17,30 @@
 #ifndef _ufinderImpl_hpp_
 #define _ufinderImpl_hpp_
 #include <pthread.h>
+#include <atomic>
+#include <deque>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
 #include <ubit/uwin.hpp>
 #include <ubit/uicon.hpp>
 #include <ubit/ufont.hpp>
 #include <ubit/ulistbox.hpp>
+#include <ubit/usource.hpp>
 namespace ubit {
   
   /* [Impl] A directory in the UFinder.
    */ 
   class UFinderDir : public UItem {
     friend class UFinder;
+    friend class UFinderWatcher;
     UStr fpath, fname;
     uptr<UIconbox> iconbox;
     UPopmenu popmenu;
     bool keep_open;
     int path_type;
+    int watch_id;    // the inotify watch descriptor (-1 if not watched)
     
   public:
     UFinderDir(class UFinder*, const UStr& path, int path_type);
@@ -79,22 +88,135 @@ namespace ubit {
   };
   
   /* ==================================================== ===== ======= */
-  /* [Impl] UFinder communication (remote file access by using ssh, etc)
-   */ 
-  class UFinderCom {
+  /* [Impl] watches the directories that are shown in the UFinder.
+   * the icons are added or removed when files are created, deleted or renamed
+   * in these directories, so that they don't need to be read again.
+   * Uses inotify (the watcher is inactive on other systems than Linux).
+   */
+  class UFinderWatcher : public USource {
+  public:
+    UFinderWatcher(class UFinder&);
+    ~UFinderWatcher();
+    
+    bool watch(UFinderDir*);
+    ///< watches the iconbox of this directory; returns false if not possible.
+
+    void unwatch(UFinderDir*);
+    
+    virtual void fireInput();
+    
+  protected:
+    void fileCreated(UFinderDir*, const char* name);
+    void fileRemoved(UFinderDir*, const char* name);
+    void invalidate(UFinderDir*);
+
+    class UFinder& fd;
+    std::map<int, UFinderDir*> dirs;   // watch descriptor => directory
+  };
+  
+  /* ==================================================== ===== ======= */
+  /* [Impl] transfer of remote documents (@see UFinderCom).
+   * fetch() copies the remote document (or the listing of the remote directory)
+   * in the file cache. It is called by the worker threads of UFinderCom: it must
+   * be reentrant, must only use plain data and should return soon after
+   * job.isCancelled() becomes true. Subclasses can keep connections open
+   * between calls, so that they are not opened again for each document.
+   */
+  class UFinderTransfer {
+  public:
+    struct Job {
+      Job() : type(0), mode(0), cancelled(false), ok(false) {}
+      bool isCancelled() const {return cancelled;}
+      bool isLoaded() const {return ok;}   // true if fetch() succeeded
+      
+      int type;                 // UFileInfo::SSH, HTTP or FTP
+      int mode;                 // UFileInfo::DIR or UFileInfo::FILE
+      std::string url, server, spath, cachepath;
+      std::string cache;        // the directory of the file cache (ends with a /)
+    private:
+      friend class UFinderCom;
+      std::atomic<bool> cancelled;
+      bool ok;
+    };
+    
+    virtual ~UFinderTransfer() {}
+    
+    virtual bool fetch(Job&) = 0;
+    ///< copies the document in job.cachepath; returns false if it failed or was cancelled.
+  };
+  
+  /* [Impl] transfers remote documents by running ssh, scp or wget.
+   * ssh connections are shared (ssh ControlMaster) and stay open for a few
+   * minutes, so that browsing a remote tree only connects once to each host.
+   */
+  class UFinderShellTransfer : public UFinderTransfer {
   public:
-    UFinderCom(UFinder*, const UStr& path, int path_type);
+    virtual bool fetch(Job&);
+  protected:
+    virtual bool run(const std::string& command, Job&);
+  };
+  
+  /* [Impl] stand-in backend that reads the documents on the local file system.
+   * the host of ssh: URLs is ignored: their path (relative to the home directory
+   * unless it is absolute, as with ssh) is copied in the file cache
+   * (directories are listed as "ls -F" does). Other URLs can't be fetched.
+   * Mainly useful for testing UFinderCom without a network.
+   */
+  class UFinderLocalTransfer : public UFinderTransfer {
+  public:
+    virtual bool fetch(Job&);
+  };
+  
+  /* ==================================================== ===== ======= */
+  /* [Impl] UFinder communication (remote file access by using ssh, etc).
+   * remote documents are loaded by a bounded pool of worker threads. A document
+   * that is being loaded is not requested again, and the pending requests are
+   * cancelled when the user opens another document. Loaded documents are shown
+   * by the main thread (the workers wake up the main loop through a pipe).
+   */
+  class UFinderCom : public USource {
+  public:
+    typedef UFinderTransfer::Job Job;
+    
+    UFinderCom(class UFinder&, int max_workers = 4);
+    ~UFinderCom();
+    
+    void setTransfer(UFinderTransfer*);
+    /**< changes the transfer backend (which is adopted, the default is UFinderShellTransfer).
+     * the pending requests are cancelled.
+     */
+    
+    void load(const UStr& url, int url_type);
+    /**< loads this remote document (or directory if 'url' ends with a /) and shows it.
+     * the other pending requests are cancelled.
+     */
+    
+    void cancel();
+    ///< cancels all the pending requests.
+    
+    int getJobCount() const {return jobs.size();}
+    ///< returns the number of requests that have not completed (including cancelled ones).
+    
+    int getWorkerCount() const {return workers.size();}
+    
+    virtual void fireInput();
     
   protected:
-    enum {INVALID_URL=-2};
-    static void loadDoc(UFinderCom*);  // pthread_create() callback
-    void showDoc();
-    
-    pthread_t thread_id;
-    UFinder* fd;
-    UStr path, cachepath;
-    int type, mode;
-    int stat;
+    static void* workerMain(void*);
+    void runJobs();
+    void stopWorkers();
+    virtual void showDoc(Job&);
+    
+    class UFinder& fd;
+    UFinderTransfer* transfer;
+    unsigned int max_workers, idle_workers;
+    std::vector<pthread_t> workers;
+    std::list<Job*> jobs;             // all the jobs (only accessed by the main thread)
+    int fds[2];                       // the workers write a byte in fds[1] when a job is done
+    pthread_mutex_t lock;             // protects the fields below
+    pthread_cond_t cond;              // signaled when a job is queued
+    std::deque<Job*> queued, done;
+    bool stopping;
   };
   
 }
@@ -21,6 +21,7 @@
 #include <ubit/uupdatecontext.hpp>
 #include <ubit/ufont.hpp>
 #include <ubit/ufontImpl.hpp>
+#include <ubit/ustyle.hpp>
 #include <ubit/uappli.hpp>
 #include <ubit/ubox.hpp>
 #include <ubit/uconf.hpp>
@@ -430,6 +431,11 @@ void UFont::update() {
   updateAutoParents(UUpdate::LAYOUT_PAINT);  // size changed in both directions
 }
 
+void UFont::changed(bool upd) {
+  ++UStyle::generation;
+  UAttr::changed(upd);
+}
+
 // This method initializes a UFont for a given UDisplay (or UAppli)
 // It returns true if the font could be found and false otherwise
 // (a default font will be used in this case)
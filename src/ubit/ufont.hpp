@@ -146,6 +146,12 @@ namespace ubit {
     virtual void update();
     ///< update parents' graphics.
     
+    virtual void changed(bool update = true);
+    /**< [impl] called when the font is changed.
+     * the computed styles are discarded as they may contain this font
+     * (@see UStyle::generation).
+     */
+    
     // - impl. - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
     
     virtual void realize(UDisp*);
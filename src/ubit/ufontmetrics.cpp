@@ -26,6 +26,7 @@
 #include <ubit/uwin.hpp>
 #include <ubit/uupdatecontext.hpp>
 #include <ubit/uappli.hpp>
+#include <ubit/utaskpool.hpp>
 #include <ubit/nat/uhardfont.hpp>
 #define NAMESPACE_UBIT namespace ubit {
 NAMESPACE_UBIT
@@ -33,7 +34,13 @@ NAMESPACE_UBIT
 // !!!CAUTION: disp->getFont() uses the default GC if it actually creates a new Font
 // in OpenGL mode, the corresponding glcontext becomes the current context
 
-#define NULL_FONT_ERROR(msg) UAppli::error(msg,"can't retreive font")
+// no error in worker threads: the task is performed again in the main thread
+// (see UDisp::getFont())
+static void nullFontError(const char* msg) {
+  if (!UTask::inWorkerThread()) UAppli::error(msg,"can't retreive font");
+}
+
+#define NULL_FONT_ERROR(msg) nullFontError(msg)
 
 UFontMetrics::UFontMetrics() 
 : disp(null), fd(null), own_fd(false) {}
@@ -51,7 +58,7 @@ disp(_ctx.getDisp()),
 fd(&_ctx.fontdesc), 
 own_fd(false) {
   UHardFont* f = disp->getFont(fd);  // see note about getFont above
-  if (!f) {
+  if (!f && !UTask::inWorkerThread()) {  // see UDisp::getFont()
     UAppli::error("UFontMetrics","can't retreive font");
   }
 }
@@ -192,7 +199,8 @@ getSubTextSize(const char* s, int len, UDimension& dim, float available_width,
   
   UHardFont* f = disp->getFont(fd);
   if (!f) {
-    UAppli::error("UFontMetrics::getSubTextSize","can't retreive font");
+    if (!UTask::inWorkerThread())   // see UDisp::getFont()
+      UAppli::error("UFontMetrics::getSubTextSize","can't retreive font");
     return false;
   }
   
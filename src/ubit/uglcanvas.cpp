@@ -38,7 +38,7 @@ NAMESPACE_UBIT
 
 
 UGlcanvas::UGlcanvas(UArgs a) :
-USubwin(a), is_init(false), share_glresources(false)
+USubwin(a), is_init(false), share_glresources(true)
 {
   addAttr(UOn::paint / ucall(this, &UGlcanvas::paintImpl));
   // resizeImpl est ajout dans USubwin
@@ -51,7 +51,7 @@ UGlcontext* UGlcanvas::getGlcontext() const {
   return hardImpl()->getGlcontext();
 }
 
-//void UGlcanvas::shareContextResources(UGlcontext* gc) {shared_res_ctx = gc;}
+void UGlcanvas::shareResources(bool state) {share_glresources = state;}
 //void UGlcanvas::setAutoBufferSwap(bool state) {is_autoswap = state;}
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
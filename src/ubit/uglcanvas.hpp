@@ -42,16 +42,19 @@ namespace ubit {
     UGlcanvas(UArgs = UArgs::none);
     virtual ~UGlcanvas();
     
-    //void shareContextResources(UGlcontext* = DEFAULT_GC);
-    /**< specifies that the resources of the GL context are shared with this argument.
-     * This function must be called immediately after the UGlcanvas is created:
-     * - the resources of the GL context of this canvas will be shared with those
-     *   of the given argument if it encapsulates a GL context.
-     * - the default argument DEFAULT_GC indicates that the ressources will be shared
-     *   with those of the default GC of the application (@see UDisp::getDefaultGC()).
-     *   This will have no effect if the application was not launched in GL mode
+    void shareResources(bool state);
+    /**< specifies whether the resources of the GL context are shared with the display.
+     * if true (the default), the GL context of this canvas shares its textures and
+     * display lists with the default context of the display: the fonts and the
+     * images of the application can then be drawn in paintGL() without being
+     * created again. This function must be called before the canvas is shown.
+     * It has no effect if the application was not launched in GL mode.
      */
     
+    bool isSharingResources() const {return share_glresources;}
+    ///< returns true if the GL context shares its resources with the display.
+    
+    
     virtual void makeCurrent();
     /**< makes this widget the current widget for OpenGL (GL will use its UGlcontext).
      * there is generally no need to call makeCurrent() explictely because this is
@@ -102,6 +102,12 @@ UGraph::UGraph(UView* v) {
   else rc->setDest(hardwin, 0, 0);
 
   rc->makeCurrent();
+  
+#if UBIT_WITH_GL
+  // uploads the textures of the images that were created since the last paint
+  if (UAppli::isUsingGL() && rc->isSharedWith(disp->getDefaultContext()))
+    disp->getGlresources()->flush();
+#endif
     
   // inutile de le refaire a chaque fois sauf si 3D ou si on change de fenetre !!!!
   setViewportOrtho(hardwin);
@@ -554,6 +560,11 @@ void UGraph::copyArea(double x, double y, double w, double h,
   rc->copyArea(x, y, w, h, delta_x, delta_y, generate_refresh_events_when_obscured);
 }
 
+bool UGraph::readPixels(double x, double y, int w, int h,
+                        std::vector<unsigned char>& pixels) const {
+  return rc->readPixels(x, y, w, h, pixels);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // strings
 
@@ -295,6 +295,14 @@ public:
     *  - CopyArea can't copy obscured parts of the component but will generate refresh
     *    events for repainting the missing parts if the last argument is true 
     */
+
+  bool readPixels(double x, double y, int width, int height, 
+                  std::vector<unsigned char>& pixels) const;
+  /** reads the pixels of a rectangular area (OpenGL and headless display only).
+    * 'pixels' are RGBA values (8 bits per component), the top row first.
+    * returns false if the pixels can't be read (with X11 or in 3D mode, or if the
+    * area is not entirely inside the window).
+    */
     
   // === Impl. =================================================================
 #ifndef NO_DOC
@@ -16,10 +16,12 @@
 
 #include <ubit/ubit_features.h>
 #include <iostream>
+#include <cstring>
 #include <sys/stat.h>
 #include <ubit/ubit.hpp>
 #include <ubit/ufile.hpp>
 #include <ubit/uicon.hpp>
+#include <ubit/uthumbnailcache.hpp>
 using namespace std;
 #define NAMESPACE_UBIT namespace ubit {
 NAMESPACE_UBIT
@@ -58,7 +60,14 @@ UIconbox::UIconbox(UArgs args) : UDocbox(), show_parent_dir(true) {
   content().add(*picons);
 }
 
-UIconbox::~UIconbox() {}
+UIconbox::~UIconbox() {
+  // the reader is referenced by the main loop while reading: its callbacks
+  // must be removed as they refer to this iconbox
+  if (reader) {
+    reader->removeAllAttrs();
+    reader->stop();
+  }
+}
 
 UChoice& UIconbox::choice() {return picons->choice();}
 const UChoice& UIconbox::choice() const {return picons->choice();}
@@ -138,35 +147,113 @@ int UIconbox::readDir(const UStr& _pathname, bool remote_dir) {
   pathname() = _pathname;
   title() = _pathname;
 
-  UFileDir dir;
-  if (remote_dir) dir.readRemote(_pathname, prefix, filter, want_dotfiles);
-  else dir.read(_pathname, prefix, filter, want_dotfiles);
-
-  filetime = dir.dir_info.getModTime();
-  picons->setAutoUpdate(false);
-
   if (show_parent_dir) {
     UIcon& icon = *new UIcon("..", UPix::bigUp);
     icon.setDir(true);
     icon.addAttr(usize(75,75) + ucall(this, &UIconbox::okBehavior));
     picons->add(icon);
   }
-  
-  const UFileInfos& entries = dir.getFileInfos(); 
 
-  for (UFileInfos::const_iterator pe = entries.begin(); pe != entries.end(); ++pe) {
-    const UFileInfo& e = *(*pe);
+  if (!remote_dir) {
+    if (!reader) {
+      reader = new UFileDirReader();
+      reader->onAction(ucall(this, &UIconbox::addEntries));
+      reader->onClose(ucall(this, &UIconbox::sortIcons));
+    }
+    if (!reader->read(_pathname, prefix, filter, want_dotfiles))
+      return UFilestat::CannotOpen;
+    filetime = reader->getModTime();
+    return UFilestat::Opened;
+  }
 
-    UIcon& icon = *new UIcon(*e.getFileName(), e.getIconImage());
-    if (e.isDir()) icon.setDir(true);
-    icon.addAttr(usize(75,75) + ucall(this, &UIconbox::okBehavior));
-    picons->add(icon);
+  UFileDir dir;
+  dir.readRemote(_pathname, prefix, filter, want_dotfiles);
+  filetime = dir.dir_info.getModTime();
+  picons->setAutoUpdate(false);
+
+  const UFileInfos& entries = dir.getFileInfos(); 
+  for (UFileInfos::const_iterator pe = entries.begin(); pe != entries.end(); ++pe) {
+    picons->add(createFileIcon(*(*pe)));
   }
 
   picons->setAutoUpdate(true);
   return UFilestat::Opened;
 }
 
+bool UIconbox::isLoading() const {
+  return reader && reader->isReading();
+}
+
+UIcon& UIconbox::createFileIcon(const UFileInfo& e) {
+  UIcon& icon = *new UIcon(*e.getFileName(), e.getIconImage());
+  if (e.isDir()) icon.setDir(true);
+  icon.addAttr(usize(75,75) + ucall(this, &UIconbox::okBehavior));
+  return icon;
+}
+
+// called by the reader for each chunk: the icons are added in reading order.
+// only the first chunk is displayed immediately: as the layout of the listbox
+// is recomputed entirely, the other chunks are displayed when they are sorted.
+void UIconbox::addEntries() {
+  const UFileInfos& entries = reader->getFileInfos();
+  picons->setAutoUpdate(false);
+  
+  for (UFileInfos::const_iterator pe = entries.begin(); pe != entries.end(); ++pe) {
+    picons->add(createFileIcon(*(*pe)));
+  }
+  
+  picons->setAutoUpdate(true);
+  if (reader->getCount() == int(entries.size())) picons->update();
+}
+
+// same order as UFileDir: .. then directories then files, sorted by name
+static int iconRank(const UIcon* i) {
+  if (!i) return 0;    // not an icon: stays first
+  else if (i->getName() == "..") return 1;
+  else if (i->isDir()) return 2;
+  else return 3;
+}
+
+static bool iconLess(const UIcon* i1, const UIcon* i2) {
+  int r1 = iconRank(i1), r2 = iconRank(i2);
+  if (r1 != r2 || r1 == 0) return r1 < r2;
+  else return strcmp(i1->getName().c_str(), i2->getName().c_str()) < 0;
+}
+
+static bool compareIcons(const UChild& c1, const UChild& c2) {
+  return iconLess(dynamic_cast<const UIcon*>(*c1), dynamic_cast<const UIcon*>(*c2));
+}
+
+// called when the reader has finished: the icons are sorted once for all
+void UIconbox::sortIcons() {
+  // std::list::sort is stable and does not invalidate iterators
+  picons->getChildren().sort(compareIcons);
+  picons->update();
+}
+
+UIcon* UIconbox::findIcon(const UStr& name) const {
+  for (UChildIter i = picons->cbegin(); i != picons->cend(); ++i) {
+    UIcon* icon = dynamic_cast<UIcon*>(*i);
+    if (icon && icon->getName() == name) return icon;
+  }
+  return null;
+}
+
+UIcon* UIconbox::insertFileIcon(const UStr& filename) {
+  if (findIcon(filename)) return null;
+  UStr path = pathname() & "/" & filename;
+  UFileInfo e(path.c_str(), filename.c_str());
+  if (!e.isValid()) return null;      // the file does not exist (anymore)
+  // same prefix, filter and dot files as the entries added by addEntries()
+  if (!reader || !reader->accepts(filename, e.isDir())) return null;
+
+  UIcon& icon = createFileIcon(e);
+  UChildIter pos = picons->cbegin();
+  while (pos != picons->cend() && !iconLess(&icon, dynamic_cast<UIcon*>(*pos))) ++pos;
+  picons->add(icon, pos);
+  return &icon;
+}
+
 /* ==================================================== ===== ======= */
 
 static const int CONTENT_WIDTH = 55, CONTENT_HEIGHT = 55;
@@ -211,28 +298,52 @@ void UIcon::set(const UStr& _name, UData&  _content) {
 }
 */
 
-int UIcon::loadImage(const UStr& ima_path) { 
+static bool isImageFile(const UStr& ima_path) {
   UStr fext = ima_path.suffix();
-  int stat = false;
-  
-  if (fext.equals("gif",true/*ignore case*/)    // !!! A REVOIR (UIma devrait faire ca) !!!@@@
-      || fext.equals("jpg",true)
-      || fext.equals("jpeg",true)
-      || fext.equals("xpm",true)
-      ) {
-    uptr<UIma> ima = new UIma;
-    stat = ima->read(ima_path, CONTENT_WIDTH, CONTENT_HEIGHT);
-
-    //delete full_ima; automatic deletion
-    if (stat <= 0) return stat;
-    else {
-      //set(*pname, *ima);
-      ima_box->removeAll();
-      ima_box->add(*ima);
-      return UFilestat::Opened;
-    }
-  }
-  return UFilestat::UnknownType;
+  return fext.equals("gif",true/*ignore case*/)    // !!! A REVOIR (UIma devrait faire ca) !!!@@@
+  || fext.equals("jpg",true)
+  || fext.equals("jpeg",true)
+  || fext.equals("xpm",true);
+}
+
+int UIcon::loadCachedImage(const UStr& ima_path) {
+  if (!isImageFile(ima_path)) return UFilestat::UnknownType;
+
+  UThumbnailCache* cache = UThumbnailCache::getDefault();
+  struct stat st;
+  if (!cache || ::stat(ima_path.c_str(), &st) < 0) return UFilestat::NotOpened;
+
+  uptr<UIma> ima = new UIma;
+  if (!cache->get(ima_path, st.st_mtime, st.st_size, *ima)) return UFilestat::NotOpened;
+  ima_box->removeAll();
+  ima_box->add(*ima);
+  return UFilestat::Opened;
+}
+
+int UIcon::loadImage(const UStr& ima_path) {
+  int stat = loadCachedImage(ima_path);
+  if (stat == UFilestat::NotOpened) stat = readImage(ima_path);
+  return stat;
+}
+
+int UIcon::readImage(const UStr& ima_path) {
+  if (!isImageFile(ima_path)) return UFilestat::UnknownType;
+
+  uptr<UIma> ima = new UIma;
+  int stat = ima->read(ima_path, CONTENT_WIDTH, CONTENT_HEIGHT);
+
+  //delete full_ima; automatic deletion
+  if (stat <= 0) return stat;
+
+  UThumbnailCache* cache = UThumbnailCache::getDefault();
+  struct stat st;
+  if (cache && ::stat(ima_path.c_str(), &st) == 0)
+    cache->put(ima_path, st.st_mtime, st.st_size, *ima);
+
+  //set(*pname, *ima);
+  ima_box->removeAll();
+  ima_box->add(*ima);
+  return UFilestat::Opened;
 }
 
 }
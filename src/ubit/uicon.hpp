@@ -32,7 +32,22 @@ namespace ubit {
     static UStyle* createStyle();
 
     virtual int loadImage(const UStr& image_path);
-    ///< load and shows the icon image, returns file loading status.
+    /**< load and shows the icon image, returns file loading status.
+     * the thumbnail is taken from the thumbnail cache if possible, and is
+     * stored in this cache otherwise (@see UThumbnailCache::getDefault()).
+     */
+
+    virtual int loadCachedImage(const UStr& image_path);
+    /**< shows the icon image if it is in the thumbnail cache.
+     * returns UFilestat::Opened if it is, UFilestat::NotOpened if it is not
+     * (readImage() must then be called) and UFilestat::UnknownType if this
+     * file is not an image.
+     */
+
+    virtual int readImage(const UStr& image_path);
+    /**< reads the image file and shows the icon image, returns file loading status.
+     * the thumbnail cache is not searched but the thumbnail is stored in it.
+     */
     
     const UStr& getName() const {return *pname;}
     
@@ -58,6 +73,14 @@ namespace ubit {
     static UStyle* createStyle();
 
     virtual int readDir(const UStr& pathname, bool remote_dir = false);
+    /**< reads this directory and adds the corresponding icons.
+     * local directories are read asynchronously: the icons are added by chunks
+     * while the directory is read (so that large directories are displayed
+     * immediately), then sorted when reading is complete (@see UFileDirReader).
+     */
+
+    bool isLoading() const;
+    ///< returns true if the directory is still being read.
     
     // inherited:
     // virtual UBox& titlebar() {return *ptitle_bar;}
@@ -75,6 +98,15 @@ namespace ubit {
     virtual void removeIcon(class UIcon&, bool auto_delete=true);
     virtual void removeAllIcons(bool auto_delete = true);
     
+    virtual UIcon* findIcon(const UStr& name) const;
+    ///< returns the icon that has this name (null if none).
+
+    virtual UIcon* insertFileIcon(const UStr& filename);
+    /**< adds the icon of a file of the directory at its sorted position.
+     * returns null if this icon already exists, if the file does not exist or 
+     * if it is not shown by readDir() (eg. dot files, see UFileDirReader::accepts()).
+     */
+    
     virtual class UIcon* getSelectedIcon();
     virtual class UIcon* getPreviousIcon();
     virtual class UIcon* getNextIcon();
@@ -88,13 +120,18 @@ namespace ubit {
     // - - - impl.  - - - - - - - - - - - - - - - - - - - - - - - - - -
   protected:
     friend class UFinder;
+    friend class UFinderWatcher;
     uptr<UStr> ppathname, ptitle;
     uptr<UListbox> picons;
     uptr<UHspacing> icon_hspacing;
     uptr<UVspacing> icon_vspacing;
+    uptr<class UFileDirReader> reader;
     unsigned long filetime;
     bool show_parent_dir;
     virtual void okBehavior(UInputEvent&); 
+    virtual void addEntries();
+    virtual void sortIcons();
+    UIcon& createFileIcon(const class UFileInfo&);
   };
   
 }
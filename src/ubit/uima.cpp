@@ -33,6 +33,7 @@
 #include <ubit/ubox.hpp>
 #include <ubit/uupdate.hpp>
 #include <ubit/uconf.hpp>
+#include <ubit/utaskpool.hpp>
 #include <ubit/nat/uhardima.hpp>
 using namespace std;
 namespace ubit {
@@ -163,9 +164,7 @@ void UIma::resize(int max_width, int max_height, bool preserve_ratio, bool dont_
   // case preserve_smaller : resize if ima is too large
   if (!dont_magnify || (xscale < 1. && yscale < 1.)) {
     UHardIma* ni = (*natimas.begin())->createScaledClone(xscale,yscale);
-    cleanCache();
-    natimas.push_back(ni);
-    changed(true);
+    replaceImpl(ni);
   }
   //return true;
 }
@@ -180,10 +179,28 @@ bool UIma::rescale(float xscale, float yscale) {
   if (natimas.empty()) return false;
 
   UHardIma* ni = (*natimas.begin())->createScaledClone(xscale,yscale);
+  replaceImpl(ni);
+  return true;
+}
+
+// replaces the image by 'ni'. In GL mode, if 'ni' has the same size as the image,
+// its pixels are transfered to the current image so that the texture is reused.
+void UIma::replaceImpl(UHardIma* ni) {
+  if (!ni) return;
+#if UBIT_WITH_GL
+  UHardImaGL* gni = dynamic_cast<UHardImaGL*>(ni);
+  UHardImaGL* cur = natimas.empty() ? null : dynamic_cast<UHardImaGL*>(natimas.front());
+  if (gni && cur && cur->swapPixels(*gni)) {
+    delete ni;
+    // the other images are scaled copies of the original
+    while (natimas.size() > 1) {delete natimas.back(); natimas.pop_back();}
+    changed(true);
+    return;
+  }
+#endif
   cleanCache();
   natimas.push_back(ni);
   changed(true);
-  return true;
 }
 
 /* ==================================================== ===== ======= */
@@ -289,12 +306,93 @@ void UIma::setImpl(int w, int h) {
   }
 }
 
+/* ==================================================== ===== ======= */
+
+bool UIma::getRGBA(std::vector<unsigned char>& pixels, int& w, int& h) const {
+#if UBIT_WITH_GL
+  if (UAppli::isUsingGL() && !natimas.empty()) {
+    UHardImaGL* ni = dynamic_cast<UHardImaGL*>(natimas.front());
+    if (ni && ni->getPixels() && ni->getWidth() > 0 && ni->getHeight() > 0) {
+      w = ni->getWidth();
+      h = ni->getHeight();
+      pixels.assign(ni->getPixels(), ni->getPixels() + size_t(w) * h * 4);
+      return true;
+    }
+  }
+#endif
+  return false;
+}
+
+bool UIma::setRGBA(const unsigned char* pixels, int w, int h) {
+  if (checkConst()) return false;
+#if UBIT_WITH_GL
+  if (UAppli::isUsingGL() && pixels && w > 0 && h > 0) {
+    // the pixel buffer and the texture are reused if the size did not change
+    UHardImaGL* ni = natimas.empty() ? null : dynamic_cast<UHardImaGL*>(natimas.front());
+    if (ni && ni->getPixels() && natimas.size() == 1 && mode == CREATE
+        && ni->getWidth() == w && ni->getHeight() == h) {
+      memcpy(ni->getPixels(), pixels, size_t(w) * h * 4);
+      pixelsChanged(0, 0, w, h);
+      return true;
+    }
+    
+    setImpl(w, h);
+    ni = natimas.empty() ? null : dynamic_cast<UHardImaGL*>(natimas.front());
+    if (ni && ni->getPixels()) {
+      memcpy(ni->getPixels(), pixels, size_t(w) * h * 4);
+      changed(true);
+      return true;
+    }
+  }
+#endif
+  return false;
+}
+
+bool UIma::setRGBA(const unsigned char* pixels, int x, int y, int w, int h) {
+  if (checkConst()) return false;
+#if UBIT_WITH_GL
+  if (UAppli::isUsingGL() && pixels && !natimas.empty()) {
+    UHardImaGL* ni = dynamic_cast<UHardImaGL*>(natimas.front());
+    if (!ni || !ni->getPixels() || w <= 0 || h <= 0 || x < 0 || y < 0
+        || x + w > ni->getWidth() || y + h > ni->getHeight()) 
+      return false;
+    
+    size_t stride = size_t(ni->getWidth()) * 4;
+    for (int j = 0; j < h; ++j)
+      memcpy(ni->getPixels() + (y + j) * stride + size_t(x) * 4, pixels + size_t(j) * w * 4, 
+             size_t(w) * 4);
+    pixelsChanged(x, y, w, h);
+    return true;
+  }
+#endif
+  return false;
+}
+
+// the size of the image did not change: its parents just need to be repainted
+void UIma::pixelsChanged(int x, int y, int w, int h) {
+#if UBIT_WITH_GL
+  if (UAppli::isUsingGL() && !natimas.empty()) {
+    UHardImaGL* ni = dynamic_cast<UHardImaGL*>(natimas.front());
+    if (ni) ni->invalidate(x, y, w, h);
+    // the other images are scaled copies of the original
+    while (natimas.size() > 1) {delete natimas.back(); natimas.pop_back();}
+  }
+#endif
+  if (!omodes.DONT_AUTO_UPDATE) _parents.updateAutoParents(UUpdate::paint);
+  changed(false);
+}
+
 /* ==================================================== [Elc] ======= */
 
 void UIma::getSize(UUpdateContext& ctx, UDimension& dim) const {
   UDisp* d = ctx.getDisp();
 
   if (stat == UFilestat::NotOpened && natimas.empty()) {
+    if (UTask::inWorkerThread()) {   // images are loaded by the main thread
+      UTask::requireMainThread();
+      dim.width = dim.height = 0;
+      return;
+    }
     realize(0 ,0, d, false);
   }
 
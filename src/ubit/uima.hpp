@@ -16,6 +16,7 @@
 
 #ifndef _uima_hpp_
 #define	_uima_hpp_ 1
+#include <vector>
 #include <ubit/udata.hpp>
 namespace ubit {
 
@@ -199,6 +200,30 @@ public:
   std::list<UHardIma*>& getNatImas() const {return natimas;}
   ///< [impl] returns internal implementation.
 
+  bool getRGBA(std::vector<unsigned char>& pixels, int& width, int& height) const;
+  /**< [impl] copies the pixels of the image (RGBA, 8 bits per component).
+   * returns false if the image is not loaded or if OpenGL is not used.
+   */
+
+  bool setRGBA(const unsigned char* pixels, int width, int height);
+  /**< [impl] replaces the image by these pixels (RGBA, 8 bits per component).
+   * the pixel buffer and the texture of the image are reused if the image was
+   * created with the same size. returns false if OpenGL is not used.
+   */
+
+  bool setRGBA(const unsigned char* pixels, int x, int y, int width, int height);
+  /**< [impl] replaces the pixels of this area of the image (RGBA, 8 bits per component).
+   * 'pixels' contains width x height pixels. Only this area of the texture is uploaded
+   * again. returns false if OpenGL is not used or if the area is not inside the image.
+   */
+
+  void pixelsChanged(int x, int y, int width, int height);
+  /**< [impl] specifies that the pixels of this area have been modified.
+   * must be called when the pixel buffer of the image (see UHardImaGL::getPixels())
+   * is modified directly: only this area of the texture is uploaded again and 
+   * the parents of the image are repainted (but not laid out again).
+   */
+
   static void getFullPath(UStr& fullpath, const char* filename);
   /**< gets the full image pathname.
     * UAppli::getImaPath() (the default image pathname) is prefixed
@@ -214,6 +239,7 @@ public:
   virtual void setImpl(const char** xpm_data);
   virtual void setImpl(int width, int height);
   virtual void cleanCache();
+  void replaceImpl(UHardIma*);
   virtual void getSize(UUpdateContext&, UDimension&) const;
   virtual void paint(UGraph&, UUpdateContext&, const URect&) const;
 
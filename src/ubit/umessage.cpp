@@ -19,22 +19,133 @@
 #include <algorithm>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <ubit/uon.hpp>
 #include <ubit/ucall.hpp>
 #include <ubit/ubox.hpp>
 #include <ubit/uevent.hpp>
 #include <ubit/uappli.hpp>
 #include <ubit/uappliImpl.hpp>
+#include <ubit/udialogs.hpp>
+#include <ubit/uwinImpl.hpp>
 #include <ubit/umessage.hpp>
 #include <ubit/umservice.hpp>
 #include <ubit/umsproto.hpp>
+#include <ubit/usocket.hpp>
+#include <ubit/utimer.hpp>
 #include <ubit/nat/udispX11.hpp>
 using namespace std;
 namespace ubit {
 
 /* ==================================================== ====== ======= */
 
-UMessagePort::UMessagePort(const UStr& _name) : name(_name) {}
+UMessagePort::UMessagePort(const UStr& _name) : name(_name), value_changed(false) {}
+
+const UStr& UMessagePort::getValue() {
+  if (value_changed) {     // the UStr is only created if needed
+    value = data.c_str();
+    value_changed = false;
+  }
+  return value;
+}
+
+/* ==================================================== ======== ======= */
+// the directory of the sockets is only accessible by this user. an existing
+// directory is rejected if it belongs to another user or is not a directory
+
+static bool makePrivateDir(const char* path) {
+  if (::mkdir(path, 0700) == 0) return true;
+  if (errno != EEXIST) return false;
+  struct stat st;
+  if (::lstat(path, &st) < 0 || !S_ISDIR(st.st_mode) || st.st_uid != getuid())
+    return false;
+  return (st.st_mode & 077) == 0 || ::chmod(path, 0700) == 0;
+}
+
+// the messages sent by applications on the same host are received on a
+// Unix-domain socket (see UMS_MESSAGE_LOCAL_SOCKET), other messages by the X server.
+
+UMessagePortMap::UMessagePortMap() : local_sock(null) {
+  char dir[100], path[100];
+  sprintf(dir, UMS_MESSAGE_LOCAL_DIR, int(getuid()));
+  sprintf(path, UMS_MESSAGE_LOCAL_SOCKET, int(getuid()), int(getpid()));
+  if (!makePrivateDir(dir)) return;
+  local_sock = new UServerSocket();
+  if (!local_sock->bindLocal(path) || ::chmod(path, 0600) < 0) {
+    delete local_sock;
+    local_sock = null;
+    return;
+  }
+  local_sock->onInput(ucall(this, &UMessagePortMap::acceptPeer));
+  local_name = UMessageChannel::getHostName();
+  local_name += ' ';
+  local_name += path;
+
+  // the windows that are already shown must give the socket to the other applications
+  UFrame* mainframe = UAppli::getMainFrame();
+  UHardwinImpl* hw = mainframe ? mainframe->getHardwin() : null;
+  if (hw && hw->isRealized()) publishLocalSocket(*hw);
+}
+
+UMessagePortMap::~UMessagePortMap() {
+  for (map<USocket*,unsigned int>::iterator k = peers.begin(); k != peers.end(); ++k)
+    delete k->first;
+  for (unsigned int k = 0; k < closed_peers.size(); k++) delete closed_peers[k];
+  delete local_sock;   // also removes the socket file
+}
+
+const char* UMessagePortMap::getLocalSocketName() const {
+  return local_sock ? local_name.c_str() : null;
+}
+
+void UMessagePortMap::acceptPeer() {
+  // the peers can't be deleted in their own input callback
+  for (unsigned int k = 0; k < closed_peers.size(); k++) delete closed_peers[k];
+  closed_peers.clear();
+
+  USocket* s = local_sock->accept();
+  if (!s) return;
+  s->setNonBlocking(true);
+  peers[s] = 0;
+  s->onInput(ucall(this, s, &UMessagePortMap::readPeer));
+}
+
+// each message is a 4 byte length (network order) followed by the name of
+// the port, a null char and the value (see UMS_MESSAGE_LOCAL_SOCKET)
+
+void UMessagePortMap::readPeer(USocket* s) {
+  map<USocket*,unsigned int>::iterator p = peers.find(s);
+  if (p == peers.end()) return;
+
+  while (true) {
+    if (p->second == 0) {
+      unsigned char len[4];
+      if (!s->receiveBytes((char*)len, 4)) break;
+      p->second = (len[0] << 24) | (len[1] << 16) | (len[2] << 8) | len[3];
+      if (p->second == 0) continue;
+      if (p->second > MAX_MESSAGE_SIZE) {   // not a valid message
+        s->close();
+        break;
+      }
+    }
+    unsigned int size = p->second;
+    if (peer_buf.size() < size) peer_buf.resize(size);
+    if (!s->receiveBytes(&peer_buf[0], size)) break;
+    p->second = 0;
+
+    const char* name = &peer_buf[0];
+    const char* end = (const char*)memchr(name, 0, size);
+    if (end) fireMessagePort(name, end + 1, size - (end + 1 - name));
+  }
+
+  if (!s->isConnected()) {
+    peers.erase(p);
+    closed_peers.push_back(s);
+  }
+}
 
 UMessagePort* UMessagePortMap::findMessagePort(const UStr& name) {
   MessMap::iterator k = mess_map.find(&name);
@@ -53,6 +164,19 @@ UMessagePort& UMessagePortMap::getMessagePort(const UStr& name) {
 
 /* ==================================================== ======== ======= */
 
+void UMessagePortMap::fireMessagePort(const char* name, const char* data,
+                                      unsigned int size) {
+  if (!name) return;
+  UStr s = name;
+  UMessagePort* port = findMessagePort(s);
+  if (port) {
+    port->data.assign(data, size);
+    port->value_changed = true;
+    UMessageEvent e(UOn::action, port);
+    port->fire(e);
+  }
+}
+
 void UMessagePortMap::fireMessagePort(const char* buf) {
   if (buf) {
     UStr name;
@@ -67,8 +191,9 @@ void UMessagePortMap::fireMessagePort(const char* buf) {
 
     UMessagePort* port = findMessagePort(name);
     if (port) {
-      if (p) port->value = p;  // A REVOIR: marche pas si multistrings ou binaires
-      else port->value = "";
+      if (p) port->data = p;
+      else port->data.clear();
+      port->value_changed = true;
 
       //UMessageEvent e(UOn::message, null, null, null);  // a quoi sert message ?
       //e.setCond(UOn::action);
@@ -86,6 +211,15 @@ void UMessage::send(UHardwinImpl&, const char* message) {
   cerr << "UMessage::send not implemented " << endl;
 }
 
+bool UMessage::send(unsigned long xwin, const char* port, const char* data, unsigned int size) {
+  cerr << "UMessage::send not implemented " << endl;
+  return false;
+}
+
+void UMessage::closeChannel(unsigned long xwin) {}
+
+void UMessagePortMap::publishLocalSocket(UHardwinImpl&) {}
+
 #else  // - - - UBIT_WITH_X11 - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 //ifdef UBIT_WITH_GDK
@@ -139,7 +273,7 @@ static void sendLongMessage(UDispX11* nd, UHardwinX11* nw,
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 void UMessage::send(UHardwinImpl& nw, const char* message) {
-  if (!message) return;
+  if (!message || !dynamic_cast<UHardwinX11*>(&nw)) return;  // not an X11 window
   unsigned int len = strlen(message);
   UDisp* nd = UAppli::impl.disp;
   
@@ -150,7 +284,7 @@ void UMessage::send(UHardwinImpl& nw, const char* message) {
 }
 
 void UMessage::send(UHardwinImpl& nw, const UStr& message) {
-  if (message.empty()) return;
+  if (message.empty() || !dynamic_cast<UHardwinX11*>(&nw)) return;  // not an X11 window
   unsigned int len = message.length();
   UDisp* nd = UAppli::impl.disp;
 
@@ -160,8 +294,176 @@ void UMessage::send(UHardwinImpl& nw, const UStr& message) {
   else sendLongMessage((UDispX11*)nd,(UHardwinX11*)&nw, message.c_str(), len);
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// connections with the applications that run on the same host. windows that
+// have no message socket (or whose socket is on another host) are not stored:
+// they may publish it later. See also closeChannel().
+
+typedef std::map<unsigned long, UMessageChannel*> MessageChannels;
+static MessageChannels channels;
+static UTimer* flush_timer = null;
+
+static void flushChannels() {
+  for (MessageChannels::iterator k = channels.begin(); k != channels.end(); ) {
+    if (!k->second->flush()) {
+      delete k->second;
+      channels.erase(k++);     // the socket will be looked for again
+    }
+    else ++k;
+  }
+}
+
+static UMessageChannel* getChannel(UDispX11* nd, unsigned long xwin) {
+  MessageChannels::iterator k = channels.find(xwin);
+  if (k != channels.end()) return k->second;
+
+  // the channel is closed when the window is destroyed or when its socket
+  // changes (see UDispX11::dispatchEvent()). the events are selected first
+  // so that no change is missed. the mask of this client is kept
+  XWindowAttributes attr;
+  if (!XGetWindowAttributes(nd->getSysDisp(), xwin, &attr)) return null;
+  XSelectInput(nd->getSysDisp(), xwin, 
+               attr.your_event_mask | StructureNotifyMask | PropertyChangeMask);
+
+  UMessageChannel* ch = null;
+  unsigned char* prop = null;
+  Atom type;
+  int format;
+  unsigned long nitems = 0, bytes_after = 0;
+  if (XGetWindowProperty(nd->getSysDisp(), xwin, nd->getAtoms().UMS_MESSAGE_SOCKET,
+                         0, 1024, False, XA_STRING, &type, &format, 
+                         &nitems, &bytes_after, &prop) == Success
+      && prop && nitems > 0 && type == XA_STRING && format == 8) {
+    ch = new UMessageChannel();
+    if (!ch->open((const char*)prop)) {delete ch; ch = null;}
+  }
+  if (prop) XFree(prop);
+  if (ch) channels[xwin] = ch;
+  return ch;
+}
+
+void UMessage::closeChannel(unsigned long xwin) {
+  MessageChannels::iterator k = channels.find(xwin);
+  if (k != channels.end()) {
+    delete k->second;
+    channels.erase(k);
+  }
+}
+
+bool UMessage::send(unsigned long xwin, const char* port, const char* data, unsigned int size) {
+  UDispX11* nd = dynamic_cast<UDispX11*>(UAppli::impl.disp);
+  if (!port || !xwin || !nd) return false;     // nd is null with the headless display
+  if (!data) size = 0;
+
+  UMessageChannel* ch = getChannel(nd, xwin);
+  if (ch) {
+    if (ch->send(port, data, size)) {
+      // the messages are sent together when the main loop becomes idle
+      if (!flush_timer) {
+        flush_timer = new UTimer(0, 1, false);
+        flush_timer->onAction(ucall(flushChannels));
+      }
+      if (!flush_timer->isRunning()) flush_timer->start();
+      return true;
+    }
+    delete ch;
+    channels.erase(xwin);
+  }
+
+  // other host: the X property can only contain a "name value" string
+  if (size > 0 && memchr(data, 0, size)) {
+    UAppli::error("UMessage::send","binary data can't be sent to the remote window %ld", xwin);
+    return false;
+  }
+  string message = port;
+  if (size > 0) message.append(" ").append(data, size);
+  XChangeProperty(nd->getSysDisp(), xwin, nd->getAtoms().UMS_MESSAGE,
+                  XA_STRING, 8, PropModeAppend,
+                  (unsigned char*)message.c_str(), message.size());
+  XFlush(nd->getSysDisp());
+  return true;
+}
+
+void UMessagePortMap::publishLocalSocket(UHardwinImpl& hw) {
+  UDispX11* nd = dynamic_cast<UDispX11*>(UAppli::impl.disp);
+  if (!local_sock || !hw.isRealized() || !nd) return;
+  XChangeProperty(nd->getSysDisp(), ((UHardwinX11&)hw).getSysWin(),
+                  nd->getAtoms().UMS_MESSAGE_SOCKET, XA_STRING, 8, PropModeReplace,
+                  (unsigned char*)local_name.c_str(), local_name.size());
+}
+
 #endif  // UBIT_WITH_X11
 
+bool UMessage::send(unsigned long xwin, const char* port, const UStr& value) {
+  return send(xwin, port, value.c_str(), value.length());
+}
+
+/* ==================================================== ====== ======= */
+
+UMessageChannel::UMessageChannel() : sock(null) {}
+
+UMessageChannel::~UMessageChannel() {
+  delete sock;
+}
+
+const char* UMessageChannel::getHostName() {
+  static char name[256] = "";
+  if (!*name && gethostname(name, sizeof(name)) == 0) name[sizeof(name)-1] = 0;
+  return name;
+}
+
+bool UMessageChannel::open(const char* prop) {
+  delete sock;
+  sock = null;
+  pending.clear();
+  const char* path = prop ? strchr(prop, ' ') : null;
+  const char* host = getHostName();
+  if (!path || !*host || strlen(host) != (unsigned int)(path - prop)
+      || strncmp(prop, host, path - prop) != 0)
+    return false;   // another host
+
+  sock = new USocket();
+  if (sock->connectLocal(path + 1) < 0) {
+    delete sock;
+    sock = null;
+    return false;
+  }
+  // the receiver may be busy: the data is then queued and sent by the main loop.
+  // large values must not be rejected
+  sock->setNonBlocking(true);
+  sock->setMaxPendingOutput(0);
+  return true;
+}
+
+bool UMessageChannel::send(const char* port, const char* data, unsigned int size) {
+  if (!sock || !sock->isConnected()) return false;
+  unsigned int namelen = strlen(port) + 1;
+  unsigned int len = namelen + size;
+  char header[4] = {char(len >> 24), char(len >> 16), char(len >> 8), char(len)};
+
+  if (pending.size() + 4 + len <= MAX_PENDING) {
+    pending.insert(pending.end(), header, header + 4);
+    pending.insert(pending.end(), port, port + namelen);
+    pending.insert(pending.end(), data, data + size);
+    return true;
+  }
+
+  // large values are not copied in the pending buffer
+  if (!flush()) return false;
+  pending.insert(pending.end(), header, header + 4);
+  pending.insert(pending.end(), port, port + namelen);
+  bool stat = sock->sendBytes(&pending[0], pending.size()) && sock->sendBytes(data, size);
+  pending.clear();
+  return stat;
+}
+
+bool UMessageChannel::flush() {
+  if (!sock) return false;
+  if (pending.empty()) return sock->isConnected();
+  bool stat = sock->sendBytes(&pending[0], pending.size());
+  pending.clear();
+  return stat;
+}
 
 }
 /* ==================================================== [TheEnd] ======= */
@@ -17,17 +17,70 @@
 #ifndef _umessage_hpp_
 #define	_umessage_hpp_
 #include <map>
+#include <vector>
 #include <string>
 #include <ubit/uelem.hpp>
 #include <ubit/uattr.hpp>
 namespace ubit {
 
+class USocket;
+class UServerSocket;
+
 /** Ubit Message.
 */
 class UMessage {
 public:
   static void send(UHardwinImpl&, const char* message);
   static void send(UHardwinImpl&, const UStr& message);
+
+  static void closeChannel(unsigned long xwin);
+  /**< [impl] closes the connection with the socket of this window.
+   * called when this window is destroyed or when its UMS_MESSAGE_SOCKET_PROPERTY
+   * changes: the socket will then be looked for again by send().
+   */
+
+  static bool send(unsigned long xwin, const char* port, const UStr& value);
+  static bool send(unsigned long xwin, const char* port, const char* data, unsigned int size);
+  /**< sends a message to a port of the application that owns this X window.
+   * if this application runs on the same host, the message is sent to its
+   * socket (see UMS_MESSAGE_SOCKET_PROPERTY): the data can then be binary and
+   * of any size, and the messages that are sent during the same iteration of 
+   * the main loop are sent together. Otherwise, the message is sent through 
+   * an X property, which fails if the data is binary.
+   */
+};
+
+/* ==================================================== ====== ======= */
+/** [Impl] connection with the message socket of another application.
+ * see UMS_MESSAGE_LOCAL_SOCKET and UMessage::send().
+ */
+class UMessageChannel {
+public:
+  UMessageChannel();
+  ~UMessageChannel();
+
+  bool open(const char* socket_property);
+  /**< connects to the socket given by the UMS_MESSAGE_SOCKET_PROPERTY of a window.
+   * fails if the application runs on another host.
+   */
+
+  bool send(const char* port, const char* data, unsigned int size);
+  /**< adds a message to the messages that are waiting to be sent.
+   * flush() is called if too much data is waiting.
+   */
+  
+  bool flush();
+  ///< sends the messages that are waiting to be sent.
+  
+  static const char* getHostName();
+  ///< returns the name of this host (as used in UMS_MESSAGE_SOCKET_PROPERTY).
+
+private:
+  enum {MAX_PENDING = 64*1024};
+  UMessageChannel(const UMessageChannel&);
+  UMessageChannel& operator=(const UMessageChannel&);
+  USocket* sock;
+  std::vector<char> pending;    // messages that are waiting to be sent
 };
 
 /* ==================================================== ====== ======= */
@@ -37,11 +90,18 @@ class UMessagePort : public UElem {
 public:
   UMessagePort(const UStr& name);
   const UStr& getName()  {return name;}
-  const UStr& getValue() {return value;}
+
+  const UStr& getValue();
+  ///< returns the value of the last message as a string (see getData()).
+
+  const std::string& getData() const {return data;}
+  ///< returns the value of the last message (which may contain binary data).
 
 private:
   friend class UMessagePortMap;
   UStr name, value;
+  std::string data;
+  bool value_changed;   // 'value' must be updated from 'data'
 };
 
 /* ==================================================== ====== ======= */
@@ -49,9 +109,28 @@ private:
  */
 class UMessagePortMap {
 public:
+  enum {MAX_MESSAGE_SIZE = 16*1024*1024};
+  ///< the connection of a peer that sends a larger message is closed.
+
+  UMessagePortMap();
+  ~UMessagePortMap();
+
   UMessagePort& getMessagePort(const UStr& name);
   UMessagePort* findMessagePort(const UStr& name);
+
   void fireMessagePort(const char* data);
+  ///< fires the port of a "name value" message.
+
+  void fireMessagePort(const char* name, const char* data, unsigned int size);
+  ///< fires this port with a value that may contain binary data.
+
+  const char* getLocalSocketName() const;
+  /**< returns the "hostname path" of the socket that receives the messages. 
+   * returns null if this socket could not be opened (see UMS_MESSAGE_LOCAL_SOCKET).
+   */
+  
+  void publishLocalSocket(UHardwinImpl&);
+  ///< sets the UMS_MESSAGE_SOCKET_PROPERTY of this window.
 
 private:
   struct Comp {
@@ -60,7 +139,14 @@ private:
   };
   typedef std::map<const UStr*, UMessagePort*, Comp> MessMap;
   MessMap mess_map;
+  UServerSocket* local_sock;
+  std::string local_name;
+  std::map<USocket*, unsigned int> peers;  // size of the message being received
+  std::vector<USocket*> closed_peers;      // deleted by the next acceptPeer()
+  std::vector<char> peer_buf;
   void _fireMessagePort(UMessageEvent&, const char* buf);
+  void acceptPeer();
+  void readPeer(USocket*);
 };
 
 }
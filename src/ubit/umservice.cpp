@@ -23,10 +23,12 @@
 #include <ubit/uappliImpl.hpp>
 #include <ubit/usource.hpp>
 #include <ubit/usocket.hpp>
+#include <ubit/usharedring.hpp>
 #include <ubit/umessage.hpp>
 #include <ubit/umservice.hpp>
 #include <ubit/umsproto.hpp>
 #include <ubit/uevent.hpp>
+#include <ubit/utimer.hpp>
 #if UBIT_WITH_X11
 #  include <X11/X.h>
 #else
@@ -39,16 +41,31 @@
 using namespace std;
 namespace ubit {
 
+// the connection is non-blocking so that a slow or hung server does not
+// block the application (see USocket::setNonBlocking())
+
 UMService::UMService(const UStr& _host, int _port, const char* _client_name)
-: USocket(_host, (_port != 0 ? _port : UMS_PORT_NUMBER)) {
+: protocol(1), batch(null), ring(null) {
+  open(_host, (_port != 0 ? _port : UMS_PORT_NUMBER));
 }
 
+// batching is negociated with the server when the connection is opened.
+// version 1 is used until the server replies (old servers never reply).
+
 UMService::UMService(const UStr& _host, int _port)
-: USocket(_host, (_port != 0 ? _port : UMS_PORT_NUMBER)) {
+: protocol(1), batch(null), ring(null) {
+  open(_host, (_port != 0 ? _port : UMS_PORT_NUMBER));
   onInput(ucall(this, &UMService::inputCallback));
+  UMSrequest req(UMSrequest::SET_PROTOCOL);
+  req.writeChar((unsigned char)UMS_PROTOCOL_VERSION);
+  sendBlock(req);
 }
 
 UMService::~UMService() {
+  if (batch_timer) batch_timer->stop();
+  flushRequests();
+  delete batch;
+  delete ring;
   UMessagePort& mp1 = UAppli::getMessagePort("_umsBrowse");
   if (browse_call) mp1.remove(*browse_call);
 
@@ -56,13 +73,53 @@ UMService::~UMService() {
    if (neighbor_call) mp2.remove(*neighbor_call);
 }
 
+// local clients send their requests through a shared memory ring (see
+// UMS_LOCAL_SOCKET), the local socket is then only used for replies. TCP is
+// used for remote hosts or if the server does not have a local socket.
+
+void UMService::open(const UStr& host, int port) {
+  if (isLocalHost(host)) {
+    char path[100];
+    sprintf(path, UMS_LOCAL_SOCKET, port);
+    if (connectLocal(path) >= 0) {
+      ring = new USharedRing();
+      if (ring->create()) {
+        int fds[2] = {ring->getMemoryDescriptor(), ring->getEventDescriptor()};
+        if (!sendDescriptors(fds, 2)) close();
+      }
+      else {
+        // the requests are then sent through the local socket
+        delete ring;
+        ring = null;
+        if (!sendDescriptors(null, 0)) close();
+      }
+      if (!isConnected()) {delete ring; ring = null;}
+    }
+  }
+  if (!isConnected()) connect(host.c_str(), port);
+  setNonBlocking(true);
+}
+
+bool UMService::isLocalHost(const UStr& host) {
+  if (host.empty() || host == "localhost" || host == "127.0.0.1") return true;
+  char name[256];
+  if (gethostname(name, sizeof(name)) != 0) return false;
+  name[sizeof(name)-1] = 0;
+  return host == name;
+}
+
 /* ==================================================== ======== ======= */
 
 void UMService::inputCallback() {
   UInbuf ib;
-  if (receiveBlock(ib) && UAppli::impl.messmap) {
+  // several messages may have been received (non-blocking mode)
+  while (receiveBlock(ib)) {
     //ib.data()[ib.size()-1] = 0; // faux
-    UAppli::impl.messmap->fireMessagePort(ib.data());
+    if (ib.size() > 13 && strncmp(ib.data(), "_umsProtocol ", 13) == 0) {
+      protocol = atoi(ib.data() + 13);
+      motions.clear();   // the delta encoding starts with this version
+    }
+    else if (UAppli::impl.messmap) UAppli::impl.messmap->fireMessagePort(ib.data());
   }
   /*
    if (input) {
@@ -184,35 +241,106 @@ UMService::ResolveReply::ResolveReply(UMessageEvent& e) {
 
 /* ==================================================== ======== ======= */
 /* ==================================================== [(c)Elc] ======= */
+// with protocol version 2, requests are appended to the current batch, which
+// is sent when the main loop becomes idle (ie. once per iteration of the loop)
+
+bool UMService::send(UMSrequest& req) {
+  // the ring is not batched: the server reads the requests as they are written
+  if (ring) {
+    if (!isConnected()) return false;
+    if (ring->write(req)) return true;
+    // the ring is full: this request and the next ones are sent through the
+    // socket. they remain ordered as the server reads the ring first
+    delete ring;
+    ring = null;
+  }
+  if (protocol < 2) return sendBlock(req);
+
+  if (batch && batch->size() + req.size() + 5 > MAX_BATCH_SIZE) {
+    if (!flushRequests()) return false;
+  }
+  // a request that doesn't fit in a batch is sent on its own (after the
+  // pending batch so that the requests remain ordered)
+  if (req.size() + 5 > MAX_BATCH_SIZE) return sendBlock(req);
+  if (!batch) batch = new UMSrequest(UMSrequest::BATCH);
+  batch->writeBlock(req);
+
+  if (!batch_timer) {
+    batch_timer = new UTimer(0, 1, false);
+    batch_timer->onAction(ucall(this, &UMService::flushRequests));
+  }
+  if (!batch_timer->isRunning()) batch_timer->start();
+  return true;
+}
+
+bool UMService::flushRequests() {
+  if (!batch) return true;
+  UMSrequest* b = batch;
+  batch = null;
+  bool stat = sendBlock(*b);
+  delete b;
+  // the motions of the batch are lost: the next ones are not delta encoded
+  if (!stat) motions.clear();
+  return stat;
+}
+
+// x and y are delta encoded for the successive motions of a flow. the last
+// motion is only updated if the request was sent (or added to the batch)
+
+bool UMService::sendEvent(unsigned char type, int flow, long x, long y,
+                          unsigned long detail) {
+  if (protocol < 2) {
+    UMSrequest req(UMSrequest::KEY_MOUSE_CTRL);
+    req.writeEvent(type, flow, x, y, detail);
+    return send(req);
+  }
+  
+  UMSrequest req(UMSrequest::COMPACT_EVENT);
+  req.writeChar(type);
+  req.writeChar((unsigned char)flow);
+  
+  if (type == MotionNotify) {
+    std::map<int, std::pair<long,long> >::iterator k = motions.find(flow);
+    if (k == motions.end()) {
+      req.writeChar((unsigned char)0);
+      req.writeSVarint(x);
+      req.writeSVarint(y);
+    }
+    else {
+      req.writeChar((unsigned char)UMSrequest::DELTA_COORDS);
+      req.writeSVarint(x - k->second.first);
+      req.writeSVarint(y - k->second.second);
+    }
+  }
+  else {
+    req.writeChar((unsigned char)0);
+    req.writeSVarint(x);
+    req.writeSVarint(y);
+  }
+  req.writeVarint(detail);
+  if (!send(req)) return false;
+  if (type == MotionNotify) motions[flow] = std::make_pair(x, y);
+  return true;
+}
 
 bool UMService::moveMouse(int event_flow, int x, int y, bool abs_coords) {
-  UMSrequest req(UMSrequest::KEY_MOUSE_CTRL);
-  req.writeEvent(MotionNotify, event_flow, x, y, abs_coords);
-  return sendBlock(req);
+  return sendEvent(MotionNotify, event_flow, x, y, abs_coords);
 }
 
 bool UMService::pressMouse(int event_flow, int button_mask) {
-  UMSrequest req(UMSrequest::KEY_MOUSE_CTRL);
-  req.writeEvent(ButtonPress, event_flow, 0, 0, button_mask);
-  return sendBlock(req);
+  return sendEvent(ButtonPress, event_flow, 0, 0, button_mask);
 }
 
 bool UMService::releaseMouse(int event_flow, int button_mask) {
-  UMSrequest req(UMSrequest::KEY_MOUSE_CTRL);
-  req.writeEvent(ButtonRelease, event_flow, 0, 0, button_mask);
-  return sendBlock(req);
+  return sendEvent(ButtonRelease, event_flow, 0, 0, button_mask);
 }
 
 bool UMService::pressKey(int event_flow, int keycode) {
-  UMSrequest req(UMSrequest::KEY_MOUSE_CTRL);
-  req.writeEvent(KeyPress, event_flow, 0, 0/*ex:mods*/, keycode);
-  return sendBlock(req);
+  return sendEvent(KeyPress, event_flow, 0, 0/*ex:mods*/, keycode);
 }
 
 bool UMService::releaseKey(int event_flow, int keycode) {
-  UMSrequest req(UMSrequest::KEY_MOUSE_CTRL);
-  req.writeEvent(KeyRelease, event_flow, 0, 0/*ex:mods*/, keycode);
-  return sendBlock(req);
+  return sendEvent(KeyRelease, event_flow, 0, 0/*ex:mods*/, keycode);
 }
 
 /*
@@ -231,7 +359,7 @@ bool UMService::sendMousePress(const char* target,
   UMSrequest req(UMSrequest::SEND_EVENT);
   req.writeEvent(ButtonPress, /*flow*/0, x, y, mouse_btn | mods);
   req.writeString(target);
-  return sendBlock(req);
+  return send(req);
 }
 
 bool UMService::sendMouseRelease(const char* target,  
@@ -239,7 +367,7 @@ bool UMService::sendMouseRelease(const char* target,
   UMSrequest req(UMSrequest::SEND_EVENT);
   req.writeEvent(ButtonRelease, /*flow*/0, x, y, mouse_btn | mods);
   req.writeString(target);
-  return sendBlock(req);
+  return send(req);
 }
 
 bool UMService::sendMouseClick(const char* target, 
@@ -260,7 +388,7 @@ bool UMService::sendRequest(int request, const char* data) {
   if (!data) data = "";    // data can be empty in this case
   UMSrequest req(request);
   req.writeString(data);
-  return sendBlock(req);
+  return send(req);
 }
 
 /* ==================================================== ======== ======= */
@@ -278,7 +406,7 @@ bool UMService::sendMessage(const char* target, const char* message) {
   UMSrequest req(UMSrequest::SEND_MESSAGE);
   req.writeString(target);
   req.writeString(message);
-  return sendBlock(req);
+  return send(req);
 }
 
 }
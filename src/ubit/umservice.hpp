@@ -16,10 +16,14 @@
 
 #ifndef _umservice_hpp_
 #define	_umservice_hpp_
+#include <map>
 #include <ubit/udefs.hpp>
 #include <ubit/usocket.hpp>
 namespace ubit {
   
+  struct UMSrequest;
+  class USharedRing;
+  
   /** UMService: Ubit Mouse/Message Service.
    */
   class UMService : public USocket {
@@ -35,9 +39,14 @@ namespace ubit {
      *  - port: the port of the UMS server. A value of 0 (the default) 
      *    means that UMS_PORT (ie. 9666) is used.
      *
-     *  Note:
-     *  the UMS server (ie. the 'umsd' program) must already be running on 
-     *  the (local or remote) host. umsd can be found in directory ubit/ums
+     *  Notes:
+     *  - the UMS server (ie. the 'umsd' program) must already be running on 
+     *    the (local or remote) host. umsd can be found in directory ubit/ums
+     *  - if the server is on the local host, requests are sent through
+     *    shared memory (see UMS_LOCAL_SOCKET) when this is supported.
+     *  - otherwise, if the server supports it, requests are batched: they are sent
+     *    together when the main loop becomes idle (see flushRequests())
+     *    and mouse motions are delta encoded.
      */
     
     ~UMService();
@@ -173,6 +182,17 @@ namespace ubit {
     bool sendRequest(int ums_request, const char* data = null);
     ///< sends a request to the UMS server (see UMSrequest).
     
+    bool flushRequests();
+    /**< sends the requests that are waiting to be sent.
+     * requests are batched if the server supports version 2 of the protocol
+     * (see UMS_PROTOCOL_VERSION). They are then sent automatically when the
+     * main loop becomes idle or when the batch is full. This function
+     * sends them immediately.
+     */
+    
+    int getProtocolVersion() const {return protocol;}
+    ///< returns the version of the protocol used with the UMS server.
+
     // - - - impl. - - - - - - - - - - - - - - - - - - - - - - - - - - -
     
     UMService(const UStr& host, int port, const char* client_name);
@@ -182,7 +202,18 @@ namespace ubit {
     ///< [impl].
     
   protected:
+    enum {MAX_BATCH_SIZE = 8192};
     uptr<UCall> browse_call, neighbor_call; 
+    int protocol;                  // negociated version of the protocol
+    UMSrequest* batch;             // batched requests (protocol >= 2)
+    uptr<UTimer> batch_timer;      // sends the batch when the main loop is idle
+    std::map<int, std::pair<long,long> > motions; // last motion of each flow
+    USharedRing* ring;             // requests of local clients (null if TCP or once full)
+    
+    void open(const UStr& host, int port);
+    static bool isLocalHost(const UStr& host);
+    bool send(UMSrequest&);
+    bool sendEvent(unsigned char type, int flow, long x, long y, unsigned long detail);
   };
   
 }
@@ -29,6 +29,14 @@ namespace ubit {
 #define UMS_PORT_NUMBER   9666
 ///< the default port used by the UMS server (available in directory ubit/ums).
   
+#define UMS_LOCAL_SOCKET  "/tmp/.umsd-%d"
+/**< the Unix-domain socket of the UMS server (%d is replaced by its port).
+ * local clients connect to this socket and send the descriptors of a
+ * USharedRing (possibly none) with the first byte (see USocket::sendDescriptors()).
+ * The requests are then written in the ring, the replies are sent on the socket.
+ * A client whose ring is full sends the next requests on the socket.
+ */
+
 #define UMS_EVENT_MASK    (1UL<<14)
 /**< state field of XEvents sent by the UMS sever.
 * if this bit is true in XEvent.state, the No of the mouse pointer
@@ -44,23 +52,65 @@ namespace ubit {
 #define UMS_MESSAGE_PROPERTY  "_UBIT_MESSAGE"
 ///< the property for exchanging messages between applications and the UMS server.
 
+#define UMS_MESSAGE_SOCKET_PROPERTY  "_UBIT_MESSAGE_SOCKET"
+/**< the property that gives the socket of an application for receiving messages.
+ * the value is "hostname path" (see UMS_MESSAGE_LOCAL_SOCKET). Applications and 
+ * UMS servers that run on the same host send the messages to this socket
+ * instead of using UMS_MESSAGE_PROPERTY (see UMessage::send()).
+ */
+
+#define UMS_MESSAGE_LOCAL_DIR  "/tmp/.ubit-msg-%d"
+/**< the directory of the message sockets of a user (%d is replaced by its uid).
+ * this directory is created with mode 0700 and must belong to this user.
+ */
+
+#define UMS_MESSAGE_LOCAL_SOCKET  UMS_MESSAGE_LOCAL_DIR "/%d"
+/**< the Unix-domain socket of an application (%d are replaced by its uid and pid).
+ * the socket has mode 0600. each message is sent as a 4 byte length (in network
+ * order) followed by the name of the message port, a null char and the value 
+ * of the message (which can contain binary data). The connection is closed if
+ * the length exceeds UMessagePortMap::MAX_MESSAGE_SIZE.
+ */
+
+#define UMS_PROTOCOL_VERSION  2
+/**< version of the protocol implemented by this UMS server or client.
+ * - version 1: one request per block
+ * - version 2: BATCH and COMPACT_EVENT requests
+ * the version is negociated by the client (see UMSrequest::SET_PROTOCOL).
+ * Version 1 is assumed if the server does not reply.
+ */
+
 /* ==================================================== ===== ======= */
 /** UMS Request (from a Client to the UMS server).
  * <pre>
  * ----------------------------------------------------------------------
- * reqtype(uchar) | arguments(c = uchar / c* = char* / l = long)
+ * reqtype(uchar) | arguments(c = uchar / c* = char* / l = long / v = varint)
  * ----------------------------------------------------------------------
  * KEY_MOUSE_CTRL (c)evtype (c)evflow (l)x (l)y (l)btn|key|mvm
  * SEND_EVENT     (c)evtype (c)evflow (l)x (l)y (l)btn|key|mvm (c*)target
  * SEND_MESSAGE   (c*)target (c*)message
  * SERVER_REQUEST (c*)request
+ * SET_PROTOCOL   (c)version       -> replies "_umsProtocol version"
+ * BATCH          {(v)size request}*
+ * COMPACT_EVENT  (c)evtype (c)evflow (c)flags (v)x (v)y (v)btn|key|mvm
  * ...
  * ----------------------------------------------------------------------
  * target identifies a window as follows:
  * - decimal (1234) or hexa (0x1234a) number of the window ID
  * - ascii-name-without-blanks of the window
  * - quoted 'asci name' of the window (if the name contains spaces)
-  * </pre>
+ *
+ * protocol version 2 (see UMS_PROTOCOL_VERSION):
+ * - SET_PROTOCOL: the server replies with the version it will use
+ *   (the lowest of both versions). Servers that only know version 1
+ *   ignore this request and don't reply.
+ * - BATCH: a sequence of requests, each of them preceded by its size
+ *   (see UOutbuf::writeBlock()). Requests are processed in this order.
+ * - COMPACT_EVENT: same as KEY_MOUSE_CTRL with zigzag varints
+ *   (see UOutbuf::writeSVarint()). If flags contains DELTA_COORDS,
+ *   x and y are relative to the coords of the previous COMPACT_EVENT
+ *   of the same flow sent on this connection.
+ * </pre>
  */
 struct UMSrequest : public UOutbuf {
   enum RequestType { 
@@ -80,8 +130,14 @@ struct UMSrequest : public UOutbuf {
     OPEN_DEVICE       = 40,
     CLOSE_DEVICE      = 41,
     TACTOS            = 50,
+    SET_PROTOCOL      = 60,
+    BATCH             = 61,
+    COMPACT_EVENT     = 62,
     REQUEST_COUNT/*NO COMMA*/
   };
+  enum CompactEventFlags {
+    DELTA_COORDS      = 1    ///< x and y are relative to the previous event.
+  };
   UMSrequest(unsigned char reqtype) {buffer[outpos++] = reqtype;}
 };
 
@@ -16,15 +16,24 @@
 
 #include <ubit/ubit_features.h>
 #include <iostream>
+#include <cmath>
+#include <cstdlib>
 #include <ubit/uon.hpp>
 #include <ubit/ucall.hpp>
 #include <ubit/uboxgeom.hpp>
+#include <ubit/ubackground.hpp>
+#include <ubit/ucolor.hpp>
 #include <ubit/ubox.hpp>
 #include <ubit/uscrollbar.hpp>
 #include <ubit/uscrollpane.hpp>
 #include <ubit/ustyle.hpp>
 #include <ubit/uappli.hpp>
 #include <ubit/uconf.hpp>
+#include <ubit/ugraph.hpp>
+#include <ubit/uviewImpl.hpp>
+#include <ubit/uupdatecontext.hpp>
+#include <ubit/uwinImpl.hpp>
+#include <ubit/ueventlog.hpp>
 using namespace std;
 #define NAMESPACE_UBIT namespace ubit {
 NAMESPACE_UBIT
@@ -239,6 +248,12 @@ void UScrollpane::setScrollImpl(float _xscroll, float _yscroll) {
   if (xscroll == _xscroll && yscroll == _yscroll) return;
   
   float xoffset_max = 0, yoffset_max = 0;  // pour toutes les Views de 'pane' 
+
+  // without OpenGL, the pixels that remain visible are copied (see blitScroll())
+  // so that the offsets must be integers
+  bool can_blit = !UAppli::isUsingGL() && !UAppli::conf.transp_scrollbars;
+  std::vector<UPaneView*> blit_views;
+  std::vector<UPoint> blit_deltas;
   
   for (UView* view = views; view != null; view = view->getNext()) {
     UPaneView* pane_view = dynamic_cast<UPaneView*>(view);  // UPaneView par constr
@@ -251,13 +266,14 @@ void UScrollpane::setScrollImpl(float _xscroll, float _yscroll) {
         UPaintEvent e(UOn::paint, winview);
         e.setSourceAndProps(viewport_view);
         float xoffset = 0, yoffset = 0;
-        //float deltax = 0, deltay = 0;
+        UPoint old_offset(pane_view->getXScroll(), pane_view->getYScroll());
         
         // horizontal scroll
         float viewport_w = pane_view->getWidth()
         - pane_view->padding.left.val - pane_view->padding.right.val;
         
         xoffset = _xscroll * (viewport_view->getWidth() - viewport_w) / 100.0; // + 0.5;
+        if (can_blit) xoffset = floor(xoffset + 0.5);
         if (xoffset >= 0) {
           //deltax = xoffset - pane_view->getXScroll();
           pane_view->setXScroll(xoffset);
@@ -268,8 +284,8 @@ void UScrollpane::setScrollImpl(float _xscroll, float _yscroll) {
         - pane_view->padding.top.val - pane_view->padding.bottom.val;
         
         yoffset = _yscroll * (viewport_view->getHeight() - viewport_h) / 100.0; // + 0.5;
+        if (can_blit) yoffset = floor(yoffset + 0.5);
         if (yoffset >= 0) {
-          //deltay = yoffset - pane_view->getYScroll();
           pane_view->setYScroll(yoffset);
         }
         
@@ -278,6 +294,11 @@ void UScrollpane::setScrollImpl(float _xscroll, float _yscroll) {
           yoffset_max = std::max(yoffset_max, yoffset);
           //viewport_view->getBox()->repaint();
         }
+        
+        // the content moves in the opposite direction
+        blit_views.push_back(pane_view);
+        blit_deltas.push_back(UPoint(old_offset.x - pane_view->getXScroll(),
+                                     old_offset.y - pane_view->getYScroll()));
       }
     }
   }
@@ -290,7 +311,16 @@ void UScrollpane::setScrollImpl(float _xscroll, float _yscroll) {
   // NB: verif callbacks OK
   if (hscrollbar) *hscrollbar->pvalue = xscroll;
   if (vscrollbar) *vscrollbar->pvalue = yscroll;
-  repaint();
+
+  // the views are repainted entirely if the pixels can't be copied
+  bool must_repaint = !can_blit;
+  for (unsigned int k = 0; k < blit_views.size() && !must_repaint; ++k) {
+    if (!canBlitScroll(blit_views[k])) must_repaint = true;
+  }
+  if (must_repaint) repaint();
+  else for (unsigned int k = 0; k < blit_views.size(); ++k) {
+    blitScroll(blit_views[k], blit_deltas[k].x, blit_deltas[k].y);
+  }
   
   /*
    cette fonction fait n'importe quoi
@@ -300,6 +330,128 @@ void UScrollpane::setScrollImpl(float _xscroll, float _yscroll) {
 */
 }
 
+/* ==================================================== ======== ======= */
+// scroll-by-copy: the pixels that remain visible are shifted in the window and
+// only the strips that have been exposed are painted, so that the cost of
+// scrolling depends on the scroll delta, not on the size of the viewport.
+// The parts that are obscured by other X windows are repainted when the
+// GraphicsExpose events are received.
+
+// the pixels of the viewport only move with the scrolled box if this box is
+// opaque (otherwise the backgrounds of the pane and of its parents are visible).
+// Conditional backgrounds are ignored (they may not be opaque).
+static void findBackground(UChildIter c, UChildIter end,
+                           const UBackground*& bg, const UAlpha*& alpha) {
+  for ( ; c != end; ++c) {
+    if (c.getCond()) continue;
+    if (const UBackground* b = dynamic_cast<const UBackground*>(*c)) bg = b;
+    else if (const UAlpha* a = dynamic_cast<const UAlpha*>(*c)) alpha = a;
+  }
+}
+
+static bool isOpaque(const UBox& box) {
+  const UStyle& style = box.getStyle(null);
+  const UBackground* bg = style.local.background;
+  const UAlpha* alpha = null;
+  findBackground(box.abegin(), box.aend(), bg, alpha);
+  findBackground(box.cbegin(), box.cend(), bg, alpha);
+  if ((alpha && *alpha < 1.) || style.local.alpha < 1. || !bg) return false;
+
+  if (bg->getIma()) return true;
+  const UColor* c = bg->getColor();
+  return c && !c->equals(UColor::none) && c->getRgba().getAlphaI() == 255;
+}
+
+bool UScrollpane::canBlitScroll(UPaneView* pane_view) {
+  UView* winview = pane_view->getWinView();
+  UHardwinImpl* hw = pane_view->getHardwin();
+  if (!winview || !hw || !hw->isRealized() || !isShown()) return false;
+
+  // the layers that are superimposed on the scrolled box are not scrolled
+  int box_count = 0;
+  for (UChildIter c = cbegin(); c != cend(); ++c) {
+    if ((*c)->toBox() && ++box_count > 1) return false;
+  }
+  UBox* scrolled = getScrolledBox();
+  UView* scrolled_view = getScrolledView(pane_view);
+  if (!scrolled || !scrolled_view || !isOpaque(*scrolled)) return false;
+
+  // the scrolled box must cover the viewport
+  if (scrolled_view->getWidth() < pane_view->getWidth()
+      - pane_view->padding.left.val - pane_view->padding.right.val
+      || scrolled_view->getHeight() < pane_view->getHeight()
+      - pane_view->padding.top.val - pane_view->padding.bottom.val)
+    return false;
+
+  // the soft windows (menus...) are drawn in the same window: their pixels
+  // would be copied with those of the pane
+  UChildren* softwins = hw->getSoftwinList();
+  if (softwins) {
+    for (UChildIter c = softwins->begin(); c != softwins->end(); ++c) {
+      UElem* w = (*c)->toElem();
+      if (w && w->isShowable()) return false;
+    }
+  }
+  return true;
+}
+
+// paints a region of the window (in window coordinates). Contrary to
+// UView::updatePaint(), drawing is clipped to this region.
+static void paintRegion(UView* winview, const URect& region) {
+  if (region.isEmpty()) return;
+  UEventProfile::Scope profile(UEventProfile::PAINT);
+  UGraph g(winview);
+  UViewUpdate vup(UViewUpdate::PAINT_ALL);
+  UWinUpdateContext winctx(winview, &g);
+  winview->doUpdate(winctx, *winview, region, vup);
+}
+
+void UScrollpane::blitScroll(UPaneView* pane_view, float delta_x, float delta_y) {
+  UView* winview = pane_view->getWinView();
+  const URect pane = *pane_view;
+  URect viewport(pane.x + pane_view->padding.left.val,
+                 pane.y + pane_view->padding.top.val,
+                 pane.width - pane_view->padding.left.val - pane_view->padding.right.val,
+                 pane.height - pane_view->padding.top.val - pane_view->padding.bottom.val);
+
+  // visible part of the viewport (the pane may be clipped by its parents)
+  URect clip = viewport;
+  UViewContext vc;
+  pane_view->findContext(vc, UView::FIND_CLIP);
+  if (vc.is_clip_set && !clip.doIntersection(vc.clip)) clip.setRect(0, 0, 0, 0);
+
+  int x = int(ceil(clip.x)), y = int(ceil(clip.y));
+  int w = int(floor(clip.x + clip.width)) - x, h = int(floor(clip.y + clip.height)) - y;
+  int dx = int(floor(delta_x + 0.5)), dy = int(floor(delta_y + 0.5));
+
+  if (w > 0 && h > 0) {
+    // the coordinates of the children that are not painted must be updated
+    pane_view->updatePaintData(&viewport);
+
+    if (abs(dx) < w && abs(dy) < h) {
+      if (dx != 0 || dy != 0) {
+        // the pixels that are waiting for an exposure are moved too
+        pane_view->getHardwin()->shiftExposes(URect(x, y, w, h), dx, dy);
+        UGraph g(winview);
+        g.copyArea(x + std::max(0, -dx), y + std::max(0, -dy), w - abs(dx), h - abs(dy),
+                   dx, dy, true);
+      }
+      if (dy > 0) paintRegion(winview, URect(x, y, w, dy));
+      else if (dy < 0) paintRegion(winview, URect(x, y + h + dy, w, -dy));
+      if (dx > 0) paintRegion(winview, URect(x, y, dx, h));
+      else if (dx < 0) paintRegion(winview, URect(x + w + dx, y, -dx, h));
+    }
+    else paintRegion(winview, URect(x, y, w, h));
+  }
+
+  // the borders of the pane, which contain the scrollbars
+  float vx2 = viewport.x + viewport.width, vy2 = viewport.y + viewport.height;
+  paintRegion(winview, URect(pane.x, pane.y, pane.width, viewport.y - pane.y));
+  paintRegion(winview, URect(pane.x, vy2, pane.width, pane.y + pane.height - vy2));
+  paintRegion(winview, URect(pane.x, viewport.y, viewport.x - pane.x, viewport.height));
+  paintRegion(winview, URect(vx2, viewport.y, pane.x + pane.width - vx2, viewport.height));
+}
+
 /* ==================================================== ======== ======= */
 
 void UScrollpane::resizeCB(UResizeEvent& e) {
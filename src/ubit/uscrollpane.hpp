@@ -109,6 +109,8 @@ namespace ubit {
     virtual void unsetVScrollbar();
     virtual void resizeCB(UResizeEvent&);
     virtual void wheelCB(UWheelEvent&);
+    virtual bool canBlitScroll(UPaneView*);
+    virtual void blitScroll(UPaneView*, float delta_x, float delta_y);
 #endif
   };
   
@@ -0,0 +1,215 @@
+/************************************************************************
+ *
+ *  usharedring.cpp: ring buffer in shared memory
+ *  Ubit GUI Toolkit - Version 6
+ *  (C) 2009 | Eric Lecolinet | TELECOM ParisTech | http://www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#include <ubit/ubit_features.h>
+#include <cstring>
+#include <atomic>
+#include <stdint.h>
+#include <unistd.h>
+#include <cerrno>
+#ifdef __linux__
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/eventfd.h>
+#endif
+#include <ubit/usharedring.hpp>
+#include <ubit/usocket.hpp>
+using namespace std;
+#define NAMESPACE_UBIT namespace ubit {
+NAMESPACE_UBIT
+
+// the header is shared by both processes. 'head' and 'tail' are on separate
+// cache lines because they are written by different processes.
+// Blocks are stored as a 2 byte size followed by the data (and may wrap).
+
+struct USharedRing::Header {
+  std::atomic<uint32_t> head;       // written by the producer
+  uint32_t capacity;
+  char pad1[56];
+  std::atomic<uint32_t> tail;       // written by the consumer
+  std::atomic<uint32_t> waiting;    // true if the consumer waits for the doorbell
+  char pad2[56];
+};
+
+
+USharedRing::USharedRing() :
+header(null), data(null), capacity(0), mapsize(0), memfd(-1), eventfd(-1) {}
+
+USharedRing::~USharedRing() {
+  close();
+}
+
+void USharedRing::close() {
+#ifdef __linux__
+  if (header) ::munmap(header, mapsize);
+#endif
+  if (memfd >= 0) ::close(memfd);
+  if (eventfd >= 0) ::close(eventfd);
+  header = null;
+  data = null;
+  capacity = 0;
+  mapsize = 0;
+  memfd = eventfd = -1;
+}
+
+bool USharedRing::map(unsigned int size) {
+#ifdef __linux__
+  void* p = ::mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, memfd, 0);
+  if (p == MAP_FAILED) return false;
+  header = (Header*)p;
+  data = (char*)p + sizeof(Header);
+  mapsize = size;
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool USharedRing::create(unsigned int _capacity) {
+  close();
+#ifdef __linux__
+  unsigned int cap = 1024;
+  while (cap < _capacity) cap <<= 1;
+
+  // the size is sealed: the consumer would get SIGBUS if it was reduced
+  memfd = ::memfd_create("ubit-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  eventfd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (memfd < 0 || eventfd < 0
+      || ::ftruncate(memfd, sizeof(Header) + cap) < 0
+      || ::fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0
+      || !map(sizeof(Header) + cap)) {
+    close();
+    return false;
+  }
+  header->capacity = capacity = cap;
+  header->head.store(0);
+  header->tail.store(0);
+  header->waiting.store(1);     // the consumer is not reading yet
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool USharedRing::attach(int _memfd, int _eventfd) {
+  close();
+  memfd = _memfd;
+  eventfd = _eventfd;
+#ifdef __linux__
+  // the memory must be sealed so that the producer can't shrink it
+  int seals = ::fcntl(memfd, F_GET_SEALS);
+  off_t size = ::lseek(memfd, 0, SEEK_END);
+  if (seals < 0 || !(seals & F_SEAL_SHRINK)
+      || size <= (off_t)sizeof(Header) || size > (off_t)sizeof(Header) + (64<<20)
+      || !map(size)) {
+    close();
+    return false;
+  }
+  // the capacity is checked as the memory is written by another process
+  uint32_t cap = header->capacity;
+  if (cap == 0 || (cap & (cap-1)) != 0 || sizeof(Header) + cap > mapsize) {
+    close();
+    return false;
+  }
+  // the shared value is not used anymore: it may be changed afterwards
+  capacity = cap;
+  return true;
+#else
+  close();
+  return false;
+#endif
+}
+
+/* ==================================================== ====== ======= */
+
+bool USharedRing::write(const UIObuf& b) {
+  return write(b.data(), b.size());
+}
+
+bool USharedRing::write(const char* buf, unsigned short size) {
+  if (!header) return false;
+  uint32_t cap = capacity;
+  uint32_t head = header->head.load(std::memory_order_relaxed);
+  uint32_t tail = header->tail.load(std::memory_order_acquire);
+  if (cap - (head - tail) < 2u + size) return false;    // full
+
+  unsigned char sz[2] = {(unsigned char)(size >> 8), (unsigned char)size};
+  for (int k = 0; k < 2; k++) data[(head + k) & (cap-1)] = sz[k];
+
+  uint32_t pos = (head + 2) & (cap-1);
+  uint32_t n1 = (size < cap - pos) ? size : cap - pos;
+  if (size > 0) {
+    memcpy(data + pos, buf, n1);
+    if (size > n1) memcpy(data, buf + n1, size - n1);
+  }
+  header->head.store(head + 2 + size, std::memory_order_seq_cst);
+
+  // rings the doorbell only if the consumer is waiting
+  if (header->waiting.load(std::memory_order_seq_cst)
+      && header->waiting.exchange(0) != 0) {
+#ifdef __linux__
+    uint64_t one = 1;
+    while (::write(eventfd, &one, sizeof(one)) < 0 && errno == EINTR) ;
+#endif
+  }
+  return true;
+}
+
+bool USharedRing::read(UInbuf& b) {
+  if (!header) return false;
+  uint32_t cap = capacity;
+  uint32_t tail = header->tail.load(std::memory_order_relaxed);
+  uint32_t head = header->head.load(std::memory_order_acquire);
+  uint32_t avail = head - tail;
+  if (avail < 2 || avail > cap) return false;
+
+  unsigned short size = ((unsigned char)data[tail & (cap-1)] << 8)
+    | (unsigned char)data[(tail+1) & (cap-1)];
+  if (avail < 2u + size) return false;    // should not happen
+
+  if (!b.resize(size)) return false;
+  b.inpos = 2;
+  b.outpos = size + 2;
+  char* dest = b.buffer + 2;
+  uint32_t pos = (tail + 2) & (cap-1);
+  uint32_t n1 = (size < cap - pos) ? size : cap - pos;
+  if (size > 0) {
+    memcpy(dest, data + pos, n1);
+    if (size > n1) memcpy(dest + n1, data, size - n1);
+  }
+  header->tail.store(tail + 2 + size, std::memory_order_release);
+  return true;
+}
+
+bool USharedRing::prepareWait() {
+  if (!header) return true;
+  header->waiting.store(1, std::memory_order_seq_cst);
+  uint32_t tail = header->tail.load(std::memory_order_relaxed);
+  if (header->head.load(std::memory_order_seq_cst) != tail) {
+    header->waiting.store(0);
+    return false;
+  }
+  return true;
+}
+
+void USharedRing::clearNotification() {
+#ifdef __linux__
+  uint64_t count;
+  if (eventfd >= 0) while (::read(eventfd, &count, sizeof(count)) < 0 && errno == EINTR) ;
+#endif
+}
+
+}
@@ -0,0 +1,105 @@
+/************************************************************************
+ *
+ *  usharedring.hpp: ring buffer in shared memory
+ *  Ubit GUI Toolkit - Version 6
+ *  (C) 2009 | Eric Lecolinet | TELECOM ParisTech | http://www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#ifndef _usharedring_hpp_
+#define	_usharedring_hpp_ 1
+#include <ubit/udefs.hpp>
+namespace ubit {
+
+  class UIObuf;
+  class UInbuf;
+
+  /** single-producer/single-consumer ring buffer in shared memory.
+   * makes it possible to send blocks of data (as USocket::sendBlock() does)
+   * to a process running on the same host without system calls in most cases.
+   * The consumer is woken up by a doorbell (an eventfd) that is only rung
+   * when it is waiting for data.
+   *
+   * The producer creates the ring by calling create(), then sends its 
+   * descriptors to the consumer (see USocket::sendDescriptors()), 
+   * which calls attach(). The consumer waits for the event descriptor
+   * (eg. by using select() or epoll) then reads the blocks as follows:
+   * <pre>
+   *    ring.clearNotification();
+   *    UInbuf ib;
+   *    do {
+   *      while (ring.read(ib)) {...}
+   *    } while (!ring.prepareWait());
+   * </pre>
+   *
+   * Note: only available on Linux (create() and attach() return false otherwise).
+   */
+  class USharedRing {
+  public:
+    enum {DEFAULT_CAPACITY = 64*1024};
+    
+    USharedRing();
+    virtual ~USharedRing();
+    
+    bool create(unsigned int capacity = DEFAULT_CAPACITY);
+    /**< creates the shared memory and the doorbell (capacity is rounded to a power of 2).
+     * the size of the memory is sealed so that it can't be changed once mapped.
+     */
+
+    bool attach(int memory_fd, int event_fd);
+    /**< maps a ring created by another process.
+     * the descriptors are then owned by this object (they are closed by close()).
+     * fails if the size of the memory is not sealed (see create()).
+     */
+
+    void close();
+    ///< unmaps the shared memory and closes the descriptors.
+
+    bool isOpen() const {return header != null;}
+    int getMemoryDescriptor() const {return memfd;}
+    int getEventDescriptor() const {return eventfd;}
+
+    bool write(const char* data, unsigned short size);
+    bool write(const UIObuf&);
+    /**< appends a block to the ring (producer side).
+     * returns false if the ring is full or not open. The consumer is notified
+     * if it is waiting.
+     */
+
+    bool read(UInbuf&);
+    /**< retrieves the next block (consumer side).
+     * returns false if there is no block (or if the ring was corrupted).
+     */
+
+    bool prepareWait();
+    /**< tells the producer that the consumer is going to wait (consumer side).
+     * returns false if data has been written in the meantime (read() must
+     * then be called again).
+     */
+
+    void clearNotification();
+    ///< resets the doorbell after a wakeup (consumer side).
+
+  private:
+    struct Header;
+    USharedRing(const USharedRing&);
+    USharedRing& operator=(const USharedRing&);
+    bool map(unsigned int size);
+
+    Header* header;
+    char* data;           // the ring (capacity bytes)
+    unsigned int capacity;  // checked copy of header->capacity
+    unsigned int mapsize;
+    int memfd, eventfd;
+  };
+
+}
+#endif
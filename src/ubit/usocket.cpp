@@ -22,9 +22,15 @@
 #include <iostream>
 #include <cstdio>
 #include <cstdlib>
+#include <cerrno>
+#include <cstring>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <poll.h>
 #include <sys/utsname.h>
 #include <netdb.h>
 #include <netinet/tcp.h>
@@ -32,6 +38,7 @@
 #include <arpa/inet.h>
 #include <ubit/ucall.hpp>
 #include <ubit/uappli.hpp>
+#include <ubit/uappliImpl.hpp>
 #include <ubit/usource.hpp>
 #include <ubit/usocket.hpp>
 using namespace std;
@@ -41,6 +48,17 @@ namespace ubit {
 // ici, par contre ca l'est dans UMS via un signal(SIGPIPE)
 
 const int DEFAULT_BACKLOG = 20;
+const unsigned int DEFAULT_MAX_OUTPUT = 1024*1024;
+const unsigned int READ_QUANTUM = 4096;
+
+// watches the writability of a socket in non-blocking mode
+class USocketOutput : public USource {
+public:
+  USocketOutput(USocket* s) : sock(s) {watchInput(false);}
+  virtual void fireOutput() {if (!isDestructed()) sock->flush();}
+private:
+  USocket* sock;
+};
 
 /* ==================================================== ====== ======= */
 
@@ -48,14 +66,16 @@ UServerSocket::UServerSocket() :
 listen_port(-1),
 listen_sock(-1),
 sin(new sockaddr_in()),
-input(null) {
+input(null),
+local_path(null) {
 }
 
 UServerSocket::UServerSocket(int _port) :
   listen_port(_port),
   listen_sock(-1),
   sin(new sockaddr_in()),
-  input(null)
+  input(null),
+  local_path(null)
 {
   bind(listen_port, 0, true);
 }
@@ -106,6 +126,31 @@ bool UServerSocket::bind(int port, int backlog, bool reuse_address) {
   return true;
 }
 
+bool UServerSocket::bindLocal(const char* path, int backlog) {
+  struct sockaddr_un sun;
+  if (!path || strlen(path) >= sizeof(sun.sun_path)) return false;
+  
+  listen_port = 0;
+  listen_sock = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_sock < 0) return false;
+
+  memset(&sun, 0, sizeof(sun));
+  sun.sun_family = AF_UNIX;
+  strcpy(sun.sun_path, path);
+  ::unlink(path);         // the socket of a previous server
+
+  if (::bind(listen_sock, (struct sockaddr*)&sun, sizeof(sun)) < 0) {
+    ::close(listen_sock);
+    listen_sock = -1;
+    return false;
+  }
+  local_path = strdup(path);
+  
+  if (backlog <= 0) backlog = DEFAULT_BACKLOG;
+  ::listen(listen_sock, backlog);
+  return true;
+}
+
 void UServerSocket::onInput(UCall& c) {
   if (!input) input = new USource();
   input->onInput(c);
@@ -129,6 +174,11 @@ void UServerSocket::close() {
     ::close(listen_sock);
   }
   listen_sock = -1;  // indiquer com_sock inutilisable par write/read*()
+  if (local_path) {
+    ::unlink(local_path);
+    free(local_path);
+    local_path = null;
+  }
 
   delete input;
   input = null;
@@ -156,20 +206,24 @@ USocket* UServerSocket::accept() {
 
 // ============================================================== ====== =======
 
-USocket::USocket()
-: remport(0), sock(-1), sin(null), input(null) {}
+USocket::USocket() :
+remport(0), sock(-1), sin(null), input(null), output(null), 
+nonblocking(false), max_output(DEFAULT_MAX_OUTPUT), outq_pos(0), inq_pos(0) {}
 
 USocket::USocket(const char* _host, int _port) :
-remport(0), sock(-1), sin(null), input(null) {
+remport(0), sock(-1), sin(null), input(null), output(null), 
+nonblocking(false), max_output(DEFAULT_MAX_OUTPUT), outq_pos(0), inq_pos(0) {
   connect(_host, _port);
 }
 
 USocket::USocket(const UStr& _host, int _port) :
-remport(0), sock(-1), sin(null), input(null) {
+remport(0), sock(-1), sin(null), input(null), output(null), 
+nonblocking(false), max_output(DEFAULT_MAX_OUTPUT), outq_pos(0), inq_pos(0) {
   connect(_host.c_str(), _port);
 }
 
 USocket::~USocket() {
+  if (nonblocking) flush();  // sends what can be sent without blocking
   close();  // en fait close fait delete input !
   delete input;
 }
@@ -188,6 +242,18 @@ void USocket::close() {
   sock = -1;  // indiquer com_sock inutilisable par write/read*()
   delete sin; sin = null;
   delete input; input = null;  //9aug05: = null etait oublie !
+  delete output; output = null;
+  outq.clear(); outq_pos = 0;
+  inq.clear(); inq_pos = 0;
+}
+
+void USocket::setNonBlocking(bool state) {
+  nonblocking = state;
+  if (sock < 0) return;    // will be set by connect()
+  int flags = ::fcntl(sock, F_GETFL, 0);
+  if (flags < 0) return;
+  ::fcntl(sock, F_SETFL, state ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+  if (!state) flush();     // sends pending data (now in blocking mode)
 }
   
 int USocket::connect(const char* host, int port) {
@@ -221,45 +287,256 @@ int USocket::connect(const char* host, int port) {
     return (sock = -1);
   }
 
+  if (nonblocking) setNonBlocking(true);
   if (input) input->open(sock);  
   return sock;
 }
 
-bool USocket::sendBytes(const char* data, unsigned int size) {
-  if (sock < 0) return false;
-  
-  // !!! ici il faut une boucle car il se peut qu'il faille plusieurs write !!! A REVOIR
-  // de plus si rec.pos est trop grand il faudrait decomposer
+/* ==================================================== ====== ======= */
+
+int USocket::connectLocal(const char* path) {
+  close();
+  remport = 0;
+  struct sockaddr_un sun;
+  if (!path || strlen(path) >= sizeof(sun.sun_path)) return (sock = -2);
+
+  memset(&sun, 0, sizeof(sun));
+  sun.sun_family = AF_UNIX;
+  strcpy(sun.sun_path, path);
+
+  sock = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0) return (sock = -1);
 
-  if (::write(sock, data, size) < 0) {
-    sock = -1;   // error  dangereux: 0 serait preferable ?
+  if (::connect(sock, (struct sockaddr*)&sun, sizeof(sun)) < 0) {
+    ::close(sock);
+    return (sock = -1);
+  }
+
+  if (nonblocking) setNonBlocking(true);
+  if (input) input->open(sock);  
+  return sock;
+}
+
+// the descriptors are sent as ancillary data (SCM_RIGHTS) with one byte
+
+bool USocket::sendDescriptors(const int* fds, int count) {
+  if (sock < 0 || count < 0) return false;
+  char byte = 0;
+  struct iovec iov;
+  iov.iov_base = &byte;
+  iov.iov_len = 1;
+
+  std::vector<char> control(CMSG_SPACE(sizeof(int) * (count > 0 ? count : 1)));
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  if (count > 0) {
+    msg.msg_control = &control[0];
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+  }
+  
+  while (true) {
+    if (::sendmsg(sock, &msg, 0) == 1) return true;
+    if (errno == EINTR) continue;
+    if (nonblocking && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      struct pollfd p = {sock, POLLOUT, 0};
+      ::poll(&p, 1, -1);
+      continue;
+    }
     return false;
   }
+}
+
+int USocket::receiveDescriptors(int* fds, int max_count, int timeout) {
+  if (sock < 0 || max_count <= 0) return -1;
+  
+  struct pollfd p = {sock, POLLIN, 0};
+  int stat;
+  while ((stat = ::poll(&p, 1, timeout)) < 0 && errno == EINTR) ;
+  if (stat <= 0) return -1;        // error or timeout
+  
+  char byte;
+  struct iovec iov;
+  iov.iov_base = &byte;
+  iov.iov_len = 1;
+  std::vector<char> control(CMSG_SPACE(sizeof(int) * max_count));
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = &control[0];
+  msg.msg_controllen = control.size();
+
+  ssize_t n;
+  while ((n = ::recvmsg(sock, &msg, 0)) < 0 && errno == EINTR) ;
+  if (n != 1) return -1;
+
+  int count = 0;
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+    int nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    int* data = (int*)CMSG_DATA(cmsg);
+    for (int k = 0; k < nfds; k++) {
+      if (count < max_count) fds[count++] = data[k];
+      else ::close(data[k]);
+    }
+  }
+  return count;
+}
+
+/* ==================================================== ====== ======= */
+// sends data1 then data2 with a single system call if possible (the size of a
+// block and its content are thus not sent in separate TCP segments).
+// in non-blocking mode, what can't be sent now is appended to the output queue.
+
+bool USocket::write2(const char* data1, unsigned int size1,
+                     const char* data2, unsigned int size2) {
+  if (sock < 0) return false;
+  unsigned int total = size1 + size2, sent = 0;
+  
+  if (nonblocking) {
+    if (max_output > 0 && getPendingOutput() + total > max_output) return false;
+    if (getPendingOutput() > 0) {     // keep the order: append to the queue
+      outq.insert(outq.end(), data1, data1 + size1);
+      outq.insert(outq.end(), data2, data2 + size2);
+      return true;
+    }
+  }
+  
+  while (sent < total) {
+    struct iovec iov[2];
+    int iovcount = 0;
+    if (sent < size1) {
+      iov[iovcount].iov_base = (void*)(data1 + sent);
+      iov[iovcount].iov_len = size1 - sent;
+      iovcount++;
+    }
+    unsigned int pos2 = (sent > size1) ? sent - size1 : 0;
+    if (size2 > pos2) {
+      iov[iovcount].iov_base = (void*)(data2 + pos2);
+      iov[iovcount].iov_len = size2 - pos2;
+      iovcount++;
+    }
+    
+    ssize_t n = ::writev(sock, iov, iovcount);
+    if (n >= 0) sent += n;
+    else if (errno == EINTR) continue;
+    else if (nonblocking && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    else {
+      close();    // error
+      return false;
+    }
+  }
+  
+  if (sent < total) {   // non-blocking mode: queue the remaining data
+    if (sent < size1) outq.insert(outq.end(), data1 + sent, data1 + size1);
+    unsigned int pos2 = (sent > size1) ? sent - size1 : 0;
+    outq.insert(outq.end(), data2 + pos2, data2 + size2);
+    // the UAppli main loop flushes the queue when the socket becomes writable.
+    // without UAppli (e.g. in the UMS server) the loop of the program must call
+    // flush() when the socket becomes writable.
+    if (!output && UAppli::impl.sources) {
+      output = new USocketOutput(this);
+      output->open(sock);
+    }
+    if (output) output->watchOutput(true);
+  }
   return true;
 }
 
-bool USocket::sendBlock(const char* data, unsigned short size) {
+bool USocket::flush() {
   if (sock < 0) return false;
+  
+  while (outq_pos < outq.size()) {
+    ssize_t n = ::write(sock, &outq[outq_pos], outq.size() - outq_pos);
+    if (n >= 0) outq_pos += n;
+    else if (errno == EINTR) continue;
+    else if (nonblocking && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+    else {
+      close();    // error
+      return false;
+    }
+  }
+  
+  // everything was sent: the queue is reused
+  outq.clear();
+  outq_pos = 0;
+  if (output) output->watchOutput(false);
+  return true;
+}
+
+bool USocket::sendBytes(const char* data, unsigned int size) {
+  return write2(data, size, null, 0);
+}
 
+bool USocket::sendBlock(const char* data, unsigned short size) {
   uint16_t net_size = htons(size); // sends the size of the packet first
-  if (::write(sock, &net_size, 2) != 2) {
-    sock = -1;  // error
-    return false;
-  }
-  return sendBytes(data, size);
+  return write2((const char*)&net_size, 2, data, size);
 }
 
 bool USocket::sendBlock(UOutbuf& ob) {
   if (sock < 0) return false;
 
-  uint16_t net_size = htons(ob.outpos);
-  memcpy(ob.buffer, &net_size, 2);  // stores the size of the packet first
+  // stores the size of the packet first (outpos includes these 2 bytes)
+  uint16_t net_size = htons(ob.size());
+  memcpy(ob.buffer, &net_size, 2);
+  
+  return sendBytes(ob.buffer, ob.outpos);
+}
+
+/* ==================================================== ====== ======= */
+// non-blocking mode: reads the available data and appends it to the input 
+// queue. returns the number of bytes that were read, 0 if none, -1 if the 
+// connection was closed.
+
+int USocket::readInput() {
+  if (sock < 0) return -1;
   
-  return sendBytes(ob.buffer, ob.outpos+2);  // +2 for the size
+  // the bytes that have been consumed are removed (the memory is reused)
+  if (inq_pos > 0 && (inq_pos == inq.size() || inq_pos > READ_QUANTUM)) {
+    inq.erase(inq.begin(), inq.begin() + inq_pos);
+    inq_pos = 0;
+  }
+
+  int received = 0;
+  while (true) {
+    unsigned int oldsize = inq.size();
+    inq.resize(oldsize + READ_QUANTUM);
+    ssize_t n = ::read(sock, &inq[oldsize], READ_QUANTUM);
+    inq.resize(oldsize + (n > 0 ? n : 0));
+    
+    if (n > 0) {
+      received += n;
+      if (n < (ssize_t)READ_QUANTUM) return received;  // nothing more for now
+    }
+    else if (n < 0 && errno == EINTR) continue;
+    else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return received;
+    else {       // error or the remote side has closed the connection
+      if (received > 0) return received;  // closed at the next call
+      close();
+      return -1;
+    }
+  }
 }
 
 bool USocket::receiveBytes(char* data, unsigned int size) {
   if (sock < 0) return false;
+  
+  if (nonblocking) {
+    if (inq.size() - inq_pos < size) readInput();
+    if (sock < 0 || inq.size() - inq_pos < size) return false;
+    memcpy(data, &inq[inq_pos], size);
+    inq_pos += size;
+    return true;
+  }
+  
   unsigned int received = 0;
 
   // attention, plusieurs read() peuvent etre necessaires
@@ -300,6 +577,26 @@ bool USocket::receiveBlock(char*& data, unsigned short& size) {
 
 bool USocket::receiveBlock(UInbuf& buf) {
   if (sock < 0) return false;
+  
+  if (nonblocking) {
+    // the header and the content of the block may arrive in several parts:
+    // they are kept in the input queue until the block is complete
+    uint16_t net_size = 0;
+    if (inq.size() - inq_pos < 2) readInput();
+    if (sock < 0 || inq.size() - inq_pos < 2) return false;
+    memcpy(&net_size, &inq[inq_pos], 2);
+    unsigned short size = ntohs(net_size);
+    
+    if (inq.size() - inq_pos < 2u + size) readInput();
+    if (sock < 0 || inq.size() - inq_pos < 2u + size) return false;
+    
+    buf.resize(size);
+    buf.inpos = 2;
+    buf.outpos = size +2;
+    memcpy(buf.buffer, &inq[inq_pos], size + 2);
+    inq_pos += size + 2;
+    return true;
+  }
 
   uint16_t net_size = 0;   // get block size
   if (!receiveBytes((char*)&net_size, 2)) return false;
@@ -307,6 +604,7 @@ bool USocket::receiveBlock(UInbuf& buf) {
   unsigned short size = ntohs(net_size);
   // !!NB: un peu absurde: ne pas sauver les 2 bytes dans le buffer !
   buf.resize(size);
+  buf.inpos = 2;
   buf.outpos = size +2;  //13nov04: +2 rajoute
   memcpy(buf.buffer, &net_size, 2);  // coherence
   return receiveBytes(buf.buffer+2, size);
@@ -356,6 +654,8 @@ unsigned int UIObuf::consumed() const {
 }
 
 bool UIObuf::resize(unsigned short _size) {
+  // the buffer is reused if it is large enough
+  if (buffer && (unsigned int)_size+2 <= bufsize) return true;
   bufsize = _size+2;
   
   if (buffer == null) {  // should not happen
@@ -375,8 +675,7 @@ bool UIObuf::resize(unsigned short _size) {
 
 bool UIObuf::augment(unsigned short sz) {
   int nblocks = sz / AUGMENT_QUANTUM + 1;
-  bufsize += nblocks * AUGMENT_QUANTUM;
-  resize(bufsize-2);
+  resize(bufsize-2 + nblocks * AUGMENT_QUANTUM);
   return (buffer && bufsize-2 <= sizeof(short));
 }
 
@@ -504,5 +803,61 @@ void UInbuf::readEvent(unsigned char& event_type, unsigned char& event_flow,
   inpos += 4;
 };
 
+/* ==================================================== ====== ======= */
+
+void UOutbuf::writeVarint(unsigned long x) {
+  if (outpos+9 >= bufsize) augment(10);
+  while (x >= 0x80) {
+    buffer[outpos++] = char((x & 0x7f) | 0x80);
+    x >>= 7;
+  }
+  buffer[outpos++] = char(x);
+}
+
+void UOutbuf::writeSVarint(long x) {
+  // zigzag: small negative values are also encoded on few bytes
+  writeVarint(x < 0 ? ((~(unsigned long)x) << 1) | 1 : (unsigned long)x << 1);
 }
 
+void UOutbuf::writeBlock(const UIObuf& b) {
+  unsigned int ll = b.size();
+  writeVarint(ll);
+  if (ll == 0) return;
+  if (outpos+ll >= bufsize) augment(ll);
+  memcpy(&buffer[outpos], b.data(), ll);
+  outpos += ll;
+}
+
+bool UInbuf::readVarint(unsigned long& x) {
+  x = 0;
+  for (unsigned int shift = 0; inpos < outpos && shift < 8*sizeof(long); shift += 7) {
+    unsigned char c = (unsigned char)buffer[inpos++];
+    x |= (unsigned long)(c & 0x7f) << shift;
+    if (!(c & 0x80)) return true;
+  }
+  return false;
+}
+
+bool UInbuf::readSVarint(long& x) {
+  unsigned long z;
+  if (!readVarint(z)) {x = 0; return false;}
+  x = (z & 1) ? ~long(z >> 1) : long(z >> 1);
+  return true;
+}
+
+bool UInbuf::readBlock(UInbuf& b) {
+  unsigned long ll;
+  unsigned int pos = inpos;
+  if (inpos >= outpos || !readVarint(ll) || ll > outpos - inpos) {
+    inpos = pos;
+    return false;
+  }
+  if (!b.resize(ll)) return false;
+  memcpy(b.buffer+2, &buffer[inpos], ll);
+  inpos += ll;
+  b.inpos = 2;
+  b.outpos = ll+2;
+  return true;
+}
+
+}
@@ -16,6 +16,7 @@
 
 #ifndef _usocket_hpp_
 #define	_usocket_hpp_ 1
+#include <vector>
 #include <ubit/udefs.hpp>
 #include <ubit/ustr.hpp>
 
@@ -71,6 +72,23 @@ public:
   virtual int connect(const char* remote_host, int remote_port);
   virtual void close();
 
+  int connectLocal(const char* path);
+  /**< connects this socket to a Unix-domain socket (local connection).
+   * 'path' is the path of the socket (see UServerSocket::bindLocal()).
+   * returns the socket descriptor (a negative value if the connection failed).
+   */
+
+  bool sendDescriptors(const int* fds, int count);
+  /**< sends file descriptors to the peer (local connections only).
+   * one byte of data is sent with the descriptors.
+   */
+  
+  int receiveDescriptors(int* fds, int max_count, int timeout);
+  /**< receives the file descriptors sent by sendDescriptors().
+   * waits at most 'timeout' millisec (-1 = forever) and returns the number
+   * of descriptors that were received (-1 if an error occured).
+   */
+
   virtual void onInput(UCall&);
   ///< adds a callback that is fired when data is received on the socket.
   
@@ -105,6 +123,9 @@ public:
    *   to indicate its length. receiveBlock() removes this integer from
    *   the received data and uses this value to determine when the 
    *   transaction is completed.
+   *
+   * - in non-blocking mode, receiveBlock() returns false until a complete
+   *   block has been received (see setNonBlocking()).
    */
 
   bool sendBytes(const char* buffer, unsigned int size);
@@ -120,13 +141,58 @@ public:
     * - both functions write/read 'size' bytes in a single call 
     *   (low-level functions send() and recv() are called until all data
     *    has been sent/received)
+    * - in non-blocking mode, receiveBytes() returns false (and does not
+    *   consume any data) until 'size' bytes have been received.
     */
   
+  void setNonBlocking(bool state = true);
+  /**< sets the non-blocking mode.
+   * in this mode, the send functions never block: the data that can't be
+   * written immediately is queued and sent when the socket becomes writable
+   * by the UAppli main loop. Programs that have no UAppli (such as the UMS
+   * server) must call flush() when the socket becomes writable. The receive functions 
+   * never block either: received data is buffered until a complete block 
+   * (or the requested number of bytes) is available. As several blocks may be
+   * received at once, input callbacks should call receiveBlock() in a loop:
+   * <pre>
+   *    UInbuf ibuf;
+   *    while (s->receiveBlock(ibuf)) {...}
+   * </pre>
+   * Hence, a slow or hung peer does not block the main loop.
+   */
+  
+  bool isNonBlocking() const {return nonblocking;}
+  ///< returns true if the socket is in non-blocking mode.
+
+  unsigned int getPendingOutput() const {return outq.size() - outq_pos;}
+  ///< returns the number of bytes that are waiting to be sent (in non-blocking mode).
+  
+  void setMaxPendingOutput(unsigned int bytes) {max_output = bytes;}
+  /**< changes the maximum number of bytes that can be waiting to be sent.
+   * in non-blocking mode, the blocks that would exceed this limit are not sent
+   * and the send functions return false. 0 means no limit (default is 1MB).
+   */
+
+  bool flush();
+  /**< sends the data that is waiting to be sent (in non-blocking mode).
+   * this function is called automatically when the socket becomes writable
+   * if the UAppli main loop is running. it returns false if an error occured.
+   */
+  
 protected:
   friend class UServerSocket;
   int remport, sock;
   struct sockaddr_in* sin;
   USource* input;
+  USource* output;              // watches writability in non-blocking mode
+  bool nonblocking;
+  unsigned int max_output;
+  std::vector<char> outq, inq;  // data to be sent and received data (non-blocking mode)
+  unsigned int outq_pos, inq_pos;  // position of the first pending byte
+
+  virtual bool write2(const char* data1, unsigned int size1,
+                      const char* data2, unsigned int size2);
+  virtual int readInput();
 };
 
 /* ==================================================== [Elc] ======= */
@@ -179,6 +245,12 @@ public:
     * by UServerSocket subclasses to create appropriate socket objets.
     */
 
+  bool bindLocal(const char* path, int backlog = 0);
+  /**< binds this socket to a Unix-domain socket (for local connections).
+   * the file 'path' is removed if it exists and when the socket is closed.
+   * see: USocket::connectLocal().
+   */
+
   bool bind(int port, int backlog = 0, bool reuse_address = true);
   /* binds this socket.
     * there is no need to call this function if the constructor
@@ -210,6 +282,7 @@ protected:
   int listen_port, listen_sock;
   struct sockaddr_in* sin;
   USource* input;
+  char* local_path;   // path of the Unix-domain socket (null otherwise)
 };
 
 /* ==================================================== [Elc] ======= */
@@ -235,6 +308,7 @@ public:
 
 protected:
   friend class USocket;
+  friend class USharedRing;
   enum {DEFAULT_BUFSIZE = 512, AUGMENT_QUANTUM = 2048};
   char* buffer;
   char  default_buffer[DEFAULT_BUFSIZE];
@@ -256,6 +330,17 @@ public:
   void writeString(const char* s, unsigned int len);
   void writeEvent(unsigned char event_type, unsigned char event_flow,
                   long x, long y, unsigned long detail);
+
+  void writeVarint(unsigned long);
+  /**< writes a variable length integer (7 bits per byte, low-order bits first).
+   * small values only take one byte (values < 128).
+   */
+
+  void writeSVarint(long);
+  ///< writes a signed variable length integer (zigzag encoded, see writeVarint()).
+
+  void writeBlock(const UIObuf&);
+  ///< writes the data of this buffer preceded by its size (see UInbuf::readBlock()).
 };
 
   /* ==================================================== [Elc] ======= */
@@ -270,6 +355,15 @@ public:
   void readString(UStr&);
   void readEvent(unsigned char& event_type, unsigned char& event_flow,
                  long& x, long& y, unsigned long& detail);
+
+  bool readVarint(unsigned long&);
+  bool readSVarint(long&);
+  ///< reads a variable length integer; returns false if the data is truncated.
+
+  bool readBlock(UInbuf&);
+  /**< reads a block written by UOutbuf::writeBlock() into the argument.
+   * returns false if there is no more (complete) block in this buffer.
+   */
 };
 
 }
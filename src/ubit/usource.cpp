@@ -27,7 +27,8 @@ using namespace std;
 #define NAMESPACE_UBIT namespace ubit {
 NAMESPACE_UBIT
 
-USource::USource(int _source) : is_opened(false), source(_source) {
+USource::USource(int _source) : 
+is_opened(false), watch_input(true), watch_output(false), source(_source) {
 # ifdef UBIT_WITH_GDK
   gid = 0;
 # endif 
@@ -44,9 +45,10 @@ USource::~USource() {
 }
 
 #if UBIT_WITH_GDK
-static void inputCB(gpointer input, gint source, GdkInputCondition) {
+static void inputCB(gpointer input, gint source, GdkInputCondition cond) {
   USource* i = (USource*)input;
-  i->fireInput();
+  if (cond & GDK_INPUT_READ) i->fireInput();
+  if ((cond & GDK_INPUT_WRITE) && !i->isDestructed()) i->fireOutput();
 }
 # endif
 
@@ -58,11 +60,28 @@ void USource::open(int _source) {
   // ne pas mettre 2 fois dans la liste!
 # if UBIT_WITH_GDK
   if (i != sources->cend()) g_source_remove(gid);
-  gid = gdk_input_add(source, GDK_INPUT_READ, inputCB, (gpointer)this);
+  int cond = (watch_input ? GDK_INPUT_READ : 0) | (watch_output ? GDK_INPUT_WRITE : 0);
+  gid = gdk_input_add(source, GdkInputCondition(cond), inputCB, (gpointer)this);
 # endif
   if (i == sources->cend()) sources->add(this);
 }
 
+void USource::watchInput(bool state) {
+  if (watch_input == state) return;
+  watch_input = state;
+# if UBIT_WITH_GDK
+  if (is_opened) open(source);
+# endif
+}
+
+void USource::watchOutput(bool state) {
+  if (watch_output == state) return;
+  watch_output = state;
+# if UBIT_WITH_GDK
+  if (is_opened) open(source);
+# endif
+}
+
 void USource::close() {
 # if UBIT_WITH_GDK
   gdk_input_remove(gid);
@@ -102,13 +121,15 @@ void USource::fireClose() {
 
 //==============================================================================
 
-void UAppliImpl::resetSources(UElem* sources, fd_set& read_set, int& maxfd) {
+void UAppliImpl::resetSources(UElem* sources, fd_set& read_set, fd_set& write_set,
+                              int& maxfd) {
   if (!sources) return;
   for (UChildIter c = sources->cbegin(); c != sources->cend(); ++c) {
     USource* i = static_cast<USource*>(*c);
     int fd = 0;
-    if (i && ((fd = i->source) >= 0)) {
-      FD_SET(fd, &read_set);
+    if (i && ((fd = i->source) >= 0) && (i->watch_input || i->watch_output)) {
+      if (i->watch_input) FD_SET(fd, &read_set);
+      if (i->watch_output) FD_SET(fd, &write_set);
       maxfd = std::max(maxfd, fd);
     }
   }
@@ -129,7 +150,7 @@ void UAppliImpl::cleanSources(UElem* sources) {
   }
 }
 
-void UAppliImpl::fireSources(UElem* sources, fd_set& read_set) {
+void UAppliImpl::fireSources(UElem* sources, fd_set& read_set, fd_set& write_set) {
   if (!sources) return;
   for (UChildIter c = sources->cbegin(); c != sources->cend(); ) {
     USource* i = static_cast<USource*>(*c);
@@ -142,8 +163,11 @@ void UAppliImpl::fireSources(UElem* sources, fd_set& read_set) {
     }
     
     int fd = 0;
-    if (i->is_opened && ((fd=i->source) >= 0) && FD_ISSET(fd,&read_set)) {
-      i->fireInput();
+    if (i->is_opened && ((fd=i->source) >= 0)) {
+      // NB: fireInput() can destroy the USource
+      if (i->watch_output && FD_ISSET(fd,&write_set)) i->fireOutput();
+      if (!i->isDestructed() && i->is_opened && i->watch_input && FD_ISSET(fd,&read_set))
+        i->fireInput();
     }
   }
 }
@@ -56,6 +56,15 @@ public:
   virtual void open(int source);
   ///< starts listening to the source (a file, a socket, a pipe ID).
 
+  virtual void watchInput(bool state);
+  ///< specifies if fireInput() is called when the source has data (the default).
+
+  virtual void watchOutput(bool state);
+  /**< specifies if fireOutput() is called when the source becomes writable.
+   * output is not watched by default. As a writable source stays writable,
+   * this mode should only be set while there is data waiting to be written.
+   */
+
   virtual void close();
   ///< stops listening to the source.
      
@@ -68,11 +77,12 @@ public:
   // - - - impl - - -    
   
   virtual void fireInput();
+  virtual void fireOutput() {}
   virtual void fireClose();
 
 private:
   friend class UAppliImpl;
-  bool is_opened;
+  bool is_opened, watch_input, watch_output;
   int source;
   int gid;  // input ID when GDK is used
 };
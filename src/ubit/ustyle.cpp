@@ -32,13 +32,17 @@ using namespace std;
 NAMESPACE_UBIT
 
 
+unsigned long UStyle::generation = 0;
+
 ULocalProps::ULocalProps() :
 size(UAUTO, UAUTO),
 padding(0, 0),
 border(null), 
 background(null), 
 alpha(1.0),
-content(null) {
+content(null),
+lod(null),
+layer(null) {
 }
 
 UStyle::UStyle() {
@@ -70,21 +74,25 @@ UStyle::~UStyle() {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 void UStyle::setSize(ULength w, ULength h) {
+  ++generation;
   if (w != UIGNORE) local.size.width = w;
   if (h != UIGNORE) local.size.height = h;
 }
 
 void UStyle::setPadding(ULength horiz, ULength vert) {
+  ++generation;
   if (horiz != UIGNORE) local.padding.left = local.padding.right = horiz;
   if (vert != UIGNORE) local.padding.top = local.padding.bottom = vert;
 }
 
 void UStyle::setHorizPadding(ULength left, ULength right) {
+  ++generation;
   if (left != UIGNORE) local.padding.left = left;
   if (right != UIGNORE) local.padding.right = right;
 }
 
 void UStyle::setVertPadding(ULength top, ULength bottom) {
+  ++generation;
   if (top != UIGNORE) local.padding.top = top;
   if (bottom != UIGNORE) local.padding.bottom = bottom;
 }
@@ -102,6 +110,7 @@ const UColor* UStyle::getBgcolor(const UElem& e) const {
 void UStyle::setColors(UColor& c) {setColors(c, c);}
 
 void UStyle::setColors(UColor& c_unselect, UColor& c_select) {
+  ++generation;
   for (int k = 0; k < UOn::ACTION_COUNT; ++k) {
     colors[k] = &c_unselect;
     colors[UOn::ACTION_COUNT + k] = &c_select;
@@ -111,6 +120,7 @@ void UStyle::setColors(UColor& c_unselect, UColor& c_select) {
 void UStyle::setBgcolors(UColor& c) {setBgcolors(c, c);}
 
 void UStyle::setBgcolors(UColor& c_unselect, UColor& c_select) {
+  ++generation;
   for (int k = 0; k < UOn::ACTION_COUNT; ++k) {
     bgcolors[k] = &c_unselect;
     bgcolors[UOn::ACTION_COUNT + k] = &c_select;
@@ -118,11 +128,13 @@ void UStyle::setBgcolors(UColor& c_unselect, UColor& c_select) {
 }
 
 void UStyle::setColor(int action, UColor& c) {
+  ++generation;
   colors[action] = &c;
   colors[UOn::ACTION_COUNT + action] = &c;
 }
 
 void UStyle::setBgcolor(int action, UColor& c) {
+  ++generation;
   bgcolors[action] = &c;
   bgcolors[UOn::ACTION_COUNT + action] = &c;
 }
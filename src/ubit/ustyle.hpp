@@ -35,6 +35,8 @@ namespace ubit {
     // if this group is not null the objects it contains are added to children for 
     // display (e.g. for adding list-item or checkboxes markers)
     UElem* content;    // NB: = null in most cases    
+    const ULod* lod;   // level of detail at small scales (null in most cases)
+    const ULayer* layer; // the box is cached in a bitmap (null in most cases)
   };
   
   
@@ -47,11 +49,11 @@ namespace ubit {
     virtual ~UStyle();
     virtual const UStyle& getStyle(UUpdateContext*) const {return *this;}
     
-    void setAlpha(float a) {local.alpha = a;}
+    void setAlpha(float a) {local.alpha = a; ++generation;}
     //void setBackground(const UBackground*);
-    void setBorder(const UBorder* b) {local.border = b;}
-    void setCursor(const UCursor* c) {cursor = c;}
-    void setFont(const UFont* f) {font = f;}
+    void setBorder(const UBorder* b) {local.border = b; ++generation;}
+    void setCursor(const UCursor* c) {cursor = c; ++generation;}
+    void setFont(const UFont* f) {font = f; ++generation;}
     void setSize(ULength width, ULength height);
     void setPadding(ULength horiz, ULength vert);
     void setHorizPadding(ULength left, ULength right);
@@ -82,6 +84,14 @@ namespace ubit {
     UColor* bgcolors[2 * UOn::ACTION_COUNT];
     //const UColor *color, *bgcolor;
     //class UAttrList* attrs;
+    
+    static unsigned long generation;
+    /* [impl] incremented each time a style is modified through its setters
+     * and each time a UFont is changed (it may be the font of a style).
+     * UComputedStyle records computed with a previous generation are discarded.
+     * must be incremented explicitly if the fields are changed directly after
+     * the styles have been used for rendering.
+     */
   };
   
 }
@@ -238,14 +238,18 @@ bool UStyleParser::readStyleSelectors(StyleMaker& xxx) {
   if (permissive) sel.lower();
 
   if (!multiple_sel) {
-    readSingleSelector(sel);
     xxx.count = 1;
+    xxx.sources.assign(1, sel);
+    readSingleSelector(sel);
     *(xxx.selectors[0]) = sel;
   }
   else {
     xxx.count = sel.tokenize(xxx.selectors, ",");
-    for (unsigned int k = 0; k < xxx.count; k++)
+    xxx.sources.clear();
+    for (unsigned int k = 0; k < xxx.count; k++) {
+      xxx.sources.push_back(*(xxx.selectors[k]));
       readSingleSelector(*(xxx.selectors[k]));
+    }
   }
  
   return true;
@@ -33,6 +33,7 @@ namespace ubit {
     
     struct StyleMaker {
       std::vector<UStr*> selectors;
+      std::vector<UStr> sources;  // selectors as written in the stylesheet
       unsigned int count;
       
       StyleMaker();
@@ -80,12 +80,14 @@ bool USubwin::realize() {
   addAttr(UOn::resize / ucall(this, &USubwin::resizeImpl));
     
 #if UBIT_WITH_X11
-  UHardwinX11* _hw = (UHardwinX11*)hw;
-  // this makes it possible for the GL window to receive events sent by the UMS
-  unsigned char winid[2] = {UHardwinImpl::SUBWIN, 0};
-  Atom UMS_WINDOW = ((UDispX11*)_hw->getDisp())->getAtoms().UMS_WINDOW;
-  XChangeProperty(_hw->getSysDisp(), _hw->getSysWin(), UMS_WINDOW,
-                  XA_STRING, 8, PropModeReplace, winid, 2);
+  UHardwinX11* _hw = dynamic_cast<UHardwinX11*>(hw);   // null with the headless display
+  if (_hw) {
+    // this makes it possible for the GL window to receive events sent by the UMS
+    unsigned char winid[2] = {UHardwinImpl::SUBWIN, 0};
+    Atom UMS_WINDOW = ((UDispX11*)_hw->getDisp())->getAtoms().UMS_WINDOW;
+    XChangeProperty(_hw->getSysDisp(), _hw->getSysWin(), UMS_WINDOW,
+                    XA_STRING, 8, PropModeReplace, winid, 2);
+  }
 #endif
   return true;
 }
@@ -88,6 +88,13 @@ void USymbol::getSize(UUpdateContext& ctx, UDimension& dim) const {
   dim.width = dim.height; // format carre
 }
 
+// fills a convex polygon of at most 4 points
+static void fillPolygon(UGraph& g, const UPoint* p, int card) {
+  float coords[8];
+  for (int k = 0; k < card; k++) {coords[2*k] = p[k].x; coords[2*k+1] = p[k].y;}
+  g.drawPolygon(coords, card, UGraph::FILLED);
+}
+
 void USymbol::paint(UGraph& g, UUpdateContext& ctx, const URect& r) const {
   // xl, yl = length for obtaining the last point (= width-1, height-1)
   // dont't forget to remove the left and right margin (SM)
@@ -112,7 +119,7 @@ void USymbol::paint(UGraph& g, UUpdateContext& ctx, const URect& r) const {
     fore = frontShadowColor ? frontShadowColor : &UColor::white;
   }
 
-  vector<UPoint> p(3);
+  UPoint p[4];      // no allocation when painting
 
   switch (ix) {
     /*
@@ -154,7 +161,7 @@ void USymbol::paint(UGraph& g, UUpdateContext& ctx, const URect& r) const {
     p[2].x = r.x+SM+xl,   p[2].y = r.y+SM;
     // dans cet ordre
     g.setColor(*symcolor);
-    g.fillPolygon(p);
+    fillPolygon(g, p, 3);
     g.setColor(*fore);
     g.drawLine(p[0], p[1]);
     g.drawLine(p[0], p[2]);
@@ -169,7 +176,7 @@ void USymbol::paint(UGraph& g, UUpdateContext& ctx, const URect& r) const {
 
     // dans cet ordre!!
     g.setColor(*symcolor);
-    g.fillPolygon(p);
+    fillPolygon(g, p, 3);
     g.setColor(*back);
     g.drawLine(p[1], p[2]);
     g.drawLine(p[0], p[2]);
@@ -183,7 +190,7 @@ void USymbol::paint(UGraph& g, UUpdateContext& ctx, const URect& r) const {
     p[2].x = r.x+SM,     p[2].y = r.y+SM+yl;
 
     g.setColor(*symcolor);
-    g.fillPolygon(p);
+    fillPolygon(g, p, 3);
     g.setColor(*fore);
     g.drawLine(p[0], p[2]);
     g.drawLine(p[0], p[1]);
@@ -196,7 +203,7 @@ void USymbol::paint(UGraph& g, UUpdateContext& ctx, const URect& r) const {
     p[1].x = r.x+SM,     p[1].y = r.y+SM+yl/2;
     p[2].x = r.x+SM+xl,  p[2].y = r.y+SM+yl;
     g.setColor(*symcolor);
-    g.fillPolygon(p);
+    fillPolygon(g, p, 3);
     g.setColor(*back);
     g.drawLine(p[1], p[2]);
     g.drawLine(p[0], p[2]);
@@ -208,11 +215,11 @@ void USymbol::paint(UGraph& g, UUpdateContext& ctx, const URect& r) const {
     p[0].x = r.x+SM+xl/2,  p[0].y = r.y+SM;
     p[1].x = r.x+SM,       p[1].y = r.y+SM+yl/2;
     p[2].x = r.x+SM+xl/2,  p[2].y = r.y+yl;
-    p.push_back(UPoint(r.x+xl, r.y+SM+yl/2));  // 4 points
+    p[3].x = r.x+xl,       p[3].y = r.y+SM+yl/2;   // 4 points
 
     if (active) {
       g.setColor(*symcolor);
-      g.fillPolygon(p);
+      fillPolygon(g, p, 4);
     }
     g.setColor(*fore);
     g.drawLine(p[0], p[1]);
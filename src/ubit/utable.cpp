@@ -17,6 +17,8 @@
 #include <ubit/ubit_features.h>
 #include <iostream>
 #include <cmath>
+#include <map>
+#include <set>
 #include <ubit/uon.hpp>
 #include <ubit/uboxgeom.hpp>
 #include <ubit/uviewImpl.hpp>
@@ -86,6 +88,83 @@ static void augmentCells(vector<UViewCell>& tab, unsigned int new_size) {
   if (new_size> tab.size()) tab.resize(new_size);
 }
 
+// sizes of a table or of a table cell that are kept from one layout to the
+// next one so that only the cells that have changed are laid out again: 'hints'
+// is the result of the GET_HINTS round and 'layout' the result of the IMPOSE_WIDTH
+// round. These sizes are valid as long as the view is not LAYOUT_DAMAGED and
+// the context of the view is unchanged.
+struct UTableSizes {
+  UTableSizes() : has_hints(false), has_layout(false) {}
+  
+  bool matches(const UUpdateContext& ctx, UView* view) const {
+    const UElem* elem = view->getBox();
+    int state = elem->isSelected() * UOn::ACTION_COUNT + (int)elem->getInterState();
+    return has_hints && !view->hasVMode(UView::LAYOUT_DAMAGED)
+    && style_generation == UStyle::generation && elem_state == state 
+    && xyscale == ctx.xyscale && fontdesc.family == ctx.fontdesc.family
+    && fontdesc.styles == ctx.fontdesc.styles 
+    && fontdesc.def_size == ctx.fontdesc.def_size
+    && fontdesc.actual_size == ctx.fontdesc.actual_size;
+  }
+  
+  void setHints(const UUpdateContext& ctx, UView* view, const UViewLayout& vl) {
+    const UElem* elem = view->getBox();
+    view->removeVModes(UView::LAYOUT_DAMAGED);
+    style_generation = UStyle::generation;
+    elem_state = elem->isSelected() * UOn::ACTION_COUNT + (int)elem->getInterState();
+    xyscale = ctx.xyscale;
+    fontdesc = ctx.fontdesc;
+    hints = vl;
+    has_hints = true;
+    has_layout = false;
+  }
+
+  bool has_hints, has_layout;
+  unsigned long style_generation;
+  int elem_state;
+  float xyscale, imposed_w;
+  UFontDesc fontdesc;
+  UViewLayout hints, layout;
+};
+
+struct UTableCellProp : public UViewProp, public UTableSizes {};
+
+// widths of the cells of a table that are kept from one layout to the next
+// one: the widths of the cells that span one column are stored in per-column
+// multisets that are only updated when a cell changes or disappears, the cells
+// that span several columns are then distributed over these columns.
+struct UTableStats {
+  struct Cell {
+    int col;
+    float d, min_d, max_d;
+    unsigned long pass;  // last GET_HINTS round where this cell was found
+  };
+  
+  struct Column {
+    std::multiset<float> d, min_d, max_d;
+  };
+  
+  struct Span {
+    int col, span;
+    float d, min_d, max_d;
+  };
+  
+  UTableStats() : pass(0), found(0) {}
+  void newPass() {pass++; found = 0; spans.clear();}
+  void addCell(UView* cellview, int col, int span, const UViewLayout&, bool changed);
+  void computeColumns(vector<UViewCell>& cols, int ccount, bool new_pass);
+
+  UTableSizes table;               // hints of the table
+  int ccount;                      // column count of the table hints
+  unsigned long pass, found;
+  std::map<UView*, Cell> cells;    // cells that span one column
+  vector<Column> columns;
+  vector<Span> spans;              // cells that span several columns
+  
+private:
+  void removeCell(const Cell&);
+};
+
 /* ==================================================== [Elc] ======= */
 
 UTcell::UTcell(UArgs a): UFlowbox(a) {
@@ -122,10 +201,11 @@ UView* UTableView::createView(UBox* box, UView* parview, UHardwinImpl* w) {
 }
 
 UTableView::~UTableView() {
+  delete stats;
 }
 
 UTableView::UTableView(UBox* box, UView* parview, UHardwinImpl* w) 
-: UView(box, parview, w) {
+: UView(box, parview, w), stats(new UTableStats) {
   lcur = ccur = ccount = lcount = 0;
 }
 
@@ -148,9 +228,20 @@ bool UTableView::doLayout(UUpdateContext&parp, UViewLayout&vl) {
   vl.dim.height = vl.min_h = vl.max_h = 0;
   
   // !!PREMIER ROUND!!
+  // the rows are not visited again if no cell has changed since the last layout
   vl.strategy = UViewLayout::GET_HINTS;
-  UUpdateContext ctx(parp, box, this, null);
-  tableDoLayout(vd, ctx, *box, vl);
+  if (stats->table.matches(parp, this)) {
+    vl = stats->table.hints;
+    ccount = stats->ccount;
+    stats->computeColumns(cols, ccount, false);
+  }
+  else {
+    UUpdateContext ctx(parp, box, this, null);
+    stats->newPass();
+    tableDoLayout(vd, ctx, *box, vl);
+    stats->ccount = ccount;
+    stats->table.setHints(parp, this, vl);
+  }
   
   if (vl.spec_w < 0) {        // "table uses as many space as needed"
     for (int c = 0; c < ccount; c++)  {
@@ -344,6 +435,9 @@ void UTableView::tableDoLayout(UTableLayoutImpl& vd, UUpdateContext& ctx,
       if (size.width!=UAUTO && size.width.unit!=UPERCENT && size.width.unit!=UPERCENT_CTR)
         vl.spec_w = size.width.toPixels(ctx.getDisp(), ctx.fontdesc, -1, -1);
       
+    if (vl.strategy == UViewLayout::GET_HINTS)
+      vd.t.stats->computeColumns(vd.t.cols, vd.t.ccount, true);
+    
     // prendre en compte les spacings (mais pas les borders rajoutes ensuite)
     vl.max_w = vl.dim.width = ctx.hspacing * (vd.t.ccount - 1);
  
@@ -436,6 +530,74 @@ static void computeSizes(vector<UViewCell>& cols, int ccur, int span,
   }  
 }
 
+/* ==================================================== ===== ======= */
+
+void UTableStats::addCell(UView* cellview, int col, int span,
+                          const UViewLayout& vl, bool changed) {
+  std::map<UView*, Cell>::iterator i = cells.find(cellview);
+  
+  if (span > 1) {
+    if (i != cells.end()) {removeCell(i->second); cells.erase(i);}
+    Span s = {col, span, vl.dim.width, vl.min_w, vl.max_w};
+    spans.push_back(s);
+    return;
+  }
+
+  if (i == cells.end()) {
+    i = cells.insert(std::make_pair(cellview, Cell())).first;
+    i->second.pass = 0;
+  }
+  else if (i->second.pass == pass) return;   // already found in this round
+  else if (i->second.col == col && !changed) {
+    i->second.pass = pass;
+    found++;
+    return;
+  }
+  else removeCell(i->second);
+  
+  Cell& c = i->second;
+  c.col = col;
+  c.d = vl.dim.width;
+  c.min_d = vl.min_w;
+  c.max_d = vl.max_w;
+  c.pass = pass;
+  found++;
+  if (col >= (int)columns.size()) columns.resize(col + 1);
+  columns[col].d.insert(c.d);
+  columns[col].min_d.insert(c.min_d);
+  columns[col].max_d.insert(c.max_d);
+}
+
+void UTableStats::removeCell(const Cell& c) {
+  Column& column = columns[c.col];
+  column.d.erase(column.d.find(c.d));
+  column.min_d.erase(column.min_d.find(c.min_d));
+  column.max_d.erase(column.max_d.find(c.max_d));
+}
+
+void UTableStats::computeColumns(vector<UViewCell>& cols, int ccount, bool new_pass) {
+  // removes the cells that were not found in the last GET_HINTS round
+  if (new_pass && found < cells.size()) {
+    for (std::map<UView*, Cell>::iterator i = cells.begin(); i != cells.end(); ) {
+      if (i->second.pass == pass) ++i;
+      else {removeCell(i->second); cells.erase(i++);}
+    }
+  }
+  
+  augmentCells(cols, ccount);
+  for (int c = 0; c < ccount && c < (int)columns.size(); c++) {
+    if (columns[c].d.empty()) continue;
+    cols[c].d = *columns[c].d.rbegin();
+    cols[c].min_d = *columns[c].min_d.rbegin();
+    cols[c].max_d = *columns[c].max_d.rbegin();
+  }
+  
+  for (unsigned int k = 0; k < spans.size(); k++) {
+    const Span& s = spans[k];
+    computeSizes(cols, s.col, s.span, s.d, s.min_d, s.max_d, 0);
+  }
+}
+
 /* ==================================================== [Elc] ======= */
 
 static void setSizes(UView *chboxview, UUpdateContext &ctx,
@@ -459,13 +621,38 @@ static void setSizes(UView *chboxview, UUpdateContext &ctx,
     return;
   }
   
-  chboxview->doLayout(ctx, chvl);  // init chvl
+  // the cell is only laid out if it has changed or if its width has changed
+  UTableCellProp* cp = null;
+  chboxview->obtainProp(cp);
+  
+  if (strategy == UViewLayout::GET_HINTS) {
+    bool changed = !cp->matches(ctx, chboxview);
+    if (!changed) chvl = cp->hints;
+    else {
+      chboxview->doLayout(ctx, chvl);  // init chvl
+      cp->setHints(ctx, chboxview, chvl);
+    }
+    // the column widths are computed from the stats at the end of the round
+    vd.t.stats->addCell(chboxview, ccur, colspan, chvl, changed);
+  }
+  else {
+    if (cp->has_layout && cp->imposed_w == chvl.spec_w && cp->matches(ctx, chboxview))
+      chvl = cp->layout;
+    else {
+      cp->imposed_w = chvl.spec_w;     // NB: doLayout() may change chvl.spec_w
+      chboxview->doLayout(ctx, chvl);  // init chvl
+      cp->layout = chvl;
+      cp->has_layout = cp->matches(ctx, chboxview);
+    }
+  }
+  
   vd.t.cols[ccur].colspan = colspan;
   vd.t.cols[ccur].rowspan = rowspan;
   
   // colonnes
-  computeSizes(vd.t.cols, ccur, colspan,
-               chvl.dim.width, chvl.min_w, chvl.max_w, chvl.spec_w);
+  if (strategy != UViewLayout::GET_HINTS)
+    computeSizes(vd.t.cols, ccur, colspan,
+                 chvl.dim.width, chvl.min_w, chvl.max_w, chvl.spec_w);
   // lignes  
   computeSizes(vd.t.lines, vd.t.lcount, rowspan,
                chvl.dim.height, chvl.min_h, chvl.max_h, chvl.spec_h);
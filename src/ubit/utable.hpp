@@ -120,6 +120,7 @@ namespace ubit {
     std::vector<UViewCell> cols, lines;
     int lcur, ccur; 
     int ccount, lcount;
+    struct UTableStats* stats;   // widths of the cells of each column
     virtual bool doLayout(UUpdateContext&, class UViewLayout&);
     static void tableDoLayout(class UTableLayoutImpl&, UUpdateContext& ctx, 
                               UElem& grp, UViewLayout&);
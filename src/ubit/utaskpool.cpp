@@ -0,0 +1,208 @@
+/************************************************************************
+ *
+ *  utaskpool.cpp: pool of worker threads
+ *  Ubit GUI Toolkit - Version 6
+ *  (C) 2009 | Eric Lecolinet | TELECOM ParisTech | http://www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#include <ubit/ubit_features.h>
+#include <unistd.h>
+#include <ubit/utaskpool.hpp>
+#include <ubit/uappli.hpp>
+using namespace std;
+#define NAMESPACE_UBIT namespace ubit {
+NAMESPACE_UBIT
+
+static thread_local int worker_index = -1;      // -1 if not a worker thread
+static thread_local UTask* current_task = null;  // task run by this thread
+
+
+bool UTask::inWorkerThread() {
+  return worker_index >= 0;
+}
+
+void UTask::requireMainThread() {
+  if (worker_index >= 0 && current_task) current_task->main_thread_required = true;
+}
+
+/* ==================================================== ===== ======= */
+
+int UTaskPool::getCoreCount() {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? int(n) : 1;
+}
+
+UTaskPool::UTaskPool(int thread_count) :
+queued(0), next_worker(0), stopping(false) {
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&cond, NULL);
+  if (thread_count <= 0) thread_count = getCoreCount();
+
+  for (int k = 0; k < thread_count; k++) {
+    Worker* w = new Worker();
+    w->pool = this;
+    w->index = k;
+    pthread_mutex_init(&w->lock, NULL);
+    workers.push_back(w);
+  }
+
+  // threads are started when all the workers are created (they may steal tasks)
+  for (unsigned int k = 0; k < workers.size(); k++) {
+    if (pthread_create(&workers[k]->thread, NULL, workerMain, workers[k]) != 0)
+      UAppli::fatalError("UTaskPool","can't create worker thread %d", k);
+  }
+}
+
+UTaskPool::~UTaskPool() {
+  pthread_mutex_lock(&lock);
+  stopping = true;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&lock);
+
+  for (unsigned int k = 0; k < workers.size(); k++) {
+    pthread_join(workers[k]->thread, NULL);
+    pthread_mutex_destroy(&workers[k]->lock);
+    delete workers[k];
+  }
+  pthread_cond_destroy(&cond);
+  pthread_mutex_destroy(&lock);
+}
+
+/* ==================================================== ===== ======= */
+
+void UTaskPool::submit(UTask* task, UTaskGroup& group) {
+  if (!task) return;
+  task->main_thread_required = false;
+
+  pthread_mutex_lock(&lock);
+  group.pending++;
+  // tasks submitted by a worker of this pool go to its own queue
+  Worker* w = (worker_index >= 0 && worker_index < (int)workers.size()
+               && workers[worker_index]->pool == this) ?
+    workers[worker_index] : workers[next_worker++ % workers.size()];
+  pthread_mutex_unlock(&lock);
+
+  // 'queued' is updated together with the queue (w->lock is always taken
+  // before the pool lock) so that it is exactly the number of queued tasks
+  pthread_mutex_lock(&w->lock);
+  w->tasks.push_back(std::make_pair(task, &group));
+  pthread_mutex_lock(&lock);
+  queued++;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&lock);
+  pthread_mutex_unlock(&w->lock);
+}
+
+// takes the most recent task of its own queue, otherwise steals the oldest
+// task of another queue. 'self' = -1 if the caller is not a worker.
+bool UTaskPool::popTask(int self, std::pair<UTask*,UTaskGroup*>& task) {
+  if (self >= 0) {
+    Worker* w = workers[self];
+    pthread_mutex_lock(&w->lock);
+    bool found = !w->tasks.empty();
+    if (found) {
+      task = w->tasks.back();
+      w->tasks.pop_back();
+      pthread_mutex_lock(&lock);
+      queued--;
+      pthread_mutex_unlock(&lock);
+    }
+    pthread_mutex_unlock(&w->lock);
+    if (found) return true;
+  }
+
+  int count = workers.size();
+  for (int k = 1; k <= count; k++) {
+    Worker* w = workers[(self + k + count) % count];
+    pthread_mutex_lock(&w->lock);
+    bool found = !w->tasks.empty();
+    if (found) {
+      task = w->tasks.front();
+      w->tasks.pop_front();
+      pthread_mutex_lock(&lock);
+      queued--;
+      pthread_mutex_unlock(&lock);
+    }
+    pthread_mutex_unlock(&w->lock);
+    if (found) return true;
+  }
+  return false;
+}
+
+void UTaskPool::runTask(std::pair<UTask*,UTaskGroup*>& task) {
+  UTask* prev_task = current_task;
+  current_task = task.first;
+  task.first->run();
+  current_task = prev_task;
+
+  pthread_mutex_lock(&lock);
+  task.second->pending--;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&lock);
+}
+
+void* UTaskPool::workerMain(void* arg) {
+  Worker* w = (Worker*)arg;
+  UTaskPool* pool = w->pool;
+  worker_index = w->index;
+  std::pair<UTask*,UTaskGroup*> task;
+
+  while (true) {
+    if (pool->popTask(w->index, task)) {
+      pool->runTask(task);
+      continue;
+    }
+    pthread_mutex_lock(&pool->lock);
+    while (pool->queued == 0 && !pool->stopping)
+      pthread_cond_wait(&pool->cond, &pool->lock);
+    bool stop = pool->stopping && pool->queued == 0;
+    pthread_mutex_unlock(&pool->lock);
+    if (stop) break;
+  }
+  return NULL;
+}
+
+void UTaskPool::wait(UTaskGroup& group) {
+  int self = (worker_index >= 0 && worker_index < (int)workers.size()
+              && workers[worker_index]->pool == this) ? worker_index : -1;
+
+  // other threads just block: tasks must not run in the main thread as they
+  // would not be considered as being run by a worker (see inWorkerThread())
+  if (self < 0) {
+    pthread_mutex_lock(&lock);
+    while (group.pending > 0) pthread_cond_wait(&cond, &lock);
+    pthread_mutex_unlock(&lock);
+    return;
+  }
+
+  std::pair<UTask*,UTaskGroup*> task;
+  while (true) {
+    pthread_mutex_lock(&lock);
+    bool done = (group.pending == 0);
+    pthread_mutex_unlock(&lock);
+    if (done) return;
+
+    // a worker helps the others instead of blocking
+    if (popTask(self, task)) {
+      runTask(task);
+      continue;
+    }
+
+    pthread_mutex_lock(&lock);
+    // the remaining tasks of the group are running: wait for their completion
+    // (or for new tasks that they may have submitted)
+    if (group.pending > 0 && queued == 0) pthread_cond_wait(&cond, &lock);
+    pthread_mutex_unlock(&lock);
+  }
+}
+
+}
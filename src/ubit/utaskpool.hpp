@@ -0,0 +1,131 @@
+/************************************************************************
+ *
+ *  utaskpool.hpp: pool of worker threads
+ *  Ubit GUI Toolkit - Version 6
+ *  (C) 2009 | Eric Lecolinet | TELECOM ParisTech | http://www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#ifndef _utaskpool_hpp_
+#define	_utaskpool_hpp_ 1
+#include <pthread.h>
+#include <deque>
+#include <vector>
+#include <ubit/udefs.hpp>
+namespace ubit {
+
+  /** task that can be executed by a UTaskPool.
+   * run() must be redefined by subclasses. run() is always called by a worker
+   * thread of the pool (@see UTaskPool).
+   */
+  class UTask {
+  public:
+    UTask() : main_thread_required(false) {}
+    virtual ~UTask() {}
+
+    virtual void run() = 0;
+    ///< executes the task.
+
+    bool isMainThreadRequired() const {return main_thread_required;}
+    ///< true if the task could not complete because requireMainThread() was called.
+
+    static bool inWorkerThread();
+    ///< true if the calling thread is a worker thread of a UTaskPool.
+
+    static void requireMainThread();
+    /**< signals that the current task needs the main thread.
+     * this function is called by code that cannot run in a worker thread (eg. code
+     * that needs the X server or the GL context). The result of the task must
+     * then be discarded and the task executed again in the main thread.
+     */
+
+  private:
+    friend class UTaskPool;
+    bool main_thread_required;
+  };
+
+
+  /** group of tasks that are waited for together (@see UTaskPool).
+   */
+  class UTaskGroup {
+  public:
+    UTaskGroup() : pending(0) {}
+
+    int getPendingCount() const {return pending;}
+    ///< number of tasks that have not yet completed.
+
+  private:
+    friend class UTaskPool;
+    int pending;
+  };
+
+
+  /** pool of worker threads with work stealing.
+   * each worker has its own task queue: tasks that are submitted by a worker
+   * are pushed on its own queue (and executed in LIFO order for locality),
+   * other tasks are distributed in turn. Idle workers steal the oldest tasks
+   * of the other queues. When called by a worker, wait() executes pending tasks
+   * while waiting, so that tasks can submit and wait for subtasks without
+   * blocking the pool. Other threads (eg. the main thread) just block.
+   *
+   * Example:
+   * <pre>
+   *    UTaskPool pool;           // one thread per core
+   *    UTaskGroup group;
+   *    for (k = 0; k < n; k++) pool.submit(tasks[k], group);
+   *    pool.wait(group);         // tasks[] are not deleted by the pool
+   * </pre>
+   */
+  class UTaskPool {
+  public:
+    UTaskPool(int thread_count = 0);
+    ///< creates the pool; 'thread_count' = 0 means one thread per core.
+
+    virtual ~UTaskPool();
+    ///< waits for the completion of the running tasks and stops the threads.
+
+    int getThreadCount() const {return workers.size();}
+    ///< returns the number of worker threads.
+
+    void submit(UTask*, UTaskGroup&);
+    ///< adds a task to the pool; the task is not deleted by the pool.
+
+    void wait(UTaskGroup&);
+    ///< waits until all the tasks of this group have completed.
+
+    static int getCoreCount();
+    ///< returns the number of cores of the machine.
+
+  private:
+    struct Worker {
+      UTaskPool* pool;
+      int index;
+      pthread_t thread;
+      pthread_mutex_t lock;       // protects 'tasks'
+      std::deque<std::pair<UTask*,UTaskGroup*> > tasks;
+    };
+
+    UTaskPool(const UTaskPool&);
+    UTaskPool& operator=(const UTaskPool&);
+    static void* workerMain(void*);
+    bool popTask(int self, std::pair<UTask*,UTaskGroup*>& task);
+    void runTask(std::pair<UTask*,UTaskGroup*>& task);
+
+    std::vector<Worker*> workers;
+    pthread_mutex_t lock;         // protects the fields below
+    pthread_cond_t cond;          // signaled when tasks are added or completed
+    int queued;
+    unsigned int next_worker;
+    bool stopping;
+  };
+
+}
+#endif
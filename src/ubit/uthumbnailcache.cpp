@@ -0,0 +1,351 @@
+/* ***********************************************************************
+ *
+ *  uthumbnailcache.cpp: persistent cache of image thumbnails
+ *  Ubit GUI Toolkit - Version 6.0
+ *  (C) 2009 Eric Lecolinet | ENST Paris | www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#include <ubit/ubit_features.h>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <ubit/udefs.hpp>
+#include <ubit/uappli.hpp>
+#include <ubit/uima.hpp>
+#include <ubit/uthumbnailcache.hpp>
+using namespace std;
+#define NAMESPACE_UBIT namespace ubit {
+NAMESPACE_UBIT
+
+static const char INDEX_MAGIC[4] = {'U','T','N','1'};
+enum {INITIAL_SLOT_COUNT = 4096};
+
+// the index file contains a Header followed by 'slot_count' Slots (a hash table
+// with linear probing). Slots are only removed when the cache is rebuilt.
+
+struct UThumbnailCache::Header {
+  char magic[4];
+  unsigned int slot_count;        // a power of 2
+  unsigned int count;             // number of used slots
+  unsigned int generation;        // incremented when the data file is rebuilt
+  unsigned long long data_size;   // size of the data file
+  unsigned int clock;             // incremented at each access (for LRU eviction)
+  unsigned int reserved;
+};
+
+struct UThumbnailCache::Slot {
+  unsigned long long key;         // 0 if the slot is empty
+  unsigned long long offset;      // offset of the pixels in the data file
+  unsigned short width, height;
+  unsigned int last_use;          // value of the clock when last accessed
+};
+
+/* ==================================================== ===== ======= */
+
+UThumbnailCache* UThumbnailCache::getDefault() {
+  static UThumbnailCache* cache = null;
+  static bool initialized = false;
+  if (initialized) return cache;
+  initialized = true;
+
+  UStr path;
+  const char* xdg = ::getenv("XDG_CACHE_HOME");
+  const char* home = ::getenv("HOME");  // pas de free() sur un getenv!
+  if (xdg && *xdg) path = xdg;
+  else if (home && *home) {
+    path = UStr(home) & "/.cache";
+    ::mkdir(path.c_str(), 0700);   // may already exist
+  }
+  else return null;
+
+  cache = new UThumbnailCache(path & "/ubit-thumbnails");
+  if (!cache->isOpened()) {
+    delete cache;
+    cache = null;
+  }
+  return cache;
+}
+
+/* ==================================================== ===== ======= */
+
+UThumbnailCache::UThumbnailCache(const UStr& _dirpath, unsigned long _max_size) :
+dirpath(_dirpath), max_size(_max_size),
+index_fd(-1), data_fd(-1), index(null), index_size(0), generation(0) {
+  ::mkdir(dirpath.c_str(), 0700);   // may already exist
+  UStr ipath = dirpath & "/index";
+  UStr dpath = dirpath & "/data";
+  index_fd = ::open(ipath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (index_fd < 0 || ::flock(index_fd, LOCK_EX) < 0) {
+    UAppli::warning("UThumbnailCache","can't open the thumbnail cache in %s", dirpath.c_str());
+    return;
+  }
+
+  // the data file is opened with the lock: another application may be
+  // replacing it (see rebuild())
+  data_fd = ::open(dpath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (data_fd < 0)
+    UAppli::warning("UThumbnailCache","can't open the thumbnail cache in %s", dirpath.c_str());
+  // the cache is (re)created if the index is new or invalid
+  else if (mapIndex()) generation = index->generation;
+  else if (!rebuild(INITIAL_SLOT_COUNT, 0)) unmapIndex();
+  unlock();
+}
+
+UThumbnailCache::~UThumbnailCache() {
+  unmapIndex();
+  if (index_fd >= 0) ::close(index_fd);
+  if (data_fd >= 0) ::close(data_fd);
+}
+
+int UThumbnailCache::getCount() const {
+  return index ? index->count : 0;
+}
+
+unsigned long UThumbnailCache::getDataSize() const {
+  return index ? index->data_size : 0;
+}
+
+unsigned long long UThumbnailCache::makeKey(const UStr& pathname, unsigned long modtime,
+                                            unsigned long size) {
+  // 64 bit FNV-1a hash of the pathname, the modification time and the size
+  unsigned long long h = 14695981039346656037ULL;
+  for (const char* p = pathname.c_str(); p && *p; ++p) {
+    h ^= (unsigned char)*p;
+    h *= 1099511628211ULL;
+  }
+  unsigned long long v[2] = {modtime, size};
+  const unsigned char* b = (const unsigned char*)v;
+  for (unsigned int k = 0; k < sizeof(v); ++k) {
+    h ^= b[k];
+    h *= 1099511628211ULL;
+  }
+  return h ? h : 1;   // 0 means empty slot
+}
+
+/* ==================================================== ===== ======= */
+
+bool UThumbnailCache::mapIndex() {
+  struct stat st;
+  if (::fstat(index_fd, &st) < 0 || st.st_size < (off_t)sizeof(Header)) return false;
+
+  void* p = ::mmap(null, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, index_fd, 0);
+  if (p == MAP_FAILED) return false;
+  index = (Header*)p;
+  index_size = st.st_size;
+
+  unsigned int n = index->slot_count;
+  if (memcmp(index->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0
+      || n == 0 || (n & (n-1)) != 0 || index_size != sizeof(Header) + n * sizeof(Slot)) {
+    unmapIndex();
+    return false;
+  }
+  return true;
+}
+
+void UThumbnailCache::unmapIndex() {
+  if (index) ::munmap(index, index_size);
+  index = null;
+  index_size = 0;
+}
+
+bool UThumbnailCache::lock(bool exclusive) {
+  if (!index || ::flock(index_fd, exclusive ? LOCK_EX : LOCK_SH) < 0) return false;
+
+  // another application may have rebuilt the cache
+  struct stat st;
+  if (::fstat(index_fd, &st) < 0 || (unsigned long)st.st_size != index_size) {
+    unmapIndex();
+    if (!mapIndex()) {
+      unlock();
+      return false;
+    }
+  }
+  if (index->generation != generation) {
+    UStr dpath = dirpath & "/data";
+    int fd = ::open(dpath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+      unlock();
+      return false;
+    }
+    ::close(data_fd);
+    data_fd = fd;
+    generation = index->generation;
+  }
+  return true;
+}
+
+void UThumbnailCache::unlock() {
+  ::flock(index_fd, LOCK_UN);
+}
+
+UThumbnailCache::Slot* UThumbnailCache::findSlot(unsigned long long key) const {
+  Slot* slots = (Slot*)(index + 1);
+  unsigned int mask = index->slot_count - 1;
+  unsigned int k = (unsigned int)(key ^ (key >> 32)) & mask;
+
+  for (unsigned int n = 0; n < index->slot_count; ++n, k = (k+1) & mask) {
+    if (slots[k].key == key || slots[k].key == 0) return &slots[k];
+  }
+  return null;   // can't happen as the table is enlarged when it is 3/4 full
+}
+
+bool UThumbnailCache::moreRecent(const Slot& s1, const Slot& s2) {
+  return s1.last_use > s2.last_use;
+}
+
+// must be called with an exclusive lock. The most recently used thumbnails are
+// kept (up to 'keep_size' bytes) and copied in a new data file, which is then
+// renamed, so that the other applications can detect the change.
+
+bool UThumbnailCache::rebuild(unsigned int slot_count, unsigned long keep_size) {
+  vector<Slot> kept;
+  unsigned int clock = 0;
+  Header header;
+  memset(&header, 0, sizeof(header));
+  header.generation = generation + 1;
+
+  if (index) {
+    Slot* slots = (Slot*)(index + 1);
+    for (unsigned int k = 0; k < index->slot_count; ++k) {
+      if (slots[k].key != 0) kept.push_back(slots[k]);
+    }
+    sort(kept.begin(), kept.end(), moreRecent);
+    clock = index->clock;
+    header.generation = index->generation + 1;
+  }
+
+  UStr dpath = dirpath & "/data";
+  UStr npath = dirpath & "/data.new";
+  int fd = ::open(npath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) return false;
+
+  unsigned long long offset = 0;
+  vector<unsigned char> pixels;
+  for (unsigned int k = 0; k < kept.size(); ++k) {
+    size_t len = size_t(kept[k].width) * kept[k].height * 4;
+    pixels.resize(len);
+    if (offset + len > keep_size
+        || ::pread(data_fd, &pixels[0], len, kept[k].offset) != (ssize_t)len
+        || ::pwrite(fd, &pixels[0], len, offset) != (ssize_t)len) {
+      kept.resize(k);
+      break;
+    }
+    kept[k].offset = offset;
+    offset += len;
+  }
+
+  if (::rename(npath.c_str(), dpath.c_str()) < 0) {
+    ::close(fd);
+    ::unlink(npath.c_str());
+    return false;
+  }
+  ::close(data_fd);
+  data_fd = fd;
+
+  // the index file is rewritten in place (other applications have mapped it)
+  unmapIndex();
+  memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  header.slot_count = slot_count;
+  header.data_size = offset;
+  header.clock = clock;
+  off_t size = sizeof(Header) + off_t(slot_count) * sizeof(Slot);
+
+  if (::ftruncate(index_fd, 0) < 0 || ::ftruncate(index_fd, size) < 0
+      || ::pwrite(index_fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)
+      || !mapIndex())
+    return false;
+  generation = index->generation;
+
+  for (unsigned int k = 0; k < kept.size(); ++k) {
+    Slot* s = findSlot(kept[k].key);
+    if (s && s->key == 0) {
+      *s = kept[k];
+      index->count++;
+    }
+  }
+  return true;
+}
+
+/* ==================================================== ===== ======= */
+
+bool UThumbnailCache::get(const UStr& pathname, unsigned long modtime, unsigned long size,
+                          UIma& thumbnail) {
+  if (!lock(false)) return false;
+  unsigned long long key = makeKey(pathname, modtime, size);
+  Slot* s = findSlot(key);
+  bool found = false;
+  int width = 0, height = 0;
+  vector<unsigned char> pixels;
+
+  if (s && s->key == key) {
+    width = s->width;
+    height = s->height;
+    size_t len = size_t(width) * height * 4;
+    pixels.resize(len);
+    found = len > 0 && ::pread(data_fd, &pixels[0], len, s->offset) == (ssize_t)len;
+    // with a shared lock, concurrent updates of the clock may be lost, which
+    // just makes eviction less accurate
+    if (found) s->last_use = ++index->clock;
+  }
+  unlock();
+
+  return found && thumbnail.setRGBA(&pixels[0], width, height);
+}
+
+bool UThumbnailCache::put(const UStr& pathname, unsigned long modtime, unsigned long size,
+                          const UIma& thumbnail) {
+  vector<unsigned char> pixels;
+  int width = 0, height = 0;
+  if (!thumbnail.getRGBA(pixels, width, height)
+      || width > 0xffff || height > 0xffff || pixels.size() > max_size / 2)
+    return false;
+
+  if (!lock(true)) return false;
+  size_t len = pixels.size();
+
+  // evicts the least recently used thumbnails or enlarges the table if needed
+  if (index->data_size + len > max_size) rebuild(index->slot_count, max_size / 2);
+  else if ((index->count + 1) * 4 > index->slot_count * 3) rebuild(index->slot_count * 2, max_size);
+
+  bool stored = false;
+  Slot* s = index ? findSlot(makeKey(pathname, modtime, size)) : null;
+  if (s) {
+    unsigned long long offset = index->data_size;
+    if (::pwrite(data_fd, &pixels[0], len, offset) == (ssize_t)len) {
+      if (s->key == 0) index->count++;
+      s->key = makeKey(pathname, modtime, size);
+      s->offset = offset;
+      s->width = width;
+      s->height = height;
+      s->last_use = ++index->clock;
+      index->data_size = offset + len;
+      stored = true;
+    }
+  }
+  unlock();
+  return stored;
+}
+
+void UThumbnailCache::clear() {
+  if (!lock(true)) return;
+  rebuild(INITIAL_SLOT_COUNT, 0);
+  unlock();
+}
+
+}
@@ -0,0 +1,100 @@
+/* ***********************************************************************
+ *
+ *  uthumbnailcache.hpp: persistent cache of image thumbnails
+ *  Ubit GUI Toolkit - Version 6.0
+ *  (C) 2009 Eric Lecolinet | ENST Paris | www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE :
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE.
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION;
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#ifndef _uthumbnailcache_hpp_
+#define	_uthumbnailcache_hpp_ 1
+#include <ubit/ustr.hpp>
+namespace ubit {
+
+  class UIma;
+
+  /** persistent cache of image thumbnails.
+   * thumbnails are identified by the pathname, the modification time and the size
+   * of the image file, so that a modified file gets a new thumbnail. They are
+   * stored in two files of the cache directory:
+   * - 'index': a hash table that is mapped in memory (fixed size records)
+   * - 'data': the pixels of the thumbnails (RGBA, 8 bits per component)
+   *
+   * The least recently used thumbnails are evicted when the size of the pixel
+   * data exceeds the maximum size. The files are locked when they are accessed,
+   * so that several applications can share the same cache.
+   *
+   * Note: thumbnails are stored as RGBA pixels, which are only available in
+   * OpenGL mode: get() and put() return false otherwise (@see UIma::getRGBA()).
+   */
+  class UThumbnailCache {
+  public:
+    UThumbnailCache(const UStr& dirpath, unsigned long max_size = 64*1024*1024);
+    /**< opens (or creates) the cache that is stored in this directory.
+     * 'max_size' is the maximum size of the pixel data, in bytes.
+     */
+
+    virtual ~UThumbnailCache();
+
+    static UThumbnailCache* getDefault();
+    /**< returns the default cache (null if it can't be opened).
+     * this cache is stored in $XDG_CACHE_HOME/ubit-thumbnails or in
+     * ~/.cache/ubit-thumbnails and is shared by all Ubit applications.
+     */
+
+    bool isOpened() const {return index != null;}
+    ///< returns true if the cache files could be opened.
+
+    bool get(const UStr& pathname, unsigned long modtime, unsigned long size, UIma& thumbnail);
+    /**< loads the thumbnail of this version of this file in 'thumbnail'.
+     * returns false if the thumbnail is not in the cache.
+     */
+
+    bool put(const UStr& pathname, unsigned long modtime, unsigned long size, const UIma& thumbnail);
+    ///< stores the thumbnail of this version of this file.
+
+    void clear();
+    ///< removes all the thumbnails.
+
+    int getCount() const;
+    ///< returns the number of thumbnails in the cache.
+
+    unsigned long getDataSize() const;
+    ///< returns the size of the pixel data (including replaced thumbnails, until they are evicted).
+
+    unsigned long getMaxSize() const {return max_size;}
+
+  private:
+    struct Header;
+    struct Slot;
+    UThumbnailCache(const UThumbnailCache&);
+    UThumbnailCache& operator=(const UThumbnailCache&);
+
+    bool lock(bool exclusive);
+    void unlock();
+    bool mapIndex();
+    void unmapIndex();
+    Slot* findSlot(unsigned long long key) const;
+    bool rebuild(unsigned int slot_count, unsigned long keep_size);
+    static bool moreRecent(const Slot&, const Slot&);
+    static unsigned long long makeKey(const UStr& pathname, unsigned long modtime,
+                                      unsigned long size);
+
+    UStr dirpath;
+    unsigned long max_size;
+    int index_fd, data_fd;
+    Header* index;            // the mapped index file
+    unsigned long index_size; // the size of the mapping
+    unsigned int generation;  // the generation of the data file that is opened
+  };
+
+}
+#endif
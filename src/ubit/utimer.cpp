@@ -194,6 +194,7 @@ timer_no(-1), ntimes(_ntimes), delay(d)
 
 UTimer::~UTimer() {
 #if UBIT_WITH_X11
+  removeTimer();    // fireTimers() would access the deleted timer otherwise
   delete &timeout;
 #elif UBIT_WITH_GDK
   g_source_remove(gid);
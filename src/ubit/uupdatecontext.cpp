@@ -22,10 +22,31 @@
 #include <ubit/uupdatecontext.hpp>
 #include <ubit/uappli.hpp>
 #include <ubit/uflag.hpp>
+#include <ubit/utaskpool.hpp>
 using namespace std;
 #define NAMESPACE_UBIT namespace ubit {
 NAMESPACE_UBIT
 
+static inline bool sameFontDesc(const UFontDesc& f1, const UFontDesc& f2) {
+  return f1.family == f2.family && f1.styles == f2.styles 
+  && f1.def_size == f2.def_size && f1.actual_size == f2.actual_size
+  && f1.findex == f2.findex && f1.scaled_size == f2.scaled_size;
+}
+
+// true if the record was computed with the same inherited values, class style
+// and interactive state
+static bool isComputedStyleValid(const UComputedStyle& cs, const UUpdateContext& parctx,
+                                 const UStyle* style, int state) {
+  return cs.obj_style == style
+  && cs.style_generation == UStyle::generation
+  && cs.state == state
+  && cs.par_color == parctx.color && cs.par_bgcolor == parctx.bgcolor
+  && cs.par_cursor == parctx.cursor
+  && cs.par_xyscale == parctx.xyscale
+  && cs.par_vspacing == parctx.vspacing && cs.par_hspacing == parctx.hspacing
+  && cs.par_valign == parctx.valign && cs.par_halign == parctx.halign
+  && sameFontDesc(cs.par_fontdesc, parctx.fontdesc);
+}
 
 UUpdateContext::UUpdateContext(const UUpdateContext& parctx, 
                                UElem* elm, UView* v, UViewUpdateImpl* vi) :
@@ -36,16 +57,65 @@ obj(elm),
 view(v),
 view_impl(vi),
 obj_style(&obj->getStyle(this)),    // att: le style depend de l'orient 
-local(obj_style->local),            // local props that can't be inherited
 pos(null),
 graph(parctx.graph)
 {
-  obj->emodes.IS_WIDTH_UNRESIZABLE =(local.size.width.modes.val & USize::UNRESIZABLE.val);  
-  obj->emodes.IS_HEIGHT_UNRESIZABLE=(local.size.height.modes.val & USize::UNRESIZABLE.val);
-  
   xyscale = parctx.xyscale;
   boxIsVFlex = (parctx.valign == UValign::FLEX);
   boxIsHFlex = (parctx.halign == UHalign::FLEX);
+  //edit = (style.edit ? style.edit : parp.edit);
+  edit = parctx.edit;  // !!!ATT un button dans un textarea va etre editable A REVOIR !!!
+
+  int state = obj->isSelected() * UOn::ACTION_COUNT + (int)obj->getInterState();
+  UComputedStyle* cs = obj->computed_style;
+  
+  if (UTask::inWorkerThread()) {
+    computeStyle(parctx);   // the cache is only used by the main thread
+  }
+  else if (cs && isComputedStyleValid(*cs, parctx, obj_style, state)) {
+    local = cs->local;
+    valign = cs->valign;
+    halign = cs->halign;
+    vspacing = cs->vspacing;
+    hspacing = cs->hspacing;
+    cursor = cs->cursor;
+    color = cs->color;
+    bgcolor = cs->bgcolor;
+    fontdesc = cs->fontdesc;
+  }
+  else {
+    computeStyle(parctx);
+    if (!cs) cs = obj->computed_style = new UComputedStyle();
+    cs->obj_style = obj_style;
+    cs->style_generation = UStyle::generation;
+    cs->state = state;
+    cs->par_color = parctx.color;
+    cs->par_bgcolor = parctx.bgcolor;
+    cs->par_cursor = parctx.cursor;
+    cs->par_fontdesc = parctx.fontdesc;
+    cs->par_xyscale = parctx.xyscale;
+    cs->par_vspacing = parctx.vspacing;
+    cs->par_hspacing = parctx.hspacing;
+    cs->par_valign = parctx.valign;
+    cs->par_halign = parctx.halign;
+    cs->local = local;
+    cs->valign = valign;
+    cs->halign = halign;
+    cs->vspacing = vspacing;
+    cs->hspacing = hspacing;
+    cs->cursor = cursor;
+    cs->color = color;
+    cs->bgcolor = bgcolor;
+    cs->fontdesc = fontdesc;
+  }
+  
+  obj->setWidthUnresizable(local.size.width.modes.val & USize::UNRESIZABLE.val);
+  obj->setHeightUnresizable(local.size.height.modes.val & USize::UNRESIZABLE.val);
+}
+
+// applies the style of obj to the values inherited from parctx.
+void UUpdateContext::computeStyle(const UUpdateContext& parctx) {
+  local = obj_style->local;            // local props that can't be inherited
 
   // si pas de spec de l'orient prendre celle du style par defaut
   /*
@@ -64,8 +134,6 @@ graph(parctx.graph)
   vspacing = (style.vspacing == UVspacing::INHERIT ? parctx.vspacing/xyscale : style.vspacing);
   hspacing = (style.hspacing == UHspacing::INHERIT ? parctx.hspacing/xyscale : style.hspacing);
   cursor = (style.cursor ? style.cursor : parctx.cursor);
-  //edit = (style.edit ? style.edit : parp.edit);
-  edit = parctx.edit;  // !!!ATT un button dans un textarea va etre editable A REVOIR !!!
 
   color = style.getColor(*obj);
   if (!color || color == &UColor::inherit) color = parctx.color;
@@ -97,6 +165,22 @@ UUpdateContext(win_view) {
   graph = g;
 }
 
+UWinUpdateContext::UWinUpdateContext(const UUpdateContext& ctx) :
+UUpdateContext(ctx) {
+  win_ctx = this;
+  for (int k = 0; k < ctx.flag_count; k++) setFlag(k, ctx.win_ctx->getFlag(k));
+}
+
+// the flags of a context are stored at [0, flag_count[ : a flag added by a 
+// subcontext replaces the flags of the previous subcontexts of the same level
+void UWinUpdateContext::setFlag(int k, const UFlagdef* flagdef) {
+  if (k < FLAG_STACK_SIZE) flags[k] = flagdef;
+  else {
+    more_flags.resize(k - FLAG_STACK_SIZE);
+    more_flags.push_back(flagdef);
+  }
+}
+
 
 UUpdateContext::UUpdateContext(UView* win_view) :
 parent_ctx(null),
@@ -171,7 +255,7 @@ void UUpdateContext::rescale() {
 
 
 void UUpdateContext::addFlagdef(const UFlagdef* flagdef) {
-  win_ctx->flags.push_back(flagdef);
+  win_ctx->setFlag(flag_count, flagdef);
   flag_count++;
 }
 
@@ -181,7 +265,7 @@ const UFlagdef* UUpdateContext::getFlagdef(const UFlag& f) const {
 
 const UFlagdef* UUpdateContext::getFlagdef(const UFlag* f) const {
   for (int k = 0; k < flag_count; k++) {
-    if (win_ctx->flags[k]->getFlag() == f) return win_ctx->flags[k];
+    if (win_ctx->getFlag(k)->getFlag() == f) return win_ctx->getFlag(k);
   }
   return null;  // not found
 }
@@ -199,8 +283,8 @@ const UPropdef* UUpdateContext::getPropdef(const UFlag* f) const {
   
   for (int k = 0; k < flag_count; k++) {
     const UPropdef* pdef = null;
-    if (win_ctx->flags[k]->getFlag() == f
-        && (pdef = dynamic_cast<const UPropdef*>(win_ctx->flags[k]))) {
+    if (win_ctx->getFlag(k)->getFlag() == f
+        && (pdef = dynamic_cast<const UPropdef*>(win_ctx->getFlag(k)))) {
       last_pdef = pdef;
     }
   }
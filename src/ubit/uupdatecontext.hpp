@@ -26,6 +26,34 @@ namespace ubit {
   // ====[internal implementation]=========================================
   // NOTE: this header is part of the Ubit intrinsics and subject to change
   
+  /* [impl] UComputedStyle = flattened result of the style cascade of an element.
+   * UUpdateContext stores this record in UElem::computed_style the first time 
+   * the element is laid out or painted, then reuses it as long as the key is 
+   * unchanged, so that repaint-only passes do not need to merge the fonts and 
+   * resolve the colors and the spacing of each element again.
+   * The key is made of the inherited values of the parent context, the class
+   * style returned by UElem::getStyle(), the interactive state of the element
+   * and UStyle::generation.
+   */
+  struct UComputedStyle {
+    // key
+    const UStyle* obj_style;
+    unsigned long style_generation;
+    int state;                     // selection and interactive state
+    const UColor *par_color, *par_bgcolor;
+    const UCursor* par_cursor;
+    UFontDesc par_fontdesc;
+    float par_xyscale, par_vspacing, par_hspacing;
+    char par_valign, par_halign;
+    // values
+    ULocalProps local;
+    UFontDesc fontdesc;
+    char valign, halign;
+    float vspacing, hspacing;
+    const UColor *color, *bgcolor;
+    const UCursor *cursor;
+  };
+  
   /* [impl] UUpdateContext = a subcontext (not the first layer of the context cstack)
    * and a base for UWinUpdateContext (the first layer of the cstack)
    */
@@ -87,6 +115,7 @@ namespace ubit {
 
   protected:
     friend class UViewFind;
+    void computeStyle(const UUpdateContext& parent_ctx);
     UUpdateContext() {}  // pour UViewFind
     UUpdateContext(UView* win_view); // for UWinUpdateContext
 #endif
@@ -101,10 +130,23 @@ namespace ubit {
     /**< creates the first layer of the context stack
      * !Warning: 'win_view' must be a valid (NOT null) window view!
      */
+    
+    UWinUpdateContext(const UUpdateContext& ctx);
+    /**< creates a copy of 'ctx' that has its own flag stack.
+     * used for laying out subtrees in worker threads (the flags of 'ctx'
+     * are copied so that addFlagdef() does not modify the original stack).
+     */
         
   private:
     friend class UUpdateContext;
-    std::vector<const UFlagdef*> flags;
+    static const int FLAG_STACK_SIZE = 16;
+    const UFlagdef* flags[FLAG_STACK_SIZE];   // preallocated flag stack
+    std::vector<const UFlagdef*> more_flags;  // used if 'flags' is full
+    
+    const UFlagdef* getFlag(int k) const {
+      return k < FLAG_STACK_SIZE ? flags[k] : more_flags[k - FLAG_STACK_SIZE];
+    }
+    void setFlag(int k, const UFlagdef*);
   };
   
   /* ==================================================== ======== ======= */
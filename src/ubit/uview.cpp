@@ -28,6 +28,8 @@
 #include <ubit/ufontmetrics.hpp>
 #include <ubit/uon.hpp>
 #include <ubit/uevent.hpp>
+#include <ubit/ueventlog.hpp>
+#include <ubit/uzoom.hpp>
 using namespace std;
 #define NAMESPACE_UBIT namespace ubit {
 NAMESPACE_UBIT
@@ -58,7 +60,7 @@ UView* UView::createView(UBox* box, UView* parview, UHardwinImpl* w) {
 }
 
 UView::UView(UBox*_box, UView*_parview, UHardwinImpl* w) :
-vmodes(0),
+vmodes(LAYOUT_DAMAGED | CACHE_DAMAGED),
 scale(1.),
 chwidth(0.), chheight(0.),
 edit_shift(0.),
@@ -67,6 +69,14 @@ parview(_parview), box(_box), hardwin(w),
 next(null) {
 }
 
+void UView::setLayoutDamaged() {
+  for (UView* v = this; v != null; v = v->parview) v->vmodes |= LAYOUT_DAMAGED;
+}
+
+void UView::setCacheDamaged() {
+  for (UView* v = this; v != null; v = v->parview) v->vmodes |= CACHE_DAMAGED;
+}
+
 UView::~UView() {
   addVModes(DESTRUCTED);  // this view has been destructed
   for (UViewProps::iterator i = props.begin(); i != props.end(); ++i) delete (*i);  
@@ -263,6 +273,7 @@ void UView::updatePaintData(const URect* winrect) {     // window coordinates
 void UView::updatePaint(const URect* winrect) {     // window coordinates
   UView* winview = getWinView();
   if (!winview) return;
+  UEventProfile::Scope profile(UEventProfile::PAINT);   // see UEventReplayer
   if (!winrect) winrect = this;
 
   // !ATT: paint impossible sur winrect vide: peut poser probleme pour maj des donnees
@@ -295,6 +306,7 @@ void UView::updatePaint(const URect* winrect) {     // window coordinates
 void UView::updateLayout(const UDimension* size, bool upd_paint_data) {
   UView* winview = getWinView();
   if (!winview) return;
+  UEventProfile::Scope profile(UEventProfile::LAYOUT);
   
   UViewLayout vl;
   UWinUpdateContext winctx1(winview, null);
@@ -394,6 +406,10 @@ UView* UView::findInBox(UBox* box, const UPoint& wpos,
 
   UUpdateContext ctx(par_ctx, box, this, null);
   UMultiList mlist(ctx, *box);   // necessaire pour parser ctx
+
+  // the children of collapsed boxes are not displayed (see ULod)
+  bool collapsed = ctx.local.lod && ctx.local.lod->isCollapsed(ctx.xyscale);
+  if (collapsed && ctx.local.lod->getMode() == ULod::HIDE) return null;
   vf.updateProps(this, box, ctx);  // !ATT evprops n'est plus recopie
   
   // si c'est une hardwin, chercher si l'event est dans ses softwins
@@ -435,6 +451,8 @@ UView* UView::findInBox(UBox* box, const UPoint& wpos,
     }
   }
   
+  if (collapsed) goto FOUND;
+  
   {// sinon chercher si l'event est dans les enfants
     UView* v = findInChildren(box, wpos, ctx, vf);
     if (v) return v;
@@ -217,7 +217,13 @@ namespace ubit {
       REALIZED_CHILDREN = 1<<6, // the children of this view have been realized (for win views only)
       POS_HAS_CHANGED  = 1<<9,  // position has changed => geometry must be updated
       SIZE_HAS_CHANGED = 1<<10, // size has changed => geometry must be updated
-      NO_DOUBLE_BUFFER = 1<< 11 
+      NO_DOUBLE_BUFFER = 1<< 11,
+      // the layout of this view or of one of its descendants has been updated 
+      // since it was cached (used by UTableView to reuse the sizes of its cells)
+      LAYOUT_DAMAGED = 1<<12,
+      // the paint of this view or of one of its descendants has been updated
+      // since it was cached (used by ULod and ULayer to discard their bitmaps)
+      CACHE_DAMAGED = 1<<13
       // !BEWARE: no comma after last item!
     };
     
@@ -238,6 +244,12 @@ namespace ubit {
     void addVModes(long modes) {vmodes |= modes;}
     // add these modes to the V-Modes bitmask.
     
+    void setLayoutDamaged();
+    // adds the LAYOUT_DAMAGED mode to this view and its parent views.
+    
+    void setCacheDamaged();
+    // adds the CACHE_DAMAGED mode to this view and its parent views.
+    
     void removeVModes(long modes) {vmodes &= ~modes;}
     // remove these modes from the V-Modes bitmask.
     
@@ -290,7 +302,8 @@ namespace ubit {
     virtual bool updatePos(UViewUpdateImpl&, UElem&, UUpdateContext& curctx,
                            URect& r, URect& clip, UViewUpdate&);
     
-    virtual void beginUpdate3d(UViewUpdateImpl&, UElem&, UUpdateContext& curctx);
+    virtual bool beginUpdate3d(UViewUpdateImpl&, UElem&, UUpdateContext& curctx, const URect& r);
+    // returns false if the element is outside the view frustum of its U3Dcanvas.
     virtual void endUpdate3d(UViewUpdateImpl&, UElem&, UUpdateContext& curctx);
     
     virtual UView* findInBox(UBox*, const UPoint& winpos, const UUpdateContext&, UViewFind&);
@@ -16,6 +16,7 @@
 
 #ifndef _uviewImpl_hpp_
 #define	_uviewImpl_hpp_ 1
+#include <map>
 #include <ubit/uevent.hpp>
 #include <ubit/uborder.hpp>
 #include <ubit/uupdatecontext.hpp>
@@ -66,6 +67,45 @@ namespace ubit {
     UViewBorderProp() : UPaddingSpec(0,0) {}
   };
   
+  // level of detail of a box that has a ULod attribute.
+  // 'chwidth' and 'chheight' are the size of the content at scale 1, as computed
+  // by the last full layout; 'collapsed' is true if the content was not laid out
+  // by the last layout (its views then have obsolete sizes and positions).
+  // 'impostors' are the bitmaps of the box for a few scale buckets; 'expand' is
+  // set while the content is laid out so that the box can be cached.
+  struct UViewLodProp : public UViewProp {
+    enum {MAX_IMPOSTORS = 8};
+    
+    UViewLodProp() : has_size(false), collapsed(false), expand(false), no_impostor(false),
+    style_generation(0), chwidth(0), chheight(0) {}
+    virtual ~UViewLodProp() {clearImpostors();}
+    
+    static int getBucket(float scale);   // a quarter of an octave
+    UIma* getImpostor(float scale);      // null if none in this bucket
+    void addImpostor(UIma*, float scale);
+    void clearImpostors();
+    
+    bool has_size, collapsed, expand;
+    bool no_impostor;    // the pixels of the display can't be read
+    unsigned long style_generation;
+    float chwidth, chheight;
+    std::map<int, UIma*> impostors;     // indexed by bucket
+  };
+  
+  // bitmap of a box that has a ULayer attribute. 'rect' is the location of the
+  // box in the window when it was cached: the bitmap can only be drawn at the same
+  // location as the children are not laid out again.
+  struct UViewLayerProp : public UViewProp {
+    UViewLayerProp() : ima(null), valid(false), no_cache(false) {}
+    virtual ~UViewLayerProp() {clear();}
+    void clear();
+    
+    UIma* ima;
+    URect rect;
+    bool valid;          // false if ima is outdated (it is then reused by the next capture)
+    bool no_cache;       // the pixels of the display can't be read
+  };
+  
   // used by to force position.
   //struct UViewForcePosProp : public UViewProp {
   //  UViewForcePosProp() : x(0), y(0) {}
@@ -559,7 +559,7 @@ void UFlowView::doUpdate(UUpdateContext& parctx, URect r, URect clip, UViewUpdat
       size.height.toPixels(ctx.getDisp(), ctx.fontdesc, vd.view->height, 
                            ctx.parent_ctx->view_impl->height);
     
-    if (g && g->in_3d_mode) beginUpdate3d(vd, box, ctx);
+    if (g && g->in_3d_mode && !beginUpdate3d(vd, box, ctx, r)) return;
 
     if (g && box.isSubWin() && vup.mode < UViewUpdate::UPDATE_DATA) {      
       // subwindows must NOT be painted recursively:
@@ -24,6 +24,8 @@
 #include <ubit/uviewImpl.hpp>
 #include <ubit/uappli.hpp>
 #include <ubit/uscrollpane.hpp>
+#include <ubit/uzoom.hpp>
+#include <ubit/utaskpool.hpp>
 using namespace std;
 namespace ubit {
 
@@ -235,6 +237,103 @@ static void hintElemBorder(UViewLayoutImpl& vd, const UUpdateContext& curp,
                            const UViewLayout& chvl, UElem* box);
 
 /* ==================================================== ======== ======= */
+// Parallel layout (see UConf::parallel_layout)
+
+// lays out a child box in a worker thread. The task has its own copy of the
+// parent context (hence its own flag stack). The child views only modify
+// themselves and their descendants: the parent view is only modified by the
+// hintElem*() functions, which are called by the main thread. The elements
+// are not modified (they may be shared by several subtrees, see
+// UElem::setWidthUnresizable()).
+class UChildLayoutTask : public UTask {
+public:
+  UChildLayoutTask(UUpdateContext& _curp, UElem* _child, UView* _view) :
+  curp(&_curp), child(_child), view(_view), must_layout_again(false) {}
+  
+  virtual void run() {
+    UWinUpdateContext ctx(*curp);
+    must_layout_again = view->doLayout(ctx, chvl);
+  }
+  
+  UUpdateContext* curp;
+  UElem* child;
+  UView* view;
+  UViewLayout chvl;
+  bool must_layout_again;
+};
+
+static UTaskPool& getLayoutPool() {
+  static UTaskPool* pool = new UTaskPool();
+  return *pool;
+}
+
+// lays out the children of 'grp' in parallel if they all are non floating
+// block boxes that appear once in 'grp'. Returns false (and does nothing)
+// otherwise. The results are merged in the order of the children so that
+// the layout is the same as in the sequential case. Tasks that need the main
+// thread (eg. for realizing fonts or loading images) are performed again by
+// the main thread.
+static bool doParallelLayout(UViewLayoutImpl& vd, UMultiList& mlist, UElem& grp,
+                             UUpdateContext& curp, bool is_pane) {
+  if (mlist.in_softwin_list) return false;
+  std::vector<UChildLayoutTask> tasks;
+  
+  for (UChildIter ch = mlist.begin(); ch != mlist.end(); mlist.next(ch)) {
+    UElem* chgrp = (*ch)->toElem();
+    if (ch.getCond() || !chgrp) return false;   // conditions, attributes, data
+    if (!chgrp->isShowable()) continue;
+    UBox* boxgrp = chgrp->toBox();
+    UView* chboxview = null;
+    if (!boxgrp || chgrp->getDisplayType() != UElem::BLOCK || chgrp->isFloating()
+        || !(chboxview = boxgrp->getViewInImpl(vd.view)))
+      return false;
+    // a box that appears several times in grp has a single view in this view
+    if (++chgrp->pbegin() != chgrp->pend()) {
+      for (unsigned int k = 0; k < tasks.size(); ++k)
+        if (tasks[k].view == chboxview) return false;
+    }
+    tasks.push_back(UChildLayoutTask(curp, chgrp, chboxview));
+  }  
+  if (tasks.size() < 2) return false;
+  
+  UTaskPool& pool = getLayoutPool();
+  UTaskGroup group;
+  for (unsigned int k = 0; k < tasks.size(); ++k) pool.submit(&tasks[k], group);
+  pool.wait(group);
+  
+  for (unsigned int k = 0; k < tasks.size(); ++k) {
+    UChildLayoutTask& t = tasks[k];
+    if (t.isMainThreadRequired()) {
+      t.chvl = UViewLayout();
+      t.must_layout_again = t.view->doLayout(curp, t.chvl);
+    }
+    vd.mustLayoutAgain |= t.must_layout_again;
+    if (is_pane)
+      hintElemViewport(vd, curp, t.chvl, t.child);
+    else if (vd.orient == UOrient::VERTICAL)
+      hintElemVert(vd, curp, t.chvl, t.child);
+    else
+      hintElemHoriz(vd, curp, t.chvl, t.child);
+  }
+  return true;
+}
+
+/* ==================================================== ======== ======= */
+
+// returns true if the content of a box that has a ULod must not be laid out:
+// the box is collapsed at this scale and its content has not changed since its
+// last full layout (and, for impostors, the box does not need to be cached).
+static bool isLodCollapsed(UViewLayoutImpl& vd, const UUpdateContext& curp,
+                           UViewLodProp*& lp) {
+  const ULod* lod = curp.local.lod;
+  vd.view->obtainProp(lp);
+  lp->collapsed = lod->isCollapsed(curp.xyscale) && lp->has_size
+  && !vd.view->hasVMode(UView::LAYOUT_DAMAGED)
+  && lp->style_generation == UStyle::generation
+  && (lod->getMode() != ULod::IMPOSTOR
+      || (!lp->no_impostor && !lp->expand));
+  return lp->collapsed;
+}
 
 void UView::doLayout2(UViewLayoutImpl& vd, UElem& grp, UUpdateContext& curp, UViewLayout& vl) {
   UMultiList mlist(curp, grp);
@@ -243,6 +342,8 @@ void UView::doLayout2(UViewLayoutImpl& vd, UElem& grp, UUpdateContext& curp, UVi
   
   bool is_pane  = dynamic_cast<UScrollpane*>(&grp);  // !!!@@@ A REVOIR !!!
   bool is_border = grp.getDisplayType() == UElem::BORDER; // !!!@@@ A REVOIR !!!
+  UViewLodProp* lp = null;
+  bool collapsed = grp.toBox() && curp.local.lod && isLodCollapsed(vd, curp, lp);
   UNode* b = null;
   UElem* chgrp = null;
   UView* chboxview = null;
@@ -256,12 +357,23 @@ void UView::doLayout2(UViewLayoutImpl& vd, UElem& grp, UUpdateContext& curp, UVi
   // if this group is not null (which generally is the case) the object
   // it contains are added to children for normal display
   // (can for instance be used for adding list-item markers, checkboxes...
-  if (curp.local.content) {
+  if (curp.local.content && !collapsed) {
     UElem* content = curp.local.content;
     curp.local.content = null;	// avoid infinite recursion
     doLayout2(vd, *content, curp, vl);    // pas de curp, meme vd
   }
 
+  // the children are laid out by worker threads if possible (the children
+  // of the boxes that are laid out by worker threads are laid out sequentially)
+  bool parallel = !collapsed && UAppli::conf.parallel_layout && !is_border 
+  && !UTask::inWorkerThread() && doParallelLayout(vd, mlist, grp, curp, is_pane);
+  
+  // the content of collapsed boxes keeps the size of the last full layout
+  if (collapsed) {
+    vd.chwidth  = lp->chwidth * curp.xyscale;
+    vd.chheight = lp->chheight * curp.xyscale;
+  }
+  else if (!parallel)
   for (UChildIter ch = mlist.begin(); ch != mlist.end(); mlist.next(ch))
     // NB: null cond means always
     if (!ch.getCond() || ch.getCond()->verifies(curp, grp)) {
@@ -339,6 +451,16 @@ void UView::doLayout2(UViewLayoutImpl& vd, UElem& grp, UUpdateContext& curp, UVi
     // la suite ne concerne pas les UElem
     if (grp.toBox()) {
 
+    // size of the content at scale 1, used when the box is collapsed (see ULod)
+    // (not when the content is only laid out for being cached)
+    if (lp && !collapsed && !lp->expand) {
+      lp->chwidth  = max(vd.chwidth, vd.pos_chwidth) / curp.xyscale;
+      lp->chheight = max(vd.chheight, vd.pos_chheight) / curp.xyscale;
+      lp->has_size = true;
+      lp->style_generation = UStyle::generation;
+      vd.view->removeVModes(UView::LAYOUT_DAMAGED);
+    }
+
     // Border and Box size
     UPaddingSpec padding(0, 0);
       
@@ -16,6 +16,7 @@
 
 #include <ubit/ubit_features.h>
 #include <iostream>
+#include <cmath>
 #include <ubit/uon.hpp>
 #include <ubit/uupdatecontext.hpp>
 #include <ubit/uboxgeom.hpp>
@@ -29,6 +30,7 @@
 #include <ubit/uscrollpane.hpp>
 #include <ubit/uappli.hpp>
 #include <ubit/uborder.hpp>
+#include <ubit/uzoom.hpp>
 using namespace std;
 #define NAMESPACE_UBIT namespace ubit {
 NAMESPACE_UBIT
@@ -439,6 +441,14 @@ bool UView::updatePos(UViewUpdateImpl& vd, UElem& grp, UUpdateContext& ctx,
   return true;
 }
 
+static bool updateLod(UViewUpdateImpl&, UUpdateContext&,
+                      const URect& r, const URect& clip, UViewLodProp*&, bool& capture);
+static void captureLod(UGraph&, UUpdateContext&, const URect& r, const URect& clip,
+                       UViewLodProp*);
+static bool updateLayer(UViewUpdateImpl&, UUpdateContext&, const URect& r,
+                        UViewLayerProp*&, bool& capture);
+static void captureLayer(UGraph&, const URect& r, const URect& clip, UViewLayerProp*);
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // - mode SearchData: juste recuperer l'data et sa position sans redessiner
 //   !ATT il faut IMPERATIVEMENT data_props != null dans le mode SearchData !
@@ -452,6 +462,9 @@ void UView::doUpdate2(UViewUpdateImpl& vd, UElem& grp, UUpdateContext& ctx,
   bool is_border = grp.getDisplayType() == UElem::BORDER;
   UGraph* g = ctx.getGraph();   // g can be null !
   bool is_pane = false;
+  UViewLodProp* lp = null;
+  UViewLayerProp* layp = null;
+  bool lod_capture = false, layer_capture = false;
 
   if (ctx.xyscale != 1.) ctx.rescale();
   scale = ctx.xyscale;
@@ -472,7 +485,8 @@ void UView::doUpdate2(UViewUpdateImpl& vd, UElem& grp, UUpdateContext& ctx,
     size.height.toPixels(ctx.getDisp(), ctx.fontdesc, vd.view->height, 
                          ctx.parent_ctx->view_impl->height);
   
-  if (g && g->in_3d_mode) beginUpdate3d(vd, grp, ctx);
+  // the children of U3Dcanvas that are not in the view frustum are not painted
+  if (g && g->in_3d_mode && !beginUpdate3d(vd, grp, ctx, r)) return;
   
   if (grp.toBox()) {      // only for Boxes
     vd.edit = ctx.edit;
@@ -491,6 +505,17 @@ void UView::doUpdate2(UViewUpdateImpl& vd, UElem& grp, UUpdateContext& ctx,
       g->setHardwinClip(clip);
     }
     
+    // collapsed boxes (see ULod) are drawn in a cheaper way: neither their
+    // content nor their border is painted and their callbacks are not called
+    if (ctx.local.lod && ctx.local.lod->isCollapsed(ctx.xyscale)
+        && updateLod(vd, ctx, r, clip, lp, lod_capture))
+      goto END_CACHED;
+    
+    // cached boxes (see ULayer) are drawn from their bitmap if it is still valid
+    if (ctx.local.layer && ctx.local.layer->isCached() && !lod_capture
+        && updateLayer(vd, ctx, r, layp, layer_capture))
+      goto END_CACHED;
+    
     // orientation should not be taken into account in UElems
     vd.orient = grp.isVertical() ? UOrient::VERTICAL : UOrient::HORIZONTAL;
 
@@ -783,10 +808,200 @@ void UView::doUpdate2(UViewUpdateImpl& vd, UElem& grp, UUpdateContext& ctx,
       }
     }
   }
-      
+  
+  if (lod_capture) captureLod(*g, ctx, r, clip, lp);
+  else if (layer_capture) captureLayer(*g, r, clip, layp);
+  
+ END_CACHED:
   if (g && g->in_3d_mode) endUpdate3d(vd, grp, ctx);
 }
 
+// ==================================================== [Ubit Toolkit] =========
+// level of detail (see ULod).
+
+int UViewLodProp::getBucket(float scale) {
+  return int(floor(log(scale) / log(2.) * 4));
+}
+
+UIma* UViewLodProp::getImpostor(float scale) {
+  std::map<int, UIma*>::iterator i = impostors.find(getBucket(scale));
+  return i == impostors.end() ? null : i->second;
+}
+
+// the impostor whose bucket is the farthest from this one is discarded if needed
+void UViewLodProp::addImpostor(UIma* ima, float scale) {
+  int bucket = getBucket(scale);
+  std::map<int, UIma*>::iterator i = impostors.find(bucket);
+  if (i != impostors.end()) {delete i->second; impostors.erase(i);}
+  
+  if (impostors.size() >= MAX_IMPOSTORS) {
+    std::map<int, UIma*>::iterator first = impostors.begin(), last = --impostors.end();
+    i = (bucket - first->first > last->first - bucket) ? first : last;
+    delete i->second;
+    impostors.erase(i);
+  }
+  impostors[bucket] = ima;
+}
+
+void UViewLodProp::clearImpostors() {
+  for (std::map<int, UIma*>::iterator i = impostors.begin(); i != impostors.end(); ++i)
+    delete i->second;
+  impostors.clear();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// draws a box that is collapsed at this scale. returns true if its content must
+// not be painted (nor searched), false if the box must be painted normally, in
+// which case 'capture' is set to true if it must then be cached as an impostor.
+
+static bool updateLod(UViewUpdateImpl& vd, UUpdateContext& ctx,
+                      const URect& r, const URect& clip, UViewLodProp*& lp, bool& capture) {
+  const ULod* lod = ctx.local.lod;
+  UGraph* g = ctx.getGraph();
+  vd.view->getProp(lp);   // null if the box has not yet been laid out
+  // true if the content was not laid out by the last layout
+  bool obsolete = lp && lp->collapsed;
+  
+  if (lod->getMode() == ULod::HIDE) return true;
+  
+  if (lod->getMode() == ULod::IMPOSTOR && lp && !lp->no_impostor
+      && !(g && g->in_3d_mode)) {
+    if (vd.can_paint && vd.view->hasVMode(UView::CACHE_DAMAGED)) {
+      lp->clearImpostors();
+      vd.view->removeVModes(UView::CACHE_DAMAGED);
+    }
+    UIma* ima = lp->getImpostor(ctx.xyscale);
+    if (ima) {
+      // the size of the box may slightly differ from the size of the bitmap
+      // (texts are not scaled linearly)
+      if (vd.can_paint) g->drawIma(*ima, r.x, r.y, r.width / ima->getWidth());
+      return true;
+    }
+    if (!vd.can_paint) return obsolete;
+    
+    if (obsolete) {
+      // the content was not laid out at this scale: it must be laid out now so
+      // that it can be painted (the box keeps its current size)
+      UWinUpdateContext parctx(*ctx.parent_ctx);   // own flag stack
+      UViewLayout vl;
+      float w = vd.view->width, h = vd.view->height;
+      lp->expand = true;
+      vd.view->doLayout(parctx, vl);
+      lp->expand = false;
+      vd.view->width = w;
+      vd.view->height = h;
+    }
+    capture = true;      // paint the content, then cache it
+    return false;
+  }
+  else if (lod->getMode() == ULod::IMPOSTOR && !obsolete) 
+    return false;
+  
+  if (vd.can_paint) {
+    const UColor* c = lod->getColor();
+    if (!c && ctx.local.background) c = ctx.local.background->getColor();
+    if (!c && ctx.bgcolor && !ctx.bgcolor->equals(UColor::none)) c = ctx.bgcolor;
+    if (!c) c = ctx.color;
+    if (ctx.local.alpha == 1.) g->setColor(*c);
+    else g->setColor(*c, ctx.local.alpha);
+    g->fillRect(clip.x, clip.y, clip.width, clip.height);
+  }
+  return true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// returns the bitmap of a box that has just been painted, null if the box is not
+// entirely visible or if the pixels of the display can't be read (in which case
+// 'unreadable' is set to true). 'ima' is reused if not null (its texture is then
+// updated rather than created again if it has the same size).
+
+static UIma* readBitmap(UGraph& g, const URect& r, const URect& clip, bool& unreadable,
+                        UIma* ima = null) {
+  int w = int(r.width + 0.5), h = int(r.height + 0.5);
+  if (w <= 0 || h <= 0 || clip.width < r.width || clip.height < r.height) return null;
+  
+  // the box must also be inside the window (the clip may exceed it)
+  float xwin = 0, ywin = 0;
+  g.getWinOffset(xwin, ywin);
+  UDimension wsize = g.getHardwin() ? g.getHardwin()->getSize() : UDimension(0, 0);
+  if (xwin + r.x < 0 || ywin + r.y < 0
+      || xwin + r.x + w > wsize.width || ywin + r.y + h > wsize.height) return null;
+  
+  std::vector<unsigned char> pixels;
+  if (!g.readPixels(r.x, r.y, w, h, pixels)) {
+    unreadable = true;
+    return null;
+  }
+  UIma* newima = ima ? null : (ima = new UIma());
+  if (!ima->setRGBA(&pixels[0], w, h)) {
+    delete newima;
+    unreadable = true;
+    return null;
+  }
+  return ima;
+}
+
+static void captureLod(UGraph& g, UUpdateContext& ctx, const URect& r, const URect& clip,
+                       UViewLodProp* lp) {
+  if (!lp) return;
+  // no_impostor is set if the pixels can't be read: boxes will be painted normally
+  UIma* ima = readBitmap(g, r, clip, lp->no_impostor);
+  if (ima) lp->addImpostor(ima, ctx.xyscale);
+}
+
+// ==================================================== [Ubit Toolkit] =========
+// cached boxes (see ULayer).
+
+void UViewLayerProp::clear() {
+  delete ima;
+  ima = null;
+  valid = false;
+}
+
+// draws a cached box from its bitmap. returns true if its content must not be
+// painted, false if the box must be painted normally, in which case 'capture'
+// is set to true if its bitmap must then be cached.
+
+static bool updateLayer(UViewUpdateImpl& vd, UUpdateContext& ctx, const URect& r,
+                        UViewLayerProp*& layp, bool& capture) {
+  UGraph* g = ctx.getGraph();
+  // the content must be traversed if it is not painted (e.g. for searching data)
+  if (!vd.can_paint || !g || g->in_3d_mode) return false;
+  
+  vd.view->obtainProp(layp);
+  if (layp->no_cache) return false;
+  
+  // the box or one of its descendants was updated since the box was cached.
+  // the bitmap is kept to be reused by captureLayer()
+  if (vd.view->hasVMode(UView::CACHE_DAMAGED)) {
+    layp->valid = false;
+    vd.view->removeVModes(UView::CACHE_DAMAGED);
+  }
+  
+  // the positions of the children are not updated when the bitmap is drawn
+  if (layp->valid && layp->ima && layp->rect.x == r.x && layp->rect.y == r.y
+      && layp->rect.width == r.width && layp->rect.height == r.height) {
+    g->drawIma(*layp->ima, r.x, r.y);
+    return true;
+  }
+  
+  layp->valid = false;
+  capture = true;      // paint the box, then cache it
+  return false;
+}
+
+static void captureLayer(UGraph& g, const URect& r, const URect& clip,
+                         UViewLayerProp* layp) {
+  if (!layp) return;
+  UIma* ima = readBitmap(g, r, clip, layp->no_cache, layp->ima);
+  if (!ima) layp->clear();
+  else {
+    layp->ima = ima;
+    layp->valid = true;
+  }
+  layp->rect = r;
+}
+
 // ==================================================== [Ubit Toolkit] =========
 
 void UView::initLayoutH(UViewUpdateImpl& vd, const UUpdateContext& ctx, const URect& r) 
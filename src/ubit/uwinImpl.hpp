@@ -144,6 +144,13 @@ namespace ubit {
     virtual void setClassProperty(const UStr& instance_name, const UStr& class_name) = 0;
     ///< changes the WM_CLASS property when X11 is used.
     
+    virtual void shiftExposes(const URect& area, float dx, float dy) {}
+    /**< shifts the pending exposures that intersect this area by (dx, dy).
+     * must be called when the pixels of 'area' are moved by UGraph::copyArea():
+     * the damaged pixels are moved too, so that they must be repainted at their
+     * new location (the exposures are also kept at their old location).
+     */
+    
   private:
     UHardwinImpl(const UHardwinImpl&);
     UHardwinImpl& operator=(const UHardwinImpl&);
@@ -31,6 +31,43 @@ bool UInscale::verifies(const UUpdateContext& ctx, const UElem&) const {
   return (ctx.xyscale >= smin && ctx.xyscale <= smax);
 }
 
+// ==================================================== [Ubit Toolkit] =========
+// collapsed boxes are laid out in UView::doLayout2() and painted in UView::doUpdate2()
+
+ULod::ULod(float _min_scale, Mode _mode) : min_scale(_min_scale), mode(_mode) {}
+
+ULod::ULod(float _min_scale, const UColor& c) : 
+min_scale(_min_scale), mode(FILL), color(new UColor(c)) {}
+
+ULod& ULod::setMinScale(float s) {
+  if (checkConst() || min_scale == s) return *this;
+  min_scale = s;
+  changed();
+  return *this;
+}
+
+ULod& ULod::setMode(Mode m) {
+  if (checkConst() || mode == m) return *this;
+  mode = m;
+  changed();
+  return *this;
+}
+
+ULod& ULod::setColor(const UColor& c) {
+  if (checkConst()) return *this;
+  color = new UColor(c);
+  changed();
+  return *this;
+}
+
+void ULod::putProp(UUpdateContext* props, UElem&) {
+  props->local.lod = this;
+}
+
+void ULod::update() {
+  updateAutoParents(UUpdate::LAYOUT_PAINT);
+}
+
 // ==================================================== [Ubit Toolkit] =========
 
 UZoommenu::UZoommenu(UBox& zoomed_box, UBox& panned_box) :
@@ -19,6 +19,7 @@
 #include <ubit/ucond.hpp>
 #include <ubit/ubox.hpp>
 #include <ubit/uctlmenu.hpp>
+#include <ubit/ucolor.hpp>
 namespace ubit {
   
   class UZoommenu;
@@ -124,6 +125,74 @@ namespace ubit {
   
   inline UInscale& uinscale(float smin, float smax) {return *new UInscale(smin,smax);}
   ///< shOrtcut for *new UInscale().
-  
+
+
+  // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  /** Level of detail of a box at small scales.
+   * a box that has a ULod attribute is "collapsed" when its scale (see UScale
+   * and UZoompane) is lower than 'min_scale': its content is then replaced by
+   * a cheaper representation that depends on 'mode':
+   * - FILL: the box is filled with the color of the ULod (or, if none, with its
+   *   background color, or with its foreground color if it has no background)
+   * - IMPOSTOR: the box is painted normally once, then the bitmap of the box is
+   *   drawn instead of its content. Bitmaps are cached for each scale bucket
+   *   (a quarter of an octave) and are discarded when the box or one of its
+   *   descendants is updated
+   * - HIDE: nothing is drawn
+   *
+   * Collapsed boxes keep the size they had when they were last laid out (multiplied
+   * by the new scale): their content is not laid out again, which is what makes
+   * it possible to zoom out over thousands of boxes interactively. Collapsed boxes
+   * catch the events that would have been sent to their children, except hidden
+   * boxes, which ignore events.
+   * example:
+   * <pre>
+   *    UZoompane& zp = uzoompane();
+   *    zp.viewport().add(ubox(ulod(0.5, ULod::IMPOSTOR) + ulabel("Hello World!")));
+   * </pre>
+   *
+   * Note: IMPOSTOR requires a display whose pixels can be read back (OpenGL or
+   * headless display). Boxes are painted normally otherwise.
+   */
+  class ULod : public UAttr {
+  public:
+    UCLASS(ULod)
+
+    enum Mode {FILL, IMPOSTOR, HIDE};
+
+    ULod(float min_scale = 0., Mode mode = FILL);
+    ///< creates a new level of detail attribute; see also shortcut ulod().
+
+    ULod(float min_scale, const UColor& fill_color);
+    ///< the box is filled with this color when it is collapsed.
+
+    bool  isCollapsed(float scale) const {return scale < min_scale;}
+    ///< returns true if the box is collapsed at this scale.
+
+    float getMinScale() const {return min_scale;}
+    Mode  getMode() const {return mode;}
+    const UColor* getColor() const {return color;}
+
+    ULod& setMinScale(float);
+    ULod& setMode(Mode);
+    ULod& setColor(const UColor&);
+
+    virtual void update();
+
+  private:
+    float min_scale;
+    Mode mode;
+    uptr<UColor> color;
+    virtual void putProp(UUpdateContext*, UElem&);
+  };
+
+  inline ULod& ulod(float min_scale, ULod::Mode mode = ULod::FILL)
+  {return *new ULod(min_scale, mode);}
+  ///< shortcut for *new ULod().
+
+  inline ULod& ulod(float min_scale, const UColor& fill_color)
+  {return *new ULod(min_scale, fill_color);}
+  ///< shortcut for *new ULod().
+
 }
 #endif
@@ -27,6 +27,7 @@ using namespace std;
 const int Calibration::CROSS_XYPOS = 50;
 const int Calibration::CROSS_SIZE  = 300 ;
 const float Calibration::SCREEN_SIZE_PERCENT = 0.9;
+const unsigned long Calibration::TIMEOUT = 2*60*1000;  // 2 mn
 
 /* ==================================================== ======== ======= */
 // CALIBRATION
@@ -45,6 +46,7 @@ Calibration::Calibration(UMServer* _ums) : ums(*_ums) {
   is_calibrating = false;
   is_completed = false;
   curpoint = 0;
+  timeout = null;
   x = y = 0;
   width = height = 0;
 
@@ -113,10 +115,38 @@ void Calibration::startCalibration(const char* calwin_title) {
   XFlush(disp);
 
   configureCalibrationWin(x, y, width, height);
+  restartTimeout();
   cout << "*** Starting Calibration" << endl;
 
 }
 
+/* ==================================================== ======== ======= */
+// the calibration window would otherwise remain on the screen (and get
+// the events of the device) if the calibration is not completed
+
+static void timeoutCB(void* data) {
+  Calibration* c = (Calibration*)data;
+  c->timeout = null;     // the timer is deleted by the wheel
+  cout << " - No calibration point set since " << Calibration::TIMEOUT/1000
+       << " sec" << endl;
+  c->cancelCalibration();
+}
+
+void Calibration::restartTimeout() {
+  ums.timers.remove(timeout);
+  timeout = ums.timers.add(UMServer::getTime(), TIMEOUT, timeoutCB, this);
+}
+
+void Calibration::cancelCalibration() {
+  ums.timers.remove(timeout);
+  timeout = null;
+  if (!is_calibrating) return;
+  is_calibrating = false;
+  XUnmapWindow(ums.getDisplay(), calwin);
+  XFlush(ums.getDisplay());
+  cout << " - Calibration cancelled" << endl << endl;
+}
+
 /* ==================================================== ======== ======= */
 
 void Calibration::configureCalibrationWin(int calwin_x, int calwin_y,
@@ -195,8 +225,11 @@ void Calibration::setCalibrationPoint(double _x, double _y) {
     ycm[curpoint] = _y;
     curpoint++;
     drawCalibrationPoint();
+    restartTimeout();
   }
   else {
+    ums.timers.remove(timeout);
+    timeout = null;
     is_calibrating = false;
     is_completed = true;
     XUnmapWindow(disp, calwin);
@@ -212,6 +245,7 @@ void Calibration::unsetLastCalibrationPoint() {
     ycm[curpoint] = 0;
   }
   drawCalibrationPoint();
+  if (is_calibrating) restartTimeout();
 }
 
 /* ==================================================== [TheEnd] ======= */
@@ -17,6 +17,7 @@
 #ifndef _umscalib_hpp_
 #define	_umscalib_hpp_
 #include <X11/Xlib.h>
+#include "timers.hpp"
 
 /**settings of the calibration window
 * (used for absolute positioning devices such as the MIMIO)
@@ -26,6 +27,7 @@ struct Calibration {
   static const int CROSS_XYPOS;
   static const int CROSS_SIZE;
   static const float SCREEN_SIZE_PERCENT;
+  static const unsigned long TIMEOUT;  ///< cancels the calibration if no point is set.
 
   Calibration(class UMServer*);
 
@@ -35,6 +37,8 @@ struct Calibration {
   void setCalibrationPoint(double x, double y);
   void unsetLastCalibrationPoint();
   void drawCalibrationPoint();
+  void cancelCalibration();
+  void restartTimeout();
 
   class UMServer& ums;
   WindowID calwin;
@@ -46,6 +50,7 @@ struct Calibration {
   double xcm[POINT_COUNT], ycm[POINT_COUNT];   ///< position of calpoints in source coords
   int msg_x, msg_y;
   unsigned long black_pixel, red_pixel;
+  TimerWheel::Timer* timeout;  ///< null if the calibration is not running.
 };
 
 #endif
@@ -297,21 +297,8 @@ void MIMIOFrame::pressPen() {
   double pen_x = 0, pen_y = 0;
   if (geo.getPos(shorts[0], shorts[1], pen_x, pen_y)) {
     if (!calibrated) {
-      Calibration* calib = mflow.ums.getCalibration();
-      if (!calib) {
-        clog << "UMServer::pressPen: Error: no calibration Window!" << endl;
-        return;
-      }
-
-      if (pen_id >= 1 && pen_id <= 4)  // stylos
-	calib->setCalibrationPoint(pen_x, pen_y);
-      else
-	calib->unsetLastCalibrationPoint();  //erasers et btns de controle
-
-      if (calib->isCalibrationCompleted()) {
-        setCoordinates(*calib);
-	calibrated = true;
-      }
+      // processed by MimioSource::processEvent() in the main thread
+      msource.postDeviceEvent(pen_id, pen_x, pen_y);
     }
     else {
       double new_x, new_y;
@@ -320,8 +307,8 @@ void MIMIOFrame::pressPen() {
       int y = int(new_y);
       //cerr << "pen " << pen_id << " pressed at " << x << " " << y << endl;
       last_x = x; last_y = y;
-      mflow.moveMouse(x, y, true);           // true => absolute pos
-      mflow.pressMouse(msource.getButton(pen_id));
+      msource.moveMouse(mflow, x, y, true);     // true => absolute pos
+      msource.pressMouse(mflow, msource.getButton(pen_id));
     }
   }
 }
@@ -334,7 +321,7 @@ void MIMIOFrame::releasePen() {
   u_int pen_id = (bytes[0] & 0x7f);
   //cerr << "pen " << pen_id << " released" << endl;
   if (calibrated) {
-    mflow.releaseMouse(msource.getButton(pen_id));
+    msource.releaseMouse(mflow, msource.getButton(pen_id));
   }
 }
 
@@ -388,7 +375,7 @@ void MIMIOFrame::holdPen() {
     }
 
     last_x = x; last_y = y;
-    mflow.moveMouse(x, y, true);   // true => absolute pos
+    msource.moveMouse(mflow, x, y, true);   // true => absolute pos
   }
 }
 
@@ -398,8 +385,8 @@ void MIMIOFrame::holdPen() {
 void MIMIOFrame::pressCtrlBtn() {
   u_int ctrl_id = (bytes[0] & 0x7f);
   //cerr << "ctrl btn " << ctrl_id << " pressed" << endl;
-  mflow.pressMouse(msource.getButton(ctrl_id+10));
-  mflow.releaseMouse(msource.getButton(ctrl_id+10));
+  msource.pressMouse(mflow, msource.getButton(ctrl_id+10));
+  msource.releaseMouse(mflow, msource.getButton(ctrl_id+10));
 }
 
 /* ==================================================== [(c)Elc] ======= */
@@ -712,6 +699,7 @@ MimioSource::~MimioSource() {
 // =====================================================================
 
 void MimioSource::close() {
+  stopThread();
   if (fd != -1) {
     // tcsetattr(fd, TCSADRAIN,  &old_tty);
     if (::close(fd) < 0)
@@ -724,6 +712,33 @@ bool MimioSource::read() {
   return frame.read();
 }
 
+// DEVICE events are the calibration points (code = the pen). They are 
+// processed here because the calibration window is managed by the main loop.
+
+void MimioSource::processEvent(const SourceEvent& e) {
+  if (e.type != SourceEvent::DEVICE) {
+    EventSource::processEvent(e);
+    return;
+  }
+  if (frame.calibrated) return;
+
+  Calibration* calib = frame.mflow.ums.getCalibration();
+  if (!calib) {
+    clog << "UMServer::pressPen: Error: no calibration Window!" << endl;
+    return;
+  }
+  
+  if (e.code >= 1 && e.code <= 4)  // stylos
+    calib->setCalibrationPoint(e.fx, e.fy);
+  else
+    calib->unsetLastCalibrationPoint();  //erasers et btns de controle
+  
+  if (calib->isCalibrationCompleted()) {
+    frame.setCoordinates(*calib);
+    frame.calibrated = true;   // the coordinates are set before
+  }
+}
+
 void MimioSource::calibrate() {
   frame.calibrated = false;
   Calibration* calib =  frame.mflow.ums.getCalibration();
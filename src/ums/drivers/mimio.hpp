@@ -40,6 +40,7 @@ public:
 
   virtual void close();
   virtual bool read();
+  virtual void processEvent(const SourceEvent&);
 
   virtual bool canCalibrate() const {return true;}
   virtual void calibrate();
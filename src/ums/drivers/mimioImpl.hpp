@@ -91,7 +91,7 @@ private:
 
   MimioSource& msource;
   MouseFlow& mflow;
-  bool calibrated;
+  std::atomic<bool> calibrated;   // also read by the thread of the source
   int fd;
   int last_x, last_y;
 
@@ -56,6 +56,7 @@ MouseSource::~MouseSource() {
 /* ==================================================== ======== ======= */
 
 void MouseSource::close() {
+  stopThread();
   if (fd != -1) ::close(fd);
   fd = -1; 
 }
@@ -143,13 +144,13 @@ bool MouseSource::read() {
 	if (is_b2_pressed) {
 	  if ((ctrl & 32) == 0)  {
 	    is_b2_pressed = false;
-	    mflow.releaseMouse(getButton(2));
+	    releaseMouse(mflow, getButton(2));
 	  }
 	}
 	else {
 	  if ((ctrl & 32) != 0) {
 	    is_b2_pressed = true;
-	    mflow.pressMouse(getButton(2));
+	    pressMouse(mflow, getButton(2));
 	  }
 	}
       }
@@ -247,19 +248,19 @@ bool MouseSource::read() {
       //tcflush (fd, TCIFLUSH); inutile
 
   // false => relative pos
-  if (dx != 0 || dy != 0) mflow.moveMouse(dx, dy, false);
+  if (dx != 0 || dy != 0) moveMouse(mflow, dx, dy, false);
 
   // 32 means B1 is pressed
   if (is_b1_pressed) {
    if ((ctrl & 32) == 0) {
      is_b1_pressed = false;
-     mflow.releaseMouse(getButton(1));
+     releaseMouse(mflow, getButton(1));
    }
   }
   else {
     if ((ctrl & 32) != 0) {
       is_b1_pressed = true;
-      mflow.pressMouse(getButton(1));
+      pressMouse(mflow, getButton(1));
     }
   }
     
@@ -267,17 +268,18 @@ bool MouseSource::read() {
   if (is_b3_pressed) {
     if ((ctrl & 16) == 0) {
      is_b3_pressed = false;
-     mflow.releaseMouse(getButton(3));
+     releaseMouse(mflow, getButton(3));
     }
   }
   else {
     if ((ctrl & 16) != 0){
       is_b3_pressed = true;
-      mflow.pressMouse(getButton(3));
+      pressMouse(mflow, getButton(3));
     }
   }
     
-  if (mflow.getX() > 0 || mflow.getY() > 0) is_init = true;
+  // the position of 'mflow' is not used: read() may run in another thread
+  if (dx != 0 || dy != 0) is_init = true;
 
   return true;
 }
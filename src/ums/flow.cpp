@@ -44,11 +44,15 @@ MouseFlow::MouseFlow(UMServer* _ums, int _id, bool create_pointer)
   last_entered_win = None;
   last_entered_in_ubitwin = false;
   last_entered_winsock = -1;
+  pointer_timer = null;
+  ptr_x = ptr_y = 0;
   if (id == 0) pointer_win = None; else createPointer();
   h_out = v_out = false;
 }
 
-MouseFlow::~MouseFlow() {}
+MouseFlow::~MouseFlow() {
+  ums.timers.remove(pointer_timer);
+}
 
 /* ==================================================== ===== ======= */
 /* ==================================================== [Elc] ======= */
@@ -84,11 +88,50 @@ void MouseFlow::createPointer() {
 
 /* ==================================================== ===== ======= */
 
+// the positions are received at an irregular rate and with some delay (in
+// particular from remote sources): the pointer window is moved at a fixed rate
+// to the position predicted by the motion model between two samples.
+
 void MouseFlow::movePointer(long x, long y) {
-  if (pointer_win != None) {
-    XMoveWindow(ums.xdisplay, pointer_win, x, y);
-    XRaiseWindow(ums.xdisplay, pointer_win);     // always on top !
+  if (pointer_win == None) {
+    XFlush(ums.xdisplay);
+    return;
   }
+  motion.addSample(x, y, ums.getEventTime());
+  if (!pointer_timer) {     // the pointer was still: move it now
+    placePointer(x, y);
+    pointer_timer = ums.timers.add(UMServer::getTime(), POINTER_DELAY, pointerCB, this);
+  }
+}
+
+void MouseFlow::pointerCB(void* data) {
+  MouseFlow* flow = (MouseFlow*)data;
+  flow->pointer_timer = null;     // the timer is deleted by the wheel
+  flow->updatePointer();
+}
+
+void MouseFlow::updatePointer() {
+  long x, y;
+  // when the pointer stops, it is moved back to the last actual position
+  bool moving = motion.predict(UMServer::getTime(), x, y);
+  if (x != ptr_x || y != ptr_y) placePointer(x, y);
+  if (moving)
+    pointer_timer = ums.timers.add(UMServer::getTime(), POINTER_DELAY, pointerCB, this);
+}
+
+void MouseFlow::snapPointer() {
+  if (pointer_win == None) return;
+  ums.timers.remove(pointer_timer);
+  pointer_timer = null;
+  motion.reset(mx, my, UMServer::getTime());
+  if (mx != ptr_x || my != ptr_y) placePointer(mx, my);
+}
+
+void MouseFlow::placePointer(long x, long y) {
+  ptr_x = x;
+  ptr_y = y;
+  XMoveWindow(ums.xdisplay, pointer_win, x, y);
+  XRaiseWindow(ums.xdisplay, pointer_win);     // always on top !
   XFlush(ums.xdisplay);
 }
 
@@ -157,6 +200,7 @@ void MouseFlow::pressMouse(int btn_id) {
     else keepMouseInsideScreen(mx, my);
   }
   else {  // inside local screen
+    snapPointer();     // the button must be pressed where the pointer is shown
     events.sendButton(*this, btn_id, true);
   } 
 
@@ -179,6 +223,7 @@ void MouseFlow::releaseMouse(int btn_id)  {
     else keepMouseInsideScreen(mx, my);
   }
   else  {        // inside local screen
+    snapPointer();
     events.sendButton(*this, btn_id, false);
   }
 
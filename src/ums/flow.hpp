@@ -17,6 +17,7 @@
 #ifndef _flow_hpp_
 #define	_flow_hpp_
 #include "umserver.hpp"
+#include "motion.hpp"
 
 /* ==================================================== ======== ======= */
 /** UMS event flow.
@@ -48,7 +49,17 @@ public:
   ///< btn_mask is a combination of Button1Mask, etc and can be ORed.
   
   WindowID getPointer() const {return pointer_win;}
+
   void movePointer(long x, long y);
+  /**< moves the pointer window of an alternate flow.
+   * the pointer window is then moved every POINTER_DELAY millisec to the position
+   * extrapolated by the motion model of the flow until the pointer stops, 
+   * so that remote pointers do not lag behind (see MotionModel).
+   */
+
+  void snapPointer();
+  ///< moves the pointer window to the actual position of the mouse (stops the extrapolation).
+
   void showPointer(bool);  
   void createPointer();
   void changePointer(const char* fgcolor, const char* bgcolor);
@@ -82,6 +93,8 @@ public:
 
   void keepMouseInsideScreen(long& mx, long& my);
 
+  enum {POINTER_DELAY = 20};  ///< delay between two moves of the pointer window.
+
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - 
 
   friend class UMServer;
@@ -93,6 +106,14 @@ public:
   bool last_entered_in_ubitwin;
   int  last_entered_winsock;
   bool h_out, v_out;
+  MotionModel motion;       ///< motion model of the pointer window
+  TimerWheel::Timer* pointer_timer;  ///< moves the pointer window (null if stopped)
+  long ptr_x, ptr_y;        ///< current pos of the pointer window
+
+private:
+  void placePointer(long x, long y);
+  void updatePointer();
+  static void pointerCB(void*);
 };
 
 #endif
@@ -23,6 +23,7 @@
 #include <cstdlib>       // getenv, atexit
 #include <cstdio>
 #include <string>
+#include <map>
 #include <unistd.h>       // darwin
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -38,6 +39,7 @@
 using namespace std;
 
 static CFRunLoopRef runloop;
+static std::map<void*, CFSocketRef> loop_sockets;  // key = info of the callback
 
 /* ==================================================== ======== ======= */
 
@@ -47,6 +49,12 @@ static void sourceReadCB(CFSocketRef s, CFSocketCallBackType type,
   if (CFSocketGetNative(s) == so->filedesc()) so->read();
 }
 
+static void queueReadCB(CFSocketRef s, CFSocketCallBackType type,
+                        CFDataRef ref, const void *data, void *info) {
+  if (type != kCFSocketReadCallBack) return;
+  Mdns::ums->processSourceEvents();
+}
+
 /* ==================================================== ======== ======= */
 
 static void cnxReadCB(CFSocketRef s, CFSocketCallBackType type,
@@ -54,8 +62,9 @@ static void cnxReadCB(CFSocketRef s, CFSocketCallBackType type,
   if (type != kCFSocketReadCallBack) return;
   USocket* sock = (USocket*)info;
   UInbuf inb;
-  if (sock->receiveBlock(inb)) Mdns::ums->processRequest(sock, inb);
-  else Mdns::ums->removeCnx(sock);
+  // all the received blocks are processed (the socket is non-blocking)
+  while (sock->receiveBlock(inb)) Mdns::ums->processRequest(sock, inb);
+  if (!sock->isConnected()) Mdns::ums->removeCnx(sock);
 }
 
 /* ==================================================== ======== ======= */
@@ -95,9 +104,26 @@ static bool loopAddSource(int fd, CFSocketCallBack callback, void* info)
                                                         sf, 0);
   if (!rlsf) return false;
   CFRunLoopAddSource(runloop, rlsf, kCFRunLoopDefaultMode);
+  CFRelease(rlsf);
+  // the descriptor is closed by its owner, not by CFSocketInvalidate()
+  CFSocketSetSocketFlags(sf, CFSocketGetSocketFlags(sf) & ~kCFSocketCloseOnInvalidate);
+  loop_sockets[info] = sf;
   return true;
 }
 
+static void loopRemoveSource(void* info) {
+  std::map<void*, CFSocketRef>::iterator k = loop_sockets.find(info);
+  if (k == loop_sockets.end()) return;
+  CFSocketInvalidate(k->second);   // also removes the run loop source
+  CFRelease(k->second);
+  loop_sockets.erase(k);
+}
+
+static void timersCB(CFRunLoopTimerRef, void* info) {
+  UMServer* ums = (UMServer*)info;
+  ums->timers.fire(UMServer::getTime());
+}
+
 /* ==================================================== [Elc] ======= */
 /* ==================================================== ===== ======= */
 // CF_LOOP SERVICES
@@ -356,6 +382,16 @@ void UMServer::initMainLoop() {
     cerr << "fatal error: can't add X connection or Server socket to CF loop" << endl;
     exit(1);
   }
+  loopAddSource(source_queue.getDescriptor(), queueReadCB, &source_queue);
+
+  // the timer wheel is checked every 10 ticks (see TimerWheel)
+  CFRunLoopTimerContext tcontext = {0, this, NULL, NULL, NULL};
+  CFTimeInterval tick = TimerWheel::TICK * 10 / 1000.;
+  CFRunLoopTimerRef timer = 
+    CFRunLoopTimerCreate(kCFAllocatorDefault, CFAbsoluteTimeGetCurrent() + tick,
+                         tick, 0, 0, timersCB, &tcontext);
+  CFRunLoopAddTimer(runloop, timer, kCFRunLoopDefaultMode);
+  CFRelease(timer);
 }
 
 void UMServer::runMainLoop() {
@@ -374,6 +410,23 @@ bool UMServer::addSourceToMainLoop(USocket* s) {
   return loopAddSource(s->getDescriptor(), cnxReadCB, s);
 }
 
+void UMServer::removeSourceFromMainLoop(EventSource* s) {
+  loopRemoveSource(s);
+}
+
+void UMServer::removeSourceFromMainLoop(USocket* s) {
+  loopRemoveSource(s);
+}
+
+// local clients use TCP on MacOSX (see USharedRing)
+
+bool UMServer::addSourceToMainLoop(USharedRing*, USocket*) {
+  return false;
+}
+
+void UMServer::removeSourceFromMainLoop(USharedRing*) {
+}
+
 #endif
 
 
@@ -0,0 +1,114 @@
+/*************************************************************************
+ *
+ *  motion.cpp: motion model of the UMS pointers.
+ *  Ubit GUI Toolkit - Version 6.0
+ *  (C) 2003-2008 Eric Lecolinet / ENST Paris / www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE : 
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE 
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. 
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU 
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION; 
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#include <cmath>
+#include "motion.hpp"
+using namespace std;
+
+// the velocity is computed over this delay so that the jitter of the
+// timestamps (eg. samples received together from the network) is smoothed
+static const unsigned long VELOCITY_WINDOW = 50;   // millisec
+
+MotionModel::MotionModel() {
+  reset(0, 0, 0);
+}
+
+void MotionModel::reset(long x, long y, unsigned long time) {
+  last = 0;
+  count = 1;
+  samples[0].x = x;
+  samples[0].y = y;
+  samples[0].time = time;
+  vx = vy = ax = ay = 0;
+}
+
+/* ==================================================== ======== ======= */
+
+void MotionModel::addSample(long x, long y, unsigned long time) {
+  const Sample& prev = samples[last];
+  
+  if (time <= prev.time) {       // same timestamp: just update the position
+    samples[last].x = x;
+    samples[last].y = y;
+    if (count == 1) return;
+  }
+  else {
+    last = (last + 1) % HISTORY;
+    if (count < HISTORY) count++;
+    samples[last].x = x;
+    samples[last].y = y;
+    samples[last].time = time;
+  }
+  
+  // oldest sample in the velocity window (excluding the new one)
+  const Sample& s = samples[last];
+  int k = (last - 1 + HISTORY) % HISTORY;
+  if (s.time - samples[k].time > MAX_PREDICTION) {   // the pointer was still
+    vx = vy = ax = ay = 0;
+    return;
+  }
+  for (int n = 2; n < count; n++) {
+    int k2 = (last - n + HISTORY) % HISTORY;
+    if (s.time - samples[k2].time > VELOCITY_WINDOW) break;
+    k = k2;
+  }
+
+  double dt = s.time - samples[k].time;
+  if (dt <= 0) return;
+  double nvx = (s.x - samples[k].x) / dt;
+  double nvy = (s.y - samples[k].y) / dt;
+
+  // the acceleration is smoothed because it is very sensitive to jitter
+  double dt_last = s.time - samples[(last - 1 + HISTORY) % HISTORY].time;
+  if (dt_last > 0) {
+    ax = 0.5 * ax + 0.5 * (nvx - vx) / dt_last;
+    ay = 0.5 * ay + 0.5 * (nvy - vy) / dt_last;
+  }
+  vx = nvx;
+  vy = nvy;
+}
+
+/* ==================================================== ======== ======= */
+
+bool MotionModel::isMoving(unsigned long time) const {
+  const Sample& s = samples[last];
+  return time >= s.time && time - s.time <= MAX_PREDICTION
+  && (vx != 0 || vy != 0 || ax != 0 || ay != 0);
+}
+
+bool MotionModel::predict(unsigned long time, long& x, long& y) const {
+  const Sample& s = samples[last];
+  x = s.x;
+  y = s.y;
+  if (!isMoving(time)) return false;
+
+  double dt = time - s.time;
+  double dx = vx * dt + 0.5 * ax * dt * dt;
+  double dy = vy * dt + 0.5 * ay * dt * dt;
+
+  // the predicted position can't be too far from the actual position
+  double d = sqrt(dx * dx + dy * dy);
+  if (d > MAX_ERROR) {
+    dx = dx * MAX_ERROR / d;
+    dy = dy * MAX_ERROR / d;
+  }
+  x = s.x + lround(dx);
+  y = s.y + lround(dy);
+  return true;
+}
+
+/* ==================================================== [TheEnd] ======= */
+/* ==================================================== [(c)Elc] ======= */
@@ -0,0 +1,63 @@
+/*************************************************************************
+ *
+ *  motion.hpp: motion model of the UMS pointers.
+ *  Ubit GUI Toolkit - Version 6.0
+ *  (C) 2003-2008 Eric Lecolinet / ENST Paris / www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE : 
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE 
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. 
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU 
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION; 
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#ifndef _umsmotion_hpp_
+#define	_umsmotion_hpp_
+
+/* ==================================================== ======== ======= */
+/** motion model of a pointer.
+ * estimates the velocity and the acceleration of the pointer from the last
+ * positions it has received, so that its position can be extrapolated until
+ * the next position is received. The extrapolation is limited in time
+ * (MAX_PREDICTION) and in distance (MAX_ERROR) so that the predicted position
+ * never goes too far from the last actual position.
+ */
+class MotionModel {
+public:
+  enum {
+    HISTORY = 8,            ///< number of samples that are kept.
+    MAX_PREDICTION = 100,   ///< max extrapolation delay (in millisec).
+    MAX_ERROR = 40          ///< max distance from the last sample (in pixels).
+  };
+  
+  MotionModel();
+
+  void addSample(long x, long y, unsigned long time);
+  ///< adds a position of the pointer ('time' is in millisec).
+
+  void reset(long x, long y, unsigned long time);
+  ///< forgets the previous samples (the pointer is then assumed to be still).
+
+  bool predict(unsigned long time, long& x, long& y) const;
+  /**< returns the extrapolated position of the pointer at this time.
+   * returns false if the pointer is not moving anymore (x and y are then
+   * the position of the last sample).
+   */
+  
+  bool isMoving(unsigned long time) const;
+  ///< true if the pointer has moved recently.
+
+private:
+  struct Sample {long x, y; unsigned long time;};
+  Sample samples[HISTORY];   // circular buffer
+  int last, count;
+  double vx, vy;             // smoothed velocity (pixels/millisec)
+  double ax, ay;             // smoothed acceleration (pixels/millisec^2)
+};
+
+#endif
+/* ==================================================== [TheEnd] ======= */
+/* ==================================================== [(c)Elc] ======= */
@@ -22,125 +22,359 @@
 #include <cstdio>
 #include <string>
 #include <unistd.h>       // darwin
+#include <cerrno>
+#include <map>
 #include <sys/stat.h>
 #include <sys/types.h>
+#ifdef __linux__
+#  include <sys/epoll.h>
+#endif
 #include <X11/Xlib.h>
+#include <ubit/usharedring.hpp>
 #include "source.hpp"
 #include "zeroconf.hpp"
 using namespace std;
 
 /* ==================================================== ======== ======= */
+// the file descriptors are registered once (when the sources and connections
+// are added) so that a wakeup only costs the descriptors that are ready.
+// epoll is used on Linux, select() otherwise.
 
 #define MAX_FD(maxfd,fd) {if ((fd) > (maxfd)) (maxfd) = (fd);}
 
-bool UMServer::addSourceToMainLoop(EventSource*) {
-  return true;
+struct LoopHandler {
+  enum Type {XCONNECTION, SERVER_SOCKET, LOCAL_SERVER_SOCKET, EVENT_SOURCE,
+    SOURCE_QUEUE, CONNECTION, RING, MDNS};
+  Type type;
+  int fd;
+  void* obj;          // the EventSource, the USocket, the USharedRing...
+  USocket* sock;      // the connection of a RING
+  bool removed;       // removed while the events of a wakeup are processed
+};
+
+struct LoopEvent {
+  LoopHandler* h;
+  bool readable, writable, hangup;
+};
+
+struct MainLoop {
+  MainLoop();
+  ~MainLoop();
+  bool add(LoopHandler::Type, int fd, void* obj, USocket* sock = null);
+  void remove(void* obj, int current_fd);
+  int  wait(long timeout, std::vector<LoopEvent>& events);
+  
+  std::map<void*, LoopHandler*> handlers;   // key = obj
+  std::vector<LoopHandler*> garbage;        // deleted at the next wakeup
+#ifdef __linux__
+  enum {MAX_EVENTS = 64};
+  int epfd;
+#endif
+};
+
+static MainLoop* mainloop = null;
+
+static MainLoop* getMainLoop() {
+  if (!mainloop) mainloop = new MainLoop();
+  return mainloop;
 }
 
-bool UMServer::addSourceToMainLoop(USocket*) {
+MainLoop::MainLoop() {
+#ifdef __linux__
+  epfd = epoll_create(MAX_EVENTS);
+  if (epfd < 0) {
+    cerr << "fatal error: UMServer::MainLoop: can't create epoll descriptor" << endl;
+    exit(1);
+  }
+#endif
+}
+
+MainLoop::~MainLoop() {
+  for (std::map<void*,LoopHandler*>::iterator k = handlers.begin(); 
+       k != handlers.end(); k++)
+    delete k->second;
+  for (unsigned int k = 0; k < garbage.size(); k++) delete garbage[k];
+#ifdef __linux__
+  ::close(epfd);
+#endif
+}
+
+bool MainLoop::add(LoopHandler::Type type, int fd, void* obj, USocket* sock) {
+  if (fd < 0 || handlers.find(obj) != handlers.end()) return false;
+  LoopHandler* h = new LoopHandler();
+  h->type = type;
+  h->fd = fd;
+  h->obj = obj;
+  h->sock = sock;
+  h->removed = false;
+
+#ifdef __linux__
+  struct epoll_event ev;
+  ev.data.ptr = h;
+  // client connections are edge triggered: USocket::receiveBlock() reads all
+  // the available data. Drivers may not, they are thus level triggered.
+  if (type == LoopHandler::CONNECTION)
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+  else ev.events = EPOLLIN;
+  
+  if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    cerr << "UMServer::MainLoop: can't add descriptor " << fd << endl;
+    delete h;
+    return false;
+  }
+#endif
+  handlers[obj] = h;
   return true;
 }
 
+// current_fd < 0 if the descriptor has already been closed (it is then 
+// automatically removed from the epoll set)
+
+void MainLoop::remove(void* obj, int current_fd) {
+  std::map<void*,LoopHandler*>::iterator k = handlers.find(obj);
+  if (k == handlers.end()) return;
+  LoopHandler* h = k->second;
+  handlers.erase(k);
+#ifdef __linux__
+  if (current_fd >= 0 && current_fd == h->fd) {
+    struct epoll_event ev;   // not used but must be non null on old kernels
+    epoll_ctl(epfd, EPOLL_CTL_DEL, h->fd, &ev);
+  }
+#endif
+  h->removed = true;
+  garbage.push_back(h);
+}
+
+// timeout is in millisec (-1 = infinite)
+
+int MainLoop::wait(long timeout, std::vector<LoopEvent>& events) {
+  for (unsigned int k = 0; k < garbage.size(); k++) delete garbage[k];
+  garbage.clear();
+  events.clear();
+
+#ifdef __linux__
+  struct epoll_event evs[MAX_EVENTS];
+  int n = epoll_wait(epfd, evs, MAX_EVENTS, int(timeout));
+  for (int k = 0; k < n; k++) {
+    LoopEvent e;
+    e.h = (LoopHandler*)evs[k].data.ptr;
+    e.readable = (evs[k].events & (EPOLLIN | EPOLLERR)) != 0;
+    e.writable = (evs[k].events & EPOLLOUT) != 0;
+    e.hangup   = (evs[k].events & (EPOLLHUP | EPOLLRDHUP)) != 0;
+    events.push_back(e);
+  }
+  return n;
+  
+#else
+  fd_set read_set, write_set;
+  int maxfd = 0;
+  FD_ZERO(&read_set);
+  FD_ZERO(&write_set);
+  
+  std::map<void*,LoopHandler*>::iterator k;
+  for (k = handlers.begin(); k != handlers.end(); k++) {
+    LoopHandler* h = k->second;
+    FD_SET(h->fd, &read_set);
+    // replies that could not be sent without blocking
+    if (h->type == LoopHandler::CONNECTION
+        && ((USocket*)h->obj)->getPendingOutput() > 0)
+      FD_SET(h->fd, &write_set);
+    MAX_FD(maxfd, h->fd);
+  }
+  
+  struct timeval tv, *ptv = NULL;
+  if (timeout >= 0) {
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+    ptv = &tv;
+  }
+  
+  int n = select(maxfd+1, &read_set, &write_set, NULL, ptv);
+  if (n <= 0) return n;
+  
+  for (k = handlers.begin(); k != handlers.end(); k++) {
+    LoopHandler* h = k->second;
+    LoopEvent e;
+    e.h = h;
+    e.readable = FD_ISSET(h->fd, &read_set);
+    e.writable = FD_ISSET(h->fd, &write_set);
+    e.hangup = false;
+    if (e.readable || e.writable) events.push_back(e);
+  }
+  return events.size();
+#endif
+}
+
+/* ==================================================== ======== ======= */
+
+bool UMServer::addSourceToMainLoop(EventSource* s) {
+  return getMainLoop()->add(LoopHandler::EVENT_SOURCE, s->filedesc(), s);
+}
+
+bool UMServer::addSourceToMainLoop(USocket* s) {
+  return getMainLoop()->add(LoopHandler::CONNECTION, s->getDescriptor(), s);
+}
+
+bool UMServer::addSourceToMainLoop(USharedRing* r, USocket* s) {
+  return getMainLoop()->add(LoopHandler::RING, r->getEventDescriptor(), r, s);
+}
+
+void UMServer::removeSourceFromMainLoop(USharedRing* r) {
+  getMainLoop()->remove(r, r->getEventDescriptor());
+}
+
+void UMServer::removeSourceFromMainLoop(EventSource* s) {
+  getMainLoop()->remove(s, s->filedesc());
+}
+
+void UMServer::removeSourceFromMainLoop(USocket* s) {
+  getMainLoop()->remove(s, s->getDescriptor());
+}
+
+static void checkCnxsCB(void* data) {
+  UMServer* ums = (UMServer*)data;
+  ums->removeClosedCnxs();
+  ums->timers.add(UMServer::getTime(), UMServer::CNX_CHECK_DELAY, checkCnxsCB, ums);
+}
+
 void UMServer::initMainLoop() {
+  MainLoop* loop = getMainLoop();
+  if (!loop->add(LoopHandler::XCONNECTION, getXConnection(), &xconnection)
+      ||
+      !loop->add(LoopHandler::SERVER_SOCKET, serv_sock->getDescriptor(), serv_sock)
+      ) {
+    cerr << "fatal error: can't add X connection or Server socket to main loop" << endl;
+    exit(1);
+  }
+  if (local_sock) 
+    loop->add(LoopHandler::LOCAL_SERVER_SOCKET, local_sock->getDescriptor(), local_sock);
+  loop->add(LoopHandler::SOURCE_QUEUE, source_queue.getDescriptor(), &source_queue);
+  timers.add(getTime(), CNX_CHECK_DELAY, checkCnxsCB, this);
 }
 
+/* ==================================================== ======== ======= */
+
 void UMServer::runMainLoop() {
-  UServerSocket* serv_sock = getServerSocket();
+  MainLoop* loop = getMainLoop();
+  std::vector<LoopEvent> events;
+  std::map<int, void*> mdns_fds;   // the descriptors currently used by mDNS
   
   while (true) {
     getAndProcessXEvents();
-  
-    fd_set read_set;
-    int maxfd = 0;
-    FD_ZERO(&read_set);
-
-    // test X events
-    FD_SET(xconnection, &read_set);
-    MAX_FD(maxfd, xconnection);
-
-    // test input sources from drivers
-    for (unsigned int k = 0; k < sources.size(); k++) {
-      FD_SET(sources[k]->filedesc(), &read_set);
-      MAX_FD(maxfd, sources[k]->filedesc());
-    }
+    timers.fire(getTime());
+    long timeout = timers.getTimeout(getTime());
+
+    //ifdef HAVE_mDNS
+    // mDNS may change its descriptors: they are registered when they change
+    {
+      fd_set mdns_set;
+      int mdns_maxfd = 0;
+      FD_ZERO(&mdns_set);
+      struct timeval mdns_timeout;
+      // timeout.tv_sec = 0x3FFFFFFF; trop grand sur MacOSX!
+      mdns_timeout.tv_sec = 0x3FFFFFF;
+      mdns_timeout.tv_usec = 0;
+      mDNSPosixGetFDSet(&mdns->mdns, &mdns_maxfd, &mdns_set, &mdns_timeout);
 
-    // test opened connections on client sockets
-    for (CnxList::iterator c = cnxs.begin(); c != cnxs.end(); c++) {
-      // verif validite sinon plantage si = -1
-      if ((*c)->sock->getDescriptor() >= 0) {
-        FD_SET((*c)->sock->getDescriptor(), &read_set);
-        MAX_FD(maxfd, (*c)->sock->getDescriptor());
+      std::map<int,void*>::iterator k2;
+      for (std::map<int,void*>::iterator k = mdns_fds.begin(); k != mdns_fds.end(); k = k2) {
+        k2 = k; k2++;
+        if (!FD_ISSET(k->first, &mdns_set)) {
+          loop->remove(k->second, k->first);
+          mdns_fds.erase(k);
+        }
+      }
+      for (int fd = 0; fd < mdns_maxfd + 1 && fd < FD_SETSIZE; fd++) {
+        if (FD_ISSET(fd, &mdns_set) && mdns_fds.find(fd) == mdns_fds.end()) {
+          // the key of the handler is the address of the map entry
+          void*& key = mdns_fds[fd];
+          key = &key;
+          loop->add(LoopHandler::MDNS, fd, key);
+        }
       }
+      long t = mdns_timeout.tv_sec * 1000 + mdns_timeout.tv_usec / 1000;
+      if (timeout < 0 || t < timeout) timeout = t;
     }
+    //endif
 
-    // test requests on the server socket
-    FD_SET(serv_sock->getDescriptor(), &read_set);
-    MAX_FD(maxfd, serv_sock->getDescriptor());
+    if (timeout > 0x3FFFFFF) timeout = 0x3FFFFFF;
+    int count = loop->wait(timeout, events);
 
-    maxfd++;
+    if (count < 0) {
+      if (errno != EINTR) {
+        cerr << "UMServer::mainLoop: error on wait" << endl;
+        removeClosedCnxs();
+      }
+      continue;
+    }
 
-    struct timeval timeout;
-    // timeout.tv_sec = 0x3FFFFFFF; trop grand sur MacOSX!
-    timeout.tv_sec = 0x3FFFFFF;
-    timeout.tv_usec = 0;
+    fd_set mdns_ready;
+    FD_ZERO(&mdns_ready);
 
-    //ifdef HAVE_mDNS
-    mDNSPosixGetFDSet(&mdns->mdns, &maxfd, &read_set, &timeout);
-    //endif
+    for (unsigned int k = 0; k < events.size(); k++) {
+      LoopHandler* h = events[k].h;
+      if (h->removed) continue;   // removed by a previous handler
 
-    int has_input = select(maxfd,
-                           &read_set,  // read
-                           NULL,       // write
-                           NULL,       // except
-                           &timeout);  // timeout
+      switch (h->type) {
+        case LoopHandler::XCONNECTION:
+          // X events are processed at the beginning of the loop
+          break;
 
-    if (has_input < 0) {
-      cerr << "UMServer::mainLoop: error on select" << endl;
-      struct stat statbuf;
+        case LoopHandler::SERVER_SOCKET: {
+          USocket* s = serv_sock->accept();
+          if (s) addCnx(s);
+        } break;
 
-      // test open connections which have become invalid
-      for (CnxList::iterator c = cnxs.begin(); c != cnxs.end(); c++) {
-        if (fstat((*c)->sock->getDescriptor(), &statbuf) < 0) {
-          removeCnx((*c)->sock);
-        }
-      }
-      continue;
-    }
+        case LoopHandler::LOCAL_SERVER_SOCKET: {
+          USocket* s = local_sock->accept();
+          if (s) addLocalCnx(s);
+        } break;
 
-    //ifdef HAVE_mDNS
-    mDNSPosixProcessFDSet(&mdns->mdns, &read_set);
-    //endif
+        case LoopHandler::RING: {
+          // requests of a local client (see UMS_LOCAL_SOCKET)
+          USharedRing* ring = (USharedRing*)h->obj;
+          ring->clearNotification();
+          UInbuf inb;
+          do {
+            while (ring->read(inb)) processRequest(h->sock, inb);
+          } while (!ring->prepareWait());
+        } break;
 
-    //process X events
-    //if (FD_ISSET(xconnection, &read_set)) {
-    //}
+        case LoopHandler::EVENT_SOURCE:
+          ((EventSource*)h->obj)->read();
+          break;
 
-    // process input sources
-    for (unsigned int k = 0; k < sources.size(); k++) {
-      if (FD_ISSET(sources[k]->filedesc(), &read_set)) sources[k]->read();
-    }
+        case LoopHandler::SOURCE_QUEUE:
+          processSourceEvents();
+          break;
+
+        case LoopHandler::MDNS:
+          FD_SET(h->fd, &mdns_ready);
+          break;
 
-    // process opened connections on client sockets
-    CnxList::iterator c2;
-    for (CnxList::iterator c = cnxs.begin(); c != cnxs.end(); c = c2) {
-      // attention: (*c) peut etre detruit par readComSocket()
-      c2 = c; c2++;
-      USocket* sock = (*c)->sock;
-      
-      if (sock->getDescriptor() < 0)
-        removeCnx(sock);
-      else if (FD_ISSET(sock->getDescriptor(), &read_set)) {
-        UInbuf inb;
-        if (sock->receiveBlock(inb)) processRequest(sock, inb);
-        else removeCnx(sock);
+        case LoopHandler::CONNECTION: {
+          USocket* sock = (USocket*)h->obj;
+          if (events[k].writable && sock->getPendingOutput() > 0) sock->flush();
+          if (events[k].readable) {
+            Cnx* c = findCnx(sock);
+            // a local client first sends its ring (see addLocalCnx())
+            if (c && c->handshake_time != 0) receiveLocalRing(c);
+            // the requests that were written in the ring before the client
+            // switched to the socket come first (see UMService::send())
+            UInbuf inb;
+            if (c && c->ring) while (c->ring->read(inb)) processRequest(sock, inb);
+            // all the blocks received since the last wakeup are processed
+            // (the socket is non-blocking, see addCnx())
+            while (sock->receiveBlock(inb)) processRequest(sock, inb);
+          }
+          if (events[k].hangup || !sock->isConnected()) removeCnx(sock);
+        } break;
       }
     }
 
-    // process requests on server socket
-    if (FD_ISSET(serv_sock->getDescriptor(), &read_set)) {
-      USocket* s = serv_sock->accept();
-      if (s) addCnx(s);
-    }
+    //ifdef HAVE_mDNS
+    mDNSPosixProcessFDSet(&mdns->mdns, &mdns_ready);
+    //endif
   }
 }
 
@@ -36,6 +36,9 @@ using namespace std;
 // protocol: see UMSrequest in ubit/src/umsproto.hpp
 
 static bool processKeyMouseRequest(UMServer* ums, UInbuf&);
+static bool processCompactEventRequest(UMServer* ums, Cnx*, UInbuf&);
+static bool processKeyMouse(UMServer* ums, u_char event_type, u_char event_flow,
+                            long x, long y, unsigned long detail);
 static bool processEventRequest(UMServer* ums, UInbuf&);
 static bool processMessageRequest(UMServer* ums, UInbuf&);
 static bool receiveFileRequest(UMServer* ums, USocket* sock, UInbuf&);
@@ -143,6 +146,32 @@ void UMServer::processRequest(USocket* sock, UInbuf& req) {
     case UMSrequest::FILE_TRANSFERT:
       receiveFileRequest(this, sock, req);
       break;
+
+    case UMSrequest::SET_PROTOCOL : {
+      Cnx* c = findCnx(sock);
+      if (!c) return;
+      unsigned char version = 1;
+      if (req.size() > req.consumed()) req.readChar(version);
+      c->protocol = (version < UMS_PROTOCOL_VERSION) ? version : UMS_PROTOCOL_VERSION;
+      c->motions.clear();
+      char msg[100];
+      sprintf(msg, "_umsProtocol %d", c->protocol);
+      events.sendMessage(sock, msg);
+    } break;
+
+    case UMSrequest::BATCH : {
+      // the requests of the batch are processed in the order they were sent.
+      // batches can't be nested: a nested BATCH is ignored
+      UInbuf subreq;
+      while (req.readBlock(subreq)) {
+        if (subreq.size() > 0 && subreq.data()[0] != UMSrequest::BATCH)
+          processRequest(sock, subreq);
+      }
+    } break;
+
+    case UMSrequest::COMPACT_EVENT :
+      processCompactEventRequest(this, findCnx(sock), req);
+      break;
   }
 }
 
@@ -269,7 +298,38 @@ static bool processKeyMouseRequest(UMServer* ums, UInbuf& req) {
   unsigned long detail;
 
   req.readEvent(event_type, event_flow, x, y, detail);
+  return processKeyMouse(ums, event_type, event_flow, x, y, detail);
+}
+
+// same as processKeyMouseRequest() with varints. Motion coords may be
+// relative to the previous motion of the same flow (see UMSrequest).
+
+static bool processCompactEventRequest(UMServer* ums, Cnx* c, UInbuf& req) {
+  u_char event_type, event_flow, flags;
+  long x, y;
+  unsigned long detail;
+
+  if (!c || req.size() < req.consumed() + 3) return false;
+  req.readChar(event_type);
+  req.readChar(event_flow);
+  req.readChar(flags);
+  if (!req.readSVarint(x) || !req.readSVarint(y) || !req.readVarint(detail))
+    return false;
+
+  if (event_type == MotionNotify) {
+    if (flags & UMSrequest::DELTA_COORDS) {
+      std::map<int, std::pair<long,long> >::iterator k = c->motions.find(event_flow);
+      if (k == c->motions.end()) return false;   // should not happen
+      x += k->second.first;
+      y += k->second.second;
+    }
+    c->motions[event_flow] = std::make_pair(x, y);
+  }
+  return processKeyMouse(ums, event_type, event_flow, x, y, detail);
+}
 
+static bool processKeyMouse(UMServer* ums, u_char event_type, u_char event_flow,
+                            long x, long y, unsigned long detail) {
   EventFlow* ef = ums->getEventFlow(event_flow);
   MouseFlow* mf = (ef ? dynamic_cast<MouseFlow*>(ef) : null);
   if (!mf) return false;
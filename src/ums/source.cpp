@@ -16,10 +16,13 @@
 
 #include <vector>
 #include <algorithm>
+#include <cerrno>
+#include <poll.h>
 #include <ubit/umservice.hpp>
 #include <X11/X.h>
 #include "umserver.hpp"
 #include "source.hpp"
+#include "flow.hpp"
 using namespace std;
 
 #define ALLMODS (ShiftMask|LockMask|ControlMask|Mod1Mask|Mod2Mask|Mod3Mask|Mod4Mask|Mod5Mask)
@@ -40,10 +43,140 @@ UMSbutton::UMSbutton(int btn_number, unsigned int mod_mask,
 /* ==================================================== ======== ======= */
 
 EventSource::~EventSource() {
+  stopThread();
   for (unsigned  int k = 0; k < button_map.size(); k++) delete button_map[k];
   fd = -1;
 }
 
+bool EventSource::startThread(SourceQueue& q) {
+  if (queue || fd < 0) return false;
+  queue = &q;
+  stopping = false;
+  if (pthread_create(&thread, NULL, threadMain, this) != 0) {
+    cerr << "EventSource: can't create thread" << endl;
+    queue = null;
+    return false;
+  }
+  return true;
+}
+
+// read() must return after reading a packet: the thread can then be stopped.
+
+void EventSource::stopThread() {
+  if (!queue) return;
+  stopping = true;
+  pthread_join(thread, NULL);
+  queue = null;
+}
+
+void* EventSource::threadMain(void* arg) {
+  EventSource* so = (EventSource*)arg;
+  struct pollfd p;
+  p.fd = so->fd;
+  p.events = POLLIN;
+
+  while (!so->stopping) {
+    // the timeout makes it possible to check 'stopping'
+    int n = poll(&p, 1, 200);
+    if (n < 0 && errno != EINTR) break;
+    if (n <= 0) continue;
+    if (p.revents & (POLLERR|POLLHUP|POLLNVAL)) {
+      cerr << "EventSource: input device closed (fd " << p.fd << ")" << endl;
+      break;
+    }
+    so->read();
+  }
+  return NULL;
+}
+
+/* ==================================================== ======== ======= */
+
+void EventSource::post(SourceEvent& e) {
+  e.source = this;
+  if (!queue) processEvent(e);
+  else {
+    SourceEvent* qe = new SourceEvent();
+    qe->type = e.type;
+    qe->source = this;
+    qe->flow = e.flow;
+    qe->button = e.button;
+    qe->x = e.x;
+    qe->y = e.y;
+    qe->code = e.code;
+    qe->fx = e.fx;
+    qe->fy = e.fy;
+    qe->time = UMServer::getTime();   // the time when the data was read
+    queue->push(qe);
+  }
+}
+
+void EventSource::moveMouse(MouseFlow& f, long x, long y, bool absolute_coords) {
+  SourceEvent e;
+  e.type = absolute_coords ? SourceEvent::MOVE_MOUSE : SourceEvent::MOVE_MOUSE_REL;
+  e.flow = &f;
+  e.button = null;
+  e.x = x;
+  e.y = y;
+  e.time = 0;
+  post(e);
+}
+
+void EventSource::pressMouse(MouseFlow& f, const UMSbutton* b) {
+  SourceEvent e;
+  e.type = SourceEvent::PRESS_MOUSE;
+  e.flow = &f;
+  e.button = b;
+  e.time = 0;
+  post(e);
+}
+
+void EventSource::releaseMouse(MouseFlow& f, const UMSbutton* b) {
+  SourceEvent e;
+  e.type = SourceEvent::RELEASE_MOUSE;
+  e.flow = &f;
+  e.button = b;
+  e.time = 0;
+  post(e);
+}
+
+void EventSource::postDeviceEvent(int code, double fx, double fy) {
+  SourceEvent e;
+  e.type = SourceEvent::DEVICE;
+  e.flow = null;
+  e.button = null;
+  e.code = code;
+  e.fx = fx;
+  e.fy = fy;
+  e.time = 0;
+  post(e);
+}
+
+// time = 0 means that the event was not queued (the current time is used)
+
+void EventSource::processEvent(const SourceEvent& e) {
+  if (!e.flow) return;
+  UMServer& ums = e.flow->ums;
+  ums.event_time = e.time;
+
+  switch (e.type) {
+    case SourceEvent::MOVE_MOUSE:
+      e.flow->moveMouse(e.x, e.y, true);
+      break;
+    case SourceEvent::MOVE_MOUSE_REL:
+      e.flow->moveMouse(e.x, e.y, false);
+      break;
+    case SourceEvent::PRESS_MOUSE:
+      e.flow->pressMouse(e.button);
+      break;
+    case SourceEvent::RELEASE_MOUSE:
+      e.flow->releaseMouse(e.button);
+      break;
+    default:
+      break;
+  }
+  ums.event_time = 0;
+}
+
 UMSbutton* EventSource::getButton(int btn_number) {
   for (unsigned  int k = 0; k < button_map.size(); k++) {
     if (button_map[k]->in_btn_number == btn_number)
@@ -87,7 +220,7 @@ void EventSource::setButton(int btn_number,
 /* ==================================================== [(c)Elc] ======= */
 // EVENT SOURCES
 
-bool UMServer::addEventSource(EventSource* so) {
+bool UMServer::addEventSource(EventSource* so, bool in_thread) {
   for (unsigned int k = 0; k < sources.size(); k++) {
     if (sources[k] == so) {
       cerr << "!addEventSource: this source is already registered" << endl;
@@ -95,7 +228,7 @@ bool UMServer::addEventSource(EventSource* so) {
     }
   }
 
-  bool stat = addSourceToMainLoop(so);
+  bool stat = in_thread ? so->startThread(source_queue) : addSourceToMainLoop(so);
   if (stat) sources.push_back(so);
   //cout << "addSource: " << so->filedesc() << " status: "<< stat << endl;
   return stat;
@@ -109,6 +242,25 @@ bool UMServer::removeEventSource(EventSource* so) {
     cerr << "!removeEventSource: source not found" << endl;
     return false;
   }
-  else return true;
+  else {
+    if (so->isThreaded()) {
+      so->stopThread();
+      processSourceEvents();   // the queue must not contain events of 'so'
+    }
+    else removeSourceFromMainLoop(so);
+    return true;
+  }
+}
+
+void UMServer::processSourceEvents() {
+  source_queue.clearNotification();
+  while (SourceEvent* e = source_queue.pop()) {
+    e->source->processEvent(*e);
+    delete e;
+  }
+}
+
+TimeID UMServer::getEventTime() const {
+  return event_time != 0 ? event_time : getTime();
 }
 
@@ -17,6 +17,10 @@
 #ifndef _umssource_hpp_
 #define	_umssource_hpp_
 #include <vector>
+#include <atomic>
+#include <pthread.h>
+#include <ubit/udefs.hpp>
+class MouseFlow;
 
 /* ==================================================== ======== ======= */
 /** Mouse button mapping
@@ -39,20 +43,95 @@ struct UMSbutton {
   unsigned int out_mod_mask;    // out_btn_mask not included
 };
 
+/* ==================================================== ======== ======= */
+/** event produced by an EventSource.
+ * these events are queued when the source runs in its own thread (see
+ * EventSource::startThread()) and processed by the main loop.
+ */
+struct SourceEvent {
+  enum Type {MOVE_MOUSE, MOVE_MOUSE_REL, PRESS_MOUSE, RELEASE_MOUSE, DEVICE};
+  Type type;
+  class EventSource* source;
+  MouseFlow* flow;
+  const UMSbutton* button;  ///< PRESS_MOUSE and RELEASE_MOUSE events.
+  long x, y;                ///< MOVE_MOUSE and MOVE_MOUSE_REL events.
+  int code;                 ///< DEVICE events (specific to each source).
+  double fx, fy;            ///< DEVICE events.
+  unsigned long time;       ///< time when the event was read (in millisec).
+  std::atomic<SourceEvent*> next;
+};
+
+/* ==================================================== ======== ======= */
+/** queue of the events produced by the sources that run in their own thread.
+ * this queue is lock-free: events can be pushed by several threads but are
+ * only popped by the main loop, which is notified through getDescriptor().
+ */
+class SourceQueue {
+public:
+  SourceQueue();
+  ~SourceQueue();
+
+  int getDescriptor() const {return fds[0];}
+  ///< readable when events have been pushed.
+
+  void push(SourceEvent*);
+  ///< adds an event (can be called by any thread).
+
+  SourceEvent* pop();
+  /**< removes the oldest event (main thread only).
+   * the event must be deleted by the caller. Returns null if the queue is 
+   * empty (or if an event is being pushed: the main loop is then notified again).
+   */
+
+  void clearNotification();
+  ///< must be called before the events are popped (main thread only).
+
+private:
+  SourceQueue(const SourceQueue&);
+  SourceQueue& operator=(const SourceQueue&);
+  void link(SourceEvent*);          // push() without notification
+  std::atomic<SourceEvent*> head;   // last pushed event
+  SourceEvent* tail;                // next event to pop
+  SourceEvent stub;
+  std::atomic<bool> notified;
+  int fds[2];
+};
+
 /* ==================================================== ======== ======= */
 /**
  * UMS event source.
  */
 class EventSource {
 public:
-  EventSource() {fd = -1;}
+  EventSource() : fd(-1), queue(null), stopping(false) {}
   virtual ~EventSource();
 
   int  filedesc() const {return fd;}
   bool is_open()  const {return fd != -1;}
 
   virtual bool read() {return false;}
-  ///< reads and process incoming data.
+  /**< reads and process incoming data.
+   * this function is called by the main loop, or by the thread of this source
+   * if startThread() was called: the events must then be produced by 
+   * moveMouse(), pressMouse() etc. instead of calling the event flow.
+   */
+
+  virtual void processEvent(const SourceEvent&);
+  /**< processes an event produced by this source (main thread only).
+   * DEVICE events must be processed by subclasses.
+   */
+
+  bool startThread(SourceQueue&);
+  /**< reads the data of this source in a separate thread.
+   * the events produced by read() are pushed on this queue, so that a slow 
+   * device does not delay the other event flows.
+   */
+
+  void stopThread();
+  ///< stops the thread of this source (if any) and waits for its termination.
+
+  bool isThreaded() const {return queue != null;}
+  ///< true if the data is read in a separate thread.
 
   virtual bool canCalibrate() const {return false;}
   virtual void calibrate() {}
@@ -66,8 +145,20 @@ public:
 		 unsigned int out_btn_mask, unsigned int out_mod_mask);
 
 protected:
+  void moveMouse(MouseFlow&, long x, long y, bool absolute_coords);
+  void pressMouse(MouseFlow&, const UMSbutton*);
+  void releaseMouse(MouseFlow&, const UMSbutton*);
+  void postDeviceEvent(int code, double fx, double fy);
+  void post(SourceEvent&);
+  ///< processes the event or pushes it on the queue if this source is threaded.
+  
+  static void* threadMain(void*);
+
   int fd;
   std::vector<UMSbutton*> button_map;
+  SourceQueue* queue;            // null if not threaded
+  pthread_t thread;
+  std::atomic<bool> stopping;
 };
 
 #endif
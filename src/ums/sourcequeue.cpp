@@ -0,0 +1,90 @@
+/*************************************************************************
+ *
+ *  sourcequeue.cpp: queue of the events of the UMS sources.
+ *  Ubit GUI Toolkit - Version 6.0
+ *  (C) 2003-2008 Eric Lecolinet / ENST Paris / www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE : 
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE 
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. 
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU 
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION; 
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#include <iostream>
+#include <unistd.h>
+#include <fcntl.h>
+#include "source.hpp"
+using namespace std;
+
+// intrusive MPSC queue: producers exchange 'head' then link the previous
+// event to the new one; the consumer follows the links from 'tail'. 'stub' 
+// is pushed again when the queue becomes empty so that 'tail' is never null.
+
+SourceQueue::SourceQueue() : head(&stub), tail(&stub), notified(false) {
+  stub.next = null;
+  if (pipe(fds) < 0) {
+    cerr << "SourceQueue: can't create pipe" << endl;
+    fds[0] = fds[1] = -1;
+  }
+  else for (int k = 0; k < 2; k++) {
+    fcntl(fds[k], F_SETFL, fcntl(fds[k], F_GETFL) | O_NONBLOCK);
+    fcntl(fds[k], F_SETFD, FD_CLOEXEC);
+  }
+}
+
+SourceQueue::~SourceQueue() {
+  while (SourceEvent* e = pop()) delete e;
+  if (fds[0] >= 0) {::close(fds[0]); ::close(fds[1]);}
+}
+
+void SourceQueue::link(SourceEvent* e) {
+  e->next.store(null, memory_order_relaxed);
+  SourceEvent* prev = head.exchange(e, memory_order_acq_rel);
+  prev->next.store(e, memory_order_release);
+}
+
+void SourceQueue::push(SourceEvent* e) {
+  link(e);
+
+  // the main loop is only notified once until it calls clearNotification()
+  if (!notified.exchange(true)) {
+    char c = 0;
+    if (::write(fds[1], &c, 1) < 0) {}   // the pipe is full: already notified
+  }
+}
+
+SourceEvent* SourceQueue::pop() {
+  SourceEvent* t = tail;
+  SourceEvent* next = t->next.load(memory_order_acquire);
+  if (t == &stub) {
+    if (!next) return null;
+    tail = t = next;
+    next = next->next.load(memory_order_acquire);
+  }
+  if (next) {
+    tail = next;
+    return t;
+  }
+  // 't' is the last event or an event is being pushed
+  if (t != head.load(memory_order_acquire)) return null;
+  link(&stub);   // the stub is not an event: the main loop is not notified
+  next = t->next.load(memory_order_acquire);
+  if (next) {
+    tail = next;
+    return t;
+  }
+  return null;
+}
+
+void SourceQueue::clearNotification() {
+  char buf[64];
+  while (::read(fds[0], buf, sizeof(buf)) > 0) ;
+  notified.store(false);
+}
+
+/* ==================================================== [TheEnd] ======= */
+/* ==================================================== [(c)Elc] ======= */
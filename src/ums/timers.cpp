@@ -0,0 +1,114 @@
+/*************************************************************************
+ *
+ *  timers.cpp: timers of the UMS server.
+ *  Ubit GUI Toolkit - Version 6.0
+ *  (C) 2003-2008 Eric Lecolinet / ENST Paris / www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE : 
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE 
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. 
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU 
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION; 
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#include <cstddef>
+#include "timers.hpp"
+using namespace std;
+
+struct TimerWheel::Timer {
+  unsigned long expiry;   // in ticks
+  Callback callback;      // null if the timer was removed
+  void* data;
+};
+
+TimerWheel::TimerWheel() : slots(SLOT_COUNT), cur_tick(0), count(0) {}
+
+TimerWheel::~TimerWheel() {
+  for (unsigned int k = 0; k < slots.size(); k++) {
+    for (Slot::iterator t = slots[k].begin(); t != slots[k].end(); t++) delete *t;
+  }
+}
+
+/* ==================================================== ======== ======= */
+
+TimerWheel::Timer* TimerWheel::add(unsigned long now, unsigned long delay,
+                                   Callback c, void* data) {
+  if (!c) return NULL;
+  unsigned long now_tick = now / TICK;
+  // the wheel can be moved forward if there is nothing to process
+  if (count == 0 || cur_tick == 0) cur_tick = now_tick;
+
+  Timer* t = new Timer;
+  // rounded up: the timer never fires before the delay
+  t->expiry = now_tick + (delay + TICK - 1) / TICK;
+  if (t->expiry <= cur_tick) t->expiry = cur_tick + 1;
+  t->callback = c;
+  t->data = data;
+  slots[t->expiry % SLOT_COUNT].push_back(t);
+  count++;
+  return t;
+}
+
+// the timer is deleted when its slot is processed (in fire())
+void TimerWheel::remove(Timer* t) {
+  if (!t || !t->callback) return;
+  t->callback = NULL;
+  count--;
+}
+
+long TimerWheel::getTimeout(unsigned long now) const {
+  if (count == 0) return -1;
+  unsigned long now_tick = now / TICK;
+  if (now_tick < cur_tick) now_tick = cur_tick;
+
+  // the first slot that contains a timer expiring during this revolution
+  for (unsigned long tick = cur_tick + 1; tick <= cur_tick + SLOT_COUNT; tick++) {
+    const Slot& s = slots[tick % SLOT_COUNT];
+    for (Slot::const_iterator t = s.begin(); t != s.end(); t++) {
+      if ((*t)->callback && (*t)->expiry == tick)
+        return tick <= now_tick ? 0 : (tick - now_tick) * TICK;
+    }
+  }
+  // only timers of the next revolutions: wakes up when this one is completed
+  return (cur_tick + SLOT_COUNT - now_tick) * TICK;
+}
+
+void TimerWheel::fire(unsigned long now) {
+  unsigned long now_tick = now / TICK;
+  if (cur_tick == 0 || now_tick <= cur_tick) {
+    if (cur_tick == 0) cur_tick = now_tick;
+    return;
+  }
+  // all the slots are processed once if more than a revolution has elapsed
+  unsigned long from = cur_tick + 1;
+  if (now_tick - cur_tick > SLOT_COUNT) from = now_tick - SLOT_COUNT + 1;
+  cur_tick = now_tick;   // timers added by the callbacks expire after now_tick
+
+  for (unsigned long tick = from; tick <= now_tick; tick++) {
+    Slot expired;
+    Slot& s = slots[tick % SLOT_COUNT];
+    for (Slot::iterator t = s.begin(); t != s.end(); ) {
+      if (!(*t)->callback || (*t)->expiry <= now_tick) {
+        expired.push_back(*t);
+        t = s.erase(t);
+      }
+      else t++;
+    }
+    for (Slot::iterator t = expired.begin(); t != expired.end(); t++) {
+      // the callback may remove other timers (but not this one)
+      if ((*t)->callback) {
+        count--;
+        Callback c = (*t)->callback;
+        (*t)->callback = NULL;
+        c((*t)->data);
+      }
+      delete *t;
+    }
+  }
+}
+
+/* ==================================================== [TheEnd] ======= */
+/* ==================================================== [(c)Elc] ======= */
@@ -0,0 +1,62 @@
+/*************************************************************************
+ *
+ *  timers.hpp: timers of the UMS server.
+ *  Ubit GUI Toolkit - Version 6.0
+ *  (C) 2003-2008 Eric Lecolinet / ENST Paris / www.enst.fr/~elc/ubit
+ *
+ * ***********************************************************************
+ * COPYRIGHT NOTICE : 
+ * THIS PROGRAM IS DISTRIBUTED WITHOUT ANY WARRANTY AND WITHOUT EVEN THE 
+ * IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE. 
+ * YOU CAN REDISTRIBUTE IT AND/OR MODIFY IT UNDER THE TERMS OF THE GNU 
+ * GENERAL PUBLIC LICENSE AS PUBLISHED BY THE FREE SOFTWARE FOUNDATION; 
+ * EITHER VERSION 2 OF THE LICENSE, OR (AT YOUR OPTION) ANY LATER VERSION.
+ * SEE FILES 'COPYRIGHT' AND 'COPYING' FOR MORE DETAILS.
+ * ***********************************************************************/
+
+#ifndef _umstimers_hpp_
+#define	_umstimers_hpp_
+#include <vector>
+#include <list>
+
+/* ==================================================== ======== ======= */
+/** hashed timer wheel.
+ * timers are stored in the slot that corresponds to their expiration tick,
+ * so that adding, removing and firing timers does not depend on the number
+ * of timers. The main loop calls getTimeout() to know how long it can wait
+ * and fire() when it wakes up.
+ */
+class TimerWheel {
+public:
+  enum {TICK = 10, SLOT_COUNT = 512};  ///< TICK is in millisec.
+  typedef void (*Callback)(void* data);
+  struct Timer;
+
+  TimerWheel();
+  ~TimerWheel();
+
+  Timer* add(unsigned long now, unsigned long delay, Callback, void* data);
+  /**< adds a timer that calls callback(data) 'delay' millisec after 'now'.
+   * the returned handle can be given to remove() until the callback is called
+   * (it is no longer valid after this call).
+   */
+
+  void remove(Timer*);
+  ///< removes a timer that has not yet been fired.
+
+  long getTimeout(unsigned long now) const;
+  ///< returns the delay until the next timer expires (in millisec), -1 if none.
+
+  void fire(unsigned long now);
+  ///< calls the callbacks of the timers that have expired.
+
+private:
+  typedef std::list<Timer*> Slot;
+  std::vector<Slot> slots;
+  unsigned long cur_tick;   // last tick that was processed
+  unsigned int count;       // number of active timers
+};
+
+#endif
+/* ==================================================== [TheEnd] ======= */
+/* ==================================================== [(c)Elc] ======= */
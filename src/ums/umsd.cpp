@@ -84,7 +84,7 @@ private:
   int argc; char** argv;
   const char *display_name, *public_dir;
   int cursor_mode, neighbor_mode;
-  bool test_ums, kill_ums, force_ums, emulate_buttons, reuse_address;
+  bool test_ums, kill_ums, force_ums, emulate_buttons, reuse_address, threads;
   int umsport;
   UMServer* ums;
   vector <Device>  idevices;
@@ -113,7 +113,7 @@ static void restart(int s) {
 }
 
 static void ignore(int s) {
-  signal(s, ignore);
+  signal(s, ::ignore);
 }
 
 static void end(int s) {
@@ -133,6 +133,7 @@ UMSD::UMSD() :
   force_ums(false),
   emulate_buttons(false),
   reuse_address(false),
+  threads(false),
   umsport(0),    // will use UMS_PORT_NUMBER
   ums(null)
 {    
@@ -150,7 +151,7 @@ UMSD::UMSD() :
 
   // il ne faut rien faire en cas de SIGPIPE (= deconnexion abusive), 
   // c'est prevue (et surtout ne pas planter le serveur dans ce cas!)
-  signal(SIGPIPE, ignore);
+  signal(SIGPIPE, ::ignore);
 
   //atexit(cleanup); inutile
 }
@@ -267,7 +268,7 @@ void UMSD::start() {
 
     if (so->is_open()) {
       cout << " - Input device opened on: "<< idevices[d].dev_name << endl;
-      ums->addEventSource(so);
+      ums->addEventSource(so, threads);
     }
     else  {
       cerr << "!!! Can't open input device on: " << idevices[d].dev_name
@@ -378,6 +379,7 @@ void UMSD::usage() {
   << "Devices and pointers:" << endl
   << "   -mi[mio] dev ptr           : add MIMIO input on device (default ptr = 0)" << endl
   << "   -mo[use] dev ptr           : add serial mouse on device (default ptr = 1)" << endl
+  << "   -th[reads]                 : read each input device in a separate thread" << endl
     //<< "   -tact dev                  : add tactile output on device" << endl
   << "   -p[ointer] ptr fgcol bgcol : set pointer colors" << endl
   << "   with: "<< endl
@@ -495,6 +497,10 @@ void UMSD::parseOptions(int _argc, char *_argv[]) {
       else {cerr << "usage : -port postnumber" << endl; exit(1);}
     }
 
+    else if (testOption(k,"-th","reads")) {
+      threads = true;
+    }
+
     else if (testOption(k,"-r","euse")) {
       reuse_address = true;
     }
@@ -33,6 +33,7 @@
 //EX: include <ubit/ubit_config.h>
 #include <ubit/umsproto.hpp>
 #include <ubit/umservice.hpp>
+#include <ubit/usharedring.hpp>
 #include "umserver.hpp"
 #include "source.hpp"
 #include "flow.hpp"
@@ -149,9 +150,13 @@ Cnx::Cnx(USocket* s) {
   sock = s; 
   //app_name = _app_name;
   browse_servers = browse_neigbors = browse_windows = false;
+  protocol = 1;
+  ring = null;
+  handshake_time = 0;
 }
 
 Cnx::~Cnx() {
+  delete ring;
   delete sock;
   // if (sock > 0) {
   //  ::shutdown(sock, 2);
@@ -163,9 +168,11 @@ Cnx::~Cnx() {
 /* ==================================================== ======== ======= */
 
 UMServer::~UMServer() {
+  delete local_sock;   // removes the socket file
   delete mdns;
   delete &events;
   for (unsigned int k = 0; k < sources.size(); k++) delete sources[k];
+  delete &source_queue;   // after the sources: their threads are stopped
   for (unsigned int k = 0; k < eflows.size(); k++) delete eflows[k];
   for (CnxList::iterator c = cnxs.begin(); c != cnxs.end(); c++) delete *c;
 }
@@ -175,10 +182,13 @@ UMServer::~UMServer() {
 UMServer::UMServer(const char* display_name, int port, bool reuse_address,
                    int cursor_mode, int neighbor_mode) :
 is_init(false),
+local_sock(null),
 events(*new Events(this)),
 edges(null),
 calib(null),
 mdns(null),
+source_queue(*new SourceQueue()),
+event_time(0),
 natsource(*new EventSource()) {
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -218,7 +228,7 @@ natsource(*new EventSource()) {
     serv_sock = null;
   }
   
-  if (serv_sock->getLocalPort() != port) {
+  if (serv_sock && serv_sock->getLocalPort() != port) {
     if (reuse_address)
       cerr << " ! UMServer: port " << port << " is busy; using a different port: "
         << serv_sock->getLocalPort()  << endl;
@@ -228,6 +238,20 @@ natsource(*new EventSource()) {
     }    
   }
 
+#ifdef __linux__
+  // fast path for local clients (see UMS_LOCAL_SOCKET)
+  if (serv_sock) {
+    char path[100];
+    sprintf(path, UMS_LOCAL_SOCKET, serv_sock->getLocalPort());
+    local_sock = new UServerSocket();
+    if (!local_sock->bindLocal(path)) {
+      cerr << " ! UMServer: can't open local socket " << path << endl;
+      delete local_sock;
+      local_sock = null;
+    }
+  }
+#endif
+
   if (!serv_sock) {
     cerr
       << "!!! Can't open socket on port "<< UMS_PORT_NUMBER
@@ -473,6 +497,10 @@ Cnx* UMServer::addCnx(USocket* s) {
   if (k != cnxs.end()) return *k;
   // not in the list
   Cnx* c = new Cnx(s);
+  // requests are read without blocking: see runMainLoop(). Replies that can't
+  // be written at once are queued by the socket and flushed by runMainLoop()
+  // when the connection becomes writable
+  s->setNonBlocking(true);
   addSourceToMainLoop(s);
   cnxs.push_back(c);
   return c;
@@ -481,11 +509,65 @@ Cnx* UMServer::addCnx(USocket* s) {
 void UMServer::removeCnx(USocket* s) {
   CnxList::iterator k = findCnxIt(s);
   if (k != cnxs.end()) {       // in the list
+    if ((*k)->ring) removeSourceFromMainLoop((*k)->ring);
+    removeSourceFromMainLoop(s);
     delete *k;
     cnxs.erase(k);
   }
 }
 
+// the client sends the descriptors of its ring just after connecting
+// (none if it can't create the ring). they are received by receiveLocalRing()
+// when the socket becomes readable so that the main loop is not blocked.
+// the requests are then read from the ring and the replies are sent on the socket
+
+Cnx* UMServer::addLocalCnx(USocket* s) {
+  Cnx* c = addCnx(s);
+  c->handshake_time = getTime();
+  return c;
+}
+
+// returns false and closes the socket if the descriptors could not be received
+
+bool UMServer::receiveLocalRing(Cnx* c) {
+  int fds[2];
+  int count = c->sock->receiveDescriptors(fds, 2, 0);
+  c->handshake_time = 0;
+  if (count < 0) {
+    c->sock->close();
+    return false;
+  }
+  
+  if (count == 2) {
+    c->ring = new USharedRing();
+    if (!c->ring->attach(fds[0], fds[1])    // closes fds if it fails
+        || !addSourceToMainLoop(c->ring, c->sock)) {
+      delete c->ring;
+      c->ring = null;
+    }
+  }
+  else {
+    for (int k = 0; k < count; k++) ::close(fds[k]);
+  }
+  return true;
+}
+
+// the main loop is not notified when a socket is closed because a reply
+// could not be sent: such connections are removed periodically, as well as
+// the local clients that did not send their ring
+
+void UMServer::removeClosedCnxs() {
+  TimeID now = getTime();
+  CnxList::iterator k2;
+  for (CnxList::iterator k = cnxs.begin(); k != cnxs.end(); k = k2) {
+    k2 = k; k2++;
+    Cnx* c = *k;
+    if (!c->sock->isConnected()
+        || (c->handshake_time != 0 && now - c->handshake_time > LOCAL_HANDSHAKE_DELAY))
+      removeCnx(c->sock);
+  }
+}
+
 CnxList::iterator UMServer::findCnxIt(USocket* s) {
   for (CnxList::iterator k = cnxs.begin(); k != cnxs.end(); k++) {
     if ((*k)->sock == s) return k;
@@ -989,14 +1071,21 @@ void UMServer::getAndProcessXEvents() {
     //cerr <<"ConfigureNotify " << e.xconfigure.window << endl;
 
     // chercher si window et above sont dans la liste
-    WinList::iterator window = wins.end();
-    WinList::iterator above = wins.end();
-
-    for (WinList::iterator k = wins.begin(); k != wins.end(); k++) {
-      if ((*k)->win == e.xconfigure.window) window = k;
-      if ((*k)->win == e.xconfigure.above)  above = k;
-    }
-    if (window == wins.end()) return;  // not found
+    WinList::iterator window = findWinIt(e.xconfigure.window);
+    if (window == wins.end() || (*window)->win != e.xconfigure.window) 
+      return;  // not found
+
+    // the geometry is cached (see getXWin())
+    Win* w = *window;
+    w->x = e.xconfigure.x;
+    w->y = e.xconfigure.y;
+    w->width = e.xconfigure.width;
+    w->height = e.xconfigure.height;
+    w->border = e.xconfigure.border_width;
+    
+    WinList::iterator above = findWinIt(e.xconfigure.above);
+    if (above != wins.end() && (*above)->win != e.xconfigure.above) 
+      above = wins.end();
 
     if (e.xconfigure.above == None) {
       // window est au debut de rien => deplacer en debut de liste
@@ -1050,6 +1139,10 @@ void UMServer::getAndProcessXEvents() {
     removeWin(e.xdestroywindow.window, true/*notify*/);
     return;
 
+  case PropertyNotify:    // the name of a window may have changed
+    updateWinProperty(e.xproperty.window, e.xproperty.atom);
+    return;
+
   //case FocusIn:
     //cerr << "FocusIn "<< e.xconfigure.window << " " << xrootwin << endl;
     //break;
@@ -25,10 +25,13 @@
 #define	_umserver_hpp_
 #include <vector>
 #include <list>
+#include <map>
 #include <iostream>
 #include <string>
 #include <ubit/udefs.hpp>
 #include <ubit/usocket.hpp>
+#include "timers.hpp"
+namespace ubit {class USharedRing;}
 using namespace ubit;
 
 #if (defined(__MACH__) && defined(__APPLE__))
@@ -107,6 +110,12 @@ struct Win {
   WindowID win, client_win;
   unsigned char* ubit_prop;
   
+  // mirror of the X server state, updated by the X events (see addWin())
+  int x, y;                     ///< position in the root window.
+  unsigned int width, height, border;
+  std::string name, client_name;///< WM_NAME of win and client_win.
+  std::string res_class;        ///< WM_CLASS of client_win (class name).
+  
 private:
   Win(const Win&);
   Win& operator=(const Win&);
@@ -123,6 +132,10 @@ struct Cnx {
 
   class USocket* sock;
   bool browse_servers, browse_neigbors, browse_windows;
+  USharedRing* ring;  // requests of local clients (null otherwise)
+  TimeID handshake_time;  // != 0 until a local client has sent its ring
+  int protocol;  // version of the protocol (see UMS_PROTOCOL_VERSION)
+  std::map<int, std::pair<long,long> > motions;  // last motion of each flow
 };
 
 typedef std::list<Cnx*> CnxList;
@@ -154,6 +167,12 @@ public:
   /// attempt to re-connect (if connection failed) after this delay
   static const TimeID NEIGHBOR_RETRY_DELAY = 6*1000;  // 1 mn
 
+  /// the connections that were closed by a failed write are removed after this delay
+  static const TimeID CNX_CHECK_DELAY = 10*1000;
+
+  /// local clients that haven't sent their ring after this delay are removed (see UMS_LOCAL_SOCKET)
+  static const TimeID LOCAL_HANDSHAKE_DELAY = 5*1000;
+
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - 
 
   UMServer(const char* display_name, int ums_port, bool reuse_address,
@@ -224,9 +243,11 @@ public:
   std::string resolveDeviceName(const char*);
   ///< returns the /dev/ttxx name from a shortcut.
 
-  bool addEventSource(EventSource*);
+  bool addEventSource(EventSource*, bool in_thread = false);
   /**< adds an event source.
    * NB: - several event sources can be created
+   *     - the source is read in a separate thread if 'in_thread' is true
+   *       (see EventSource::startThread())
    * Return value:
    *     - true if this source could be added (ie. if this source
    *       was not previously registered)
@@ -290,6 +311,8 @@ public:
   CnxList::iterator findCnxIt(USocket*);
   Cnx* findCnx(USocket*);
   Cnx* addCnx(USocket*);
+  Cnx* addLocalCnx(USocket*);
+  bool receiveLocalRing(Cnx*);
   void removeCnx(USocket*);
   
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - 
@@ -322,7 +345,13 @@ public:
   Win* findWin(const char* name);
   Win* findWin(WindowID);
   WinList::iterator findWinIt(WindowID);
-  ///< searches a window from its name or its ID in the X window list.
+  /**< searches a window from its name or its ID in the X window list.
+   * the name can be the WM_NAME of the window or the class of the application.
+   * these functions do not query the X server (see addWin()).
+   */
+
+  void updateWinProperty(WindowID, AtomID);
+  ///< updates the cached properties of the Win after a PropertyNotify event.
 
   bool getXWin(int root_x, int root_y, Pos&, bool check_props);
   ///< returns the window and pos that contains this point.
@@ -347,6 +376,9 @@ public:
 
   static TimeID getTime();     ///< in millisec.
 
+  TimeID getEventTime() const;
+  ///< time when the event being processed was read (the current time by default).
+
   class UServerSocket* getServerSocket() {return serv_sock;}
   WinList& getWins() {return wins;}
   CnxList& getCnxs() {return cnxs;}
@@ -363,13 +395,20 @@ public:
 
   bool addSourceToMainLoop(USocket*);
   bool addSourceToMainLoop(EventSource*);
+  bool addSourceToMainLoop(USharedRing*, USocket*);
+  void removeSourceFromMainLoop(USocket*);
+  void removeSourceFromMainLoop(EventSource*);
+  void removeSourceFromMainLoop(USharedRing*);
   void initMainLoop();
   void runMainLoop();
+  void removeClosedCnxs();
+  void processSourceEvents();
 
   // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - 
 
   bool is_init;
   class UServerSocket* serv_sock;
+  class UServerSocket* local_sock;   ///< for local clients (null if not supported).
   int xconnection;
   XDisplay* xdisplay;
   XScreen*  xscreen;
@@ -379,6 +418,9 @@ public:
   struct Edges* edges;
   struct Calibration* calib;
   struct Mdns* mdns;
+  TimerWheel timers;        ///< timers fired by the main loop.
+  class SourceQueue& source_queue;  ///< events of the threaded sources.
+  TimeID event_time;        ///< see getEventTime().
   std::string hostname, system, public_dir;
   EventSource& natsource;   ///< the native event source.
 
@@ -391,9 +433,12 @@ public:
   /// lists of connections (= connected applications) and their opened windows
   CnxList cnxs;
 
-  /// list of the windows of this X server
+  /// list of the windows of this X server (in stacking order, top-most last)
   WinList wins;
 
+  /// index of 'wins' (both win and client_win are keys)
+  std::map<WindowID, WinList::iterator> win_index;
+
   /// the list of RemoteUMS that are currently browsed.
   RemoteUMSList remotes;
 
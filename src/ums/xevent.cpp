@@ -57,7 +57,7 @@ TimeID UMServer::getTime() {
   timeval time;
   gettimeofday(&time, 0);
   FIX_TIME(time);
-  return time.tv_sec * 1000 + time.tv_usec % 1000;
+  return time.tv_sec * 1000 + time.tv_usec / 1000;
 }
 
 /* ==================================================== ======== ======= */
@@ -159,7 +159,7 @@ void Events::sendXKey(MouseFlow& flow, unsigned long keysym,
   e.xkey.window    = pos.win;     // event window it is reported relative to
   e.xkey.root      = ums.xrootwin;    // root window that the event occurred on
   e.xkey.subwindow = None;        // child window: utile??
-  e.xkey.time      = ums.getTime();   // milliseconds
+  e.xkey.time      = ums.getEventTime();   // milliseconds
   e.xkey.x         = pos.wx;      // pointer x, y coordinates in event window
   e.xkey.y         = pos.wy;
   e.xkey.x_root    = pos.rx;      // coordinates relative to root
@@ -256,7 +256,7 @@ void Events::sendXButton(MouseFlow& flow, int btn_id,
   e.xbutton.window    = pos.win;     // event window it is reported relative to
   e.xbutton.root      = ums.xrootwin;    // root window that the event occurred on
   e.xbutton.subwindow = None;        // child window: 
-  e.xbutton.time      = ums.getTime();   // milliseconds
+  e.xbutton.time      = ums.getEventTime();   // milliseconds
   e.xbutton.x         = pos.wx;      // pointer x, y coordinates in event window
   e.xbutton.y         = pos.wy;
   e.xbutton.x_root    = pos.rx;      // coordinates relative to root
@@ -305,7 +305,7 @@ static void sendXCrossingEvent(UMServer& ums, MouseFlow& flow,
   e.xcrossing.window     = pos.win;
   e.xcrossing.root       = ums.xrootwin;
   e.xcrossing.subwindow  = None;
-  e.xcrossing.time       = ums.getTime();
+  e.xcrossing.time       = ums.getEventTime();
   e.xcrossing.x          = pos.wx;
   e.xcrossing.y          = pos.wy;
   e.xcrossing.x_root     = pos.rx;
@@ -343,13 +343,11 @@ static void sendXCrossingEvent(UMServer& ums, MouseFlow& flow,
 
 void Events::sendXMotion(MouseFlow& flow, long x, long y,bool move_ptr) {
   if (move_ptr) {
-    if (flow.id == 0)
+    if (flow.id == 0) {
       XWarpPointer(ums.xdisplay, ums.xrootwin, ums.xrootwin, 0, 0, 0, 0, x, y);
-    else if (flow.getPointer() != None) {
-      XMoveWindow(ums.xdisplay, flow.getPointer(), x, y);
-      XRaiseWindow(ums.xdisplay, flow.getPointer());     // always on top !
+      XFlush(ums.xdisplay);
     }
-    XFlush(ums.xdisplay);
+    else flow.movePointer(x, y);     // extrapolated by the motion model
   }
   
   // cas pointeur natif X 
@@ -391,7 +389,7 @@ void Events::sendXMotion(MouseFlow& flow, long x, long y,bool move_ptr) {
   e.xmotion.window     = pos.win;
   e.xmotion.root       = ums.xrootwin;
   e.xmotion.subwindow  = None;
-  e.xmotion.time       = ums.getTime();
+  e.xmotion.time       = ums.getEventTime();
   e.xmotion.x          = pos.wx;
   e.xmotion.y          = pos.wy;
   e.xmotion.x_root     = pos.rx;
@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <X11/Xlib.h>
+#include <X11/Xutil.h>
 #include <X11/Xatom.h>
 #include <X11/Xmu/WinUtil.h>
 #include <ubit/umsproto.hpp>
@@ -33,7 +34,8 @@ Win::Win(Window _win, Window _client_win) :
   is_input_only(false), is_icon(false),
   win_sock(-1),
   win(_win), client_win(_client_win),
-  ubit_prop(null) {
+  ubit_prop(null),
+  x(0), y(0), width(0), height(0), border(0) {
 }
 
 Win::~Win() {
@@ -45,10 +47,9 @@ Win::~Win() {
 
 WinList::iterator UMServer::findWinIt(WindowID win) {
   if (win != None) {
-    for (WinList::iterator k = wins.begin(); k != wins.end(); k++) {
-      // chercher si c'est win OU client_win (ca varie selon les cas)
-      if ((*k)->win == win || (*k)->client_win == win) return k;
-    }
+    // chercher si c'est win OU client_win (ca varie selon les cas)
+    map<WindowID, WinList::iterator>::iterator k = win_index.find(win);
+    if (k != win_index.end()) return k->second;
   }
   return wins.end();  // not found
 }
@@ -80,38 +81,66 @@ static bool isMatchingPattern(const char* pattern, const char* wname) {
 }
 */
 
-// NB: considere la version courante du wname (via XFetchName) laquelle
-// peut changer si modifiee par l'application (par ex. Mozilla, etc.)
+// NB: considere la version courante du wname laquelle peut changer si 
+// modifiee par l'application (par ex. Mozilla, etc.): les noms sont mis
+// a jour par les PropertyNotify (see updateWinProperty())
 
 Win* UMServer::findWin(const char* pattern) {
   if (!pattern || !*pattern) return null;
 
-  for (WinList::iterator k = wins.begin(); k != wins.end(); k++) {
-    if (!(*k)->is_override && !(*k)->is_input_only && !(*k)->is_icon
-	// ?? && (*k)->win->is_shown ??
-	) {
-      bool found = false;
-      char* n = null;
-
+  // the names are searched first, then the classes of the applications
+  for (int pass = 0; pass < 2; pass++) {
+    for (WinList::iterator k = wins.begin(); k != wins.end(); k++) {
+      Win* w = *k;
+      if (w->is_override || w->is_input_only || w->is_icon
+          // ?? || !w->is_shown ??
+          ) continue;
+      
       // respecter case sinon ambiguites!
-      if (XFetchName(xdisplay,(*k)->win,&n) && n && strstr(n,pattern)) 
-	found = true;
-      if (n) XFree(n);
-
-      if (!found) {
-	n = null;
-	if (XFetchName(xdisplay,(*k)->client_win,&n) && n && strstr(n,pattern)) 
-	  found = true;
-	if (n) XFree(n);
+      if (pass == 0) {
+        if (strstr(w->name.c_str(), pattern) || strstr(w->client_name.c_str(), pattern))
+          return w;
       }
-
-      //if (found)fprintf(stderr, "FOUND: %x %x %s \n", (*k)->win, (*k)->client_win,n);
-      if (found) return *k;
+      else if (strstr(w->res_class.c_str(), pattern)) return w;
     }
   }
   return null;
 }
 
+static void fetchName(XDisplay* xdisplay, WindowID win, std::string& name) {
+  char* n = null;
+  name.clear();
+  if (XFetchName(xdisplay, win, &n) && n) name = n;
+  if (n) XFree(n);
+}
+
+static void fetchClass(XDisplay* xdisplay, WindowID win, std::string& res_class) {
+  XClassHint hint;
+  hint.res_name = hint.res_class = null;
+  res_class.clear();
+  if (XGetClassHint(xdisplay, win, &hint)) {
+    if (hint.res_class) res_class = hint.res_class;
+    if (hint.res_name) XFree(hint.res_name);
+    if (hint.res_class) XFree(hint.res_class);
+  }
+}
+
+// PropertyChangeMask is selected on win and client_win by addWin()
+
+void UMServer::updateWinProperty(WindowID win, AtomID prop) {
+  if (prop != XA_WM_NAME && prop != XA_WM_CLASS) return;
+  Win* w = findWin(win);
+  if (!w) return;
+  
+  if (prop == XA_WM_CLASS) {
+    if (win == w->client_win) fetchClass(xdisplay, win, w->res_class);
+  }
+  else {
+    if (win == w->win) fetchName(xdisplay, win, w->name);
+    if (win == w->client_win) fetchName(xdisplay, win, w->client_name);
+  }
+}
+
 /* ==================================================== ======== ======= */
 /*
  Win* UMServer::findWinCommand(const char* pattern) {
@@ -156,12 +185,35 @@ Win* UMServer::addWin(WindowID win, bool notify) {
 
   Win* w = new Win(win, client_win);
   wins.push_back(w);
+  WinList::iterator it = wins.end(); --it;
+  win_index[win] = it;
+  if (client_win != None) win_index[client_win] = it;
 
+  // the geometry is then updated by ConfigureNotify events and the names by
+  // PropertyNotify events. The event mask of this client is preserved
+  // (some of these windows are created by the UMS)
   XWindowAttributes a;
   if (XGetWindowAttributes(xdisplay, win, &a)) {
     if (a.map_state == IsViewable) w->is_shown = true;
     if (a.override_redirect) w->is_override = true;
     if (a.c_class == InputOnly) w->is_input_only = true;
+    w->x = a.x;
+    w->y = a.y;
+    w->width = a.width;
+    w->height = a.height;
+    w->border = a.border_width;
+    if (a.c_class != InputOnly)
+      XSelectInput(xdisplay, win, a.your_event_mask | PropertyChangeMask);
+  }
+  if (client_win != None && client_win != win
+      && XGetWindowAttributes(xdisplay, client_win, &a)
+      && a.c_class != InputOnly)
+    XSelectInput(xdisplay, client_win, a.your_event_mask | PropertyChangeMask);
+
+  fetchName(xdisplay, win, w->name);
+  if (client_win != None) {
+    fetchName(xdisplay, client_win, w->client_name);
+    fetchClass(xdisplay, client_win, w->res_class);
   }
 
   XWMHints* wm_hints = XGetWMHints(xdisplay, win);
@@ -187,6 +239,8 @@ void UMServer::removeWin(Window win, bool notify) {
   WinList::iterator k = findWinIt(win);
   if (k != wins.end()) {       // in the list
     if (notify) sendWindowState(*k, Win::DESTROY);
+    win_index.erase((*k)->win);
+    if ((*k)->client_win != None) win_index.erase((*k)->client_win);
     delete *k;
     wins.erase(k);
   }
@@ -198,9 +252,12 @@ void UMServer::reorderWin(WinList::iterator& from,
 			  const WinList::iterator& to) {
   // on transfere l'objet pointe de from a to
   // on evite ainsi une creation et une destruction d'objet
-  wins.insert(to, *from);
+  Win* w = *from;
+  WinList::iterator it = wins.insert(to, w);
   *from = null;          // from ne pointe plus sur rien
   wins.erase(from);
+  win_index[w->win] = it;
+  if (w->client_win != None) win_index[w->client_win] = it;
 }
 
 /* ==================================================== ===== ======= */
@@ -213,7 +270,9 @@ void UMServer::retrieveXWindows() {
   Window* windows = NULL;
   unsigned int wcount = 0;
 
+  for (WinList::iterator k = wins.begin(); k != wins.end(); k++) delete *k;
   wins.clear();
+  win_index.clear();
 
   // The children are listed in current stacking order, from bottom-most 
   // (first) to top-most (last).
@@ -310,9 +369,7 @@ void UMServer::showWindows() {
 
 bool UMServer::getXWin(int rx, int ry, Pos& pos, bool check_props) {
   Win* found_w = null;
-  Window root_win = None;
-  int x, y;
-  unsigned int width, height, border, depth;
+  Window root_win = xrootwin;   // tjrs vrai si 1 seul screen
 
   pos.win = None;
   pos.win_sock = -1;
@@ -328,24 +385,23 @@ bool UMServer::getXWin(int rx, int ry, Pos& pos, bool check_props) {
   // !ATT: cette liste ne doit contenir que les window filles de xrootwin
   // (cad les window du WM qui contiennent celles des applis
   // ou les window override_redirect des menus)
+  // la geometrie de ces windows est connue (see addWin()): seules les 
+  // subwindows de la window trouvee sont demandees au serveur X.
+  // la liste est parcourue du haut vers le bas de la pile des windows
 
-  for (WinList::iterator k = wins.begin(); k != wins.end(); k++) {
+  for (WinList::reverse_iterator k = wins.rbegin(); k != wins.rend(); k++) {
 
     // !ATT: x et y sont relatifs a la parent window. il ne faut donc
     // considerer que les filles de root_win (ce qui est le cas ici)
     // sinon il faudrait translater les coords par XTranslateCoordinates
 
     if ((*k)->is_shown
-        && XGetGeometry(xdisplay, (*k)->win, &root_win,
-                        &x, &y, &width, &height, &border, &depth)
-        && root_win == xrootwin      // tjrs vrai si 1 seul screen
-        && rx >= x && rx < int(x + width)
-        && ry >= y && ry < int(y + height)
+        && rx >= (*k)->x && rx < int((*k)->x + (*k)->width)
+        && ry >= (*k)->y && ry < int((*k)->y + (*k)->height)
         ) {
 
       // trouver la subwindow de root_children[k] qui contient rx,ry
       // et coords dans cette subwindow
-      found_w = *k;
       Window win = (*k)->win;
 
 #if TST
@@ -374,6 +430,11 @@ bool UMServer::getXWin(int rx, int ry, Pos& pos, bool check_props) {
           win = win_child;
         }
       }
+      
+      if (pos.win != None) {   // otherwise the window has been destroyed
+        found_w = *k;
+        break;
+      }
     }
   }
 
@@ -465,29 +526,19 @@ bool UMServer::getXSubwin(const Pos& winpos, int x, int y, Pos& pos) {
 
 bool UMServer::getXWinPos(const Win* w, Pos& pos) {
   if (!w || !w->win) return false;
-  int x, y;
-  unsigned int win_width, win_height, win_border, win_depth;
-  Window root_win = None;
-  Window win_child = None;
   pos.win = None;
   pos.win_sock = -1;
   pos.wx = pos.wy = 0;
   pos.rx = pos.ry = 0;
 
   // !NB: XGetGeometry ne donne pas les coords absolues dans le cas des Shells
-  // car ceux-ci sont inclus dans une fenetre intermediaire cree par le WM
-  if (XGetGeometry(xdisplay, w->win, &root_win,
-                   &x, &y, &win_width, &win_height,
-                   &win_border, &win_depth)
-
-      && XTranslateCoordinates(xdisplay, /*src*/w->win, /*dst*/root_win,
-                               0, 0, &x, &y, &win_child)) {
-    pos.win = w->win;
-    pos.rx = x;
-    pos.ry = y;
-    return true;
-  }
-  else return false;
+  // car ceux-ci sont inclus dans une fenetre intermediaire cree par le WM.
+  // les windows de la liste sont les filles de root: leur position est
+  // connue (see addWin())
+  pos.win = w->win;
+  pos.rx = w->x + w->border;
+  pos.ry = w->y + w->border;
+  return true;
 }
 
 /* ==================================================== [TheEnd] ======= */
@@ -0,0 +1,115 @@
+#include <cstdio>
+#include <unistd.h>
+#include <ubit/ueventlog.hpp>
+#include <gtest/gtest.h>
+
+using namespace ubit;
+
+TEST(UEventLogTest, WriteAndRead) {
+
+	char path[64];
+	sprintf(path, "/tmp/test_ueventlog-%d", int(getpid()));
+
+	UEventLog::Record press;
+	press.type = UEventLog::MOUSE_PRESS;
+	press.time = 4000000000UL;
+	press.win = 2;
+	press.state = 0x100;
+	press.x = 10; press.y = -5;
+	press.screen_x = 110; press.screen_y = 95;
+	press.detail = 1;
+
+	UEventLog::Record wheel = press;
+	wheel.type = UEventLog::WHEEL_MOTION;
+	wheel.time = press.time + 15;
+	wheel.channel = 3;
+	wheel.detail = -120;
+	wheel.detail2 = 0;
+
+	UEventLog::Record key;
+	key.type = UEventLog::KEY_PRESS;
+	key.time = wheel.time - 2;    // times may not be ordered
+	key.detail = 38;
+	key.detail2 = 'a';
+
+	UEventLog::Record enter;
+	enter.type = UEventLog::WIN_ENTER;
+	enter.time = key.time + 1;
+	enter.win = 1;
+
+	UEventLog out;
+	ASSERT_TRUE(out.openWrite(path));
+	EXPECT_TRUE(out.write(press));
+	EXPECT_TRUE(out.write(wheel));
+	EXPECT_TRUE(out.write(key));
+	EXPECT_TRUE(out.write(enter));
+	out.close();
+
+	UEventLog in;
+	ASSERT_TRUE(in.openRead(path));
+	UEventLog::Record r;
+	ASSERT_TRUE(in.read(r));
+	EXPECT_EQ(UEventLog::MOUSE_PRESS, r.type);
+	EXPECT_EQ(press.time, r.time);
+	EXPECT_EQ(2, r.win);
+	EXPECT_EQ(0x100, r.state);
+	EXPECT_EQ(10, r.x); EXPECT_EQ(-5, r.y);
+	EXPECT_EQ(110, r.screen_x); EXPECT_EQ(95, r.screen_y);
+	EXPECT_EQ(1, r.detail);
+
+	ASSERT_TRUE(in.read(r));
+	EXPECT_EQ(UEventLog::WHEEL_MOTION, r.type);
+	EXPECT_EQ(wheel.time, r.time);
+	EXPECT_EQ(3, r.channel);
+	EXPECT_EQ(-120, r.detail);
+
+	ASSERT_TRUE(in.read(r));
+	EXPECT_EQ(UEventLog::KEY_PRESS, r.type);
+	EXPECT_EQ(key.time, r.time);
+	EXPECT_EQ(38, r.detail);
+	EXPECT_EQ('a', r.detail2);
+
+	ASSERT_TRUE(in.read(r));
+	EXPECT_EQ(UEventLog::WIN_ENTER, r.type);
+	EXPECT_EQ(enter.time, r.time);
+	EXPECT_EQ(1, r.win);
+
+	EXPECT_FALSE(in.read(r));    // end of file
+	in.close();
+
+	// not a log file
+	FILE* f = fopen(path, "w");
+	fputs("hello", f);
+	fclose(f);
+	EXPECT_FALSE(in.openRead(path));
+	unlink(path);
+}
+
+TEST(UEventProfileTest, NestedScopes) {
+
+	UEventProfile::time[UEventProfile::LAYOUT] = 0;
+	UEventProfile::time[UEventProfile::PAINT] = 0;
+
+	// nothing is measured when the profile is disabled
+	UEventProfile::enabled = false;
+	{
+		UEventProfile::Scope s(UEventProfile::LAYOUT);
+		usleep(1000);
+	}
+	EXPECT_EQ(0UL, UEventProfile::time[UEventProfile::LAYOUT]);
+
+	// nested scopes of the same phase are measured once
+	UEventProfile::enabled = true;
+	{
+		UEventProfile::Scope outer(UEventProfile::LAYOUT);
+		usleep(1000);
+		{
+			UEventProfile::Scope inner(UEventProfile::LAYOUT);
+			usleep(50000);
+		}
+	}
+	UEventProfile::enabled = false;
+	EXPECT_GE(UEventProfile::time[UEventProfile::LAYOUT], 51000UL);
+	EXPECT_LT(UEventProfile::time[UEventProfile::LAYOUT], 90000UL);
+	EXPECT_EQ(0UL, UEventProfile::time[UEventProfile::PAINT]);
+}
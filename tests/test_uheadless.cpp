@@ -0,0 +1,1041 @@
+#include <gtest/gtest.h>
+#if UBIT_WITH_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#include <ubit/ubit.hpp>
+#include <ubit/ufontImpl.hpp>
+#include <ubit/nat/uhardfont.hpp>
+#include <ubit/nat/udispHeadless.hpp>
+#include <ubit/nat/uhardima.hpp>
+#include <ubit/nat/uglcontext.hpp>
+#include <ubit/uthumbnailcache.hpp>
+#include <ubit/ueventlog.hpp>
+#include <ubit/uhtml.hpp>
+#include <ubit/u3d.hpp>
+#include <ubit/ucss.hpp>
+#include <ubit/udom.hpp>
+#include <ubit/uicon.hpp>
+#include <ubit/ufile.hpp>
+#include <ubit/ufinder.hpp>
+#include <ubit/ufinderImpl.hpp>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <poll.h>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace ubit;
+
+// counts the heap allocations of each thread
+static thread_local unsigned long new_count = 0;
+
+void* operator new(size_t size) {
+	new_count++;
+	void* p = malloc(size ? size : 1);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+static int clicks = 0;
+static void click() {clicks++;}
+
+static int paints = 0;
+static void paint() {paints++;}
+
+static bool isRed(const unsigned char* p) {
+	return p[0] > 200 && p[1] < 50 && p[2] < 50;
+}
+
+static int countRed(UHardwinHeadless* hw) {
+	const unsigned char* p = hw->getPixels();
+	int red = 0;
+	for (int k = 0; k < hw->getWidth() * hw->getHeight(); ++k, p += 4) {
+		if (isRed(p)) red++;
+	}
+	return red;
+}
+
+TEST(UHeadlessTest, RenderAndClick) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+
+	UButton& button = ubutton("Hello" + ucall(click));
+	UFrame& frame = uframe(usize(200, 100) + UBackground::red + ulabel("Headless") + button);
+	UAppli::getAppli()->add(frame);
+	frame.show();
+
+	UHardwinHeadless* hw = disp->getHardwin(frame);
+	ASSERT_TRUE(hw != NULL);
+	EXPECT_TRUE(hw->isShown());
+	EXPECT_EQ(200, hw->getWidth());
+	EXPECT_EQ(100, hw->getHeight());
+
+	// the background is red and the text is dark
+	const unsigned char* p = hw->getPixels();
+	int red = 0, dark = 0;
+	for (int k = 0; k < hw->getWidth() * hw->getHeight(); ++k, p += 4) {
+		if (isRed(p)) red++;
+		else if (p[0] < 64 && p[1] < 64 && p[2] < 64) dark++;
+	}
+	EXPECT_GT(red, 200 * 100 / 2);
+	EXPECT_GT(dark, 0);
+
+	UPoint pos = button.getView()->getPos();
+	disp->mousePress(frame, UPoint(pos.x + 5, pos.y + 5), UMouseEvent::LeftButton);
+	disp->mouseRelease(frame, UPoint(pos.x + 5, pos.y + 5), UMouseEvent::LeftButton);
+	EXPECT_EQ(1, clicks);
+}
+
+TEST(UHeadlessTest, FontMetrics) {
+	UFontDesc fd(UFont::sans_serif);
+	UHardFont* f = UAppli::getDisp()->getFont(&fd);
+	ASSERT_TRUE(f != NULL);
+	EXPECT_GT(f->getHeight(), 0);
+	EXPECT_FLOAT_EQ(2 * f->getWidth('a'), f->getWidth("ab", 2));
+}
+
+TEST(UHeadlessTest, ThumbnailCache) {
+	if (!UAppli::isUsingGL())
+		GTEST_SKIP() << "the thumbnails are stored as RGBA pixels, which requires GL mode";
+	char dir[] = "/tmp/ubit_thumbnailsXXXXXX";
+	ASSERT_TRUE(mkdtemp(dir) != NULL);
+
+	std::vector<unsigned char> pixels(16 * 8 * 4), pixels2;
+	for (unsigned int k = 0; k < pixels.size(); ++k) pixels[k] = k % 251;
+	UIma ima, ima2;
+	ASSERT_TRUE(ima.setRGBA(&pixels[0], 16, 8));
+	{
+		UThumbnailCache cache(dir, 4 * pixels.size());
+		ASSERT_TRUE(cache.isOpened());
+		EXPECT_TRUE(cache.put("/a.jpg", 100, 2000, ima));
+		EXPECT_FALSE(cache.get("/a.jpg", 101, 2000, ima2));   // modified file
+		EXPECT_FALSE(cache.get("/b.jpg", 100, 2000, ima2));
+	}
+
+	// the cache is persistent
+	UThumbnailCache cache(dir, 4 * pixels.size());
+	ASSERT_TRUE(cache.get("/a.jpg", 100, 2000, ima2));
+	int w = 0, h = 0;
+	ASSERT_TRUE(ima2.getRGBA(pixels2, w, h));
+	EXPECT_EQ(16, w);
+	EXPECT_EQ(8, h);
+	EXPECT_TRUE(pixels == pixels2);
+
+	// the least recently used thumbnails are evicted
+	EXPECT_TRUE(cache.put("/b.jpg", 100, 2000, ima));
+	EXPECT_TRUE(cache.get("/a.jpg", 100, 2000, ima2));
+	EXPECT_TRUE(cache.put("/c.jpg", 100, 2000, ima));
+	EXPECT_TRUE(cache.put("/d.jpg", 100, 2000, ima));
+	EXPECT_TRUE(cache.put("/e.jpg", 100, 2000, ima));
+	EXPECT_LE(cache.getDataSize(), cache.getMaxSize());
+	EXPECT_TRUE(cache.get("/e.jpg", 100, 2000, ima2));
+	EXPECT_FALSE(cache.get("/b.jpg", 100, 2000, ima2));
+
+	cache.clear();
+	EXPECT_EQ(0, cache.getCount());
+	EXPECT_FALSE(cache.get("/e.jpg", 100, 2000, ima2));
+	std::system((std::string("rm -rf ") + dir).c_str());
+}
+
+// fires the input of the reader (as the main loop does) until the directory is read
+static bool waitReader(UFileDirReader& reader) {
+	for (int k = 0; k < 500 && reader.isReading(); ++k) {
+		struct pollfd p = {reader.getSource(), POLLIN, 0};
+		if (poll(&p, 1, 10) > 0) reader.fireInput();
+	}
+	return !reader.isReading();
+}
+
+struct TestIconbox : public UIconbox {
+	UFileDirReader* getReader() {return reader;}
+};
+
+static void createFile(const std::string& path) {
+	FILE* f = fopen(path.c_str(), "w");
+	if (f) fclose(f);
+}
+
+TEST(UHeadlessTest, InsertFileIcon) {
+	char dir[] = "/tmp/ubit_iconboxXXXXXX";
+	ASSERT_TRUE(mkdtemp(dir) != NULL);
+	createFile(std::string(dir) + "/b.txt");
+
+	TestIconbox& box = *new TestIconbox();
+	uptr<UIconbox> pbox = box;
+	ASSERT_EQ(UFilestat::Opened, box.readDir(dir));
+	ASSERT_TRUE(waitReader(*box.getReader()));
+	ASSERT_TRUE(box.findIcon("b.txt") != NULL);
+
+	// files created after reading are inserted like the entries of the reader
+	createFile(std::string(dir) + "/a.txt");
+	createFile(std::string(dir) + "/.hidden");
+	UIcon* icon = box.insertFileIcon("a.txt");
+	ASSERT_TRUE(icon != NULL);
+	int a = -1, b = -1;                                     // sorted by name
+	for (int k = 0; box.getIcon(k); ++k) {
+		if (box.getIcon(k) == icon) a = k;
+		else if (box.getIcon(k) == box.findIcon("b.txt")) b = k;
+	}
+	EXPECT_EQ(a + 1, b);
+	EXPECT_TRUE(box.insertFileIcon("a.txt") == NULL);      // already there
+	EXPECT_TRUE(box.insertFileIcon(".hidden") == NULL);    // dot files are not shown
+	EXPECT_TRUE(box.insertFileIcon("none.txt") == NULL);   // does not exist
+	EXPECT_TRUE(box.findIcon(".hidden") == NULL);
+	std::system((std::string("rm -rf ") + dir).c_str());
+}
+
+struct ReaderLog {
+	ReaderLog(UFileDirReader& r) : reader(r), chunks(0), closes(0) {}
+	UFileDirReader& reader;
+	std::vector<std::string> names;
+	int chunks, closes;
+	void addChunk() {
+		chunks++;
+		const UFileInfos& infos = reader.getFileInfos();
+		for (unsigned int k = 0; k < infos.size(); ++k) names.push_back(infos[k]->getFileName()->c_str());
+	}
+	void close() {closes++;}
+};
+
+static std::string makeDir(char* dir, int file_count) {
+	if (!mkdtemp(dir)) return "";
+	for (int k = 0; k < file_count; ++k) {
+		char name[32];
+		sprintf(name, "/f%02d.txt", file_count - 1 - k);
+		createFile(dir + std::string(name));
+	}
+	createFile(dir + std::string("/.hidden"));
+	createFile(dir + std::string("/notes.doc"));
+	mkdir((dir + std::string("/zdir")).c_str(), 0700);
+	mkdir((dir + std::string("/adir")).c_str(), 0700);
+	return dir;
+}
+
+// the entries are received by chunks, which are bigger and bigger
+TEST(UHeadlessTest, FileDirReader) {
+	char dir[] = "/tmp/ubit_readerXXXXXX";
+	ASSERT_FALSE(makeDir(dir, 30).empty());
+	int first_chunk_size = UFileDirReader::first_chunk_size;
+	int chunk_size = UFileDirReader::chunk_size;
+	UFileDirReader::first_chunk_size = 4;
+	UFileDirReader::chunk_size = 8;
+
+	uptr<UFileDirReader> reader = new UFileDirReader();
+	ReaderLog log(*reader);
+	reader->onAction(ucall(&log, &ReaderLog::addChunk));
+	reader->onClose(ucall(&log, &ReaderLog::close));
+	EXPECT_FALSE(reader->read(std::string(dir) + "/none", "", "", false));
+	EXPECT_EQ(0, log.closes);
+
+	ASSERT_TRUE(reader->read(dir, "", "*.txt", false));
+	EXPECT_TRUE(waitReader(*reader));
+	UFileDirReader::first_chunk_size = first_chunk_size;
+	UFileDirReader::chunk_size = chunk_size;
+
+	// the .txt files and the directories (which are not filtered), not the dot files
+	EXPECT_EQ(32, reader->getCount());
+	EXPECT_EQ(32u, log.names.size());
+	EXPECT_GE(log.chunks, 5);      // 4 + 8 + 8 + 8 + 4
+	EXPECT_EQ(1, log.closes);
+	std::sort(log.names.begin(), log.names.end());
+	EXPECT_EQ("adir", log.names.front());
+	EXPECT_EQ("f00.txt", log.names[1]);
+	EXPECT_EQ("zdir", log.names.back());
+	EXPECT_TRUE(std::find(log.names.begin(), log.names.end(), ".hidden") == log.names.end());
+	EXPECT_TRUE(std::find(log.names.begin(), log.names.end(), "notes.doc") == log.names.end());
+	std::system((std::string("rm -rf ") + dir).c_str());
+}
+
+// the icons are added while the directory is read, then sorted
+TEST(UHeadlessTest, IconboxReadDir) {
+	char dir[] = "/tmp/ubit_iconboxXXXXXX";
+	ASSERT_FALSE(makeDir(dir, 30).empty());
+	int first_chunk_size = UFileDirReader::first_chunk_size;
+	UFileDirReader::first_chunk_size = 4;
+
+	TestIconbox& box = *new TestIconbox();
+	uptr<UIconbox> pbox = box;
+	ASSERT_EQ(UFilestat::Opened, box.readDir(dir));
+	EXPECT_TRUE(box.isLoading());
+	EXPECT_TRUE(waitReader(*box.getReader()));
+	UFileDirReader::first_chunk_size = first_chunk_size;
+	EXPECT_FALSE(box.isLoading());
+
+	// .. then the directories then the files, sorted by name
+	std::vector<std::string> names;
+	for (int k = 0; box.getIcon(k); ++k) names.push_back(box.getIcon(k)->getName().c_str());
+	ASSERT_EQ(34u, names.size());
+	EXPECT_EQ("..", names[0]);
+	EXPECT_EQ("adir", names[1]);
+	EXPECT_EQ("zdir", names[2]);
+	EXPECT_EQ("f00.txt", names[3]);
+	EXPECT_EQ("notes.doc", names[33]);
+	EXPECT_TRUE(std::is_sorted(names.begin() + 3, names.end()));
+	EXPECT_TRUE(box.findIcon(".hidden") == NULL);
+	std::system((std::string("rm -rf ") + dir).c_str());
+}
+
+// the documents are fetched when the gate is opened
+struct GatedTransfer : public UFinderLocalTransfer {
+	GatedTransfer() : fetches(0), opened(false) {}
+	std::atomic<int> fetches;
+	std::atomic<bool> opened;
+	virtual bool fetch(Job& job) {
+		fetches++;
+		while (!opened && !job.isCancelled()) usleep(1000);
+		return UFinderLocalTransfer::fetch(job);
+	}
+};
+
+struct TestFinderCom : public UFinderCom {
+	TestFinderCom(UFinder& fd) : UFinderCom(fd, 2) {}
+	std::vector<std::string> shown;
+	virtual void showDoc(Job& job) {if (job.isLoaded()) shown.push_back(job.url);}
+};
+
+TEST(UHeadlessTest, FinderRemoteLoads) {
+	setenv("USER", "ubit-test", 0);    // see UFileCache::createCache()
+	char dir[] = "/tmp/ubit_finderXXXXXX";
+	ASSERT_TRUE(mkdtemp(dir) != NULL);
+	createFile(std::string(dir) + "/a.txt");
+	createFile(std::string(dir) + "/b.txt");
+	std::string url_a = std::string("ssh://localhost:") + dir + "/a.txt";
+	std::string url_b = std::string("ssh://localhost:") + dir + "/b.txt";
+
+	uptr<UFinder> finder = new UFinder();
+	uptr<TestFinderCom> com = new TestFinderCom(*finder);
+	GatedTransfer* transfer = new GatedTransfer();
+	com->setTransfer(transfer);
+
+	// the same document is only requested once
+	com->load(url_a.c_str(), UFileInfo::SSH);
+	com->load(url_a.c_str(), UFileInfo::SSH);
+	EXPECT_EQ(1, com->getJobCount());
+
+	// opening another document cancels the first one
+	com->load(url_b.c_str(), UFileInfo::SSH);
+	EXPECT_EQ(2, com->getJobCount());
+	EXPECT_LE(com->getWorkerCount(), 2);
+	transfer->opened = true;
+
+	// fires the input of the com (as the main loop does) until the jobs are done
+	for (int k = 0; k < 500 && com->getJobCount() > 0; ++k) {
+		struct pollfd p = {com->getSource(), POLLIN, 0};
+		if (poll(&p, 1, 10) > 0) com->fireInput();
+	}
+	EXPECT_EQ(0, com->getJobCount());
+	ASSERT_EQ(1U, com->shown.size());
+	EXPECT_EQ(url_b, com->shown[0]);
+	EXPECT_LE(transfer->fetches.load(), 2);
+
+	// changing the backend cancels the pending requests
+	transfer = new GatedTransfer();
+	com->load(url_a.c_str(), UFileInfo::SSH);
+	com->setTransfer(transfer);
+	EXPECT_EQ(0, com->getWorkerCount());
+	for (int k = 0; k < 10 && com->getJobCount() > 0; ++k) {
+		struct pollfd p = {com->getSource(), POLLIN, 0};
+		if (poll(&p, 1, 10) > 0) com->fireInput();
+	}
+	EXPECT_EQ(0, com->getJobCount());
+	EXPECT_EQ(1U, com->shown.size());
+	std::system((std::string("rm -rf ") + dir).c_str());
+}
+
+static UElem* findElement(UElem* e, const char* name) {
+	if (!e) return NULL;
+	if (e->getNodeName().equals(name)) return e;
+	for (UChildIter i = e->cbegin(); i != e->cend(); ++i) {
+		UElem* found = findElement((*i)->toElem(), name);
+		if (found) return found;
+	}
+	return NULL;
+}
+
+static std::vector<UNode*> getRuleProps(const UStyleSheet& sheet, UElem* e) {
+	std::vector<UNode*> props;
+	for (UChildIter i = e->abegin(); i != e->aend(); ++i) {
+		if (sheet.isRuleProps(*i)) props.push_back(*i);
+	}
+	return props;
+}
+
+TEST(UHeadlessTest, RestyleAfterThemeSwitch) {
+	UHtmlParser parser;
+	UXmlDocument* doc = parser.parse("theme", "<html><head><style>p.note {color: red}</style></head>"
+	                                          "<body><p class=\"note\">text</p></body></html>");
+	ASSERT_TRUE(doc != NULL);
+	UElem* p = findElement(doc->getDocumentElement(), "p");
+	ASSERT_TRUE(p != NULL);
+	UStyleSheet& sheet = doc->getStyleSheet();
+	std::vector<UNode*> old_props = getRuleProps(sheet, p);
+	ASSERT_EQ(1u, old_props.size());
+
+	// the rules of the previous theme are replaced
+	sheet.removeRules();
+	UCssParser css;
+	css.parse("body p.note {color: blue}", doc);
+	EXPECT_EQ(1, doc->restyle());
+
+	std::vector<UNode*> new_props = getRuleProps(sheet, p);
+	ASSERT_EQ(1u, new_props.size());
+	EXPECT_NE(old_props[0], new_props[0]);
+	EXPECT_TRUE(std::find(p->abegin(), p->aend(), old_props[0]) == p->aend());
+	EXPECT_FALSE(sheet.isRuleProps(old_props[0]));
+	EXPECT_EQ(0, doc->restyle());
+}
+
+// a selector that is declared again replaces the props of the previous rule
+TEST(UHeadlessTest, RedeclaredSelector) {
+	UHtmlParser parser;
+	UXmlDocument* doc = parser.parse("redeclared", "<html><head><style>p.note {color: red}"
+	                                               "p.note {color: blue}</style></head>"
+	                                               "<body><p class=\"note\">text</p></body></html>");
+	ASSERT_TRUE(doc != NULL);
+	UElem* p = findElement(doc->getDocumentElement(), "p");
+	ASSERT_TRUE(p != NULL);
+	UStyleSheet& sheet = doc->getStyleSheet();
+	const UClass* c = sheet.findClass("p[class=note]");
+	ASSERT_TRUE(c != NULL);
+	std::vector<UNode*> props = getRuleProps(sheet, p);
+	ASSERT_EQ(1u, props.size());
+	EXPECT_EQ(c->getAttributes(), props[0]);
+	UColor* color = c->getAttributes()->getAttr<UColor>();
+	ASSERT_TRUE(color != NULL);
+	UColor blue;
+	blue.setNamedColor("blue");
+	EXPECT_TRUE(*color == blue);
+
+	// the previous props are removed from the element
+	UNode* old_props = props[0];
+	UCssParser css;
+	css.parse("p.note {color: green}", doc);
+	EXPECT_NE(old_props, c->getAttributes());
+	EXPECT_EQ(1, doc->restyle());
+	props = getRuleProps(sheet, p);
+	ASSERT_EQ(1u, props.size());
+	EXPECT_EQ(c->getAttributes(), props[0]);
+	EXPECT_TRUE(std::find(p->abegin(), p->aend(), old_props) == p->aend());
+	EXPECT_EQ(0, doc->restyle());
+}
+
+// the events are recorded, then replayed on the same window
+TEST(UHeadlessTest, RecordAndReplay) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+
+	UButton& button = ubutton("Replay" + ucall(click));
+	UFrame& frame = uframe(usize(200, 100) + button);
+	UAppli::getAppli()->add(frame);
+	frame.show();
+	UPoint pos = button.getView()->getPos();
+
+	char path[64];
+	sprintf(path, "/tmp/test_ureplay-%d", int(getpid()));
+	UEventRecorder recorder;
+	ASSERT_TRUE(recorder.start(path));
+	int clicks0 = clicks;
+	disp->mousePress(frame, UPoint(pos.x + 5, pos.y + 5), UMouseEvent::LeftButton);
+	disp->mouseRelease(frame, UPoint(pos.x + 5, pos.y + 5), UMouseEvent::LeftButton);
+	recorder.stop();
+	EXPECT_EQ(clicks0 + 1, clicks);
+
+	UEventReplayer replayer;
+	ASSERT_TRUE(replayer.replay(path));
+	EXPECT_EQ(clicks0 + 2, clicks);
+	EXPECT_EQ(0, replayer.getSkippedCount());
+	ASSERT_EQ(2u, replayer.getTimings().size());
+	EXPECT_EQ(UEventLog::MOUSE_PRESS, replayer.getTimings()[0].type);
+	EXPECT_EQ(UEventLog::MOUSE_RELEASE, replayer.getTimings()[1].type);
+
+	std::ostringstream report;
+	replayer.printReport(report);
+	EXPECT_NE(std::string::npos, report.str().find("2 events replayed, 0 skipped"));
+	EXPECT_NE(std::string::npos, report.str().find("total"));
+
+	// the times go backwards: the events are then replayed without waiting
+	UEventLog::Record r;
+	r.type = UEventLog::WIN_ENTER;
+	r.win = 100000;     // no such window
+	UEventLog log;
+	ASSERT_TRUE(log.openWrite(path));
+	r.time = 1000; log.write(r);
+	r.time = 500;  log.write(r);
+	r.time = 530;  log.write(r);
+	log.close();
+
+	unsigned long t0 = UEventProfile::now();
+	ASSERT_TRUE(replayer.replay(path, true));
+	unsigned long elapsed = UEventProfile::now() - t0;
+	EXPECT_EQ(3, replayer.getSkippedCount());
+	EXPECT_GE(elapsed, 30000UL);
+	EXPECT_LT(elapsed, 1000000UL);
+	unlink(path);
+}
+
+static UFont& noteFont() {
+	static UFont& font = *new UFont();
+	return font;
+}
+
+// the font of this class style is changed by the test
+struct NoteBox : public UBox {
+	UCLASS(NoteBox)
+	NoteBox(const UArgs& a = UArgs::none) : UBox(a) {}
+	static UStyle* createStyle() {
+		UStyle* style = UBox::createStyle();
+		style->setFont(&noteFont());
+		return style;
+	}
+};
+
+// the computed styles are discarded when a font of a style is changed
+TEST(UHeadlessTest, FontChangeRestyles) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+
+	noteFont().setPixelSize(12);
+	NoteBox& note = *new NoteBox(ustr("Styled text"));
+	UFrame& frame = uframe(usize(600, 200) + uhbox(UHalign::left + note));
+	UAppli::getAppli()->add(frame);
+	frame.show();
+	float width = note.getView()->getWidth();
+	ASSERT_GT(width, 0);
+
+	noteFont().setPixelSize(24);
+	note.update();
+	disp->mouseMotion(frame, UPoint(0, 0));   // processes the pending updates
+	EXPECT_GT(note.getView()->getWidth(), width * 1.5);
+}
+
+static void clickAt(UDispHeadless* disp, UFrame& frame, const UPoint& pos) {
+	disp->mousePress(frame, pos, UMouseEvent::LeftButton);
+	disp->mouseRelease(frame, pos, UMouseEvent::LeftButton);
+}
+
+TEST(UHeadlessTest, LevelOfDetail) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+
+	int clicks0 = clicks;
+	UButton& button = ubutton("Detail" + ucall(click));
+	UBox& cell = ubox(ulod(0.5, UColor::red) + button + ulabel("Level of detail"));
+	UZoompane& zp = uzoompane();
+	zp.viewport().add(uvbox(uhbox(cell)));
+	UFrame& frame = uframe(usize(300, 200) + zp);
+	UAppli::getAppli()->add(frame);
+	frame.show();
+
+	UHardwinHeadless* hw = disp->getHardwin(frame);
+	ASSERT_TRUE(hw != NULL);
+	EXPECT_EQ(0, countRed(hw));
+
+	// the cell is collapsed: it is filled with the color of the ULod and
+	// its content is not laid out nor painted
+	zp.viewportScale() = 0.25;
+	disp->mouseMotion(frame, UPoint(0, 0));   // processes the pending updates
+	EXPECT_GT(countRed(hw), 0);
+
+	// collapsed boxes catch the events of their children: the button is not
+	// laid out at this scale, its view still covers the top left corner of the cell
+	UPoint pos = cell.getView()->getHardwinPos();
+	ASSERT_GT(cell.getView()->getWidth(), 2);
+	ASSERT_GT(cell.getView()->getHeight(), 2);
+	clickAt(disp, frame, UPoint(pos.x + 1, pos.y + 1));
+	EXPECT_EQ(clicks0, clicks);
+
+	zp.viewportScale() = 1.;
+	disp->mouseMotion(frame, UPoint(0, 0));
+	EXPECT_EQ(0, countRed(hw));
+	pos = button.getView()->getHardwinPos();
+	clickAt(disp, frame, UPoint(pos.x + 2, pos.y + 2));
+	EXPECT_EQ(clicks0 + 1, clicks);
+}
+
+TEST(UHeadlessTest, LevelOfDetailImpostor) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+
+	UStr& text = ustr("Impostor");
+	UBox& cell = ubox(ulod(0.5, ULod::IMPOSTOR) + UBackground::red
+	                  + ulabel(text + UOn::paint / ucall(paint)));
+	UZoompane& zp = uzoompane();
+	zp.viewport().add(uvbox(uhbox(cell)));
+	UPos& glass_pos = upos(250, 150);
+	UBox& glass = ubox(glass_pos + usize(40, 40) + UBackground::white);
+	UFrame& frame = uframe(usize(300, 200) + zp + glass);
+	UAppli::getAppli()->add(frame);
+	frame.show();
+
+	UHardwinHeadless* hw = disp->getHardwin(frame);
+	ASSERT_TRUE(hw != NULL);
+
+	// the collapsed cell is painted once, then drawn from its bitmap
+	zp.viewportScale() = 0.25;
+	disp->mouseMotion(frame, UPoint(0, 0));   // processes the pending updates
+	int red = countRed(hw);
+	EXPECT_GT(red, 0);
+	int size = hw->getWidth() * hw->getHeight() * 4;
+	std::vector<unsigned char> pixels(hw->getPixels(), hw->getPixels() + size);
+
+	int paints0 = paints;
+	glass_pos.set(0, 0);
+	disp->mouseMotion(frame, UPoint(0, 0));
+	EXPECT_LT(countRed(hw), red);
+	glass_pos.set(250, 150);
+	disp->mouseMotion(frame, UPoint(0, 0));
+	EXPECT_EQ(paints0, paints);
+	EXPECT_TRUE(std::equal(pixels.begin(), pixels.end(), hw->getPixels()));
+
+	// the bitmap is discarded when the content changes
+	text = "Changed";
+	disp->mouseMotion(frame, UPoint(0, 0));
+	EXPECT_GT(paints, paints0);
+	EXPECT_GT(countRed(hw), 0);
+}
+
+TEST(UHeadlessTest, LevelOfDetailHide) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+
+	int clicks0 = clicks;
+	UButton& button = ubutton("Hidden" + ucall(click));
+	UBox& cell = ubox(ulod(0.5, ULod::HIDE) + UOn::paint / ucall(paint) + button);
+	UZoompane& zp = uzoompane();
+	zp.viewport().add(uvbox(upadding(10, 10) + uhbox(cell)));
+	UFrame& frame = uframe(usize(300, 200) + zp);
+	UAppli::getAppli()->add(frame);
+	frame.show();
+
+	ASSERT_TRUE(disp->getHardwin(frame) != NULL);
+
+	// the cell is not painted (its paint callbacks are not called) and ignores the events
+	zp.viewportScale() = 0.25;
+	disp->mouseMotion(frame, UPoint(0, 0));   // processes the pending updates
+	int paints0 = paints;
+	frame.repaint();
+	disp->mouseMotion(frame, UPoint(0, 0));
+	EXPECT_EQ(paints0, paints);
+	UPoint pos = cell.getView()->getHardwinPos();
+	clickAt(disp, frame, UPoint(pos.x + 1, pos.y + 1));
+	EXPECT_EQ(clicks0, clicks);
+
+	zp.viewportScale() = 1.;
+	disp->mouseMotion(frame, UPoint(0, 0));
+	EXPECT_GT(paints, paints0);
+	pos = button.getView()->getHardwinPos();
+	clickAt(disp, frame, UPoint(pos.x + 2, pos.y + 2));
+	EXPECT_EQ(clicks0 + 1, clicks);
+}
+
+TEST(UHeadlessTest, Layer) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+
+	int clicks0 = clicks;
+	UStr& text = ustr("Cached");
+	UButton& button = ubutton("Layer" + ucall(click));
+	UBox& panel = uvbox(ulayer() + UBackground::red + ulabel(text + UOn::paint / ucall(paint)) + button);
+	UPos& glass_pos = upos(0, 0);
+	UBox& glass = ubox(glass_pos + usize(40, 40) + UBackground::white);
+	UFrame& frame = uframe(usize(200, 100) + panel + glass);
+	UAppli::getAppli()->add(frame);
+	frame.show();
+
+	UHardwinHeadless* hw = disp->getHardwin(frame);
+	ASSERT_TRUE(hw != NULL);
+	int size = hw->getWidth() * hw->getHeight() * 4;
+	std::vector<unsigned char> pixels(hw->getPixels(), hw->getPixels() + size);
+
+	// the panel is drawn from its bitmap when the glass is moved over it:
+	// the content of the panel is not painted
+	int paints0 = paints;
+	glass_pos.set(100, 50);
+	disp->mouseMotion(frame, UPoint(0, 0));   // processes the pending updates
+	glass_pos.set(0, 0);
+	disp->mouseMotion(frame, UPoint(0, 0));
+	EXPECT_EQ(paints0, paints);
+	EXPECT_TRUE(std::equal(pixels.begin(), pixels.end(), hw->getPixels()));
+
+	// the bitmap is discarded when a descendant changes
+	text = "Changed";
+	disp->mouseMotion(frame, UPoint(0, 0));
+	EXPECT_GT(paints, paints0);
+	EXPECT_FALSE(std::equal(pixels.begin(), pixels.end(), hw->getPixels()));
+
+	// the children still get the events
+	UPoint pos = button.getView()->getPos();
+	disp->mousePress(frame, UPoint(pos.x + 2, pos.y + 2), UMouseEvent::LeftButton);
+	disp->mouseRelease(frame, UPoint(pos.x + 2, pos.y + 2), UMouseEvent::LeftButton);
+	EXPECT_EQ(clicks0 + 1, clicks);
+
+	// the bitmap is also discarded when a descendant changes while the window is hidden
+	frame.show(false);
+	text = "Cached";
+	disp->mouseMotion(frame, UPoint(0, 0));
+	frame.show();
+	disp->mouseMotion(frame, UPoint(0, 0));
+	EXPECT_TRUE(std::equal(pixels.begin(), pixels.end(), hw->getPixels()));
+}
+
+// the width of a column follows the widest of its cells when a cell changes
+TEST(UHeadlessTest, TableColumnWidth) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+
+	UStr& text = ustr("Cell");
+	UTcell& other = utcell(ulabel("Other cell"));
+	UTable& table = utable(utrow(utcell(ulabel(text)) + utcell(ulabel("Right")))
+			+ utrow(other + utcell(ulabel("Right")))
+			+ utrow(utcell(ulabel("Short")) + utcell(ulabel("Right"))));
+	UFrame& frame = uframe(usize(400, 200) + uvbox(table));
+	UAppli::getAppli()->add(frame);
+	frame.show();
+
+	UTableView* view = dynamic_cast<UTableView*>(table.getView());
+	ASSERT_TRUE(view != NULL);
+	ASSERT_EQ(2, view->ccount);
+	float width = view->cols[0].d;
+	EXPECT_EQ(other.getView()->getWidth(), width);
+
+	// the column grows with the cell
+	text = "A much wider cell";
+	disp->mouseMotion(frame, UPoint(0, 0));   // processes the pending updates
+	EXPECT_GT(view->cols[0].d, width);
+
+	// and shrinks back when the cell shrinks
+	text = "Cell";
+	disp->mouseMotion(frame, UPoint(0, 0));
+	EXPECT_EQ(width, view->cols[0].d);
+
+	// the widest cell of the column is removed
+	other.show(false);
+	disp->mouseMotion(frame, UPoint(0, 0));
+	EXPECT_LT(view->cols[0].d, width);
+	other.show(true);
+	disp->mouseMotion(frame, UPoint(0, 0));
+	EXPECT_EQ(width, view->cols[0].d);
+}
+
+// the panes are only scrolled by copying their pixels without OpenGL:
+// this test calls the copy directly
+struct TestScrollpane : public UScrollpane {
+	TestScrollpane(const UArgs& a) : UScrollpane(a) {}
+	bool scrollBy(float delta_y) {
+		UPaneView* pane_view = dynamic_cast<UPaneView*>(getView());
+		if (!pane_view || !canBlitScroll(pane_view)) return false;
+		pane_view->setYScroll(pane_view->getYScroll() + delta_y);
+		blitScroll(pane_view, 0, -delta_y);   // the content moves up
+		return true;
+	}
+};
+
+// the exposures that are not painted yet must be moved with the pixels
+TEST(UHeadlessTest, ScrollExposes) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+
+	UBackground* colors[] = {&UBackground::red, &UBackground::green, &UBackground::blue};
+	UBox& content = uvbox(UBackground::yellow);
+	for (int k = 0; k < 30; ++k) content.add(ubox(usize(150, 10) + *colors[k % 3]));
+	TestScrollpane& pane = *new TestScrollpane(usize(160, 100) + content);
+	UFrame& frame = uframe(pane);
+	UAppli::getAppli()->add(frame);
+	frame.show();
+
+	UHardwinHeadless* hw = disp->getHardwin(frame);
+	ASSERT_TRUE(hw != NULL);
+	int size = hw->getWidth() * hw->getHeight() * 4;
+	UPoint pos = content.getView()->getHardwinPos();
+
+	disp->expose(frame, URect(pos.x + 10, pos.y + 40, 50, 20));
+	ASSERT_TRUE(pane.scrollBy(25));
+	disp->flushExposes(frame);
+	std::vector<unsigned char> pixels(hw->getPixels(), hw->getPixels() + size);
+
+	// same pixels as when the window is painted entirely
+	disp->onPaint(frame.getWinView(disp), 0, 0, hw->getWidth(), hw->getHeight());
+	EXPECT_TRUE(std::equal(pixels.begin(), pixels.end(), hw->getPixels()));
+}
+
+// the children of a wide box are laid out in the same way by worker threads
+TEST(UHeadlessTest, ParallelLayout) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+
+	// a box shared by several columns
+	UBox& shared = ubox(ulabel("Shared") + usize(40, 20));
+	UBox& row = uhbox();
+	for (int k = 0; k < 12; k++) {
+		UBox& col = uvbox(ulabel(ustr(UStr("Column ") & k)));
+		for (int i = 0; i <= k % 4; i++) col.add(ubutton("Button"));
+		if (k % 3 == 0) col.add(shared);
+		if (k == 5) col.add(usize(120, UIGNORE));
+		row.add(col);
+	}
+	// a box that appears twice in the same box
+	UBox& twice = uvbox(ulabel("Twice"));
+	UBox& row2 = uhbox(uvbox(ulabel("Once")) + twice + twice);
+	UFrame& frame = uframe(usize(1000, 300) + uvbox(row + row2));
+	UAppli::getAppli()->add(frame);
+	frame.show();
+
+	std::vector<URect> rects[2];
+	for (int parallel = 0; parallel < 2; parallel++) {
+		UAppli::conf.parallel_layout = (parallel == 1);
+		frame.update();
+		disp->mouseMotion(frame, UPoint(0, 0));   // processes the pending updates
+		for (UChildIter i = row.cbegin(); i != row.cend(); ++i) {
+			UView* v = (*i)->toBox()->getView();
+			ASSERT_TRUE(v != NULL);
+			rects[parallel].push_back(URect(v->getX(), v->getY(), v->getWidth(), v->getHeight()));
+		}
+		for (UChildIter i = row2.cbegin(); i != row2.cend(); ++i) {
+			UView* v = (*i)->toBox()->getView();
+			ASSERT_TRUE(v != NULL);
+			rects[parallel].push_back(URect(v->getX(), v->getY(), v->getWidth(), v->getHeight()));
+		}
+	}
+	UAppli::conf.parallel_layout = false;
+
+	ASSERT_EQ(15u, rects[0].size());
+	ASSERT_EQ(rects[0].size(), rects[1].size());
+	for (unsigned int k = 0; k < rects[0].size(); k++) {
+		EXPECT_EQ(rects[0][k].x, rects[1][k].x);
+		EXPECT_EQ(rects[0][k].y, rects[1][k].y);
+		EXPECT_EQ(rects[0][k].width, rects[1][k].width);
+		EXPECT_EQ(rects[0][k].height, rects[1][k].height);
+	}
+	EXPECT_GT(rects[0][5].width, rects[0][4].width);
+}
+
+// once the computed styles exist, painting does not allocate memory
+TEST(UHeadlessTest, RepaintWithoutAllocs) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+
+	UBox& panel = uvbox(UBackground::wheat + ulabel("Allocations")
+			+ uhbox(ubutton("One") + ubutton("Two") + ucheckbox("Three")));
+	UFrame& frame = uframe(usize(200, 100) + panel);
+	UAppli::getAppli()->add(frame);
+	frame.show();
+
+	UHardwinHeadless* hw = disp->getHardwin(frame);
+	ASSERT_TRUE(hw != NULL);
+	unsigned long count = new_count;
+	disp->onPaint(frame.getWinView(disp), 0, 0, hw->getWidth(), hw->getHeight());
+	disp->onPaint(frame.getWinView(disp), 0, 0, hw->getWidth(), hw->getHeight());
+	EXPECT_EQ(count, new_count);
+}
+
+TEST(UHeadlessTest, ImagePartialUpdate) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+
+	std::vector<unsigned char> red(16 * 8 * 4), white(4 * 4 * 4, 255);
+	for (size_t k = 0; k < red.size(); k += 4) {
+		red[k] = 255; red[k+1] = 0; red[k+2] = 0; red[k+3] = 255;
+	}
+	UIma& ima = *new UIma();
+	ASSERT_TRUE(ima.setRGBA(&red[0], 16, 8));
+	UHardIma* natima = ima.getNatImas().front();
+	UFrame& frame = uframe(usize(100, 50) + uhbox(ima));
+	UAppli::getAppli()->add(frame);
+	frame.show();
+
+	UHardwinHeadless* hw = disp->getHardwin(frame);
+	ASSERT_TRUE(hw != NULL);
+	EXPECT_EQ(16 * 8, countRed(hw));
+
+	// the pixel buffer is reused when the image keeps the same size
+	ASSERT_TRUE(ima.setRGBA(&red[0], 16, 8));
+	EXPECT_EQ(natima, ima.getNatImas().front());
+
+	// only an area of the image is replaced
+	EXPECT_FALSE(ima.setRGBA(&white[0], 14, 6, 4, 4));
+	ASSERT_TRUE(ima.setRGBA(&white[0], 2, 2, 4, 4));
+	EXPECT_EQ(natima, ima.getNatImas().front());
+
+	std::vector<unsigned char> pixels;
+	int w = 0, h = 0;
+	ASSERT_TRUE(ima.getRGBA(pixels, w, h));
+	EXPECT_EQ(16, w);
+	EXPECT_EQ(8, h);
+	EXPECT_EQ(255, pixels[(3 * 16 + 3) * 4 + 1]);   // white
+	EXPECT_EQ(0, pixels[(1 * 16 + 1) * 4 + 1]);     // still red
+	EXPECT_EQ(0, pixels[(6 * 16 + 6) * 4 + 1]);
+
+	// the image is repainted
+	disp->mouseMotion(frame, UPoint(0, 0));
+	EXPECT_EQ(16 * 8 - 4 * 4, countRed(hw));
+}
+
+// the headless display never flushes the GL resources: nothing is queued
+TEST(UHeadlessTest, NoPendingUploads) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+	UGlresources* res = disp->getGlresources();
+	std::vector<UHardImaGL*> imas;
+	for (int k = 0; k < 10; ++k) imas.push_back(new UHardImaGL(disp, 20, 10));
+	imas[0]->invalidate(0, 0, 5, 5);
+	EXPECT_EQ(0, res->getPendingUploadCount());
+	for (unsigned int k = 0; k < imas.size(); ++k) delete imas[k];
+}
+
+#if UBIT_WITH_EGL
+
+// the GL tests run in a surfaceless EGL context (they are skipped if GL is not
+// available). The context is released even if a test fails.
+class UHeadlessGLTest : public testing::Test {
+protected:
+	EGLDisplay edisp = EGL_NO_DISPLAY;
+	EGLContext ctx = EGL_NO_CONTEXT;
+
+	void SetUp() override {
+		edisp = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		if (edisp == EGL_NO_DISPLAY || !eglInitialize(edisp, NULL, NULL) || !eglBindAPI(EGL_OPENGL_API))
+			GTEST_SKIP() << "no EGL display";
+		ctx = eglCreateContext(edisp, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, NULL);
+		if (ctx == EGL_NO_CONTEXT || !eglMakeCurrent(edisp, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx))
+			GTEST_SKIP() << "no GL context";
+	}
+
+	void TearDown() override {
+		if (edisp == EGL_NO_DISPLAY) return;
+		if (ctx != EGL_NO_CONTEXT) {
+			eglMakeCurrent(edisp, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			eglDestroyContext(edisp, ctx);
+		}
+		eglTerminate(edisp);
+	}
+};
+
+TEST_F(UHeadlessGLTest, ImageTexture) {
+	UDispHeadless* disp = dynamic_cast<UDispHeadless*>(UAppli::getDisp());
+	ASSERT_TRUE(disp != NULL);
+
+	// gray image with a lighter last column and a darker last row
+	UGlresources* res = disp->getGlresources();
+	UHardImaGL* ima = new UHardImaGL(disp, 100, 50);
+	unsigned int* px = (unsigned int*)ima->getPixels();
+	for (int y = 0; y < 50; ++y)
+		for (int x = 0; x < 100; ++x)
+			px[y * 100 + x] = (y == 49) ? 0xff404040 : (x == 99) ? 0xffc8c8c8 : 0xff808080;
+	res->upload(ima);
+	GLuint texid = ima->getTexID();
+	ASSERT_NE(0u, texid);
+
+	GLint tw = 0, th = 0;
+	glBindTexture(GL_TEXTURE_2D, texid);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &tw);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &th);
+	if (tw != 128 || th != 64) {
+		delete ima;
+		res->flush();
+		GTEST_SKIP() << "no mipmap generation: the image is scaled";
+	}
+
+	// the last column and the last row fill the padding of the texture
+	std::vector<unsigned int> tex(128 * 64);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &tex[0]);
+	int bad = 0;
+	for (int y = 0; y < 64; ++y)
+		for (int x = 0; x < 128; ++x)
+			if (tex[y * 128 + x] != px[std::min(y, 49) * 100 + std::min(x, 99)]) bad++;
+	EXPECT_EQ(0, bad);
+
+	// the mipmaps do not blend the borders with undefined texels
+	std::vector<unsigned char> mip(64 * 32 * 4);
+	glGetTexImage(GL_TEXTURE_2D, 1, GL_RGBA, GL_UNSIGNED_BYTE, &mip[0]);
+	EXPECT_NEAR(0xc8, mip[(10 * 64 + 50) * 4], 1);
+	EXPECT_NEAR(0x40, mip[(30 * 64 + 20) * 4], 1);
+
+	// only the modified area is uploaded in the same texture, with its padding
+	for (int y = 40; y < 50; ++y)
+		for (int x = 90; x < 100; ++x) px[y * 100 + x] = 0xff070707;
+	ima->invalidate(90, 40, 10, 10);
+	res->upload(ima);
+	EXPECT_EQ(texid, ima->getTexID());
+	glBindTexture(GL_TEXTURE_2D, texid);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &tex[0]);
+	EXPECT_EQ(0xff070707u, tex[45 * 128 + 120]);
+	EXPECT_EQ(0xff070707u, tex[60 * 128 + 95]);
+	EXPECT_EQ(0xff070707u, tex[60 * 128 + 120]);
+	EXPECT_EQ(0xff404040u, tex[60 * 128 + 80]);
+	EXPECT_EQ(0xffc8c8c8u, tex[30 * 128 + 120]);
+	glGetTexImage(GL_TEXTURE_2D, 1, GL_RGBA, GL_UNSIGNED_BYTE, &mip[0]);
+	EXPECT_NEAR(0x07, mip[(25 * 64 + 55) * 4], 1);   // the mipmaps are generated again
+	EXPECT_EQ(GLenum(GL_NO_ERROR), glGetError());
+
+	delete ima;
+	res->flush();
+	EXPECT_FALSE(glIsTexture(texid));
+}
+
+// the screen bounds of the children of U3Dcanvas are computed in software:
+// they are checked against gluProject() with the matrices of OpenGL
+TEST_F(UHeadlessGLTest, U3DScreenBounds) {
+	U3Dcanvas& canvas = u3dcanvas();
+	U3Dpos& pos = u3dpos(-40, 30, -500);
+	pos.setRot(20, -35, 10);
+	float width = 400, height = 300;
+	URect rect(0, -60, 120, 60);   // y is up
+
+	double model[16], proj[16], glmodel[16], glproj[16];
+	canvas.getMatrices(pos, width, height, model, proj);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	gluPerspective(canvas.getFovy(), canvas.getAspect() * width / height,
+	               canvas.getNear(), canvas.getFar());
+	glGetDoublev(GL_PROJECTION_MATRIX, glproj);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+	glTranslatef(pos.getX().val, pos.getY().val, pos.getZ());
+	glRotatef(-pos.getXRot(), 1,0,0);
+	glRotatef(pos.getYRot(), 0,1,0);
+	glRotatef(pos.getZRot(), 0,0,1);
+	glGetDoublev(GL_MODELVIEW_MATRIX, glmodel);
+	for (int k = 0; k < 16; ++k) {
+		EXPECT_NEAR(glproj[k], proj[k], 1e-5);
+		EXPECT_NEAR(glmodel[k], model[k], 1e-3);
+	}
+
+	GLint viewport[4] = {0, 0, int(width), int(height)};
+	double xmin = 1e30, ymin = 1e30, xmax = -1e30, ymax = -1e30;
+	for (int k = 0; k < 4; ++k) {
+		double wx, wy, wz;
+		ASSERT_TRUE(gluProject(rect.x + (k & 1) * rect.width, rect.y + (k >> 1) * rect.height, 0,
+		                       glmodel, glproj, viewport, &wx, &wy, &wz));
+		xmin = std::min(xmin, wx); xmax = std::max(xmax, wx);
+		ymin = std::min(ymin, wy); ymax = std::max(ymax, wy);
+	}
+	URect bounds;
+	EXPECT_TRUE(canvas.getScreenBounds(pos, rect, 0, width, height, bounds));
+	EXPECT_NEAR(xmin, bounds.x, 0.01);
+	EXPECT_NEAR(ymin, bounds.y, 0.01);
+	EXPECT_NEAR(xmax, bounds.x + bounds.width, 0.01);
+	EXPECT_NEAR(ymax, bounds.y + bounds.height, 0.01);
+
+	// behind the eye
+	pos.setTrans(-40, 30, 500);
+	EXPECT_FALSE(canvas.getScreenBounds(pos, rect, 0, width, height, bounds));
+	EXPECT_TRUE(bounds.isEmpty());
+}
+
+#endif
+
+int main(int argc, char **argv) {
+	UAppli::conf.headless = true;
+	UAppli appli(argc, argv);
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
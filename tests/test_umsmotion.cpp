@@ -0,0 +1,111 @@
+#include <ums/motion.hpp>
+#include <gtest/gtest.h>
+
+// the pointer moves by (dx, dy) every 10 ms from (0, 0) at time 1000
+static void move(MotionModel& m, long dx, long dy, int count) {
+	m.reset(0, 0, 1000);
+	for (int k = 1; k <= count; k++) m.addSample(k * dx, k * dy, 1000 + k * 10);
+}
+
+TEST(MotionModelTest, Prediction) {
+
+	MotionModel m;
+	long x, y;
+	move(m, 10, 0, 8);    // 1 pixel/ms, last sample at (80, 0) at 1080
+	EXPECT_TRUE(m.isMoving(1080));
+
+	EXPECT_TRUE(m.predict(1080, x, y));
+	EXPECT_EQ(80, x);
+	EXPECT_EQ(0, y);
+
+	EXPECT_TRUE(m.predict(1090, x, y));
+	EXPECT_EQ(90, x);
+	EXPECT_EQ(0, y);
+
+	EXPECT_TRUE(m.predict(1110, x, y));
+	EXPECT_EQ(110, x);
+
+	// the prediction is limited to MAX_ERROR pixels from the last sample
+	EXPECT_TRUE(m.predict(1140, x, y));
+	EXPECT_EQ(80 + MotionModel::MAX_ERROR, x);
+	EXPECT_EQ(0, y);
+
+	// and to MAX_PREDICTION millisec after it
+	EXPECT_TRUE(m.predict(1080 + MotionModel::MAX_PREDICTION, x, y));
+	EXPECT_FALSE(m.predict(1080 + MotionModel::MAX_PREDICTION + 1, x, y));
+	EXPECT_EQ(80, x);
+	EXPECT_EQ(0, y);
+	EXPECT_FALSE(m.isMoving(1080 + MotionModel::MAX_PREDICTION + 1));
+}
+
+TEST(MotionModelTest, DiagonalPrediction) {
+
+	MotionModel m;
+	long x, y;
+	move(m, 30, 40, 8);   // 5 pixels/ms, last sample at (240, 320)
+
+	EXPECT_TRUE(m.predict(1082, x, y));
+	EXPECT_EQ(240 + 6, x);
+	EXPECT_EQ(320 + 8, y);
+
+	// the direction is kept when the distance is limited
+	EXPECT_TRUE(m.predict(1100, x, y));
+	EXPECT_EQ(240 + 24, x);
+	EXPECT_EQ(320 + 32, y);
+}
+
+TEST(MotionModelTest, StillPointer) {
+
+	MotionModel m;
+	long x, y;
+	m.reset(50, 60, 1000);
+	EXPECT_FALSE(m.isMoving(1000));
+	EXPECT_FALSE(m.predict(1010, x, y));
+	EXPECT_EQ(50, x);
+	EXPECT_EQ(60, y);
+
+	// the pointer moves again after a pause longer than MAX_PREDICTION
+	move(m, 10, 0, 8);
+	m.addSample(90, 0, 1080 + MotionModel::MAX_PREDICTION + 1);
+	EXPECT_FALSE(m.predict(1080 + MotionModel::MAX_PREDICTION + 11, x, y));
+	EXPECT_EQ(90, x);
+	EXPECT_EQ(0, y);
+}
+
+TEST(MotionModelTest, Coalescing) {
+
+	MotionModel m;
+	long x, y;
+
+	// samples with the same timestamp only update the position
+	m.reset(0, 0, 1000);
+	m.addSample(5, 5, 1000);
+	EXPECT_FALSE(m.predict(1010, x, y));
+	EXPECT_EQ(5, x);
+	EXPECT_EQ(5, y);
+
+	move(m, 10, 0, 8);
+	m.addSample(85, 0, 1080);
+	EXPECT_TRUE(m.predict(1080, x, y));
+	EXPECT_EQ(85, x);
+
+	// the position received first at 1080 is forgotten: the pointer is
+	// predicted as if only (85, 0) had been received at this time
+	MotionModel ref;
+	move(ref, 10, 0, 7);
+	ref.addSample(85, 0, 1080);
+
+	long rx, ry;
+	for (unsigned long t = 1080; t <= 1120; t += 10) {
+		EXPECT_TRUE(m.predict(t, x, y));
+		EXPECT_TRUE(ref.predict(t, rx, ry));
+		EXPECT_EQ(rx, x);
+		EXPECT_EQ(ry, y);
+	}
+
+	// samples received at the same time do not look like a still pointer
+	m.addSample(95, 0, 1090);
+	m.addSample(105, 0, 1090);
+	EXPECT_TRUE(m.predict(1100, x, y));
+	EXPECT_GT(x, 105);
+}
@@ -0,0 +1,82 @@
+#include <vector>
+#include <thread>
+#include <poll.h>
+#include <ums/source.hpp>
+#include <gtest/gtest.h>
+
+static bool waitReadable(int fd) {
+	struct pollfd p = {fd, POLLIN, 0};
+	return poll(&p, 1, 5000) == 1;
+}
+
+static void produce(SourceQueue* q, int producer, int count) {
+	for (int k = 0; k < count; k++) {
+		SourceEvent* e = new SourceEvent();
+		e->type = SourceEvent::DEVICE;
+		e->code = producer;
+		e->x = k;
+		q->push(e);
+	}
+}
+
+TEST(SourceQueueTest, SeveralProducers) {
+
+	const int PRODUCERS = 4, COUNT = 20000;
+	SourceQueue q;
+	ASSERT_TRUE(q.getDescriptor() >= 0);
+	EXPECT_TRUE(q.pop() == null);
+
+	std::vector<std::thread> threads;
+	for (int p = 0; p < PRODUCERS; p++)
+		threads.push_back(std::thread(produce, &q, p, COUNT));
+
+	// same protocol as the main loop: the events of each producer must be
+	// received in the order they were pushed
+	std::vector<long> next(PRODUCERS, 0);
+	int received = 0, misordered = 0;
+	while (received < PRODUCERS * COUNT) {
+		if (!waitReadable(q.getDescriptor())) break;
+		q.clearNotification();
+		while (SourceEvent* e = q.pop()) {
+			if (e->code >= 0 && e->code < PRODUCERS) {
+				if (e->x != next[e->code]) misordered++;
+				next[e->code] = e->x + 1;
+			}
+			received++;
+			delete e;
+		}
+	}
+	for (unsigned int k = 0; k < threads.size(); k++) threads[k].join();
+
+	EXPECT_EQ(PRODUCERS * COUNT, received);
+	EXPECT_EQ(0, misordered);
+	for (int p = 0; p < PRODUCERS; p++) EXPECT_EQ(COUNT, next[p]);
+	EXPECT_TRUE(q.pop() == null);
+}
+
+TEST(SourceQueueTest, Notification) {
+
+	SourceQueue q;
+	struct pollfd p = {q.getDescriptor(), POLLIN, 0};
+	EXPECT_EQ(0, poll(&p, 1, 0));
+
+	SourceEvent* e1 = new SourceEvent();
+	SourceEvent* e2 = new SourceEvent();
+	q.push(e1);
+	q.push(e2);
+	EXPECT_EQ(1, poll(&p, 1, 0));
+	q.clearNotification();
+	EXPECT_EQ(0, poll(&p, 1, 0));
+
+	// the queue is emptied without notifying the main loop
+	EXPECT_EQ(e1, q.pop());
+	EXPECT_EQ(e2, q.pop());
+	EXPECT_TRUE(q.pop() == null);
+	EXPECT_EQ(0, poll(&p, 1, 0));
+	delete e1;
+	delete e2;
+
+	// events that are not popped are deleted with the queue
+	q.push(new SourceEvent());
+	EXPECT_EQ(1, poll(&p, 1, 0));
+}
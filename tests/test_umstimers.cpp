@@ -0,0 +1,103 @@
+#include <vector>
+#include <ums/timers.hpp>
+#include <gtest/gtest.h>
+
+static std::vector<int> fired;
+
+static void timerCB(void* data) {
+	fired.push_back(*(int*)data);
+}
+
+// the times are in millisec: a tick lasts TimerWheel::TICK millisec
+static const unsigned long T0 = 100000;
+
+TEST(TimerWheelTest, NearestDeadline) {
+
+	TimerWheel wheel;
+	int a = 1, b = 2, c = 3;
+	fired.clear();
+	EXPECT_EQ(-1, wheel.getTimeout(T0));
+
+	wheel.add(T0, 300, timerCB, &a);
+	wheel.add(T0, 50, timerCB, &b);
+	wheel.add(T0, 120, timerCB, &c);
+	EXPECT_EQ(50, wheel.getTimeout(T0));
+	EXPECT_EQ(20, wheel.getTimeout(T0 + 30));
+
+	// nothing has expired yet
+	wheel.fire(T0 + 40);
+	EXPECT_TRUE(fired.empty());
+	EXPECT_EQ(10, wheel.getTimeout(T0 + 40));
+
+	wheel.fire(T0 + 50);
+	ASSERT_EQ(1u, fired.size());
+	EXPECT_EQ(2, fired[0]);
+	EXPECT_EQ(70, wheel.getTimeout(T0 + 50));
+
+	// the main loop was late: the timer is due
+	EXPECT_EQ(0, wheel.getTimeout(T0 + 200));
+	wheel.fire(T0 + 200);
+	ASSERT_EQ(2u, fired.size());
+	EXPECT_EQ(3, fired[1]);
+	EXPECT_EQ(100, wheel.getTimeout(T0 + 200));
+
+	wheel.fire(T0 + 300);
+	ASSERT_EQ(3u, fired.size());
+	EXPECT_EQ(1, fired[2]);
+	EXPECT_EQ(-1, wheel.getTimeout(T0 + 300));
+}
+
+TEST(TimerWheelTest, Cancellation) {
+
+	TimerWheel wheel;
+	int a = 1, b = 2;
+	fired.clear();
+
+	TimerWheel::Timer* ta = wheel.add(T0, 50, timerCB, &a);
+	wheel.add(T0, 100, timerCB, &b);
+	wheel.remove(ta);
+	wheel.remove(ta);     // already removed: ignored
+	EXPECT_EQ(100, wheel.getTimeout(T0));
+
+	wheel.fire(T0 + 100);
+	ASSERT_EQ(1u, fired.size());
+	EXPECT_EQ(2, fired[0]);
+
+	// no timer left once the last one is removed
+	TimerWheel::Timer* tb = wheel.add(T0 + 100, 50, timerCB, &b);
+	EXPECT_EQ(50, wheel.getTimeout(T0 + 100));
+	wheel.remove(tb);
+	EXPECT_EQ(-1, wheel.getTimeout(T0 + 100));
+	wheel.fire(T0 + 1000);
+	EXPECT_EQ(1u, fired.size());
+}
+
+TEST(TimerWheelTest, Wraparound) {
+
+	TimerWheel wheel;
+	int a = 1, b = 2;
+	fired.clear();
+	const unsigned long revolution = TimerWheel::SLOT_COUNT * TimerWheel::TICK;
+
+	// both timers are in the same slot but one revolution apart
+	wheel.add(T0, revolution + 30, timerCB, &a);
+	// no timer expires during this revolution: wakes up at its end
+	EXPECT_EQ(long(revolution), wheel.getTimeout(T0));
+	wheel.add(T0, 30, timerCB, &b);
+	EXPECT_EQ(30, wheel.getTimeout(T0));
+
+	wheel.fire(T0 + 30);
+	ASSERT_EQ(1u, fired.size());
+	EXPECT_EQ(2, fired[0]);
+
+	// the other timer was not fired although its slot has been processed
+	EXPECT_EQ(long(revolution), wheel.getTimeout(T0 + 30));
+	wheel.fire(T0 + revolution);
+	EXPECT_EQ(1u, fired.size());
+	EXPECT_EQ(30, wheel.getTimeout(T0 + revolution));
+
+	wheel.fire(T0 + revolution + 30);
+	ASSERT_EQ(2u, fired.size());
+	EXPECT_EQ(1, fired[1]);
+	EXPECT_EQ(-1, wheel.getTimeout(T0 + revolution + 30));
+}
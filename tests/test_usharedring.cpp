@@ -0,0 +1,147 @@
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <ubit/usharedring.hpp>
+#include <ubit/usocket.hpp>
+#include <gtest/gtest.h>
+
+using namespace ubit;
+
+static bool isReadable(int fd) {
+	struct pollfd p = {fd, POLLIN, 0};
+	return poll(&p, 1, 0) == 1;
+}
+
+TEST(USharedRingTest, BlocksAndDoorbell) {
+
+	USharedRing producer;
+	ASSERT_TRUE(producer.create(1024));
+
+	USharedRing consumer;
+	ASSERT_TRUE(consumer.attach(dup(producer.getMemoryDescriptor()),
+	                            dup(producer.getEventDescriptor())));
+
+	UInbuf ib;
+	EXPECT_FALSE(consumer.read(ib));
+	EXPECT_TRUE(consumer.prepareWait());
+
+	// the first write wakes up the consumer
+	ASSERT_TRUE(producer.write("hello", 6));
+	EXPECT_TRUE(isReadable(consumer.getEventDescriptor()));
+	consumer.clearNotification();
+	EXPECT_FALSE(isReadable(consumer.getEventDescriptor()));
+
+	// the consumer is not waiting: no notification
+	ASSERT_TRUE(producer.write("world", 6));
+	EXPECT_FALSE(isReadable(consumer.getEventDescriptor()));
+
+	ASSERT_TRUE(consumer.read(ib));
+	EXPECT_STREQ("hello", ib.data());
+	EXPECT_FALSE(consumer.prepareWait());    // "world" is pending
+	ASSERT_TRUE(consumer.read(ib));
+	EXPECT_STREQ("world", ib.data());
+	EXPECT_FALSE(consumer.read(ib));
+	EXPECT_TRUE(consumer.prepareWait());
+
+	// blocks that wrap around the end of the ring
+	char block[300];
+	for (int k = 0; k < 20; k++) {
+		memset(block, 'a' + k, sizeof(block));
+		ASSERT_TRUE(producer.write(block, sizeof(block)));
+		ASSERT_TRUE(consumer.read(ib));
+		ASSERT_EQ(sizeof(block), ib.size());
+		EXPECT_EQ(0, memcmp(block, ib.data(), sizeof(block)));
+	}
+
+	// the ring is full
+	int count = 0;
+	while (producer.write(block, sizeof(block))) count++;
+	EXPECT_EQ(3, count);
+	ASSERT_TRUE(consumer.read(ib));
+	EXPECT_TRUE(producer.write(block, sizeof(block)));
+}
+
+TEST(USharedRingTest, SealedMemory) {
+
+	USharedRing producer;
+	ASSERT_TRUE(producer.create(1024));
+	// the producer can't shrink the memory mapped by the consumer
+	EXPECT_NE(0, ftruncate(producer.getMemoryDescriptor(), 16));
+
+	// unsealed memory is rejected
+	int memfd = memfd_create("test-ring", MFD_CLOEXEC);
+	ASSERT_GE(memfd, 0);
+	ASSERT_EQ(0, ftruncate(memfd, 4096));
+	USharedRing consumer;
+	EXPECT_FALSE(consumer.attach(memfd, eventfd(0, EFD_CLOEXEC)));
+	EXPECT_FALSE(consumer.isOpen());
+}
+
+TEST(USharedRingTest, CorruptedCapacity) {
+
+	USharedRing producer;
+	ASSERT_TRUE(producer.create(1024));
+	USharedRing consumer;
+	ASSERT_TRUE(consumer.attach(dup(producer.getMemoryDescriptor()),
+	                            dup(producer.getEventDescriptor())));
+
+	// the capacity is changed in the shared header after attach()
+	size_t size = lseek(producer.getMemoryDescriptor(), 0, SEEK_END);
+	void* p = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED,
+	               producer.getMemoryDescriptor(), 0);
+	ASSERT_NE(MAP_FAILED, p);
+	((unsigned int*)p)[1] = 1u << 30;
+
+	// the blocks are still read within the ring
+	char block[300];
+	UInbuf ib;
+	for (int k = 0; k < 20; k++) {
+		memset(block, 'a' + k, sizeof(block));
+		ASSERT_TRUE(producer.write(block, sizeof(block)));
+		ASSERT_TRUE(consumer.read(ib));
+		ASSERT_EQ(sizeof(block), ib.size());
+		EXPECT_EQ(0, memcmp(block, ib.data(), sizeof(block)));
+	}
+	munmap(p, size);
+}
+
+TEST(USharedRingTest, DescriptorsOverLocalSocket) {
+
+	char path[100];
+	sprintf(path, "/tmp/.ubit-test-%d", (int)getpid());
+	UServerSocket server;
+	ASSERT_TRUE(server.bindLocal(path));
+
+	USocket client;
+	ASSERT_GE(client.connectLocal(path), 0);
+	USocket* peer = server.accept();
+	ASSERT_TRUE(peer != nullptr);
+
+	USharedRing producer;
+	ASSERT_TRUE(producer.create());
+	int fds[2] = {producer.getMemoryDescriptor(), producer.getEventDescriptor()};
+	ASSERT_TRUE(client.sendDescriptors(fds, 2));
+
+	int received[2];
+	ASSERT_EQ(2, peer->receiveDescriptors(received, 2, 1000));
+	USharedRing consumer;
+	ASSERT_TRUE(consumer.attach(received[0], received[1]));
+
+	ASSERT_TRUE(producer.write("ping", 5));
+	UInbuf ib;
+	ASSERT_TRUE(consumer.read(ib));
+	EXPECT_STREQ("ping", ib.data());
+
+	// blocks are still sent over the socket
+	ASSERT_TRUE(client.sendBlock("pong", 5));
+	ASSERT_TRUE(peer->receiveBlock(ib));
+	EXPECT_STREQ("pong", ib.data());
+
+	delete peer;
+	server.close();
+	EXPECT_NE(0, access(path, F_OK));   // removed by close()
+}
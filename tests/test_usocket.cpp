@@ -0,0 +1,141 @@
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <ubit/usocket.hpp>
+#include <gtest/gtest.h>
+
+using namespace ubit;
+
+TEST(USocketTest, NonBlockingPartialBlocks) {
+
+	UServerSocket server(0);
+	ASSERT_FALSE(server.isClosed());
+
+	USocket client("localhost", server.getLocalPort());
+	ASSERT_TRUE(client.isConnected());
+
+	USocket* peer = server.accept();
+	ASSERT_TRUE(peer != nullptr);
+	peer->setNonBlocking(true);
+
+	UInbuf ib;
+	EXPECT_FALSE(peer->receiveBlock(ib));   // nothing received yet
+	EXPECT_TRUE(peer->isConnected());
+
+	// a block whose size and content arrive in several parts
+	const char frame[] = {0, 5, 'h', 'e', 'l', 'l', 'o'};
+	client.sendBytes(frame, 1);
+	usleep(20000);
+	EXPECT_FALSE(peer->receiveBlock(ib));
+	client.sendBytes(frame + 1, 3);
+	usleep(20000);
+	EXPECT_FALSE(peer->receiveBlock(ib));
+	client.sendBytes(frame + 4, 3);
+	usleep(20000);
+	ASSERT_TRUE(peer->receiveBlock(ib));
+	EXPECT_EQ(5u, ib.size());
+	EXPECT_EQ(0, memcmp(ib.data(), "hello", 5));
+
+	// several blocks received at once
+	client.sendBlock("one", 4);
+	client.sendBlock("two", 4);
+	usleep(20000);
+	ASSERT_TRUE(peer->receiveBlock(ib));
+	EXPECT_STREQ("one", ib.data());
+	ASSERT_TRUE(peer->receiveBlock(ib));
+	EXPECT_STREQ("two", ib.data());
+	EXPECT_FALSE(peer->receiveBlock(ib));
+
+	// the remote side closes the connection
+	client.close();
+	usleep(20000);
+	EXPECT_FALSE(peer->receiveBlock(ib));
+	EXPECT_FALSE(peer->isConnected());
+	delete peer;
+}
+
+TEST(USocketTest, QueuedOutputWithoutAppli) {
+
+	// without UAppli, the data that can't be sent is queued until flush() is called
+	UServerSocket server(0);
+	USocket client("localhost", server.getLocalPort());
+	ASSERT_TRUE(client.isConnected());
+
+	USocket* peer = server.accept();
+	ASSERT_TRUE(peer != nullptr);
+	peer->setNonBlocking(true);
+	peer->setMaxPendingOutput(0);
+
+	std::vector<char> data(60000, 'x');
+	int count = 0;
+	while (peer->getPendingOutput() == 0 && count < 1000) {
+		ASSERT_TRUE(peer->sendBlock(&data[0], data.size()));
+		count++;
+	}
+	EXPECT_GT(peer->getPendingOutput(), 0u);
+
+	// the client reads everything while the queue is flushed
+	unsigned long expected = count * (data.size() + 2), received = 0;
+	std::vector<char> buf(65536);
+	while (received < expected) {
+		ASSERT_TRUE(peer->flush());
+		ssize_t n = ::recv(client.getDescriptor(), &buf[0], buf.size(), MSG_DONTWAIT);
+		if (n > 0) received += n;
+		else if (n == 0) break;
+		else usleep(1000);
+	}
+	EXPECT_EQ(expected, received);
+	EXPECT_EQ(0u, peer->getPendingOutput());
+	delete peer;
+}
+
+TEST(USocketTest, VarintsAndBlocks) {
+
+	UOutbuf sub;
+	sub.writeChar('a');
+	sub.writeSVarint(-3);
+
+	UOutbuf ob;
+	ob.writeVarint(0);
+	ob.writeVarint(127);
+	ob.writeVarint(128);
+	ob.writeVarint(4000000000UL);
+	ob.writeSVarint(-1);
+	ob.writeSVarint(-70000);
+	ob.writeSVarint(70000);
+	ob.writeBlock(sub);
+	ob.writeBlock(sub);
+	EXPECT_EQ(1u + 1 + 2 + 5 + 1 + 3 + 3 + 2*3, ob.size());
+
+	UServerSocket server(0);
+	USocket client("localhost", server.getLocalPort());
+	USocket* peer = server.accept();
+	ASSERT_TRUE(peer != nullptr);
+	ASSERT_TRUE(client.sendBlock(ob));
+
+	UInbuf ib;
+	ASSERT_TRUE(peer->receiveBlock(ib));
+	unsigned long u;
+	long s;
+	EXPECT_TRUE(ib.readVarint(u)); EXPECT_EQ(0u, u);
+	EXPECT_TRUE(ib.readVarint(u)); EXPECT_EQ(127u, u);
+	EXPECT_TRUE(ib.readVarint(u)); EXPECT_EQ(128u, u);
+	EXPECT_TRUE(ib.readVarint(u)); EXPECT_EQ(4000000000UL, u);
+	EXPECT_TRUE(ib.readSVarint(s)); EXPECT_EQ(-1, s);
+	EXPECT_TRUE(ib.readSVarint(s)); EXPECT_EQ(-70000, s);
+	EXPECT_TRUE(ib.readSVarint(s)); EXPECT_EQ(70000, s);
+
+	UInbuf b;
+	for (int k = 0; k < 2; k++) {
+		ASSERT_TRUE(ib.readBlock(b));
+		ASSERT_EQ(2u, b.size());
+		char c;
+		b.readChar(c);
+		EXPECT_EQ('a', c);
+		EXPECT_TRUE(b.readSVarint(s)); EXPECT_EQ(-3, s);
+	}
+	EXPECT_FALSE(ib.readBlock(b));   // no more blocks
+	EXPECT_FALSE(ib.readVarint(u));  // truncated
+	delete peer;
+}